@@ -0,0 +1,28 @@
+include make/Config.mk
+include make/Defs.mk
+
+#
+# Microbenchmarks.  Unlike the tests, these are built with the library's
+# optimization flags, since they time inlined kernels.
+#
+
+VPATH                   := $(PROJECT_ROOT)/src/Benchmarks
+BENCH_BUILD_ROOT        := $(BUILD_ROOT)/Benchmarks
+BENCH_SRCS              := $(notdir $(shell find $(PROJECT_ROOT)/src/Benchmarks -name "*.cpp" | grep -v '\#'))
+BENCH_EXECUTABLES       := $(addprefix $(BENCH_BUILD_ROOT)/,$(BENCH_SRCS:.cpp=))
+
+run-benchmarks: $(BENCH_EXECUTABLES)
+	@for b in $(BENCH_EXECUTABLES); do echo "== $$(basename $$b)"; $$b || exit 1; done
+
+benchmarks: $(BENCH_EXECUTABLES)
+
+# The suite's JSON results, kept for comparison across changes
+json-benchmarks: $(BENCH_BUILD_ROOT)/QuiverBenchmark
+	$< $(BENCH_BUILD_ROOT)/QuiverBenchmark.json
+	@echo "Wrote $(BENCH_BUILD_ROOT)/QuiverBenchmark.json"
+
+$(BENCH_EXECUTABLES): $(BENCH_BUILD_ROOT)/% : %.cpp $(CXX_LIB)
+	-mkdir -p $(BENCH_BUILD_ROOT)
+	$(CXX) $< $(CXX_LIB) -lpthread -o $@
+
+.PHONY: run-benchmarks benchmarks json-benchmarks
@@ -0,0 +1,110 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Throughput of the vectorized log-add used by the sum-product recursor,
+// against the exp_ps/log_ps formulation it replaced.  Build and run with
+// "make bench".
+
+#include <stdio.h>
+#include <time.h>
+
+#include <vector>
+
+#include "Quiver/detail/SseMath.hpp"
+
+using namespace ConsensusCore; // NOLINT
+using namespace ConsensusCore::detail; // NOLINT
+
+#define N_VALUES   4096
+#define N_REPEATS  20000
+
+namespace {
+
+    inline __m128 logAdd4Reference(__m128 aa, __m128 bb)
+    {
+        __m128 max = _mm_max_ps(aa, bb);
+        __m128 min = _mm_min_ps(aa, bb);
+        __m128 diff = _mm_sub_ps(min, max);
+        return _mm_add_ps(max, log_ps(_mm_add_ps(_mm_set_ps1(1.0f), exp_ps(diff))));
+    }
+
+    double Now()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + 1e-9 * ts.tv_nsec;
+    }
+
+    // Folds a stream of operands into four accumulators, the way the
+    // recursor folds its Combine results; returns ns per logAdd lane.
+    template <__m128 (*F)(__m128, __m128)>
+    double Time(const std::vector<float>& values, float* sink)
+    {
+        double start = Now();
+        __m128 acc = _mm_set_ps1(-10.0f);
+        for (int r = 0; r < N_REPEATS; r++)
+        {
+            for (int i = 0; i < N_VALUES; i += 4)
+            {
+                acc = F(acc, _mm_loadu_ps(&values[i]));
+                acc = _mm_sub_ps(acc, _mm_set_ps1(1.0f));
+            }
+        }
+        double elapsed = Now() - start;
+        _mm_storeu_ps(sink, acc);
+        return 1e9 * elapsed / (static_cast<double>(N_REPEATS) * N_VALUES);
+    }
+}
+
+int main()
+{
+    std::vector<float> values(N_VALUES);
+    unsigned int seed = 42;
+    for (int i = 0; i < N_VALUES; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        values[i] = -20.0f * ((seed >> 8) & 0xFFFF) / 65536.0f;
+    }
+
+    float sink[8];
+    double reference = Time<logAdd4Reference>(values, &sink[0]);
+    double table = Time<logAdd4>(values, &sink[4]);
+
+    printf("logAdd4 (exp_ps/log_ps):  %6.3f ns/op\n", reference);
+    printf("logAdd4 (table, %d bits):  %6.3f ns/op  (%.2fx)\n",
+           LOGADD_TABLE_BITS, table, reference / table);
+    printf("(checksum %g)\n", sink[0] + sink[4]);
+    return 0;
+}
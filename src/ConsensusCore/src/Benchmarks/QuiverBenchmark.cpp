@@ -0,0 +1,389 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Performance suite for the consensus pipeline: FillAlphaBeta,
+// MultiReadMutationScorer::Score, RefineConsensus, ConsensusQVs and
+// PoaConsensus::FindConsensus, over fixed-seed simulated workloads of
+// several template lengths and coverages.  Results are written as JSON
+// (to stdout, or to the file named by the first argument) so that runs
+// can be compared across changes.  Build and run with "make bench", or
+// "make bench-json" to keep the results in build/Benchmarks.
+//
+// For each benchmark, "cells_per_op" is the number of DP matrix cells,
+// (read length + 1) * (template length + 1), summed over the reads an
+// operation covers (for the scorer benchmarks, the reads the scorer
+// accepted); ns_per_cell and cells_per_sec are normalized by it.  Scoring
+// a mutation only refills a window around its site, so ScoreMutation's
+// cell rate is a nominal one, for comparison between runs.
+// peak_rss_kb is the peak resident set size of the process so far.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include <string>
+#include <vector>
+
+#include "Features.hpp"
+#include "Matrix/SparseMatrix.hpp"
+#include "Mutation.hpp"
+#include "Poa/PoaConsensus.hpp"
+#include "Quiver/MultiReadMutationScorer.hpp"
+#include "Quiver/QuiverConfig.hpp"
+#include "Quiver/QuiverConsensus.hpp"
+#include "Quiver/QvEvaluator.hpp"
+#include "Quiver/SseRecursor.hpp"
+#include "Read.hpp"
+#include "Simulation/Random.hpp"
+#include "Simulation/Simulator.hpp"
+
+using namespace ConsensusCore; // NOLINT
+
+#define SEED             42
+#define N_MUTATIONS      100
+#define MIN_TIME_SEC     0.5
+#define MAX_ITERATIONS   1000
+
+namespace {
+
+    const int TemplateLengths[] = { 500, 1000, 2000 };
+    const int Coverages[]       = { 5, 10, 20 };
+
+    double Now()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + 1e-9 * ts.tv_nsec;
+    }
+
+    long PeakRssKb()
+    {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+
+    QuiverConfigTable BenchmarkConfig()
+    {
+        QvModelParams params(0.f, -10.f, -0.1f, -5.f, -0.1f, -6.f, -7.f,
+                             -0.1f, -8.f, -0.1f, -2.f, 0.f);
+        QuiverConfigTable configs;
+        configs.Insert("unknown", QuiverConfig(params, ALL_MOVES, BandingOptions(4, 18), -12.5f));
+        return configs;
+    }
+
+    // A true template and reads simulated from it with the C2 error
+    // model, plus the POA consensus of the reads, which is where
+    // refinement starts from.
+    struct Workload
+    {
+        std::string Template;
+        std::vector<std::string> Reads;
+        std::string PoaTemplate;
+
+        Workload(int templateLength, int coverage)
+        {
+            RandomNumberGenerator rng(SEED + templateLength + coverage);
+            for (int j = 0; j < templateLength; j++)
+            {
+                Template += rng.RandomBase();
+            }
+            for (int n = 0; n < coverage; n++)
+            {
+                Reads.push_back(SimulateRead(SequencingParameters::C2(), Template, rng));
+            }
+            const PoaConsensus* pc = PoaConsensus::FindConsensus(Reads);
+            PoaTemplate = pc->Sequence();
+            delete pc;
+        }
+
+        double Cells(const std::string& tpl) const
+        {
+            double cells = 0;
+            foreach (const std::string& read, Reads)
+            {
+                cells += (read.length() + 1.0) * (tpl.length() + 1.0);
+            }
+            return cells;
+        }
+
+        // Only the reads the scorer accepted
+        static double Cells(const AbstractMultiReadMutationScorer& mms)
+        {
+            double cells = 0;
+            for (int i = 0; i < mms.NumReads(); i++)
+            {
+                if (mms.Read(i) != NULL)
+                {
+                    cells += (mms.Read(i)->Length() + 1.0) * (mms.TemplateLength() + 1.0);
+                }
+            }
+            return cells;
+        }
+
+        MultiReadMutationScorer<SparseSseQvRecursor>*
+        Scorer(const QuiverConfigTable& configs, const std::string& tpl) const
+        {
+            MultiReadMutationScorer<SparseSseQvRecursor>* mms =
+                new MultiReadMutationScorer<SparseSseQvRecursor>(configs, tpl);
+            foreach (const std::string& seq, Reads)
+            {
+                Read read(QvSequenceFeatures(seq), "bench", "unknown");
+                mms->AddRead(MappedRead(read, FORWARD_STRAND, 0, tpl.length()));
+            }
+            return mms;
+        }
+    };
+
+    // One benchmark: Setup is untimed and runs before every timed Run.
+    class Benchmark
+    {
+    public:
+        virtual ~Benchmark() {}
+        virtual const char* Name() const = 0;
+        virtual double CellsPerOp() const = 0;
+        virtual void Setup() {}
+        virtual void Run() = 0;
+    };
+
+    class FillAlphaBetaBenchmark : public Benchmark
+    {
+    public:
+        FillAlphaBetaBenchmark(const Workload& w, const QuiverConfigTable& configs)
+            : w_(w)
+            , config_(configs.At("unknown"))
+            , recursor_(config_.MovesAvailable, config_.Banding)
+        {}
+        const char* Name() const { return "FillAlphaBeta"; }
+        double CellsPerOp() const { return w_.Cells(w_.Template); }
+
+        void Run()
+        {
+            foreach (const std::string& seq, w_.Reads)
+            {
+                Read read(QvSequenceFeatures(seq), "bench", "unknown");
+                QvEvaluator e(read, w_.Template, config_.QvParams);
+                SparseMatrix alpha(e.ReadLength() + 1, e.TemplateLength() + 1);
+                SparseMatrix beta(e.ReadLength() + 1, e.TemplateLength() + 1);
+                // A read whose banded alpha and beta disagree has still
+                // been filled; the scorer would just set it aside.
+                try
+                {
+                    recursor_.FillAlphaBeta(e, alpha, beta);
+                }
+                catch (AlphaBetaMismatchException& e)
+                {}
+            }
+        }
+
+    private:
+        const Workload& w_;
+        QuiverConfig config_;
+        SparseSseQvRecursor recursor_;
+    };
+
+    // An op is scoring one mutation against all the reads.
+    class ScoreMutationBenchmark : public Benchmark
+    {
+    public:
+        ScoreMutationBenchmark(const Workload& w, const QuiverConfigTable& configs)
+            : w_(w)
+            , mms_(w.Scorer(configs, w.Template))
+            , next_(0)
+        {
+            RandomNumberGenerator rng(SEED);
+            int length = w.Template.length();
+            for (int k = 0; k < N_MUTATIONS; k++)
+            {
+                int pos = 5 + (k * 7919) % (length - 10);
+                mutations_.push_back(Mutation(SUBSTITUTION, pos, rng.RandomBase()));
+            }
+        }
+        ~ScoreMutationBenchmark() { delete mms_; }
+        const char* Name() const { return "ScoreMutation"; }
+        double CellsPerOp() const { return Workload::Cells(*mms_); }
+
+        void Run()
+        {
+            mms_->Score(mutations_[next_]);
+            next_ = (next_ + 1) % N_MUTATIONS;
+        }
+
+    private:
+        const Workload& w_;
+        MultiReadMutationScorer<SparseSseQvRecursor>* mms_;
+        std::vector<Mutation> mutations_;
+        int next_;
+    };
+
+    // An op is a full refinement, starting from the POA consensus.
+    class RefineConsensusBenchmark : public Benchmark
+    {
+    public:
+        RefineConsensusBenchmark(const Workload& w, const QuiverConfigTable& configs)
+            : w_(w)
+            , configs_(configs)
+            , mms_(NULL)
+        {}
+        ~RefineConsensusBenchmark() { delete mms_; }
+        const char* Name() const { return "RefineConsensus"; }
+        double CellsPerOp() const { return Workload::Cells(*mms_); }
+
+        void Setup()
+        {
+            delete mms_;
+            mms_ = w_.Scorer(configs_, w_.PoaTemplate);
+        }
+
+        void Run()
+        {
+            RefineConsensus(*mms_);
+        }
+
+    private:
+        const Workload& w_;
+        const QuiverConfigTable& configs_;
+        MultiReadMutationScorer<SparseSseQvRecursor>* mms_;
+    };
+
+    class ConsensusQVsBenchmark : public Benchmark
+    {
+    public:
+        ConsensusQVsBenchmark(const Workload& w, const QuiverConfigTable& configs)
+            : w_(w)
+            , mms_(w.Scorer(configs, w.PoaTemplate))
+        {
+            RefineConsensus(*mms_);
+        }
+        ~ConsensusQVsBenchmark() { delete mms_; }
+        const char* Name() const { return "ConsensusQVs"; }
+        double CellsPerOp() const { return Workload::Cells(*mms_); }
+
+        void Run()
+        {
+            ConsensusQVs(*mms_);
+        }
+
+    private:
+        const Workload& w_;
+        MultiReadMutationScorer<SparseSseQvRecursor>* mms_;
+    };
+
+    class PoaConsensusBenchmark : public Benchmark
+    {
+    public:
+        explicit PoaConsensusBenchmark(const Workload& w)
+            : w_(w)
+        {}
+        const char* Name() const { return "PoaConsensus"; }
+        double CellsPerOp() const { return w_.Cells(w_.Template); }
+
+        void Run()
+        {
+            delete PoaConsensus::FindConsensus(w_.Reads);
+        }
+
+    private:
+        const Workload& w_;
+    };
+
+    // Repeat the benchmark until it has run for MIN_TIME_SEC (counting
+    // only the timed part), and report it as one JSON record.
+    void RunBenchmark(Benchmark& b, int templateLength, int coverage, FILE* out, bool first)
+    {
+        double elapsed = 0;
+        int iterations = 0;
+        while (elapsed < MIN_TIME_SEC && iterations < MAX_ITERATIONS)
+        {
+            b.Setup();
+            double start = Now();
+            b.Run();
+            elapsed += Now() - start;
+            iterations++;
+        }
+        double nsPerOp = 1e9 * elapsed / iterations;
+        double cells = b.CellsPerOp();
+        fprintf(out,
+                "%s    {\"name\": \"%s/%d/%d\", \"template_length\": %d, \"coverage\": %d,"
+                " \"iterations\": %d, \"ns_per_op\": %.1f, \"cells_per_op\": %.0f,"
+                " \"ns_per_cell\": %.4f, \"cells_per_sec\": %.4g, \"peak_rss_kb\": %ld}",
+                first ? "" : ",\n", b.Name(), templateLength, coverage,
+                templateLength, coverage, iterations, nsPerOp, cells, nsPerOp / cells, 1e9 * cells / nsPerOp,
+                PeakRssKb());
+        fflush(out);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    FILE* out = stdout;
+    if (argc > 1 && (out = fopen(argv[1], "w")) == NULL)
+    {
+        fprintf(stderr, "Cannot open %s\n", argv[1]);
+        return 1;
+    }
+
+    QuiverConfigTable configs = BenchmarkConfig();
+    fprintf(out, "{\n  \"context\": {\"seed\": %d, \"min_time_sec\": %g},\n"
+            "  \"benchmarks\": [\n", SEED, MIN_TIME_SEC);
+    bool first = true;
+    foreach (int templateLength, TemplateLengths)
+    {
+        foreach (int coverage, Coverages)
+        {
+            Workload w(templateLength, coverage);
+            std::vector<Benchmark*> benchmarks;
+            benchmarks.push_back(new FillAlphaBetaBenchmark(w, configs));
+            benchmarks.push_back(new ScoreMutationBenchmark(w, configs));
+            benchmarks.push_back(new RefineConsensusBenchmark(w, configs));
+            benchmarks.push_back(new ConsensusQVsBenchmark(w, configs));
+            benchmarks.push_back(new PoaConsensusBenchmark(w));
+            foreach (Benchmark* b, benchmarks)
+            {
+                RunBenchmark(*b, templateLength, coverage, out, first);
+                first = false;
+                delete b;
+            }
+        }
+    }
+    fprintf(out, "\n  ]\n}\n");
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    return 0;
+}
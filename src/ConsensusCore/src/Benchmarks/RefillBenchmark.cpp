@@ -0,0 +1,148 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Cost of refilling a read's alpha and beta matrices after a few template
+// edits: from scratch (FillAlphaBeta), versus incrementally
+// (MutationScorer::Template).  Build and run with "make bench".
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+#include "Features.hpp"
+#include "Matrix/SparseMatrix.hpp"
+#include "Mutation.hpp"
+#include "Quiver/MutationScorer.hpp"
+#include "Quiver/QuiverConfig.hpp"
+#include "Quiver/QvEvaluator.hpp"
+#include "Quiver/SseRecursor.hpp"
+#include "Read.hpp"
+
+using namespace ConsensusCore; // NOLINT
+
+#define TEMPLATE_LENGTH  3000
+#define N_MUTATIONS      4
+#define N_ROUNDS         20
+
+namespace {
+
+    double Now()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + 1e-9 * ts.tv_nsec;
+    }
+
+    char RandomBase()
+    {
+        return "ACGT"[rand() % 4];
+    }
+
+    // A noisy copy of tpl: roughly 5% each substitutions, insertions and
+    // deletions.
+    std::string NoisyCopy(const std::string& tpl)
+    {
+        std::string read;
+        for (unsigned int j = 0; j < tpl.length(); j++)
+        {
+            int r = rand() % 100;
+            if (r < 5) { read += RandomBase(); }
+            else if (r < 10) { read += tpl[j]; read += RandomBase(); }
+            else if (r < 15) { }
+            else { read += tpl[j]; }
+        }
+        return read;
+    }
+}
+
+int main()
+{
+    srand(42);
+    std::string tpl;
+    for (int j = 0; j < TEMPLATE_LENGTH; j++)
+    {
+        tpl += RandomBase();
+    }
+    Read read(QvSequenceFeatures(NoisyCopy(tpl)), "bench", "unknown");
+    QvModelParams params(0.f, -10.f, -0.1f, -5.f, -0.1f, -6.f, -7.f,
+                         -0.1f, -8.f, -0.1f, -2.f, 0.f);
+    SparseSseQvRecursor recursor(ALL_MOVES, BandingOptions(4, 18));
+    QvEvaluator ev(read, tpl, params);
+    MutationScorer<SparseSseQvRecursor> scorer(ev, recursor);
+
+    // Each round edits a few well-separated sites near the middle of the
+    // template, as a late round of refinement would.
+    std::vector<std::string> templates;
+    for (int r = 0; r < N_ROUNDS; r++)
+    {
+        std::vector<Mutation> muts;
+        for (int k = 0; k < N_MUTATIONS; k++)
+        {
+            int pos = TEMPLATE_LENGTH / 3 + k * 97 + r;
+            muts.push_back(Mutation(SUBSTITUTION, pos, RandomBase()));
+        }
+        templates.push_back(ApplyMutations(muts, tpl));
+    }
+
+    double start = Now();
+    float fullScore = 0;
+    for (int r = 0; r < N_ROUNDS; r++)
+    {
+        QvEvaluator e(read, templates[r], params);
+        SparseMatrix alpha(e.ReadLength() + 1, e.TemplateLength() + 1);
+        SparseMatrix beta(e.ReadLength() + 1, e.TemplateLength() + 1);
+        recursor.FillAlphaBeta(e, alpha, beta);
+        fullScore += beta(0, 0);
+    }
+    double full = (Now() - start) / N_ROUNDS;
+
+    start = Now();
+    float incrementalScore = 0;
+    for (int r = 0; r < N_ROUNDS; r++)
+    {
+        scorer.Template(templates[r]);
+        incrementalScore += scorer.Score();
+    }
+    double incremental = (Now() - start) / N_ROUNDS;
+
+    printf("refill from scratch:  %8.3f ms/round\n", 1e3 * full);
+    printf("incremental refill:   %8.3f ms/round  (%.2fx)\n",
+           1e3 * incremental, full / incremental);
+    printf("(score difference %g)\n", fullScore - incrementalScore);
+    return 0;
+}
@@ -0,0 +1,166 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+
+// Cost of the sum-product recursion in probability space (ScaledRecursor)
+// against the log-space SSE sum-product and Viterbi recursors: filling a
+// read's alpha and beta matrices, and then scoring substitutions along it
+// by extending alpha and linking to beta, as MutationScorer does.  Build
+// and run with "make bench".
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <string>
+
+#include "Features.hpp"
+#include "Matrix/SparseMatrix.hpp"
+#include "Mutation.hpp"
+#include "Quiver/QuiverConfig.hpp"
+#include "Quiver/QvEvaluator.hpp"
+#include "Quiver/ScaledRecursor.hpp"
+#include "Quiver/SseRecursor.hpp"
+#include "Read.hpp"
+
+using namespace ConsensusCore; // NOLINT
+
+#define TEMPLATE_LENGTH  2000
+#define N_ROUNDS         5
+#define N_MUTATIONS      200
+
+namespace {
+
+    double Now()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + 1e-9 * ts.tv_nsec;
+    }
+
+    char RandomBase()
+    {
+        return "ACGT"[rand() % 4];
+    }
+
+    // A noisy copy of tpl, with errorRate percent each of substitutions,
+    // insertions and deletions
+    std::string NoisyCopy(const std::string& tpl, int errorRate)
+    {
+        std::string read;
+        for (unsigned int j = 0; j < tpl.length(); j++)
+        {
+            int r = rand() % 100;
+            if (r < errorRate) { read += RandomBase(); }
+            else if (r < 2 * errorRate) { read += tpl[j]; read += RandomBase(); }
+            else if (r < 3 * errorRate) { }
+            else { read += tpl[j]; }
+        }
+        return read;
+    }
+
+    // Milliseconds per fill of alpha and then beta, and per N_MUTATIONS
+    // substitutions scored against them; the score of the read is left
+    // in *score
+    template<typename R>
+    void Time(const R& recursor, const QvEvaluator& e,
+              double* fillTime, double* scoreTime, float* score)
+    {
+        SparseMatrix alpha(e.ReadLength() + 1, e.TemplateLength() + 1);
+        SparseMatrix beta(e.ReadLength() + 1, e.TemplateLength() + 1);
+
+        double start = Now();
+        for (int r = 0; r < N_ROUNDS; r++)
+        {
+            recursor.FillAlpha(e, SparseMatrix::Null(), alpha);
+            recursor.FillBeta(e, alpha, beta);
+        }
+        *fillTime = 1e3 * (Now() - start) / N_ROUNDS;
+        *score = beta(0, 0);
+
+        SparseMatrix ext(e.ReadLength() + 1, 2);
+        int step = (e.TemplateLength() - 4) / N_MUTATIONS;
+        start = Now();
+        for (int r = 0; r < N_ROUNDS; r++)
+        {
+            for (int j = 2; j < e.TemplateLength() - 2; j += step)
+            {
+                QvEvaluator mutated = e;
+                mutated.ApplyMutation(Mutation(SUBSTITUTION, j, 'A'));
+                recursor.ExtendAlpha(mutated, alpha, j, ext);
+                recursor.LinkAlphaBeta(mutated, ext, 2, beta, j + 2, j + 2);
+            }
+        }
+        *scoreTime = 1e3 * (Now() - start) / N_ROUNDS;
+    }
+}
+
+int main()
+{
+    srand(42);
+    std::string tpl;
+    for (int j = 0; j < TEMPLATE_LENGTH; j++)
+    {
+        tpl += RandomBase();
+    }
+    QvModelParams params(0.f, -10.f, -0.1f, -5.f, -0.1f, -6.f, -7.f,
+                         -0.1f, -8.f, -0.1f, -2.f, 0.f);
+
+    const int errorRates[] = { 2, 5 };
+    const float scoreDiffs[] = { 12, 25, 50 };
+    for (int k = 0; k < 2; k++)
+    {
+        Read read(QvSequenceFeatures(NoisyCopy(tpl, errorRates[k])), "bench", "unknown");
+        QvEvaluator e(read, tpl, params);
+        for (int d = 0; d < 3; d++)
+        {
+            BandingOptions banding(4, scoreDiffs[d]);
+            double fill[3], scoring[3];
+            float score[3];
+            Time(SparseSseQvRecursor(ALL_MOVES, banding), e, &fill[0], &scoring[0], &score[0]);
+            Time(SparseSseQvSumProductRecursor(ALL_MOVES, banding), e, &fill[1], &scoring[1], &score[1]);
+            Time(SparseScaledQvSumProductRecursor(ALL_MOVES, banding), e, &fill[2], &scoring[2], &score[2]);
+            printf("%2d%% errors, score diff %4.1f:  fill  viterbi %7.3f  sum-product %7.3f"
+                   "  scaled %7.3f ms  (%.2fx)\n",
+                   3 * errorRates[k], scoreDiffs[d], fill[0], fill[1], fill[2],
+                   fill[1] / fill[2]);
+            printf("%29s score viterbi %7.3f  sum-product %7.3f  scaled %7.3f ms  (%.2fx)"
+                   "  log-likelihood %.3f vs %.3f\n",
+                   "", scoring[0], scoring[1], scoring[2], scoring[1] / scoring[2],
+                   score[1], score[2]);
+        }
+    }
+    return 0;
+}
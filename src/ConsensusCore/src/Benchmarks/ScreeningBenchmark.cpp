@@ -0,0 +1,138 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+
+// Cost of FastIsFavorable on a sum-product MultiReadMutationScorer over the
+// single-base candidates of a stretch of template, as RefineConsensus
+// screens them, with and without screening on Viterbi matrices first.
+// Build and run with "make bench".
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+#include "Features.hpp"
+#include "Mutation.hpp"
+#include "Quiver/MultiReadMutationScorer.hpp"
+#include "Quiver/MutationEnumerator.hpp"
+#include "Quiver/QuiverConfig.hpp"
+#include "Read.hpp"
+
+using namespace ConsensusCore; // NOLINT
+
+#define TEMPLATE_LENGTH  1000
+#define N_READS          20
+#define N_POSITIONS      100
+
+namespace {
+
+    double Now()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + 1e-9 * ts.tv_nsec;
+    }
+
+    char RandomBase()
+    {
+        return "ACGT"[rand() % 4];
+    }
+
+    // A noisy copy of tpl: roughly 5% each substitutions, insertions and
+    // deletions.
+    std::string NoisyCopy(const std::string& tpl)
+    {
+        std::string read;
+        for (unsigned int j = 0; j < tpl.length(); j++)
+        {
+            int r = rand() % 100;
+            if (r < 5) { read += RandomBase(); }
+            else if (r < 10) { read += tpl[j]; read += RandomBase(); }
+            else if (r < 15) { }
+            else { read += tpl[j]; }
+        }
+        return read;
+    }
+}
+
+int main()
+{
+    srand(42);
+    std::string tpl;
+    for (int j = 0; j < TEMPLATE_LENGTH; j++)
+    {
+        tpl += RandomBase();
+    }
+    QvModelParams params(0.f, -10.f, -0.1f, -5.f, -0.1f, -6.f, -7.f,
+                         -0.1f, -8.f, -0.1f, -2.f, 0.f);
+    QuiverConfigTable configs;
+    configs.Insert("unknown", QuiverConfig(params, ALL_MOVES, BandingOptions(4, 18), -12.5f));
+
+    SparseSseQvSumProductMultiReadMutationScorer exact(configs, tpl);
+    SparseSseQvSumProductMultiReadMutationScorer screened(configs, tpl);
+    screened.Screening(true);
+    for (int n = 0; n < N_READS; n++)
+    {
+        Read read(QvSequenceFeatures(NoisyCopy(tpl)), "bench", "unknown");
+        MappedRead mr(read, FORWARD_STRAND, 0, TEMPLATE_LENGTH);
+        exact.AddRead(mr);
+        screened.AddRead(mr);
+    }
+
+    int begin = (TEMPLATE_LENGTH - N_POSITIONS) / 2;
+    std::vector<Mutation> muts =
+        UniqueSingleBaseMutationEnumerator(tpl).Mutations(begin, begin + N_POSITIONS);
+
+    double start = Now();
+    int nExact = 0;
+    foreach (const Mutation& m, muts) nExact += exact.FastIsFavorable(m);
+    double exactTime = (Now() - start) / muts.size();
+
+    screened.ResetCounters();
+    start = Now();
+    int nScreened = 0;
+    foreach (const Mutation& m, muts) nScreened += screened.FastIsFavorable(m);
+    double screenedTime = (Now() - start) / muts.size();
+
+    ScorerCounters counters = screened.Counters();
+    printf("%d candidates:  exact %8.1f us  screened %8.1f us (%5.2fx)"
+           "  [%d rejected unscored; %d vs %d favorable]\n",
+           (int)muts.size(), 1e6 * exactTime, 1e6 * screenedTime, exactTime / screenedTime,
+           counters.MutationsScreenedOut, nExact, nScreened);
+    return 0;
+}
@@ -0,0 +1,147 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Throughput of MultiReadMutationScorer::Score, ScoreMutations (batched)
+// and FastIsFavorable over a pile of reads, by number of scoring threads.  Build and run with
+// "make bench".
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "Features.hpp"
+#include "Mutation.hpp"
+#include "Quiver/MultiReadMutationScorer.hpp"
+#include "Quiver/QuiverConfig.hpp"
+#include "Quiver/detail/ThreadPool.hpp"
+#include "Read.hpp"
+
+using namespace ConsensusCore; // NOLINT
+
+#define TEMPLATE_LENGTH  1000
+#define N_READS          40
+#define N_MUTATIONS      200
+
+namespace {
+
+    double Now()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + 1e-9 * ts.tv_nsec;
+    }
+
+    char RandomBase()
+    {
+        return "ACGT"[rand() % 4];
+    }
+
+    // A noisy copy of tpl: roughly 5% each substitutions, insertions and
+    // deletions.
+    std::string NoisyCopy(const std::string& tpl)
+    {
+        std::string read;
+        for (unsigned int j = 0; j < tpl.length(); j++)
+        {
+            int r = rand() % 100;
+            if (r < 5) { read += RandomBase(); }
+            else if (r < 10) { read += tpl[j]; read += RandomBase(); }
+            else if (r < 15) { }
+            else { read += tpl[j]; }
+        }
+        return read;
+    }
+}
+
+int main()
+{
+    srand(42);
+    std::string tpl;
+    for (int j = 0; j < TEMPLATE_LENGTH; j++)
+    {
+        tpl += RandomBase();
+    }
+    QvModelParams params(0.f, -10.f, -0.1f, -5.f, -0.1f, -6.f, -7.f,
+                         -0.1f, -8.f, -0.1f, -2.f, 0.f);
+    QuiverConfigTable configs;
+    configs.Insert("unknown", QuiverConfig(params, ALL_MOVES, BandingOptions(4, 18), -12.5f));
+
+    SparseSseQvMultiReadMutationScorer mms(configs, tpl);
+    for (int n = 0; n < N_READS; n++)
+    {
+        Read read(QvSequenceFeatures(NoisyCopy(tpl)), "bench", "unknown");
+        mms.AddRead(MappedRead(read, FORWARD_STRAND, 0, TEMPLATE_LENGTH));
+    }
+
+    std::vector<Mutation> muts;
+    for (int k = 0; k < N_MUTATIONS; k++)
+    {
+        int pos = 5 + rand() % (TEMPLATE_LENGTH - 10);
+        muts.push_back(Mutation(SUBSTITUTION, pos, RandomBase()));
+    }
+
+    int maxThreads = std::max(4, detail::ThreadPool::HardwareConcurrency());
+    double serialScore = 0, serialBatched = 0, serialFast = 0;
+    for (int numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+    {
+        mms.NumThreads(numThreads);
+
+        double start = Now();
+        float total = 0;
+        foreach (const Mutation& m, muts) total += mms.Score(m);
+        double score = (Now() - start) / N_MUTATIONS;
+
+        start = Now();
+        std::vector<float> batch = mms.ScoreMutations(muts);
+        double batched = (Now() - start) / N_MUTATIONS;
+
+        start = Now();
+        int nFavorable = 0;
+        foreach (const Mutation& m, muts) nFavorable += mms.FastIsFavorable(m);
+        double fast = (Now() - start) / N_MUTATIONS;
+
+        if (numThreads == 1) { serialScore = score; serialBatched = batched; serialFast = fast; }
+        printf("%2d threads:  Score %8.1f us (%5.2fx)  ScoreMutations %8.1f us (%5.2fx)"
+               "  FastIsFavorable %8.1f us (%5.2fx)  [sum %g, %d favorable]\n",
+               numThreads, 1e6 * score, serialScore / score,
+               1e6 * batched, serialBatched / batched,
+               1e6 * fast, serialFast / fast, total, nFavorable);
+    }
+    return 0;
+}
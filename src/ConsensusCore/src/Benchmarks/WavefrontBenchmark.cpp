@@ -0,0 +1,149 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Cost of filling a read's alpha and beta matrices with the column-wise
+// SSE recursor and with the anti-diagonal (wavefront) one, across band
+// widths and read accuracies.  Build and run with "make bench".
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <string>
+
+#include "Features.hpp"
+#include "Matrix/SparseMatrix.hpp"
+#include "Quiver/QuiverConfig.hpp"
+#include "Quiver/QvEvaluator.hpp"
+#include "Quiver/SseRecursor.hpp"
+#include "Quiver/WavefrontRecursor.hpp"
+#include "Read.hpp"
+
+using namespace ConsensusCore; // NOLINT
+
+#define TEMPLATE_LENGTH  2000
+#define N_ROUNDS         5
+
+namespace {
+
+    double Now()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + 1e-9 * ts.tv_nsec;
+    }
+
+    char RandomBase()
+    {
+        return "ACGT"[rand() % 4];
+    }
+
+    // A noisy copy of tpl, with errorRate percent each of substitutions,
+    // insertions and deletions
+    std::string NoisyCopy(const std::string& tpl, int errorRate)
+    {
+        std::string read;
+        for (unsigned int j = 0; j < tpl.length(); j++)
+        {
+            int r = rand() % 100;
+            if (r < errorRate) { read += RandomBase(); }
+            else if (r < 2 * errorRate) { read += tpl[j]; read += RandomBase(); }
+            else if (r < 3 * errorRate) { }
+            else { read += tpl[j]; }
+        }
+        return read;
+    }
+
+    // Milliseconds per fill of alpha and then beta (guided by alpha),
+    // and the cells filled
+    template<typename R>
+    double TimeFill(const R& recursor, const QvEvaluator& e, double* cells)
+    {
+        double start = Now();
+        for (int r = 0; r < N_ROUNDS; r++)
+        {
+            SparseMatrix alpha(e.ReadLength() + 1, e.TemplateLength() + 1);
+            SparseMatrix beta(e.ReadLength() + 1, e.TemplateLength() + 1);
+            recursor.FillAlpha(e, SparseMatrix::Null(), alpha);
+            recursor.FillBeta(e, alpha, beta);
+            *cells = alpha.UsedEntries() + beta.UsedEntries();
+        }
+        return 1e3 * (Now() - start) / N_ROUNDS;
+    }
+
+    template<typename SseType, typename WavefrontType>
+    void Compare(const char* name, const QvEvaluator& e, int errorRate)
+    {
+        const float scoreDiffs[] = { 12, 25, 50, 100, 200 };
+        for (int k = 0; k < 5; k++)
+        {
+            BandingOptions banding(4, scoreDiffs[k]);
+            SseType sse(ALL_MOVES, banding);
+            WavefrontType wavefront(ALL_MOVES, banding);
+            double sseCells, wavefrontCells;
+            double sseTime = TimeFill(sse, e, &sseCells);
+            double wavefrontTime = TimeFill(wavefront, e, &wavefrontCells);
+            printf("%-12s %2d%% errors, score diff %5.1f:  sse %8.3f ms (%6.0f cells/col)"
+                   "  wavefront %8.3f ms (%6.0f cells/col)  %.2fx\n",
+                   name, 3 * errorRate, scoreDiffs[k],
+                   sseTime, sseCells / (2 * (e.TemplateLength() + 1)),
+                   wavefrontTime, wavefrontCells / (2 * (e.TemplateLength() + 1)),
+                   sseTime / wavefrontTime);
+        }
+    }
+}
+
+int main()
+{
+    srand(42);
+    std::string tpl;
+    for (int j = 0; j < TEMPLATE_LENGTH; j++)
+    {
+        tpl += RandomBase();
+    }
+    QvModelParams params(0.f, -10.f, -0.1f, -5.f, -0.1f, -6.f, -7.f,
+                         -0.1f, -8.f, -0.1f, -2.f, 0.f);
+
+    const int errorRates[] = { 2, 5 };
+    for (int k = 0; k < 2; k++)
+    {
+        Read read(QvSequenceFeatures(NoisyCopy(tpl, errorRates[k])), "bench", "unknown");
+        QvEvaluator e(read, tpl, params);
+        Compare<SparseSseQvRecursor, SparseWavefrontQvRecursor>("viterbi", e, errorRates[k]);
+        Compare<SparseSseQvSumProductRecursor,
+                SparseWavefrontQvSumProductRecursor>("sum-product", e, errorRates[k]);
+    }
+    return 0;
+}
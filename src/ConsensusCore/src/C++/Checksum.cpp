@@ -48,13 +48,15 @@ namespace ConsensusCore {
         boost::crc_32_type summer;
 
         int len = x.Length();
-        summer.process_bytes(x.Sequence().get()      ,  len * sizeof(char));
-        summer.process_bytes(x.SequenceAsFloat.get() ,  len * sizeof(float));
-        summer.process_bytes(x.InsQv.get()           ,  len * sizeof(float));
-        summer.process_bytes(x.SubsQv.get()          ,  len * sizeof(float));
-        summer.process_bytes(x.DelQv.get()           ,  len * sizeof(float));
-        summer.process_bytes(x.DelTag.get()          ,  len * sizeof(float));
-        summer.process_bytes(x.MergeQv.get()         ,  len * sizeof(float));
+        summer.process_bytes(x.Sequence().get(), len * sizeof(char));
+        for (int i = 0; i < len; i++)
+        {
+            summer.process_byte(x.InsQv(i));
+            summer.process_byte(x.SubsQv(i));
+            summer.process_byte(x.DelQv(i));
+            summer.process_byte(x.DelTag(i));
+            summer.process_byte(x.MergeQv(i));
+        }
 
         int checksum = summer.checksum();
 
@@ -37,6 +37,7 @@
 
 #pragma once
 
+#include <immintrin.h>
 #include <xmmintrin.h>
 #include <pmmintrin.h>
 
@@ -51,6 +52,8 @@
 #include <vector>
 
 #include "Features.hpp"
+#include "Mutation.hpp"
+#include "Quiver/detail/TemplateView.hpp"
 #include "Read.hpp"
 #include "LFloat.hpp"
 #include "Types.hpp"
@@ -101,12 +104,24 @@ namespace ConsensusCore
 
         std::string Template() const
         {
-            return tpl_;
+            return tpl_.str();
         }
 
         void Template(std::string tpl)
         {
-            tpl_ = tpl;
+            tpl_.Reset(tpl);
+        }
+
+        /// \brief Evaluate against the template with m applied, until
+        ///        UndoMutation; the template itself is not copied.
+        void ApplyMutation(const Mutation& m)
+        {
+            tpl_.Patch(m.Start(), m.End(), m.IsDeletion() ? std::string() : m.NewBases());
+        }
+
+        void UndoMutation()
+        {
+            tpl_.Unpatch();
         }
 
         int ReadLength() const
@@ -314,6 +329,65 @@ namespace ConsensusCore
             return res;
         }
 
+#ifndef SWIG
+        TARGET_AVX2 __m256 Inc8(int i, int j) const
+        {
+            float res[8];
+            for (int k = 0; k < 8; k++) { res[k] = Inc(i + k, j); }
+            return _mm256_loadu_ps(res);
+        }
+
+        TARGET_AVX2 __m256 Del8(int i, int j) const
+        {
+            float res[8];
+            for (int k = 0; k < 8; k++) { res[k] = Del(i + k, j); }
+            return _mm256_loadu_ps(res);
+        }
+
+        TARGET_AVX2 __m256 Extra8(int i, int j) const
+        {
+            float res[8];
+            for (int k = 0; k < 8; k++) { res[k] = Extra(i + k, j); }
+            return _mm256_loadu_ps(res);
+        }
+
+        TARGET_AVX2 __m256 Merge8(int i, int j) const
+        {
+            float res[8];
+            for (int k = 0; k < 8; k++) { res[k] = Merge(i + k, j); }
+            return _mm256_loadu_ps(res);
+        }
+
+        TARGET_AVX512 __m512 Inc16(int i, int j) const
+        {
+            float res[16];
+            for (int k = 0; k < 16; k++) { res[k] = Inc(i + k, j); }
+            return _mm512_loadu_ps(res);
+        }
+
+        TARGET_AVX512 __m512 Del16(int i, int j) const
+        {
+            float res[16];
+            for (int k = 0; k < 16; k++) { res[k] = Del(i + k, j); }
+            return _mm512_loadu_ps(res);
+        }
+
+        TARGET_AVX512 __m512 Extra16(int i, int j) const
+        {
+            float res[16];
+            for (int k = 0; k < 16; k++) { res[k] = Extra(i + k, j); }
+            return _mm512_loadu_ps(res);
+        }
+
+        TARGET_AVX512 __m512 Merge16(int i, int j) const
+        {
+            float res[16];
+            for (int k = 0; k < 16; k++) { res[k] = Merge(i + k, j); }
+            return _mm512_loadu_ps(res);
+        }
+
+#endif  // SWIG
+
         __m128 Burst4(int i, int j, int hpLength) const
         {
             NotYetImplemented();
@@ -323,7 +397,7 @@ namespace ConsensusCore
     protected:
         ChannelSequenceFeatures features_;
         EdnaModelParams params_;
-        std::string tpl_;
+        detail::TemplateView tpl_;
         Feature<int> channelTpl_;
         bool pinStart_;
         bool pinEnd_;
@@ -85,6 +85,19 @@ namespace ConsensusCore
             assert(length >= 0);
         }
 
+#ifndef SWIG
+        // \brief A feature viewing length elements at ptr, which lie
+        // inside a block owned by owner; the block lives as long as any
+        // feature viewing it.
+        template <typename U>
+        Feature(const boost::shared_array<U>& owner, T* ptr, int length)
+            : boost::shared_array<T>(owner, ptr),
+              length_(length)
+        {
+            assert(length >= 0);
+        }
+#endif  // !SWIG
+
         int Length() const
         {
             return length_;
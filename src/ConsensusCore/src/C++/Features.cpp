@@ -46,16 +46,35 @@
 #include "Utils.hpp"
 
 
+// QvSequenceFeatures keeps its sequence and QV channels in one block,
+// in this order, each channel starting on a cache line
+#define QV_FEATURE_ALIGNMENT 64
+#define SEQUENCE_CHANNEL     0
+#define INS_QV_CHANNEL       1
+#define SUBS_QV_CHANNEL      2
+#define DEL_QV_CHANNEL       3
+#define DEL_TAG_CHANNEL      4
+#define MERGE_QV_CHANNEL     5
+#define QV_FEATURE_CHANNELS  6
+
 ConsensusCore::SequenceFeatures::SequenceFeatures(const std::string& seq)
     : sequence_(seq.c_str(), seq.length())
 {}
 
+ConsensusCore::SequenceFeatures::SequenceFeatures(const Feature<char>& sequence)
+    : sequence_(sequence)
+{}
+
 namespace
 {
-    void CheckTagFeature(ConsensusCore::Feature<float> feature)
+    using ConsensusCore::Feature;
+
+    template<typename T>
+    void CheckTagFeature(const T* tags, int length)
     {
-        foreach (const float& tag, feature)
+        for (int i = 0; i < length; i++)
         {
+            T tag = tags[i];
             if (!(tag == 'A' ||
                   tag == 'C' ||
                   tag == 'G' ||
@@ -68,23 +87,72 @@ namespace
             }
         }
     }
+
+    int ChannelStride(int length)
+    {
+        return (length + QV_FEATURE_ALIGNMENT - 1) / QV_FEATURE_ALIGNMENT * QV_FEATURE_ALIGNMENT;
+    }
+
+    // A zero-filled block holding seq in its first channel, viewed as
+    // the sequence feature that owns it
+    Feature<char> AllocateQvBlock(const std::string& seq)
+    {
+        int stride = ChannelStride(seq.length());
+        boost::shared_array<char> block(
+            new char[QV_FEATURE_CHANNELS * stride + QV_FEATURE_ALIGNMENT]());
+        size_t misalignment = reinterpret_cast<size_t>(block.get()) % QV_FEATURE_ALIGNMENT;
+        char* start = block.get() + (QV_FEATURE_ALIGNMENT - misalignment) % QV_FEATURE_ALIGNMENT;
+        std::copy(seq.begin(), seq.end(), start);
+        return Feature<char>(block, start, seq.length());
+    }
+
+    unsigned char* Channel(Feature<char> sequence, int channel)
+    {
+        return reinterpret_cast<unsigned char*>(sequence.get()) +
+            channel * ChannelStride(sequence.Length());
+    }
+
+    unsigned char QvByte(float qv)
+    {
+        if (!(qv > 0.0f)) return 0;
+        if (qv >= 255.0f) return 255;
+        return static_cast<unsigned char>(qv + 0.5f);
+    }
+
+    void FillChannel(unsigned char* dest, const float* src, int length)
+    {
+        std::transform(src, src + length, dest, QvByte);
+    }
+
+    void FillChannel(unsigned char* dest, const unsigned char* src, int length)
+    {
+        std::copy(src, src + length, dest);
+    }
+
+    template<typename T>
+    void FillChannels(Feature<char> sequence,
+                      const T* insQv,
+                      const T* subsQv,
+                      const T* delQv,
+                      const T* delTag,
+                      const T* mergeQv)
+    {
+        int length = sequence.Length();
+        CheckTagFeature(delTag, length);
+        FillChannel(Channel(sequence, INS_QV_CHANNEL),   insQv,   length);
+        FillChannel(Channel(sequence, SUBS_QV_CHANNEL),  subsQv,  length);
+        FillChannel(Channel(sequence, DEL_QV_CHANNEL),   delQv,   length);
+        FillChannel(Channel(sequence, DEL_TAG_CHANNEL),  delTag,  length);
+        FillChannel(Channel(sequence, MERGE_QV_CHANNEL), mergeQv, length);
+    }
 }
 
 namespace ConsensusCore
 {
     QvSequenceFeatures::QvSequenceFeatures(const std::string& seq)
-        : SequenceFeatures(seq),
-          SequenceAsFloat(Length()),
-          InsQv (Length()),
-          SubsQv(Length()),
-          DelQv (Length()),
-          DelTag(Length()),
-          MergeQv(Length())
+        : SequenceFeatures(AllocateQvBlock(seq))
     {
-        for (int i = 0; i < Length(); i++)
-        {
-            SequenceAsFloat[i] = static_cast<float>(seq[i]);
-        }
+        LocateChannels();
     }
 
     QvSequenceFeatures::QvSequenceFeatures(const std::string& seq,
@@ -93,19 +161,10 @@ namespace ConsensusCore
                                            const float* delQv,
                                            const float* delTag,
                                            const float* mergeQv)
-        : SequenceFeatures(seq),
-          SequenceAsFloat(Length()),
-          InsQv (insQv, Length()),
-          SubsQv(subsQv, Length()),
-          DelQv (delQv, Length()),
-          DelTag(delTag, Length()),
-          MergeQv(mergeQv, Length())
+        : SequenceFeatures(AllocateQvBlock(seq))
     {
-        for (int i = 0; i < Length(); i++)
-        {
-            SequenceAsFloat[i] = static_cast<float>(seq[i]);
-        }
-        CheckTagFeature(DelTag);
+        FillChannels(Sequence(), insQv, subsQv, delQv, delTag, mergeQv);
+        LocateChannels();
     }
 
 
@@ -115,19 +174,10 @@ namespace ConsensusCore
                                            const unsigned char* delQv,
                                            const unsigned char* delTag,
                                            const unsigned char* mergeQv)
-        : SequenceFeatures(seq),
-          SequenceAsFloat(Length()),
-          InsQv (insQv, Length()),
-          SubsQv(subsQv, Length()),
-          DelQv (delQv, Length()),
-          DelTag(delTag, Length()),
-          MergeQv(mergeQv, Length())
+        : SequenceFeatures(AllocateQvBlock(seq))
     {
-        for (int i = 0; i < Length(); i++)
-        {
-            SequenceAsFloat[i] = static_cast<float>(seq[i]);
-        }
-        CheckTagFeature(DelTag);
+        FillChannels(Sequence(), insQv, subsQv, delQv, delTag, mergeQv);
+        LocateChannels();
     }
 
 
@@ -137,19 +187,20 @@ namespace ConsensusCore
                                            const Feature<float> delQv,
                                            const Feature<float> delTag,
                                            const Feature<float> mergeQv)
-        : SequenceFeatures(seq),
-          SequenceAsFloat(Length()),
-          InsQv (insQv),
-          SubsQv(subsQv),
-          DelQv (delQv),
-          DelTag(delTag),
-          MergeQv(mergeQv)
+        : SequenceFeatures(AllocateQvBlock(seq))
     {
-        for (int i = 0; i < Length(); i++)
-        {
-            SequenceAsFloat[i] = static_cast<float>(seq[i]);
-        }
-        CheckTagFeature(DelTag);
+        FillChannels(Sequence(), insQv.get(), subsQv.get(), delQv.get(),
+                     delTag.get(), mergeQv.get());
+        LocateChannels();
+    }
+
+    void QvSequenceFeatures::LocateChannels()
+    {
+        insQv_   = Channel(Sequence(), INS_QV_CHANNEL);
+        subsQv_  = Channel(Sequence(), SUBS_QV_CHANNEL);
+        delQv_   = Channel(Sequence(), DEL_QV_CHANNEL);
+        delTag_  = Channel(Sequence(), DEL_TAG_CHANNEL);
+        mergeQv_ = Channel(Sequence(), MERGE_QV_CHANNEL);
     }
 
     ChannelSequenceFeatures::ChannelSequenceFeatures(const std::string& seq)
@@ -60,20 +60,26 @@ namespace ConsensusCore
         const char& operator[] (int i) const { return sequence_[i]; }
         char ElementAt(int i) const          { return (*this)[i]; }
 
+    protected:
+        explicit SequenceFeatures(const Feature<char>& sequence);
 
     private:
         Feature<char> sequence_;
     };
 
     /// \brief A features object that contains PulseToBase QV metrics
+    ///
+    /// The sequence and the QV channels share one allocation, each
+    /// channel a cache-line aligned run of bytes.  QVs are stored as
+    /// integers in [0, 255] and DelTags as ASCII; the float constructors
+    /// round and clamp their input to fit.
     struct QvSequenceFeatures : public SequenceFeatures
     {
-        Feature<float> SequenceAsFloat;
-        Feature<float> InsQv;
-        Feature<float> SubsQv;
-        Feature<float> DelQv;
-        Feature<float> DelTag;
-        Feature<float> MergeQv;
+        unsigned char InsQv(int i) const   { return insQv_[i]; }
+        unsigned char SubsQv(int i) const  { return subsQv_[i]; }
+        unsigned char DelQv(int i) const   { return delQv_[i]; }
+        unsigned char DelTag(int i) const  { return delTag_[i]; }
+        unsigned char MergeQv(int i) const { return mergeQv_[i]; }
 
         explicit QvSequenceFeatures(const std::string& seq);
 
@@ -97,6 +103,17 @@ namespace ConsensusCore
                            const unsigned char* delQv,
                            const unsigned char* delTag,
                            const unsigned char* mergeQv);
+
+    private:
+        void LocateChannels();
+
+    private:
+        // Views into the block owned by the sequence
+        const unsigned char* insQv_;
+        const unsigned char* subsQv_;
+        const unsigned char* delQv_;
+        const unsigned char* delTag_;
+        const unsigned char* mergeQv_;
     };
 
 
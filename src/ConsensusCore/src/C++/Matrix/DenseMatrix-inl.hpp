@@ -176,4 +176,34 @@ namespace ConsensusCore {
         assert(0 <= i && i <= Rows() - 4);
         _mm_storeu_ps(&boost_dense_matrix::operator()(i, j).value, v4);
     }
+
+    inline TARGET_AVX2 __m256
+    DenseMatrix::Get8(int i, int j) const
+    {
+        assert(0 <= i && i <= Rows() - 8);
+        return _mm256_loadu_ps(&boost_dense_matrix::operator()(i, j).value);
+    }
+
+    inline TARGET_AVX2 void
+    DenseMatrix::Set8(int i, int j, __m256 v8)
+    {
+        assert(columnBeingEdited_ == j);
+        assert(0 <= i && i <= Rows() - 8);
+        _mm256_storeu_ps(&boost_dense_matrix::operator()(i, j).value, v8);
+    }
+
+    inline TARGET_AVX512 __m512
+    DenseMatrix::Get16(int i, int j) const
+    {
+        assert(0 <= i && i <= Rows() - 16);
+        return _mm512_loadu_ps(&boost_dense_matrix::operator()(i, j).value);
+    }
+
+    inline TARGET_AVX512 void
+    DenseMatrix::Set16(int i, int j, __m512 v16)
+    {
+        assert(columnBeingEdited_ == j);
+        assert(0 <= i && i <= Rows() - 16);
+        _mm512_storeu_ps(&boost_dense_matrix::operator()(i, j).value, v16);
+    }
 }
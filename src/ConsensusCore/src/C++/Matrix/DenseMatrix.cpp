@@ -66,6 +66,40 @@ namespace ConsensusCore {
     DenseMatrix::~DenseMatrix()
     {}
 
+    void
+    DenseMatrix::Reset(int rows, int cols)
+    {
+        assert(columnBeingEdited_ == -1);
+        resize(rows, cols, false);
+        std::fill(data().begin(), data().end(), value_type());
+        usedRanges_.assign(cols, Interval(0, 0));
+    }
+
+    void
+    DenseMatrix::ReplaceColumns(int beginColumn, int endColumn, int numColumns)
+    {
+        assert(columnBeingEdited_ == -1);
+        assert(0 <= beginColumn && beginColumn <= endColumn &&
+               endColumn <= Columns() && numColumns >= 0);
+        int shift = numColumns - (endColumn - beginColumn);
+        boost_dense_matrix m(Rows(), Columns() + shift);
+        std::fill(m.data().begin(), m.data().end(), value_type());
+        for (int j = 0; j < Columns(); j++)
+        {
+            if (beginColumn <= j && j < endColumn) continue;
+            int newJ = (j < beginColumn) ? j : j + shift;
+            for (int i = 0; i < Rows(); i++)
+            {
+                m(i, newJ) = boost_dense_matrix::operator()(i, j);
+            }
+        }
+        boost_dense_matrix::swap(m);
+        usedRanges_.erase(usedRanges_.begin() + beginColumn,
+                          usedRanges_.begin() + endColumn);
+        usedRanges_.insert(usedRanges_.begin() + beginColumn,
+                           numColumns, Interval(0, 0));
+    }
+
     int
     DenseMatrix::UsedEntries() const
     {
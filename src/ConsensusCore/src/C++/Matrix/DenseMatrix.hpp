@@ -37,6 +37,7 @@
 
 #pragma once
 
+#include <immintrin.h>
 #include <xmmintrin.h>
 
 #include <boost/numeric/ublas/matrix.hpp>
@@ -67,6 +68,13 @@ namespace ConsensusCore {
         DenseMatrix(int rows, int cols);
         ~DenseMatrix();
 
+        // Reshape to an empty rows x cols matrix
+        void Reset(int rows, int cols);
+
+        // Replace columns [beginColumn, endColumn) with numColumns empty
+        // columns, shifting those after them
+        void ReplaceColumns(int beginColumn, int endColumn, int numColumns);
+
     public:  // Nullability
         static const DenseMatrix& Null();
         bool IsNull() const;
@@ -104,6 +112,15 @@ namespace ConsensusCore {
         __m128 Get4(int i, int j) const;
         void Set4(int i, int j, __m128 v);
 
+#ifndef SWIG
+    public:  // AVX2 and AVX-512 accessors, for 8 and 16 successive entries;
+             // only callable when the running CPU supports them.
+        TARGET_AVX2   __m256 Get8(int i, int j) const;
+        TARGET_AVX2   void Set8(int i, int j, __m256 v);
+        TARGET_AVX512 __m512 Get16(int i, int j) const;
+        TARGET_AVX512 void Set16(int i, int j, __m512 v);
+#endif
+
     public:
         // Method SWIG clients can use to get a native matrix (e.g. Numpy)
         // mat must be filled as a ROW major matrix
@@ -40,11 +40,25 @@
 #include <algorithm>
 #include <boost/tuple/tuple.hpp>
 #include <cassert>
+#include <cfloat>
 
 #include "Interval.hpp"
 #include "Matrix/SparseMatrix.hpp"
 #include "LFloat.hpp"
 
+#define PADDING  8
+#define LZERO    (-FLT_MAX)
+
+// INT16_STORAGE: an entry is stored as round((v - base) * INT16_SCALE
+// + dither), with INT16_EMPTY standing for LZERO and anything too far
+// below base.  Values up to INT16_RANGE above base are representable.
+#define INT16_SCALE          1024.0f
+#define INT16_STEP           (1.0f / INT16_SCALE)
+#define INT16_MAX_CODE       32767
+#define INT16_EMPTY          (-32768)
+#define INT16_RANGE          ((INT16_MAX_CODE - 1) * INT16_STEP)
+#define INT16_DITHER_PERIOD  17
+
 using std::min;
 using std::max;
 
@@ -80,6 +94,12 @@ namespace ConsensusCore {
         return nCols_;
     }
 
+    inline MatrixStorage
+    SparseMatrix::Storage() const
+    {
+        return storage_;
+    }
+
     //
     // Entry range queries per column
     //
@@ -87,12 +107,29 @@ namespace ConsensusCore {
     SparseMatrix::StartEditingColumn(int j, int hintBegin, int hintEnd)
     {
         assert(columnBeingEdited_ == -1);
+        assert(hintBegin >= 0 && hintBegin <= hintEnd && hintEnd <= nRows_);
         columnBeingEdited_ = j;
-        if (columns_[j] != NULL)
+        int newAllocatedBegin = max(hintBegin - PADDING, 0);
+        int newAllocatedEnd   = min(hintEnd   + PADDING, nRows_);
+        if (newAllocatedEnd - newAllocatedBegin > bands_[j].Capacity)
         {
-            columns_[j]->ResetForRange(hintBegin, hintEnd);
-        } else {
-            columns_[j] = new SparseVector(Rows(), hintBegin, hintEnd);
+            ReserveColumn(j, newAllocatedEnd - newAllocatedBegin);
+        }
+        ColumnBand& band = bands_[j];
+        band.AllocatedBegin = newAllocatedBegin;
+        band.AllocatedEnd   = newAllocatedEnd;
+        if (storage_ == INT16_STORAGE)
+        {
+            band.Base = LZERO;
+            std::fill(slab16_.begin() + band.Offset,
+                      slab16_.begin() + band.Offset + (newAllocatedEnd - newAllocatedBegin),
+                      INT16_EMPTY);
+        }
+        else
+        {
+            std::fill(slab_.begin() + band.Offset,
+                      slab_.begin() + band.Offset + (newAllocatedEnd - newAllocatedBegin),
+                      LZERO);
         }
     }
 
@@ -119,27 +156,39 @@ namespace ConsensusCore {
         return (usedRanges_[j].Begin >= usedRanges_[j].End);
     }
 
+    inline bool
+    SparseMatrix::IsColumnReleased(int j) const
+    {
+        return !IsColumnEmpty(j) && bands_[j].AllocatedBegin == bands_[j].AllocatedEnd;
+    }
+
     //
     // Accessors
     //
-    inline const float&
+    inline float
     SparseMatrix::operator() (int i, int j) const
     {
-        static const float emptyCell = Zero<lfloat>();
-        if (columns_[j] == NULL)
+        if (IsAllocated(i, j))
         {
-            return emptyCell;
+            const ColumnBand& band = bands_[j];
+            if (storage_ == INT16_STORAGE)
+            {
+                return Decode(slab16_[band.Offset + i - band.AllocatedBegin], band.Base);
+            }
+            return slab_[band.Offset + i - band.AllocatedBegin];
         }
         else
         {
-            return (*columns_[j])(i);
+            return Zero<lfloat>();
         }
     }
 
     inline bool
     SparseMatrix::IsAllocated(int i, int j) const
     {
-        return columns_[j] != NULL && columns_[j]->IsAllocated(i);
+        assert(0 <= i && i < nRows_ && 0 <= j && j < nCols_);
+        const ColumnBand& band = bands_[j];
+        return i >= band.AllocatedBegin && i < band.AllocatedEnd;
     }
 
     inline float
@@ -152,30 +201,114 @@ namespace ConsensusCore {
     SparseMatrix::Set(int i, int j, float v)
     {
         assert(columnBeingEdited_ == j);
-        columns_[j]->Set(i, v);
+        if (!IsAllocated(i, j))
+        {
+            const ColumnBand& band = bands_[j];
+            ExpandColumn(j,
+                         max(min(i - PADDING, band.AllocatedBegin), 0),
+                         min(max(i + PADDING, band.AllocatedEnd), nRows_));
+        }
+        if (storage_ == INT16_STORAGE)
+        {
+            SetInt16(i, j, v);
+            return;
+        }
+        const ColumnBand& band = bands_[j];
+        slab_[band.Offset + i - band.AllocatedBegin] = v;
     }
 
     inline void
     SparseMatrix::ClearColumn(int j)
     {
         usedRanges_[j] = Interval(0, 0);
-        columns_[j]->Clear();
+        ColumnBand& band = bands_[j];
+        if (storage_ == INT16_STORAGE)
+        {
+            band.Base = LZERO;
+            std::fill(slab16_.begin() + band.Offset,
+                      slab16_.begin() + band.Offset + (band.AllocatedEnd - band.AllocatedBegin),
+                      INT16_EMPTY);
+        }
+        else
+        {
+            std::fill(slab_.begin() + band.Offset,
+                      slab_.begin() + band.Offset + (band.AllocatedEnd - band.AllocatedBegin),
+                      LZERO);
+        }
         DEBUG_ONLY(CheckInvariants(j);)
     }
 
+    //
+    // INT16_STORAGE encoding
+    //
+    inline const float*
+    SparseMatrix::Dither(int i, int j)
+    {
+        return &int16Dither_[(i + 3 * j) % INT16_DITHER_PERIOD];
+    }
+
+    inline int16_t
+    SparseMatrix::Encode(float v, float base, float dither)
+    {
+        // Round and saturate as the vector conversions in Set4 etc. do
+        int code = _mm_cvtss_si32(_mm_set_ss((v - base) * INT16_SCALE + dither));
+        assert(code <= INT16_MAX_CODE);
+        return static_cast<int16_t>(code < -INT16_MAX_CODE ? INT16_EMPTY : code);
+    }
+
+    inline float
+    SparseMatrix::Decode(int16_t code, float base)
+    {
+        return code == INT16_EMPTY ? LZERO : base + code * INT16_STEP;
+    }
+
+    inline void
+    SparseMatrix::SetInt16(int i, int j, float v)
+    {
+        ColumnBand& band = bands_[j];
+        int16_t& entry = slab16_[band.Offset + i - band.AllocatedBegin];
+        if (band.Base == LZERO || v > band.Base + INT16_RANGE)
+        {
+            // The first finite entry, or one the column has risen too far
+            // to represent; the new base gives it code 0.
+            if (v <= LZERO)
+            {
+                entry = INT16_EMPTY;
+                return;
+            }
+            Rebase(j, v);
+        }
+        entry = Encode(v, band.Base, *Dither(i, j));
+    }
+
     //
     // SSE
     //
     inline __m128
     SparseMatrix::Get4(int i, int j) const
     {
-        if (columns_[j] == NULL)
+        assert(0 <= i && i < nRows_ - 3);
+        const ColumnBand& band = bands_[j];
+        if (i >= band.AllocatedBegin && i < band.AllocatedEnd - 3)
         {
-            return Zero4<lfloat>();
+            if (storage_ == INT16_STORAGE)
+            {
+                __m128i c = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(
+                    &slab16_[band.Offset + i - band.AllocatedBegin]));
+                __m128i c32 = _mm_srai_epi32(_mm_unpacklo_epi16(c, c), 16);
+                __m128 v4 = _mm_add_ps(_mm_set1_ps(band.Base),
+                                       _mm_mul_ps(_mm_cvtepi32_ps(c32),
+                                                  _mm_set1_ps(INT16_STEP)));
+                __m128 empty = _mm_castsi128_ps(
+                    _mm_cmpeq_epi32(c32, _mm_set1_epi32(INT16_EMPTY)));
+                return _mm_or_ps(_mm_and_ps(empty, _mm_set1_ps(LZERO)),
+                                 _mm_andnot_ps(empty, v4));
+            }
+            return _mm_loadu_ps(&slab_[band.Offset + i - band.AllocatedBegin]);
         }
         else
         {
-            return columns_[j]->Get4(i);
+            return _mm_set_ps(Get(i+3, j), Get(i+2, j), Get(i+1, j), Get(i+0, j));
         }
     }
 
@@ -183,6 +316,155 @@ namespace ConsensusCore {
     SparseMatrix::Set4(int i, int j, __m128 v4)
     {
         assert(columnBeingEdited_ == j);
-        columns_[j]->Set4(i, v4);
+        assert(0 <= i && i < nRows_ - 3);
+        const ColumnBand& band = bands_[j];
+        if (i >= band.AllocatedBegin && i < band.AllocatedEnd - 3 &&
+            storage_ == FLOAT_STORAGE)
+        {
+            _mm_storeu_ps(&slab_[band.Offset + i - band.AllocatedBegin], v4);
+        }
+        else if (i >= band.AllocatedBegin && i < band.AllocatedEnd - 3 &&
+                 band.Base != LZERO &&
+                 _mm_movemask_ps(_mm_cmpgt_ps(v4, _mm_set1_ps(band.Base + INT16_RANGE))) == 0)
+        {
+            __m128 x4 = _mm_mul_ps(_mm_sub_ps(v4, _mm_set1_ps(band.Base)),
+                                   _mm_set1_ps(INT16_SCALE));
+            __m128i c32 = _mm_cvtps_epi32(_mm_add_ps(x4, _mm_loadu_ps(Dither(i, j))));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(
+                                 &slab16_[band.Offset + i - band.AllocatedBegin]),
+                             _mm_packs_epi32(c32, c32));
+        }
+        else
+        {
+            float vbuf[4];
+            _mm_storeu_ps(vbuf, v4);
+            Set(i+0, j, vbuf[0]);
+            Set(i+1, j, vbuf[1]);
+            Set(i+2, j, vbuf[2]);
+            Set(i+3, j, vbuf[3]);
+        }
+    }
+
+    inline TARGET_AVX2 __m256
+    SparseMatrix::Get8(int i, int j) const
+    {
+        assert(0 <= i && i < nRows_ - 7);
+        const ColumnBand& band = bands_[j];
+        if (i >= band.AllocatedBegin && i < band.AllocatedEnd - 7)
+        {
+            if (storage_ == INT16_STORAGE)
+            {
+                __m256i c32 = _mm256_cvtepi16_epi32(_mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(
+                        &slab16_[band.Offset + i - band.AllocatedBegin])));
+                __m256 v8 = _mm256_add_ps(_mm256_set1_ps(band.Base),
+                                          _mm256_mul_ps(_mm256_cvtepi32_ps(c32),
+                                                        _mm256_set1_ps(INT16_STEP)));
+                __m256 empty = _mm256_castsi256_ps(
+                    _mm256_cmpeq_epi32(c32, _mm256_set1_epi32(INT16_EMPTY)));
+                return _mm256_blendv_ps(v8, _mm256_set1_ps(LZERO), empty);
+            }
+            return _mm256_loadu_ps(&slab_[band.Offset + i - band.AllocatedBegin]);
+        }
+        else
+        {
+            float vbuf[8];
+            for (int k = 0; k < 8; k++) { vbuf[k] = Get(i+k, j); }
+            return _mm256_loadu_ps(vbuf);
+        }
+    }
+
+    inline TARGET_AVX2 void
+    SparseMatrix::Set8(int i, int j, __m256 v8)
+    {
+        assert(columnBeingEdited_ == j);
+        assert(0 <= i && i < nRows_ - 7);
+        const ColumnBand& band = bands_[j];
+        if (i >= band.AllocatedBegin && i < band.AllocatedEnd - 7 &&
+            storage_ == FLOAT_STORAGE)
+        {
+            _mm256_storeu_ps(&slab_[band.Offset + i - band.AllocatedBegin], v8);
+        }
+        else if (i >= band.AllocatedBegin && i < band.AllocatedEnd - 7 &&
+                 band.Base != LZERO &&
+                 _mm256_movemask_ps(_mm256_cmp_ps(v8, _mm256_set1_ps(band.Base + INT16_RANGE),
+                                                  _CMP_GT_OQ)) == 0)
+        {
+            __m256 x8 = _mm256_mul_ps(_mm256_sub_ps(v8, _mm256_set1_ps(band.Base)),
+                                      _mm256_set1_ps(INT16_SCALE));
+            __m256i c32 = _mm256_cvtps_epi32(_mm256_add_ps(x8, _mm256_loadu_ps(Dither(i, j))));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(
+                                 &slab16_[band.Offset + i - band.AllocatedBegin]),
+                             _mm_packs_epi32(_mm256_castsi256_si128(c32),
+                                             _mm256_extracti128_si256(c32, 1)));
+        }
+        else
+        {
+            float vbuf[8];
+            _mm256_storeu_ps(vbuf, v8);
+            for (int k = 0; k < 8; k++) { Set(i+k, j, vbuf[k]); }
+        }
+    }
+
+    inline TARGET_AVX512 __m512
+    SparseMatrix::Get16(int i, int j) const
+    {
+        assert(0 <= i && i < nRows_ - 15);
+        const ColumnBand& band = bands_[j];
+        if (i >= band.AllocatedBegin && i < band.AllocatedEnd - 15)
+        {
+            if (storage_ == INT16_STORAGE)
+            {
+                // (The zero-masked forms avoid GCC's spurious warnings
+                // about the unmasked ones' undefined source operand.)
+                __m512i c32 = _mm512_maskz_cvtepi16_epi32(0xFFFF, _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(
+                        &slab16_[band.Offset + i - band.AllocatedBegin])));
+                __m512 v16 = _mm512_add_ps(_mm512_set1_ps(band.Base),
+                                           _mm512_mul_ps(_mm512_maskz_cvtepi32_ps(0xFFFF, c32),
+                                                         _mm512_set1_ps(INT16_STEP)));
+                __mmask16 empty = _mm512_cmpeq_epi32_mask(c32, _mm512_set1_epi32(INT16_EMPTY));
+                return _mm512_mask_mov_ps(v16, empty, _mm512_set1_ps(LZERO));
+            }
+            return _mm512_loadu_ps(&slab_[band.Offset + i - band.AllocatedBegin]);
+        }
+        else
+        {
+            float vbuf[16];
+            for (int k = 0; k < 16; k++) { vbuf[k] = Get(i+k, j); }
+            return _mm512_loadu_ps(vbuf);
+        }
+    }
+
+    inline TARGET_AVX512 void
+    SparseMatrix::Set16(int i, int j, __m512 v16)
+    {
+        assert(columnBeingEdited_ == j);
+        assert(0 <= i && i < nRows_ - 15);
+        const ColumnBand& band = bands_[j];
+        if (i >= band.AllocatedBegin && i < band.AllocatedEnd - 15 &&
+            storage_ == FLOAT_STORAGE)
+        {
+            _mm512_storeu_ps(&slab_[band.Offset + i - band.AllocatedBegin], v16);
+        }
+        else if (i >= band.AllocatedBegin && i < band.AllocatedEnd - 15 &&
+                 band.Base != LZERO &&
+                 _mm512_cmp_ps_mask(v16, _mm512_set1_ps(band.Base + INT16_RANGE),
+                                    _CMP_GT_OQ) == 0)
+        {
+            __m512 x16 = _mm512_mul_ps(_mm512_sub_ps(v16, _mm512_set1_ps(band.Base)),
+                                       _mm512_set1_ps(INT16_SCALE));
+            __m512i c32 = _mm512_maskz_cvtps_epi32(
+                0xFFFF, _mm512_add_ps(x16, _mm512_loadu_ps(Dither(i, j))));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(
+                                    &slab16_[band.Offset + i - band.AllocatedBegin]),
+                                _mm512_maskz_cvtsepi32_epi16(0xFFFF, c32));
+        }
+        else
+        {
+            float vbuf[16];
+            _mm512_storeu_ps(vbuf, v16);
+            for (int k = 0; k < 16; k++) { Set(i+k, j, vbuf[k]); }
+        }
     }
 }
@@ -37,50 +37,279 @@
 
 #include <algorithm>
 #include <boost/tuple/tuple.hpp>
+#include <cassert>
+#include <cfloat>
 #include <limits>
 #include <vector>
 
 #include "Matrix/SparseMatrix.hpp"
 
+#define SLAB_GROWTH  2
+
+// Evenly spaced offsets in [-0.5, 0.5), in a scrambled order; the table
+// repeats so that up to 16 consecutive entries can be loaded from any
+// starting point in the period.
+#define DITHER(k)    (((k) + 0.5f) / INT16_DITHER_PERIOD - 0.5f)
+
 namespace ConsensusCore {
+    const float SparseMatrix::int16Dither_[INT16_DITHER_PERIOD + 15] = {
+        DITHER(0),  DITHER(7),  DITHER(14), DITHER(4),  DITHER(11), DITHER(1),
+        DITHER(8),  DITHER(15), DITHER(5),  DITHER(12), DITHER(2),  DITHER(9),
+        DITHER(16), DITHER(6),  DITHER(13), DITHER(3),  DITHER(10),
+        DITHER(0),  DITHER(7),  DITHER(14), DITHER(4),  DITHER(11), DITHER(1),
+        DITHER(8),  DITHER(15), DITHER(5),  DITHER(12), DITHER(2),  DITHER(9),
+        DITHER(16), DITHER(6),  DITHER(13)
+    };
+
     // Performance insensitive routines are not inlined
 
-    SparseMatrix::SparseMatrix(int rows, int cols)
-        : columns_(cols),  nCols_(cols), nRows_(rows), columnBeingEdited_(-1),
-          usedRanges_(cols, Interval(0, 0))
-    {
-        for (int j = 0; j < nCols_; j++)
-        {
-            columns_[j] = NULL;
-        }
-    }
+    SparseMatrix::SparseMatrix(int rows, int cols, MatrixStorage storage)
+        : storage_(storage), slab_(), slab16_(),
+          slabUsed_(0), slabGarbage_(0), nSlabReallocs_(0),
+          bands_(cols), nCols_(cols), nRows_(rows),
+          columnBeingEdited_(-1), usedRanges_(cols, Interval(0, 0))
+    {}
 
     SparseMatrix::SparseMatrix(const SparseMatrix& other)
-        : columns_(other.nCols_),
+        : storage_(other.storage_),
+          slab_(other.slab_),
+          slab16_(other.slab16_),
+          slabUsed_(other.slabUsed_),
+          slabGarbage_(other.slabGarbage_),
+          nSlabReallocs_(0),
+          bands_(other.bands_),
           nCols_(other.nCols_),
           nRows_(other.nRows_),
           columnBeingEdited_(other.columnBeingEdited_),
           usedRanges_(other.usedRanges_)
+    {}
+
+    SparseMatrix::~SparseMatrix()
+    {}
+
+    void
+    SparseMatrix::Reset(int rows, int cols)
+    {
+        assert(columnBeingEdited_ == -1);
+        nRows_ = rows;
+        nCols_ = cols;
+        bands_.assign(cols, ColumnBand());
+        usedRanges_.assign(cols, Interval(0, 0));
+        slabUsed_ = 0;
+        slabGarbage_ = 0;
+    }
+
+    void
+    SparseMatrix::ReplaceColumns(int beginColumn, int endColumn, int numColumns)
+    {
+        assert(columnBeingEdited_ == -1);
+        assert(0 <= beginColumn && beginColumn <= endColumn &&
+               endColumn <= nCols_ && numColumns >= 0);
+        int numRemoved = endColumn - beginColumn;
+        int numReused = min(numRemoved, numColumns);
+        // Hand the bands of removed columns on to new ones, emptied
+        for (int j = beginColumn; j < beginColumn + numReused; j++)
+        {
+            bands_[j].AllocatedBegin = 0;
+            bands_[j].AllocatedEnd = 0;
+        }
+        for (int j = beginColumn + numReused; j < endColumn; j++)
+        {
+            slabGarbage_ += bands_[j].Capacity;
+        }
+        bands_.erase(bands_.begin() + beginColumn + numReused,
+                     bands_.begin() + endColumn);
+        bands_.insert(bands_.begin() + beginColumn + numReused,
+                      numColumns - numReused, ColumnBand());
+        usedRanges_.erase(usedRanges_.begin() + beginColumn,
+                          usedRanges_.begin() + endColumn);
+        usedRanges_.insert(usedRanges_.begin() + beginColumn,
+                           numColumns, Interval(0, 0));
+        nCols_ += numColumns - numRemoved;
+    }
+
+    void
+    SparseMatrix::ReleaseColumn(int j)
     {
+        assert(columnBeingEdited_ == -1);
+        ColumnBand& band = bands_[j];
+        slabGarbage_ += band.Capacity;
+        band.Capacity = 0;
+        band.AllocatedBegin = 0;
+        band.AllocatedEnd = 0;
+    }
+
+    void
+    SparseMatrix::Compact(int reserve)
+    {
+        assert(columnBeingEdited_ == -1 && reserve >= 0);
+        int newSize = slabUsed_ - slabGarbage_ + reserve;
+        if (storage_ == INT16_STORAGE)
+        {
+            slabUsed_ = RepackSlab(slab16_, newSize, static_cast<int16_t>(INT16_EMPTY));
+        }
+        else
+        {
+            slabUsed_ = RepackSlab(slab_, newSize, LZERO);
+        }
+        slabGarbage_ = 0;
+    }
+
+    template<typename T>
+    int
+    SparseMatrix::RepackSlab(std::vector<T>& slab, int newSize, T empty)
+    {
+        std::vector<T> newSlab(newSize, empty);
+        int offset = 0;
         for (int j = 0; j < nCols_; j++)
         {
-            if (other.columns_[j] != NULL)
+            ColumnBand& band = bands_[j];
+            if (band.Capacity > 0)
             {
-                columns_[j] = new SparseVector(*other.columns_[j]);
+                std::copy(slab.begin() + band.Offset,
+                          slab.begin() + band.Offset + band.Capacity,
+                          newSlab.begin() + offset);
+                band.Offset = offset;
+                offset += band.Capacity;
+            }
+        }
+        slab.swap(newSlab);
+        return offset;
+    }
+
+    int
+    SparseMatrix::AllocateBand(int n)
+    {
+        if (slabUsed_ + n > SlabSize())
+        {
+            // Regrow the slab, packing the live bands (in column order)
+            // at its front.  If most of the old slab was garbage this may
+            // just compact it at its present size.
+            int live = slabUsed_ - slabGarbage_;
+            int newSize = max(SLAB_GROWTH * (live + n), SlabSize());
+            if (storage_ == INT16_STORAGE)
+            {
+                slabUsed_ = RepackSlab(slab16_, newSize, static_cast<int16_t>(INT16_EMPTY));
             }
             else
             {
-                columns_[j] = NULL;
+                slabUsed_ = RepackSlab(slab_, newSize, LZERO);
             }
+            slabGarbage_ = 0;
+            nSlabReallocs_++;
         }
+        int offset = slabUsed_;
+        slabUsed_ += n;
+        return offset;
     }
 
-    SparseMatrix::~SparseMatrix()
+    void
+    SparseMatrix::ReserveColumn(int j, int n)
     {
-        for (int j = 0; j < nCols_; j++)
+        ColumnBand& band = bands_[j];
+        assert(n > band.Capacity);
+        if (band.Offset + band.Capacity == slabUsed_ &&
+            band.Offset + n <= SlabSize())
         {
-            if (columns_[j] != NULL) delete columns_[j];
+            // The band is the last in the slab, so can grow in place
+            slabUsed_ = band.Offset + n;
         }
+        else
+        {
+            // Abandon the band before allocating, so that a regrowth
+            // does not carry it over
+            slabGarbage_ += band.Capacity;
+            band.Capacity = 0;
+            band.Offset = AllocateBand(n);
+        }
+        band.Capacity = n;
+    }
+
+    void
+    SparseMatrix::ExpandColumn(int j, int newAllocatedBegin, int newAllocatedEnd)
+    {
+        ColumnBand& band = bands_[j];
+        assert(newAllocatedBegin >= 0                  &&
+               newAllocatedBegin <= newAllocatedEnd    &&
+               newAllocatedEnd   <= nRows_);
+        assert(newAllocatedBegin <= band.AllocatedBegin &&
+               newAllocatedEnd   >= band.AllocatedEnd);
+        int oldLength = band.AllocatedEnd - band.AllocatedBegin;
+        int newLength = newAllocatedEnd - newAllocatedBegin;
+        int shift = band.AllocatedBegin - newAllocatedBegin;
+        int from, to;
+        if (newLength > band.Capacity &&
+            !(band.Offset + band.Capacity == slabUsed_ &&
+              band.Offset + newLength <= SlabSize()))
+        {
+            // Move the contents to a new band at the end of the slab.  The
+            // old band stays live until they have been copied, since
+            // AllocateBand may relocate it.
+            to = AllocateBand(newLength);
+            from = band.Offset;
+            slabGarbage_ += band.Capacity;
+            band.Offset = to;
+            band.Capacity = newLength;
+        }
+        else
+        {
+            // Room enough in (or directly after) the existing band
+            if (newLength > band.Capacity)
+            {
+                slabUsed_ = band.Offset + newLength;
+                band.Capacity = newLength;
+            }
+            from = to = band.Offset;
+        }
+        if (storage_ == INT16_STORAGE)
+        {
+            MoveEntries(slab16_, from, to, oldLength, shift, newLength,
+                        static_cast<int16_t>(INT16_EMPTY));
+        }
+        else
+        {
+            MoveEntries(slab_, from, to, oldLength, shift, newLength, LZERO);
+        }
+        band.AllocatedBegin = newAllocatedBegin;
+        band.AllocatedEnd   = newAllocatedEnd;
+    }
+
+    template<typename T>
+    void
+    SparseMatrix::MoveEntries(std::vector<T>& slab, int from, int to, int n,
+                              int shift, int newLength, T empty)
+    {
+        typename std::vector<T>::iterator data = slab.begin() + to;
+        if (from == to)
+        {
+            std::copy_backward(data, data + n, data + shift + n);
+        }
+        else
+        {
+            std::copy(slab.begin() + from, slab.begin() + from + n, data + shift);
+        }
+        // "Zero"-fill the newly allocated space.
+        std::fill(data, data + shift, empty);
+        std::fill(data + shift + n, data + newLength, empty);
+    }
+
+    int
+    SparseMatrix::SlabSize() const
+    {
+        return storage_ == INT16_STORAGE ? slab16_.size() : slab_.size();
+    }
+
+    void
+    SparseMatrix::Rebase(int j, float newBase)
+    {
+        ColumnBand& band = bands_[j];
+        for (int k = 0; k < band.AllocatedEnd - band.AllocatedBegin; k++)
+        {
+            int16_t& code = slab16_[band.Offset + k];
+            code = Encode(Decode(code, band.Base), newBase,
+                          *Dither(band.AllocatedBegin + k, j));
+        }
+        band.Base = newBase;
     }
 
     int
@@ -100,13 +329,21 @@ namespace ConsensusCore {
     int
     SparseMatrix::AllocatedEntries() const
     {
-        int sum = 0;
-        for (int j = 0; j < nCols_; j++)
-        {
-            sum += (columns_[j] != NULL ?
-                    columns_[j]->AllocatedEntries() : 0);
-        }
-        return sum;
+        // Entries reserved by column bands; abandoned bands awaiting
+        // compaction are not counted.
+        return slabUsed_ - slabGarbage_;
+    }
+
+    int
+    SparseMatrix::SlabEntries() const
+    {
+        return SlabSize();
+    }
+
+    int
+    SparseMatrix::NumSlabReallocs() const
+    {
+        return nSlabReallocs_;
     }
 
     void
@@ -126,9 +363,15 @@ namespace ConsensusCore {
     void
     SparseMatrix::CheckInvariants(int column) const
     {
-        for (int j = 0; j < nCols_; j++)
-         {
-             if (columns_[j] != NULL) columns_[j]->CheckInvariants();
-         }
+#ifndef NDEBUG
+        const ColumnBand& band = bands_[column];
+        assert(0 <= band.AllocatedBegin &&
+               band.AllocatedBegin <= band.AllocatedEnd &&
+               band.AllocatedEnd <= nRows_);
+        assert(band.AllocatedEnd - band.AllocatedBegin <= band.Capacity);
+        assert(0 <= band.Offset && band.Offset + band.Capacity <= slabUsed_);
+        assert(slabGarbage_ <= slabUsed_ &&
+               slabUsed_ <= SlabSize());
+#endif  // NDEBUG
     }
 }
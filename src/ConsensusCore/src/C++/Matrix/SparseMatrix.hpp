@@ -37,25 +37,71 @@
 
 #pragma once
 
+#include <immintrin.h>
 #include <xmmintrin.h>
 #include <utility>
 #include <vector>
 
 #include "Interval.hpp"
 #include "Matrix/AbstractMatrix.hpp"
-#include "Matrix/SparseVector.hpp"
 #include "Types.hpp"
 #include "Utils.hpp"
 
 namespace ConsensusCore {
 
+    //
+    // Banded matrix whose columns are stored at offsets within a single
+    // contiguous slab, rather than in individually allocated vectors.  A
+    // column that outgrows its band is moved to the end of the slab; the
+    // slab grows geometrically, compacting away abandoned bands as it
+    // does, so a fill performs O(log n) allocations rather than O(n).
+    //
+    // With INT16_STORAGE, entries are kept as 16-bit fixed point, in
+    // steps of 1/1024, relative to a per-column base (the first finite
+    // value written to the column, raised if a later one exceeds the
+    // range), halving the memory needed.  Entries more than 32 below the
+    // base read back as the empty value: they lie far outside any band
+    // ScoreDiff would keep, and are negligible in a sum-product sum.  The
+    // accessors widen entries back to float, so recursors are unaware of
+    // the storage mode.
+    //
+    // Accuracy: each stored entry is within 1/1024 of the value written.
+    // Plain rounding would err the same way at every step of a path that
+    // adds the same transition score over and over, so errors would grow
+    // linearly along the DP; a dither that varies along rows, columns and
+    // diagonals makes them wander instead.  With the sum-product recursor
+    // on simulated 1-3 kb reads, alpha(I, J) and beta(0, 0) move by about
+    // 0.01 from their float values and differ from each other by about
+    // as much, growing as the square root of the read length---well
+    // within ALPHA_BETA_MISMATCH_TOLERANCE (0.2) for reads of tens of kb.
+    // Mutation scores move by up to a few hundredths.
+    //
     class SparseMatrix : public AbstractMatrix
     {
     public:  // Constructor, destructor
-        SparseMatrix(int rows, int cols);
+        SparseMatrix(int rows, int cols, MatrixStorage storage = FLOAT_STORAGE);
         SparseMatrix(const SparseMatrix& other);
         ~SparseMatrix();
 
+        // Reshape to an empty rows x cols matrix, keeping the slab so that
+        // a refill does not need to allocate.
+        void Reset(int rows, int cols);
+
+        // Replace columns [beginColumn, endColumn) with numColumns empty
+        // columns, shifting those after them.  The storage of the removed
+        // columns is reused for the new ones.
+        void ReplaceColumns(int beginColumn, int endColumn, int numColumns);
+
+        // Free the storage of a filled column, keeping its used row range;
+        // its entries read as empty until it is edited again.  The space
+        // is reclaimed by the next Compact or slab regrowth.
+        void ReleaseColumn(int j);
+        bool IsColumnReleased(int j) const;
+
+        // Repack the slab to just hold the live bands, plus room for
+        // reserve more entries, returning freed space to the system.
+        void Compact(int reserve = 0);
+
     public:  // Nullability
         static const SparseMatrix& Null();
         bool IsNull() const;
@@ -63,6 +109,7 @@ namespace ConsensusCore {
     public:  // Size information
         const int Rows() const;
         const int Columns() const;
+        MatrixStorage Storage() const;
 
     public:  // Information about entries filled by column
         void StartEditingColumn(int j, int hintBegin, int hintEnd);
@@ -72,8 +119,12 @@ namespace ConsensusCore {
         int UsedEntries() const;
         int AllocatedEntries() const;  // an entry may be allocated but not used
 
+    public:  // Slab statistics
+        int SlabEntries() const;       // entries reserved, including free space
+        int NumSlabReallocs() const;   // times the slab has been regrown
+
     public:  // Accessors
-        const float& operator()(int i, int j) const;
+        float operator()(int i, int j) const;
         bool IsAllocated(int i, int j) const;
         float Get(int i, int j) const;
         void Set(int i, int j, float v);
@@ -83,6 +134,15 @@ namespace ConsensusCore {
         __m128 Get4(int i, int j) const;
         void Set4(int i, int j, __m128 v);
 
+#ifndef SWIG
+    public:  // AVX2 and AVX-512 accessors, for 8 and 16 successive entries;
+             // only callable when the running CPU supports them.
+        TARGET_AVX2   __m256 Get8(int i, int j) const;
+        TARGET_AVX2   void Set8(int i, int j, __m256 v);
+        TARGET_AVX512 __m512 Get16(int i, int j) const;
+        TARGET_AVX512 void Set16(int i, int j, __m512 v);
+#endif
+
     public:
         // Method SWIG clients can use to get a native matrix (e.g. Numpy)
         // mat must be filled as a ROW major matrix
@@ -92,7 +152,69 @@ namespace ConsensusCore {
         void CheckInvariants(int column) const;
 
     private:
-        std::vector<SparseVector*> columns_;
+        // Band of slab storage backing rows [AllocatedBegin, AllocatedEnd)
+        // of a column.  Unallocated columns have an empty row range; a
+        // value-initialized band is such a column.
+        struct ColumnBand
+        {
+            int Offset;
+            int Capacity;
+            int AllocatedBegin;
+            int AllocatedEnd;
+            float Base;  // INT16_STORAGE only; LZERO until first set
+        };
+
+        // Reserve a band of n entries at the end of the slab, regrowing
+        // (and compacting) it if necessary; returns the offset.  Other
+        // columns' offsets may change.
+        int AllocateBand(int n);
+
+        // Give column j a band able to hold n entries, without preserving
+        // its contents' position; returns with the column's offset valid.
+        void ReserveColumn(int j, int n);
+
+        // Expand the range of rows for which column j has storage, while
+        // preserving contents.
+        void ExpandColumn(int j, int newAllocatedBegin, int newAllocatedEnd);
+
+        // Size of whichever slab is in use
+        int SlabSize() const;
+
+        // Copy the live bands, in column order, to the front of a new
+        // slab of newSize entries; returns the space they take.
+        template<typename T>
+        int RepackSlab(std::vector<T>& slab, int newSize, T empty);
+
+        // Move n entries from offset from to offset to + shift, and fill
+        // the rest of [to, to + newLength) with empty.
+        template<typename T>
+        void MoveEntries(std::vector<T>& slab, int from, int to, int n,
+                         int shift, int newLength, T empty);
+
+    private:  // INT16_STORAGE
+        static int16_t Encode(float v, float base, float dither);
+        static float Decode(int16_t code, float base);
+
+        // Rounding offsets for the entries from (i, j) down, varying with
+        // the row, column and diagonal so that rounding errors do not
+        // pile up along a DP path adding the same transition scores.
+        static const float* Dither(int i, int j);
+        static const float int16Dither_[];
+
+        // Set an allocated entry, rebasing its column if need be
+        void SetInt16(int i, int j, float v);
+
+        // Re-encode column j's entries relative to newBase
+        void Rebase(int j, float newBase);
+
+    private:
+        MatrixStorage storage_;
+        std::vector<float> slab_;
+        std::vector<int16_t> slab16_;
+        int slabUsed_;
+        int slabGarbage_;
+        int nSlabReallocs_;
+        std::vector<ColumnBand> bands_;
         int nCols_;
         int nRows_;
         int columnBeingEdited_;
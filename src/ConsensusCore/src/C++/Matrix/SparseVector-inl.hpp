@@ -225,6 +225,70 @@ namespace ConsensusCore
         }
     }
 
+    inline TARGET_AVX2 __m256
+    SparseVector::Get8(int i) const
+    {
+        assert(i >= 0 && i < logicalLength_ - 7);
+        if (i >= allocatedBeginRow_ && i < allocatedEndRow_ - 7)
+        {
+            return _mm256_loadu_ps(&(*storage_)[i-allocatedBeginRow_]);
+        }
+        else
+        {
+            float vbuf[8];
+            for (int k = 0; k < 8; k++) { vbuf[k] = Get(i+k); }
+            return _mm256_loadu_ps(vbuf);
+        }
+    }
+
+    inline TARGET_AVX2 void
+    SparseVector::Set8(int i, __m256 v8)
+    {
+        assert(i >= 0 && i < logicalLength_ - 7);
+        if (i >= allocatedBeginRow_ && i < allocatedEndRow_ - 7)
+        {
+            _mm256_storeu_ps(&(*storage_)[i-allocatedBeginRow_], v8);
+        }
+        else
+        {
+            float vbuf[8];
+            _mm256_storeu_ps(vbuf, v8);
+            for (int k = 0; k < 8; k++) { Set(i+k, vbuf[k]); }
+        }
+    }
+
+    inline TARGET_AVX512 __m512
+    SparseVector::Get16(int i) const
+    {
+        assert(i >= 0 && i < logicalLength_ - 15);
+        if (i >= allocatedBeginRow_ && i < allocatedEndRow_ - 15)
+        {
+            return _mm512_loadu_ps(&(*storage_)[i-allocatedBeginRow_]);
+        }
+        else
+        {
+            float vbuf[16];
+            for (int k = 0; k < 16; k++) { vbuf[k] = Get(i+k); }
+            return _mm512_loadu_ps(vbuf);
+        }
+    }
+
+    inline TARGET_AVX512 void
+    SparseVector::Set16(int i, __m512 v16)
+    {
+        assert(i >= 0 && i < logicalLength_ - 15);
+        if (i >= allocatedBeginRow_ && i < allocatedEndRow_ - 15)
+        {
+            _mm512_storeu_ps(&(*storage_)[i-allocatedBeginRow_], v16);
+        }
+        else
+        {
+            float vbuf[16];
+            _mm512_storeu_ps(vbuf, v16);
+            for (int k = 0; k < 16; k++) { Set(i+k, vbuf[k]); }
+        }
+    }
+
     inline void
     SparseVector::Clear()
     {
@@ -239,6 +303,12 @@ namespace ConsensusCore
         return storage_->capacity();
     }
 
+    inline int
+    SparseVector::NumReallocs() const
+    {
+        return nReallocs_;
+    }
+
     inline void
     SparseVector::CheckInvariants() const
     {
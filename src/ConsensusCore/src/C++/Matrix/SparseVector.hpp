@@ -37,6 +37,7 @@
 
 #pragma once
 
+#include <immintrin.h>
 #include <xmmintrin.h>
 #include <utility>
 #include <vector>
@@ -66,10 +67,17 @@ namespace ConsensusCore {
         void Set(int i, float v);
         __m128 Get4(int i) const;
         void Set4(int i, __m128 v);
+#ifndef SWIG
+        TARGET_AVX2   __m256 Get8(int i) const;
+        TARGET_AVX2   void Set8(int i, __m256 v);
+        TARGET_AVX512 __m512 Get16(int i) const;
+        TARGET_AVX512 void Set16(int i, __m512 v);
+#endif
         void Clear();
 
     public:
         int AllocatedEntries() const;
+        int NumReallocs() const;      // times storage has been regrown
         void CheckInvariants() const;
 
     private:
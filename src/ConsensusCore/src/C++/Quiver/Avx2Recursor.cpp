@@ -0,0 +1,118 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// AVX2 instantiations of the SimdRecursor.  Everything between the
+// target pragmas is compiled for AVX2, so all other headers must be
+// included above them; code here only runs after SseRecursor has checked
+// the CPU (see detail::MaxSimdWidth).
+
+#include "Quiver/SimdRecursor.hpp"
+
+#include <algorithm>
+#include <boost/tuple/tuple.hpp>
+#include <cfloat>
+#include <immintrin.h>
+#include <numeric>
+
+#include "Interval.hpp"
+#include "Utils.hpp"
+#include "Edna/EdnaEvaluator.hpp"
+#include "Matrix/DenseMatrix.hpp"
+#include "Matrix/SparseMatrix.hpp"
+#include "Quiver/detail/Combiner.hpp"
+#include "Quiver/QvEvaluator.hpp"
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace ConsensusCore {
+namespace detail {
+
+    template<>
+    struct SimdLanes<8>
+    {
+        typedef __m256 Vec;
+
+        static Vec NegInf()                      { return _mm256_set1_ps(-FLT_MAX); }
+        static Vec Add(Vec a, Vec b)             { return _mm256_add_ps(a, b); }
+        static void Store(float* p, Vec v)       { _mm256_storeu_ps(p, v); }
+
+        template<typename M>
+        static Vec Get(const M& m, int i, int j) { return m.Get8(i, j); }
+        template<typename M>
+        static void Set(M& m, int i, int j, Vec v) { m.Set8(i, j, v); }
+
+        template<typename E>
+        static Vec Inc(const E& e, int i, int j)   { return e.Inc8(i, j); }
+        template<typename E>
+        static Vec Del(const E& e, int i, int j)   { return e.Del8(i, j); }
+        template<typename E>
+        static Vec Extra(const E& e, int i, int j) { return e.Extra8(i, j); }
+        template<typename E>
+        static Vec Merge(const E& e, int i, int j) { return e.Merge8(i, j); }
+
+        template<typename C>
+        static Vec Combine(Vec a, Vec b)         { return C::Combine8(a, b); }
+        template<typename C>
+        static Vec PrefixScan(float first, Vec score, Vec ins)
+        { return PrefixScan8<C>(first, score, ins); }
+        template<typename C>
+        static Vec SuffixScan(Vec score, Vec ins, float last)
+        { return SuffixScan8<C>(score, ins, last); }
+
+        static float HorizontalMax(Vec v)        { return HorizontalMax8(v); }
+        static float HorizontalMin(Vec v)        { return HorizontalMin8(v); }
+    };
+}}
+
+#include "Quiver/detail/SimdRecursorKernels.hpp"
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+namespace ConsensusCore {
+
+    template class SimdRecursor<DenseMatrix,  QvEvaluator, detail::ViterbiCombiner, 8>;
+    template class SimdRecursor<SparseMatrix, QvEvaluator, detail::ViterbiCombiner, 8>;
+    template class SimdRecursor<SparseMatrix, QvEvaluator, detail::SumProductCombiner, 8>;
+    template class SimdRecursor<SparseMatrix, EdnaEvaluator, detail::SumProductCombiner, 8>;
+}
@@ -0,0 +1,556 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#include "Quiver/BatchRecursor.hpp"
+
+#include <algorithm>
+#include <boost/tuple/tuple.hpp>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+#include "Interval.hpp"
+#include "Utils.hpp"
+#include "Matrix/DenseMatrix.hpp"
+#include "Matrix/SparseMatrix.hpp"
+#include "Quiver/detail/Combiner.hpp"
+#include "Quiver/detail/Instrumentation.hpp"
+#include "Quiver/QvEvaluator.hpp"
+
+using std::max;
+using std::min;
+
+#define NEG_INF -FLT_MAX
+
+namespace ConsensusCore {
+
+    namespace {
+        //
+        // Where one lane is in the fill of its current column.  The rows
+        // are filled as in the SimpleRecursor, Row being the next one.
+        //
+        struct LaneState
+        {
+            bool HasColumn;
+            bool IsRunning;
+            int Column;
+            int Row;
+            int BeginRow;
+            int EndRow;
+            int HintBeginRow;
+            int HintEndRow;
+            int RequiredRow;
+            float MaxScore;
+            float ThresholdScore;
+        };
+
+        // Combine each lane's move scores (all NEG_INF for idle lanes)
+        template<typename C>
+        inline void CombineLanes(const float* start, const float* inc,
+                                 const float* extra, const float* del,
+                                 const float* merge, bool useMerge,
+                                 float* score)
+        {
+            __m128 score4 = _mm_loadu_ps(start);
+            score4 = C::Combine4(score4, _mm_loadu_ps(inc));
+            score4 = C::Combine4(score4, _mm_loadu_ps(extra));
+            score4 = C::Combine4(score4, _mm_loadu_ps(del));
+            if (useMerge)
+            {
+                score4 = C::Combine4(score4, _mm_loadu_ps(merge));
+            }
+            _mm_storeu_ps(score, score4);
+        }
+    }
+
+    template<typename M, typename E, typename C>
+    void
+    BatchRecursor<M, E, C>::FillAlphaLanes(const E* const* evaluators,
+                                           const M* const* guides,
+                                           M* const* alphas,
+                                           const int* beginColumns,
+                                           int numReads) const
+    {
+        assert(0 < numReads && numReads <= BATCH_RECURSOR_LANES);
+
+        LaneState lanes[BATCH_RECURSOR_LANES];
+        int numSteps = 0;
+        for (int l = 0; l < numReads; l++)
+        {
+            const E& e = *evaluators[l];
+            const M& alpha = *alphas[l];
+            assert(alpha.Rows() == e.ReadLength() + 1 &&
+                   alpha.Columns() == e.TemplateLength() + 1);
+            assert(guides[l]->IsNull() ||
+                   (guides[l]->Rows() == alpha.Rows() &&
+                    guides[l]->Columns() == alpha.Columns()));
+
+            boost::tie(lanes[l].HintBeginRow, lanes[l].HintEndRow) =
+                detail::AlphaResumeHints(beginColumns[l], alpha,
+                                         this->bandingOptions_.ScoreDiff);
+            numSteps = max(numSteps, e.TemplateLength() + 1 - beginColumns[l]);
+        }
+
+        bool useMerge = (this->movesAvailable_ & MERGE);
+        float start[BATCH_RECURSOR_LANES], inc[BATCH_RECURSOR_LANES],
+              extra[BATCH_RECURSOR_LANES], del[BATCH_RECURSOR_LANES],
+              merge[BATCH_RECURSOR_LANES], score[BATCH_RECURSOR_LANES];
+
+        for (int step = 0; step < numSteps; step++)
+        {
+            // Start each lane on its next column
+            bool anyRunning = false;
+            for (int l = 0; l < numReads; l++)
+            {
+                LaneState& lane = lanes[l];
+                const E& e = *evaluators[l];
+                M& alpha = *alphas[l];
+                int I = e.ReadLength();
+                int j = beginColumns[l] + step;
+
+                lane.HasColumn = (j <= e.TemplateLength());
+                lane.IsRunning = false;
+                if (!lane.HasColumn) continue;
+
+                this->RangeGuide(j, *guides[l], alpha, &lane.HintBeginRow, &lane.HintEndRow);
+                alpha.StartEditingColumn(j, lane.HintBeginRow, lane.HintEndRow);
+
+                lane.Column = j;
+                lane.Row = lane.BeginRow = lane.HintBeginRow;
+                lane.RequiredRow = min(I + 1, lane.HintEndRow);
+                lane.MaxScore = lane.ThresholdScore = NEG_INF;
+                lane.IsRunning = (lane.Row < I + 1);
+                anyRunning |= lane.IsRunning;
+            }
+
+            // Then fill a row of each running lane at a time
+            while (anyRunning)
+            {
+                for (int l = 0; l < BATCH_RECURSOR_LANES; l++)
+                {
+                    start[l] = inc[l] = extra[l] = del[l] = merge[l] = NEG_INF;
+                    if (l >= numReads || !lanes[l].IsRunning) continue;
+
+                    const E& e = *evaluators[l];
+                    const M& alpha = *alphas[l];
+                    int i = lanes[l].Row;
+                    int j = lanes[l].Column;
+
+                    if (i == 0 && j == 0)
+                    {
+                        start[l] = 0.0f;
+                    }
+                    if (i > 0 && j > 0)
+                    {
+                        inc[l] = alpha(i - 1, j - 1) + e.Inc(i - 1, j - 1);
+                    }
+                    if (i > 0)
+                    {
+                        extra[l] = alpha(i - 1, j) + e.Extra(i - 1, j);
+                    }
+                    if (j > 0)
+                    {
+                        del[l] = alpha(i, j - 1) + e.Del(i, j - 1);
+                    }
+                    if (useMerge && j > 1 && i > 0)
+                    {
+                        merge[l] = alpha(i - 1, j - 2) + e.Merge(i - 1, j - 2);
+                    }
+                }
+
+                CombineLanes<C>(start, inc, extra, del, merge, useMerge, score);
+
+                anyRunning = false;
+                for (int l = 0; l < numReads; l++)
+                {
+                    LaneState& lane = lanes[l];
+                    if (!lane.IsRunning) continue;
+
+                    alphas[l]->Set(lane.Row, lane.Column, score[l]);
+                    if (score[l] > lane.MaxScore)
+                    {
+                        lane.MaxScore = score[l];
+                        lane.ThresholdScore = lane.MaxScore - this->bandingOptions_.ScoreDiff;
+                    }
+                    lane.Row++;
+                    lane.IsRunning = (lane.Row < evaluators[l]->ReadLength() + 1 &&
+                                      (score[l] >= lane.ThresholdScore ||
+                                       lane.Row < lane.RequiredRow));
+                    anyRunning |= lane.IsRunning;
+                }
+            }
+
+            // Finish the columns, and revise the hints to tell the next
+            // column where the mass of the distribution really lived
+            for (int l = 0; l < numReads; l++)
+            {
+                LaneState& lane = lanes[l];
+                if (!lane.HasColumn) continue;
+
+                M& alpha = *alphas[l];
+                int j = lane.Column;
+                lane.EndRow = lane.Row;
+                alpha.FinishEditingColumn(j, lane.BeginRow, lane.EndRow);
+
+                int i;
+                lane.HintEndRow = lane.EndRow;
+                for (i = lane.BeginRow;
+                     i < lane.EndRow && alpha(i, j) < lane.ThresholdScore;
+                     ++i);
+                lane.HintBeginRow = i;
+            }
+        }
+    }
+
+    template<typename M, typename E, typename C>
+    void
+    BatchRecursor<M, E, C>::FillBetaLanes(const E* const* evaluators,
+                                          const M* const* guides,
+                                          M* const* betas,
+                                          const int* endColumns,
+                                          int numReads) const
+    {
+        assert(0 < numReads && numReads <= BATCH_RECURSOR_LANES);
+
+        LaneState lanes[BATCH_RECURSOR_LANES];
+        int lastColumns[BATCH_RECURSOR_LANES];
+        int numSteps = 0;
+        for (int l = 0; l < numReads; l++)
+        {
+            const E& e = *evaluators[l];
+            const M& beta = *betas[l];
+            assert(beta.Rows() == e.ReadLength() + 1 &&
+                   beta.Columns() == e.TemplateLength() + 1);
+            assert(guides[l]->IsNull() ||
+                   (guides[l]->Rows() == beta.Rows() &&
+                    guides[l]->Columns() == beta.Columns()));
+
+            lastColumns[l] = min(endColumns[l], e.TemplateLength() + 1) - 1;
+            boost::tie(lanes[l].HintBeginRow, lanes[l].HintEndRow) =
+                detail::BetaResumeHints(lastColumns[l], beta,
+                                        this->bandingOptions_.ScoreDiff);
+            numSteps = max(numSteps, lastColumns[l] + 1);
+        }
+
+        bool useMerge = (this->movesAvailable_ & MERGE);
+        float start[BATCH_RECURSOR_LANES], inc[BATCH_RECURSOR_LANES],
+              extra[BATCH_RECURSOR_LANES], del[BATCH_RECURSOR_LANES],
+              merge[BATCH_RECURSOR_LANES], score[BATCH_RECURSOR_LANES];
+
+        for (int step = 0; step < numSteps; step++)
+        {
+            // Start each lane on its next column
+            bool anyRunning = false;
+            for (int l = 0; l < numReads; l++)
+            {
+                LaneState& lane = lanes[l];
+                M& beta = *betas[l];
+                int j = lastColumns[l] - step;
+
+                lane.HasColumn = (j >= 0);
+                lane.IsRunning = false;
+                if (!lane.HasColumn) continue;
+
+                this->RangeGuide(j, *guides[l], beta, &lane.HintBeginRow, &lane.HintEndRow);
+                beta.StartEditingColumn(j, lane.HintBeginRow, lane.HintEndRow);
+
+                lane.Column = j;
+                lane.EndRow = lane.HintEndRow;
+                lane.Row = lane.EndRow - 1;
+                lane.RequiredRow = max(0, lane.HintBeginRow);
+                lane.MaxScore = lane.ThresholdScore = NEG_INF;
+                lane.IsRunning = (lane.Row >= 0);
+                anyRunning |= lane.IsRunning;
+            }
+
+            // Then fill a row of each running lane at a time, upwards
+            while (anyRunning)
+            {
+                for (int l = 0; l < BATCH_RECURSOR_LANES; l++)
+                {
+                    start[l] = inc[l] = extra[l] = del[l] = merge[l] = NEG_INF;
+                    if (l >= numReads || !lanes[l].IsRunning) continue;
+
+                    const E& e = *evaluators[l];
+                    const M& beta = *betas[l];
+                    int I = e.ReadLength();
+                    int J = e.TemplateLength();
+                    int i = lanes[l].Row;
+                    int j = lanes[l].Column;
+
+                    if (i == I && j == J)
+                    {
+                        start[l] = 0.0f;
+                    }
+                    if (i < I && j < J)
+                    {
+                        inc[l] = beta(i + 1, j + 1) + e.Inc(i, j);
+                    }
+                    if (i < I)
+                    {
+                        extra[l] = beta(i + 1, j) + e.Extra(i, j);
+                    }
+                    if (j < J)
+                    {
+                        del[l] = beta(i, j + 1) + e.Del(i, j);
+                    }
+                    if (useMerge && j < J - 1 && i < I)
+                    {
+                        merge[l] = beta(i + 1, j + 2) + e.Merge(i, j);
+                    }
+                }
+
+                CombineLanes<C>(start, inc, extra, del, merge, useMerge, score);
+
+                anyRunning = false;
+                for (int l = 0; l < numReads; l++)
+                {
+                    LaneState& lane = lanes[l];
+                    if (!lane.IsRunning) continue;
+
+                    betas[l]->Set(lane.Row, lane.Column, score[l]);
+                    if (score[l] > lane.MaxScore)
+                    {
+                        lane.MaxScore = score[l];
+                        lane.ThresholdScore = lane.MaxScore - this->bandingOptions_.ScoreDiff;
+                    }
+                    lane.Row--;
+                    lane.IsRunning = (lane.Row >= 0 &&
+                                      (score[l] >= lane.ThresholdScore ||
+                                       lane.Row >= lane.RequiredRow));
+                    anyRunning |= lane.IsRunning;
+                }
+            }
+
+            // Finish the columns, and revise the hints
+            for (int l = 0; l < numReads; l++)
+            {
+                LaneState& lane = lanes[l];
+                if (!lane.HasColumn) continue;
+
+                M& beta = *betas[l];
+                int j = lane.Column;
+                lane.BeginRow = lane.Row + 1;
+                beta.FinishEditingColumn(j, lane.BeginRow, lane.EndRow);
+
+                int i;
+                lane.HintBeginRow = lane.BeginRow;
+                for (i = lane.EndRow;
+                     i > lane.BeginRow && beta(i - 1, j) < lane.ThresholdScore;
+                     --i);
+                lane.HintEndRow = i;
+            }
+        }
+    }
+
+    template<typename M, typename E, typename C>
+    void
+    BatchRecursor<M, E, C>::FillAlpha(const E& e, const M& guide, M& alpha,
+                                      int beginColumn) const
+    {
+        const E* evaluator = &e;
+        const M* guidePtr = &guide;
+        M* alphaPtr = &alpha;
+        FillAlphaLanes(&evaluator, &guidePtr, &alphaPtr, &beginColumn, 1);
+    }
+
+    template<typename M, typename E, typename C>
+    void
+    BatchRecursor<M, E, C>::FillBeta(const E& e, const M& guide, M& beta,
+                                     int endColumn) const
+    {
+        const E* evaluator = &e;
+        const M* guidePtr = &guide;
+        M* betaPtr = &beta;
+        FillBetaLanes(&evaluator, &guidePtr, &betaPtr, &endColumn, 1);
+    }
+
+    template<typename M, typename E, typename C>
+    void
+    BatchRecursor<M, E, C>::FillAlphas(const std::vector<const E*>& evaluators,
+                                       const std::vector<const M*>& guides,
+                                       const std::vector<M*>& alphas,
+                                       const std::vector<int>& beginColumns) const
+    {
+        int n = evaluators.size();
+        assert(guides.size() == n && alphas.size() == n && beginColumns.size() == n);
+        for (int k = 0; k < n; k += BATCH_RECURSOR_LANES)
+        {
+            FillAlphaLanes(&evaluators[k], &guides[k], &alphas[k], &beginColumns[k],
+                           min(n - k, BATCH_RECURSOR_LANES));
+        }
+    }
+
+    template<typename M, typename E, typename C>
+    void
+    BatchRecursor<M, E, C>::FillBetas(const std::vector<const E*>& evaluators,
+                                      const std::vector<const M*>& guides,
+                                      const std::vector<M*>& betas,
+                                      const std::vector<int>& endColumns) const
+    {
+        int n = evaluators.size();
+        assert(guides.size() == n && betas.size() == n && endColumns.size() == n);
+        for (int k = 0; k < n; k += BATCH_RECURSOR_LANES)
+        {
+            FillBetaLanes(&evaluators[k], &guides[k], &betas[k], &endColumns[k],
+                          min(n - k, BATCH_RECURSOR_LANES));
+        }
+    }
+
+    template<typename M, typename E, typename C>
+    void
+    BatchRecursor<M, E, C>::RefillAlphaBetas(std::vector<RefillType>& refills) const
+    {
+        int n = refills.size();
+        for (int k = 0; k < n; k += BATCH_RECURSOR_LANES)
+        {
+            int numReads = min(n - k, BATCH_RECURSOR_LANES);
+            const E* evaluators[BATCH_RECURSOR_LANES];
+            const M* alphaGuides[BATCH_RECURSOR_LANES];
+            const M* betaGuides[BATCH_RECURSOR_LANES];
+            M* alphas[BATCH_RECURSOR_LANES];
+            M* betas[BATCH_RECURSOR_LANES];
+            int beginColumns[BATCH_RECURSOR_LANES];
+            int endColumns[BATCH_RECURSOR_LANES];
+            int reallocs[BATCH_RECURSOR_LANES];
+
+            // As RecursorBase::RefillAlphaBeta: keep the alpha columns
+            // before the change and the beta columns after it, and fill
+            // in the rest, each guided by the other
+            for (int l = 0; l < numReads; l++)
+            {
+                RefillType& r = refills[k + l];
+                int J = r.Evaluator->TemplateLength();
+
+                assert(r.Alpha->Rows() == r.Evaluator->ReadLength() + 1 &&
+                       r.Alpha->Columns() == J + 1 - r.LengthDiff);
+                assert(r.Beta->Rows() == r.Evaluator->ReadLength() + 1 &&
+                       r.Beta->Columns() == J + 1 - r.LengthDiff);
+                assert(0 <= r.ChangeBegin && r.ChangeBegin <= r.ChangeEnd &&
+                       r.ChangeEnd + r.LengthDiff >= r.ChangeBegin);
+
+                int newChangeEnd = r.ChangeEnd + r.LengthDiff;
+                r.Alpha->ReplaceColumns(r.ChangeBegin, r.Alpha->Columns(), J + 1 - r.ChangeBegin);
+                r.Beta->ReplaceColumns(0, r.ChangeEnd, newChangeEnd);
+
+                evaluators[l] = r.Evaluator;
+                alphas[l] = r.Alpha;
+                betas[l] = r.Beta;
+                alphaGuides[l] = r.Beta;
+                betaGuides[l] = r.Alpha;
+                beginColumns[l] = r.ChangeBegin;
+                endColumns[l] = newChangeEnd;
+                reallocs[l] = detail::NumReallocs(*r.Alpha) + detail::NumReallocs(*r.Beta);
+            }
+
+            double start = detail::Now();
+            FillAlphaLanes(evaluators, alphaGuides, alphas, beginColumns, numReads);
+            double filledAlpha = detail::Now();
+            FillBetaLanes(evaluators, betaGuides, betas, endColumns, numReads);
+            double filledBeta = detail::Now();
+
+            for (int l = 0; l < numReads; l++)
+            {
+                RefillType& r = refills[k + l];
+                ScorerCounters* counters = r.Counters;
+                if (counters != NULL)
+                {
+                    // The lanes share the time
+                    int endColumn = min(endColumns[l], r.Beta->Columns());
+                    counters->FillAlphaSeconds += (filledAlpha - start) / numReads;
+                    counters->FillBetaSeconds += (filledBeta - filledAlpha) / numReads;
+                    counters->FillAlphaCells += detail::UsedCells(*r.Alpha, beginColumns[l],
+                                                                  r.Alpha->Columns(),
+                                                                  &counters->MaxBandWidth);
+                    counters->FillBetaCells += detail::UsedCells(*r.Beta, 0, endColumn,
+                                                                 &counters->MaxBandWidth);
+                    counters->BandColumns += r.Alpha->Columns() - beginColumns[l] + endColumn;
+                    counters->Reallocations += detail::NumReallocs(*r.Alpha) +
+                        detail::NumReallocs(*r.Beta) - reallocs[l];
+                }
+
+                try
+                {
+                    r.FlipFlops = this->FinishRefill(*r.Evaluator, *r.Alpha, *r.Beta, counters);
+                }
+                catch (AlphaBetaMismatchException&)
+                {
+                    r.FlipFlops = -1;
+                }
+            }
+        }
+    }
+
+    template<typename M, typename E, typename C>
+    float
+    BatchRecursor<M, E, C>::LinkAlphaBeta(const E& e,
+                                          const M& alpha, int alphaColumn,
+                                          const M& beta, int betaColumn,
+                                          int absoluteColumn) const
+    {
+        return sseRecursor_.LinkAlphaBeta(e, alpha, alphaColumn,
+                                          beta, betaColumn, absoluteColumn);
+    }
+
+    template<typename M, typename E, typename C>
+    void
+    BatchRecursor<M, E, C>::ExtendAlpha(const E& e,
+                                        const M& alpha, int beginColumn,
+                                        M& ext, int numExtColumns,
+                                        int firstExtColumn) const
+    {
+        sseRecursor_.ExtendAlpha(e, alpha, beginColumn, ext, numExtColumns, firstExtColumn);
+    }
+
+    template<typename M, typename E, typename C>
+    void
+    BatchRecursor<M, E, C>::ExtendBeta(const E& e,
+                                       const M& beta, int endColumn,
+                                       M& ext, int numExtColumns,
+                                       int lengthDiff) const
+    {
+        sseRecursor_.ExtendBeta(e, beta, endColumn, ext, numExtColumns, lengthDiff);
+    }
+
+    template<typename M, typename E, typename C>
+    BatchRecursor<M, E, C>::BatchRecursor(int movesAvailable, const BandingOptions& banding)
+        : detail::RecursorBase<M, E, C>(movesAvailable, banding),
+          sseRecursor_(movesAvailable, banding)
+    {}
+
+    template class BatchRecursor<DenseMatrix,  QvEvaluator, detail::ViterbiCombiner>;
+    template class BatchRecursor<SparseMatrix, QvEvaluator, detail::ViterbiCombiner>;
+    template class BatchRecursor<SparseMatrix, QvEvaluator, detail::SumProductCombiner>;
+}
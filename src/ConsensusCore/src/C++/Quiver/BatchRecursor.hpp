@@ -0,0 +1,165 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#pragma once
+
+#include <climits>
+#include <vector>
+
+#include "Matrix/DenseMatrix.hpp"
+#include "Matrix/SparseMatrix.hpp"
+#include "Quiver/QvEvaluator.hpp"
+#include "Quiver/ScorerCounters.hpp"
+#include "Quiver/detail/Combiner.hpp"
+#include "Quiver/detail/RecursorBase.hpp"
+#include "Quiver/SseRecursor.hpp"
+
+// The number of reads a BatchRecursor fills at once, one per SSE lane
+#define BATCH_RECURSOR_LANES 4
+
+namespace ConsensusCore {
+
+    /// \brief One read's part in a batched RefillAlphaBeta: the arguments
+    ///        RefillAlphaBeta would take, and its result.
+    template <typename M, typename E>
+    struct AlphaBetaRefill
+    {
+        const E* Evaluator;
+        M* Alpha;
+        M* Beta;
+        int ChangeBegin;
+        int ChangeEnd;
+        int LengthDiff;
+        ScorerCounters* Counters;
+
+        // Set by the refill: the number of flip-flops it took, or -1 if
+        // alpha and beta could not be mated (where RefillAlphaBeta throws)
+        int FlipFlops;
+    };
+
+    /// \brief A recursor that fills the alpha and beta matrices of several
+    ///        reads at once, one read per SSE lane.
+    ///
+    /// The SseRecursor vectorizes down a column, which leaves it little
+    /// to do when the band is only a few vectors wide, as it is for short
+    /// reads.  Here each lane instead runs the SimpleRecursor's recursion
+    /// and banding for its own read and template, and the lanes step
+    /// through their columns and rows together, so the move scores are
+    /// combined for four reads in each instruction---most worthwhile for
+    /// the log-adds of the sum-product recursion.  The reads need not
+    /// share a template, or be of the same length.
+    ///
+    /// Used on its own (one read at a time) it fills just as the batch
+    /// would, with three lanes idle; the other methods are the
+    /// SseRecursor's.
+    template <typename M, typename E, typename C>
+    class BatchRecursor : public detail::RecursorBase<M, E, C>
+    {
+    public:
+        typedef AlphaBetaRefill<M, E> RefillType;
+
+        void FillAlpha(const E& e, const M& guide, M& alpha,
+                       int beginColumn = 0) const;
+        void FillBeta(const E& e, const M& guide, M& beta,
+                      int endColumn = INT_MAX) const;
+
+        /// \brief FillAlpha (FillBeta) for each of the reads: read k has
+        ///        evaluator *evaluators[k] and guide *guides[k], and its
+        ///        matrix *alphas[k] is filled from beginColumns[k] (*betas[k]
+        ///        up to endColumns[k]).
+        void FillAlphas(const std::vector<const E*>& evaluators,
+                        const std::vector<const M*>& guides,
+                        const std::vector<M*>& alphas,
+                        const std::vector<int>& beginColumns) const;
+        void FillBetas(const std::vector<const E*>& evaluators,
+                       const std::vector<const M*>& guides,
+                       const std::vector<M*>& betas,
+                       const std::vector<int>& endColumns) const;
+
+        /// \brief RefillAlphaBeta for each of the reads, filling in the
+        ///        FlipFlops of each refill.  Reads whose matrices do not
+        ///        mate are filled again from scratch on their own.
+        void RefillAlphaBetas(std::vector<RefillType>& refills) const;
+
+        float LinkAlphaBeta(const E& e,
+                            const M& alpha, int alphaColumn,
+                            const M& beta, int betaColumn,
+                            int absoluteColumn) const;
+
+        void ExtendAlpha(const E& e,
+                         const M& alpha, int beginColumn,
+                         M& ext, int numExtColumns = 2,
+                         int firstExtColumn = 0) const;
+
+        void ExtendBeta(const E& e,
+                        const M& beta, int endColumn,
+                        M& ext, int numExtColumns = 2,
+                        int lengthDiff = 0) const;
+
+    public:
+        //
+        // Constructors
+        //
+        BatchRecursor(int movesAvailable, const BandingOptions& banding);
+
+    private:
+        // Fill the matrices of numReads reads, at most BATCH_RECURSOR_LANES
+        void FillAlphaLanes(const E* const* evaluators,
+                            const M* const* guides,
+                            M* const* alphas,
+                            const int* beginColumns,
+                            int numReads) const;
+        void FillBetaLanes(const E* const* evaluators,
+                           const M* const* guides,
+                           M* const* betas,
+                           const int* endColumns,
+                           int numReads) const;
+
+    private:
+        SseRecursor<M, E, C> sseRecursor_;
+    };
+
+    typedef BatchRecursor<DenseMatrix,
+                          QvEvaluator,
+                          detail::ViterbiCombiner> BatchQvRecursor;
+
+    typedef BatchRecursor<SparseMatrix,
+                          QvEvaluator,
+                          detail::ViterbiCombiner> SparseBatchQvRecursor;
+
+    typedef BatchRecursor<SparseMatrix,
+                          QvEvaluator,
+                          detail::SumProductCombiner> SparseBatchQvSumProductRecursor;
+}
@@ -37,6 +37,7 @@
 
 #include <algorithm>
 #include <cfloat>
+#include <limits>
 #include <map>
 #include <string>
 #include <vector>
@@ -44,13 +45,16 @@
 
 
 #include "Checksum.hpp"
+#include "Quiver/BatchRecursor.hpp"
 #include "Quiver/MutationScorer.hpp"
 #include "Quiver/MultiReadMutationScorer.hpp"
+#include "Quiver/detail/Mutex.hpp"
+#include "Quiver/detail/ThreadPool.hpp"
 #include "Mutation.hpp"
 #include "Sequence.hpp"
 #include "Utils.hpp"
 
-#define MIN_FAVORABLE_SCOREDIFF 0.04  // Chosen such that 0.49 = 1 / (1 + exp(minScoreDiff))
+#define MIN_BATCH_CHUNK_SIZE 16  // Fewest mutations scored per work item, when splitting reads
 
 namespace ConsensusCore
 {
@@ -125,6 +129,573 @@ namespace ConsensusCore
     }
 
 
+    namespace detail {
+
+        //
+        // Scores a mutation against each of the given reads (indices into
+        // reads, in increasing order); Run works on one read, and Commit
+        // adds the per-read differences up in read order, so the sum does
+        // not depend on how the reads were spread over threads.
+        // If screening, the reads' screening scorers are used instead,
+        // where they have them, and each difference is raised by margin
+        // in the sum.
+        //
+        template<typename ReadStateType>
+        class MutationScoringTask : public ParallelTask
+        {
+        public:
+            MutationScoringTask(const std::vector<ReadStateType>& reads,
+                                const std::vector<int>& readIndices,
+                                const Mutation& m,
+                                float unscoredValue,
+                                bool earlyExit,
+                                float threshold,
+                                bool screening = false,
+                                float margin = 0)
+                : reads_(reads),
+                  readIndices_(readIndices),
+                  m_(m),
+                  earlyExit_(earlyExit),
+                  threshold_(threshold),
+                  screening_(screening),
+                  margin_(margin),
+                  scores_(reads.size(), unscoredValue),
+                  scored_(reads.size(), false),
+                  sum_(0)
+            {}
+
+            int NumItems() const
+            {
+                return readIndices_.size();
+            }
+
+            void Run(int k)
+            {
+                int i = readIndices_[k];
+                const ReadStateType& rs = reads_[i];
+                if (rs.IsActive && ReadScoresMutation(*rs.Read, m_))
+                {
+                    Mutation orientedMut = OrientedMutation(*rs.Read, m_);
+                    if (screening_ && rs.ScreeningScorer != NULL)
+                    {
+                        scores_[i] = (rs.ScreeningScorer->ScoreMutation(orientedMut) -
+                                      rs.ScreeningScorer->Score());
+                    }
+                    else
+                    {
+                        scores_[i] = (rs.Scorer->ScoreMutation(orientedMut) -
+                                      rs.Scorer->Score());
+                    }
+                    scored_[i] = true;
+                }
+            }
+
+            bool Commit(int k)
+            {
+                int i = readIndices_[k];
+                if (scored_[i])
+                {
+                    sum_ += scores_[i] + margin_;
+                    if (earlyExit_ && sum_ < threshold_)
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            float Sum() const { return sum_; }
+            const std::vector<float>& Scores() const { return scores_; }
+
+        private:
+            const std::vector<ReadStateType>& reads_;
+            const std::vector<int>& readIndices_;
+            const Mutation& m_;
+            bool earlyExit_;
+            float threshold_;
+            bool screening_;
+            float margin_;
+            std::vector<float> scores_;
+            std::vector<char> scored_;
+            float sum_;
+        };
+
+        //
+        // Decides whether a mutation is favorable, scoring the reads in the
+        // given order.  Run scores the read at one place in the order;
+        // Commit adds its difference in, and stops once the sum falls below
+        // the threshold, or the reads left, giving at most remainingUpper
+        // in all, could not lift it above MIN_FAVORABLE_SCOREDIFF.  The
+        // bounds are only empirical, so a mutation is accepted only once
+        // every read has been scored.
+        //
+        template<typename ReadStateType>
+        class AdaptiveScoringTask : public ParallelTask
+        {
+        public:
+            AdaptiveScoringTask(const std::vector<ReadStateType>& reads,
+                                const Mutation& m,
+                                const std::vector<int>& order,
+                                const std::vector<double>& remainingUpper,
+                                float threshold)
+                : reads_(reads),
+                  m_(m),
+                  order_(order),
+                  remainingUpper_(remainingUpper),
+                  threshold_(threshold),
+                  scores_(order.size(), 0.0f),
+                  sum_(0),
+                  numCommitted_(0),
+                  decisive_(-1)
+            {}
+
+            void Run(int k)
+            {
+                const ReadStateType& rs = reads_[order_[k]];
+                Mutation orientedMut = OrientedMutation(*rs.Read, m_);
+                scores_[k] = rs.Scorer->ScoreMutation(orientedMut) - rs.Scorer->Score();
+            }
+
+            bool Commit(int k)
+            {
+                sum_ += scores_[k];
+                numCommitted_ = k + 1;
+                bool last = (k + 1 == (int)order_.size());
+                if (!last &&
+                    (sum_ < threshold_ ||
+                     sum_ + remainingUpper_[k + 1] <= MIN_FAVORABLE_SCOREDIFF))
+                {
+                    decisive_ = order_[k];
+                    return false;
+                }
+                return true;
+            }
+
+            bool Favorable() const
+            {
+                return decisive_ < 0 && sum_ > MIN_FAVORABLE_SCOREDIFF;
+            }
+
+            // The reads scored, in order, and their differences
+            int NumScored() const { return numCommitted_; }
+            const std::vector<float>& Scores() const { return scores_; }
+
+            // The read that tipped the mutation into rejection before the
+            // last read was scored, or -1
+            int Decisive() const { return decisive_; }
+
+        private:
+            const std::vector<ReadStateType>& reads_;
+            const Mutation& m_;
+            const std::vector<int>& order_;
+            const std::vector<double>& remainingUpper_;
+            float threshold_;
+            std::vector<float> scores_;
+            float sum_;
+            int numCommitted_;
+            int decisive_;
+        };
+
+        //
+        // Orders reads by how often they have been decisive, most first
+        //
+        class MoreDecisive
+        {
+        public:
+            explicit MoreDecisive(const std::vector<ReadDeltaStats>& stats)
+                : stats_(stats)
+            {}
+
+            bool operator()(int a, int b) const
+            {
+                return stats_[a].Decisive > stats_[b].Decisive;
+            }
+
+        private:
+            const std::vector<ReadDeltaStats>& stats_;
+        };
+
+        //
+        // Scores a batch of mutations.  Work items are (read, chunk of
+        // mutations) pairs, read-major, so each read's matrices stay in
+        // cache while it is worked on; with few reads, chunking also lets
+        // threads share a read.  Commit adds each item's differences into
+        // the per-mutation sums, so every sum is accumulated in read order
+        // and matches scoring the mutations one at a time.
+        //
+        template<typename ReadStateType>
+        class BatchScoringTask : public ParallelTask
+        {
+        public:
+            BatchScoringTask(const std::vector<ReadStateType>& reads,
+                             const std::vector<Mutation>& mutations,
+                             float unscoredValue,
+                             int numChunks)
+                : reads_(reads),
+                  mutations_(mutations),
+                  numChunks_(numChunks),
+                  scores_(reads.size() * mutations.size(), unscoredValue),
+                  scored_(reads.size() * mutations.size(), false),
+                  sums_(mutations.size(), 0.0f)
+            {}
+
+            int NumItems() const
+            {
+                return reads_.size() * numChunks_;
+            }
+
+            void Run(int item)
+            {
+                int i = item / numChunks_;
+                const ReadStateType& rs = reads_[i];
+                if (!rs.IsActive) return;
+
+                int M = mutations_.size();
+                float baseline = rs.Scorer->Score();
+                for (int k = ChunkBegin(item); k < ChunkEnd(item); k++)
+                {
+                    const Mutation& m = mutations_[k];
+                    if (ReadScoresMutation(*rs.Read, m))
+                    {
+                        Mutation orientedMut = OrientedMutation(*rs.Read, m);
+                        scores_[i * M + k] = rs.Scorer->ScoreMutation(orientedMut) - baseline;
+                        scored_[i * M + k] = true;
+                    }
+                }
+            }
+
+            bool Commit(int item)
+            {
+                int i = item / numChunks_;
+                int M = mutations_.size();
+                for (int k = ChunkBegin(item); k < ChunkEnd(item); k++)
+                {
+                    if (scored_[i * M + k]) sums_[k] += scores_[i * M + k];
+                }
+                return true;
+            }
+
+            const std::vector<float>& Sums() const { return sums_; }
+            const std::vector<float>& ScoresMatrix() const { return scores_; }
+
+        private:
+            // The item's chunk of mutations is [ChunkBegin, ChunkEnd)
+            int ChunkBegin(int item) const
+            {
+                return ChunkBoundary(item % numChunks_);
+            }
+
+            int ChunkEnd(int item) const
+            {
+                return ChunkBoundary(item % numChunks_ + 1);
+            }
+
+            int ChunkBoundary(int chunk) const
+            {
+                return static_cast<int>(
+                    (static_cast<long>(mutations_.size()) * chunk) / numChunks_);
+            }
+
+        private:
+            const std::vector<ReadStateType>& reads_;
+            const std::vector<Mutation>& mutations_;
+            int numChunks_;
+            std::vector<float> scores_;
+            std::vector<char> scored_;
+            std::vector<float> sums_;
+        };
+
+        //
+        // The single-base alternatives at template position pos, in
+        // ScoreSite order; the substitution by the base already there is
+        // left out, and its index returned in identity.
+        //
+        inline std::vector<Mutation> SiteAlternatives(const std::string& tpl, int pos,
+                                                      int* identity)
+        {
+            std::vector<Mutation> alternatives;
+            for (int b = 0; b < 4; b++)
+            {
+                if (tpl[pos] == "ACGT"[b])
+                {
+                    *identity = b;
+                }
+                else
+                {
+                    alternatives.push_back(Mutation(SUBSTITUTION, pos, "ACGT"[b]));
+                }
+            }
+            for (int b = 0; b < 4; b++)
+            {
+                alternatives.push_back(Mutation(INSERTION, pos, "ACGT"[b]));
+            }
+            alternatives.push_back(Mutation(DELETION, pos, '-'));
+            return alternatives;
+        }
+
+        //
+        // Scores the alternatives at a site against the given reads; Run
+        // scores those each read covers together (see
+        // MutationScorer::ScoreSite), and Commit adds the differences up in
+        // read order.  With earlyExit, an
+        // alternative's sum stops once it falls below the threshold, so
+        // every sum matches SumScores, and reads run after that skip it.
+        //
+        template<typename ReadStateType>
+        class SiteScoringTask : public ParallelTask
+        {
+        public:
+            SiteScoringTask(const std::vector<ReadStateType>& reads,
+                            const std::vector<int>& readIndices,
+                            const std::vector<Mutation>& alternatives,
+                            bool earlyExit,
+                            float threshold)
+                : reads_(reads),
+                  readIndices_(readIndices),
+                  alternatives_(alternatives),
+                  earlyExit_(earlyExit),
+                  threshold_(threshold),
+                  scores_(reads.size() * alternatives.size(), 0.0f),
+                  scored_(reads.size() * alternatives.size(), false),
+                  sums_(alternatives.size(), 0.0f),
+                  exited_(alternatives.size(), false),
+                  numExited_(0)
+            {}
+
+            int NumItems() const
+            {
+                return readIndices_.size();
+            }
+
+            void Run(int item)
+            {
+                int i = readIndices_[item];
+                const ReadStateType& rs = reads_[i];
+                if (!rs.IsActive) return;
+
+                std::vector<char> exited;
+                {
+                    detail::ScopedLock lock(exitedMutex_);
+                    exited = exited_;
+                }
+                std::vector<Mutation> oriented;
+                std::vector<int> indices;
+                for (int k = 0; k < (int)alternatives_.size(); k++)
+                {
+                    if (!exited[k] && ReadScoresMutation(*rs.Read, alternatives_[k]))
+                    {
+                        oriented.push_back(OrientedMutation(*rs.Read, alternatives_[k]));
+                        indices.push_back(k);
+                    }
+                }
+                if (oriented.empty()) return;
+
+                int K = alternatives_.size();
+                float baseline = rs.Scorer->Score();
+                std::vector<float> scores = rs.Scorer->ScoreSite(oriented);
+                for (int n = 0; n < (int)indices.size(); n++)
+                {
+                    scores_[i * K + indices[n]] = scores[n] - baseline;
+                    scored_[i * K + indices[n]] = true;
+                }
+            }
+
+            bool Commit(int item)
+            {
+                int i = readIndices_[item];
+                int K = alternatives_.size();
+                detail::ScopedLock lock(exitedMutex_);
+                for (int k = 0; k < K; k++)
+                {
+                    if (scored_[i * K + k] && !exited_[k])
+                    {
+                        sums_[k] += scores_[i * K + k];
+                        if (earlyExit_ && sums_[k] < threshold_)
+                        {
+                            exited_[k] = true;
+                            numExited_++;
+                        }
+                    }
+                }
+                return numExited_ < K;
+            }
+
+            const std::vector<float>& Sums() const { return sums_; }
+
+        private:
+            const std::vector<ReadStateType>& reads_;
+            const std::vector<int>& readIndices_;
+            const std::vector<Mutation>& alternatives_;
+            bool earlyExit_;
+            float threshold_;
+            std::vector<float> scores_;
+            std::vector<char> scored_;
+            std::vector<float> sums_;
+            std::vector<char> exited_;
+            int numExited_;
+            detail::Mutex exitedMutex_;
+        };
+
+        //
+        // Moves each read onto the mutated template
+        //
+        template<typename ReadStateType>
+        class TemplateUpdateTask : public ParallelTask
+        {
+        public:
+            TemplateUpdateTask(std::vector<ReadStateType>& reads,
+                               const std::vector<int>& mtp,
+                               const AbstractMultiReadMutationScorer& mms)
+                : reads_(reads),
+                  mtp_(mtp),
+                  mms_(mms)
+            {}
+
+            void Run(int i)
+            {
+                ReadStateType& rs = reads_[i];
+                try {
+                    int newTemplateStart = mtp_[rs.Read->TemplateStart];
+                    int newTemplateEnd   = mtp_[rs.Read->TemplateEnd];
+
+                    // reads (even inactive reads) will have their mapping coords updated
+                    rs.Read->TemplateStart = newTemplateStart;
+                    rs.Read->TemplateEnd   = newTemplateEnd;
+
+                    if (rs.IsActive)
+                    {
+                        rs.Scorer->Template(mms_.Template(rs.Read->Strand,
+                                                          newTemplateStart,
+                                                          newTemplateEnd));
+                    }
+                }
+                catch (AlphaBetaMismatchException& e)
+                {
+                    rs.IsActive = false;
+                }
+            }
+
+        private:
+            std::vector<ReadStateType>& reads_;
+            const std::vector<int>& mtp_;
+            const AbstractMultiReadMutationScorer& mms_;
+        };
+
+        //
+        // A scorer for the read against tpl, or NULL if its alpha and
+        // beta matrices disagree
+        //
+        template<typename ScorerType>
+        ScorerType* MakeScorer(const MappedRead& mr,
+                               const std::string& tpl,
+                               const QuiverConfig& config)
+        {
+            typename ScorerType::EvaluatorType ev(mr, tpl, config.QvParams);
+            typename ScorerType::RecursorType recursor(config.MovesAvailable, config.Banding);
+            try
+            {
+                return new ScorerType(ev, recursor, config.Storage, config.CheckpointInterval);
+            }
+            catch (AlphaBetaMismatchException& e)
+            {
+                return NULL;
+            }
+        }
+
+        //
+        // Moves each active read's screening scorer onto the read's
+        // template, making it if need be; a read whose screening matrices
+        // disagree is left without one until the next template.
+        //
+        template<typename ReadStateType>
+        class ScreeningUpdateTask : public ParallelTask
+        {
+        public:
+            typedef typename ReadStateType::ScreeningScorerType ScreeningScorerType;
+
+            ScreeningUpdateTask(std::vector<ReadStateType>& reads,
+                                const QuiverConfigTable& configs,
+                                const AbstractMultiReadMutationScorer& mms)
+                : reads_(reads),
+                  configs_(configs),
+                  mms_(mms)
+            {}
+
+            void Run(int i)
+            {
+                ReadStateType& rs = reads_[i];
+                if (!rs.IsActive)
+                {
+                    delete rs.ScreeningScorer;
+                    rs.ScreeningScorer = NULL;
+                    return;
+                }
+
+                std::string tpl = mms_.Template(rs.Read->Strand,
+                                                rs.Read->TemplateStart,
+                                                rs.Read->TemplateEnd);
+                if (rs.ScreeningScorer != NULL)
+                {
+                    try
+                    {
+                        rs.ScreeningScorer->Template(tpl);
+                    }
+                    catch (AlphaBetaMismatchException& e)
+                    {
+                        delete rs.ScreeningScorer;
+                        rs.ScreeningScorer = NULL;
+                    }
+                }
+                else
+                {
+                    rs.ScreeningScorer = MakeScorer<ScreeningScorerType>(
+                        *rs.Read, tpl, configs_.At(rs.Read->Chemistry));
+                }
+            }
+
+        private:
+            std::vector<ReadStateType>& reads_;
+            const QuiverConfigTable& configs_;
+            const AbstractMultiReadMutationScorer& mms_;
+        };
+
+        //
+        // Refills a batch of reads' matrices per item
+        //
+        template<typename BatchRecursorType>
+        class BatchRefillTask : public ParallelTask
+        {
+        public:
+            typedef typename BatchRecursorType::RefillType RefillType;
+
+            BatchRefillTask(const BatchRecursorType& recursor,
+                            std::vector<RefillType>& refills)
+                : recursor_(recursor),
+                  refills_(refills)
+            {}
+
+            int NumItems() const
+            {
+                return (refills_.size() + BATCH_RECURSOR_LANES - 1) / BATCH_RECURSOR_LANES;
+            }
+
+            void Run(int k)
+            {
+                typename std::vector<RefillType>::iterator begin, end;
+                begin = refills_.begin() + k * BATCH_RECURSOR_LANES;
+                end = refills_.begin() + std::min<int>(refills_.size(),
+                                                       (k + 1) * BATCH_RECURSOR_LANES);
+                std::vector<RefillType> batch(begin, end);
+                recursor_.RefillAlphaBetas(batch);
+                std::copy(batch.begin(), batch.end(), begin);
+            }
+
+        private:
+            const BatchRecursorType& recursor_;
+            std::vector<RefillType>& refills_;
+        };
+    }
+
 
     template<typename R>
     MultiReadMutationScorer<R>::MultiReadMutationScorer(const QuiverConfigTable& quiverConfigByChemistry,
@@ -132,7 +703,12 @@ namespace ConsensusCore
         : quiverConfigByChemistry_(quiverConfigByChemistry),
           fwdTemplate_(tpl),
           revTemplate_(ReverseComplement(tpl)),
-          reads_()
+          reads_(),
+          threadPool_(new detail::ThreadPool(1)),
+          batchRefills_(false),
+          screening_(false),
+          screeningMargin_(DEFAULT_SCREENING_MARGIN),
+          adaptiveFastScoring_(false)
     {
         DEBUG_ONLY(CheckInvariants());
         fastScoreThreshold_ = 0;
@@ -149,7 +725,12 @@ namespace ConsensusCore
           fastScoreThreshold_(other.fastScoreThreshold_),
           fwdTemplate_(other.fwdTemplate_),
           revTemplate_(other.revTemplate_),
-          reads_()
+          reads_(),
+          threadPool_(new detail::ThreadPool(other.threadPool_->NumThreads())),
+          batchRefills_(other.batchRefills_),
+          screening_(other.screening_),
+          screeningMargin_(other.screeningMargin_),
+          adaptiveFastScoring_(other.adaptiveFastScoring_)
     {
         // Make a deep copy of the readsAndScorers
         foreach (const ReadStateType& read, reads_)
@@ -163,7 +744,9 @@ namespace ConsensusCore
 
     template<typename R>
     MultiReadMutationScorer<R>::~MultiReadMutationScorer()
-    {}
+    {
+        delete threadPool_;
+    }
 
     template<typename R>
     int
@@ -186,6 +769,13 @@ namespace ConsensusCore
         return reads_[readIdx].IsActive ? reads_[readIdx].Read : NULL;
     }
 
+    template<typename R>
+    std::vector<int>
+    MultiReadMutationScorer<R>::Coverage() const
+    {
+        return readIntervals_.Coverage(TemplateLength());
+    }
+
     template<typename R>
     std::string
     MultiReadMutationScorer<R>::Template(StrandEnum strand) const
@@ -215,33 +805,104 @@ namespace ConsensusCore
     MultiReadMutationScorer<R>::ApplyMutations(const std::vector<Mutation>& mutations)
     {
         DEBUG_ONLY(CheckInvariants());
+
+        // Adaptive scoring takes up the history gathered on the old template
+        for (unsigned int i = 0; i < deltaStats_.size(); i++)
+        {
+            deltaStats_[i].Merge(pendingDeltaStats_[i]);
+            pendingDeltaStats_[i] = detail::ReadDeltaStats();
+        }
+
         std::vector<int> mtp = TargetToQueryPositions(mutations, fwdTemplate_);
         fwdTemplate_ = ConsensusCore::ApplyMutations(mutations, fwdTemplate_);
         revTemplate_ = ReverseComplement(fwdTemplate_);
 
-        foreach (ReadStateType& rs, reads_)
+        if (batchRefills_)
+        {
+            // reads (even inactive reads) will have their mapping coords updated
+            foreach (ReadStateType& rs, reads_)
+            {
+                rs.Read->TemplateStart = mtp[rs.Read->TemplateStart];
+                rs.Read->TemplateEnd   = mtp[rs.Read->TemplateEnd];
+            }
+            BatchUpdateTemplates();
+        }
+        else
+        {
+            detail::TemplateUpdateTask<ReadStateType> task(reads_, mtp, *this);
+            threadPool_->ParallelFor(reads_.size(), task);
+        }
+        if (screening_)
+        {
+            UpdateScreeningScorers();
+        }
+
+        // Reads may have been deactivated by the update
+        std::vector<char> isActive(reads_.size());
+        for (unsigned int i = 0; i < reads_.size(); i++)
         {
-            try {
-                int newTemplateStart = mtp[rs.Read->TemplateStart];
-                int newTemplateEnd   = mtp[rs.Read->TemplateEnd];
+            isActive[i] = reads_[i].IsActive;
+        }
+        readIntervals_.Remap(mtp);
+        readIntervals_.Retain(isActive);
+        DEBUG_ONLY(CheckInvariants());
+    }
 
-                // reads (even inactive reads) will have their mapping coords updated
-                rs.Read->TemplateStart = newTemplateStart;
-                rs.Read->TemplateEnd   = newTemplateEnd;
+    template<typename R>
+    void
+    MultiReadMutationScorer<R>::BatchUpdateTemplates()
+    {
+        typedef BatchRecursor<typename R::MatrixType,
+                              typename R::EvaluatorType,
+                              typename R::CombinerType> BatchRecursorType;
+        typedef typename ScorerType::RefillType RefillType;
+        typedef std::map<std::string, std::vector<int> >::iterator GroupIterator;
+
+        // Start each read's template update, leaving out those with
+        // nothing to refill
+        std::vector<RefillType> refills(reads_.size());
+        std::map<std::string, std::vector<int> > readsByChemistry;
+        for (unsigned int i = 0; i < reads_.size(); i++)
+        {
+            ReadStateType& rs = reads_[i];
+            if (rs.IsActive &&
+                rs.Scorer->BeginTemplate(Template(rs.Read->Strand,
+                                                  rs.Read->TemplateStart,
+                                                  rs.Read->TemplateEnd),
+                                         &refills[i]))
+            {
+                readsByChemistry[rs.Read->Chemistry].push_back(i);
+            }
+        }
 
-                if (rs.IsActive)
-                {
-                    rs.Scorer->Template(Template(rs.Read->Strand,
-                                                 newTemplateStart,
-                                                 newTemplateEnd));
-                }
+        // Refill the reads of each chemistry, which share moves and
+        // banding, a batch at a time
+        for (GroupIterator it = readsByChemistry.begin(); it != readsByChemistry.end(); ++it)
+        {
+            const QuiverConfig& config = quiverConfigByChemistry_.At(it->first);
+            BatchRecursorType recursor(config.MovesAvailable, config.Banding);
+
+            std::vector<RefillType> group;
+            foreach (int i, it->second)
+            {
+                group.push_back(refills[i]);
             }
-            catch (AlphaBetaMismatchException& e)
+            detail::BatchRefillTask<BatchRecursorType> task(recursor, group);
+            threadPool_->ParallelFor(task.NumItems(), task);
+
+            for (unsigned int k = 0; k < group.size(); k++)
             {
-                rs.IsActive = false;
+                ReadStateType& rs = reads_[it->second[k]];
+                try
+                {
+                    rs.Scorer->EndTemplate(group[k]);
+                }
+                catch (AlphaBetaMismatchException& e)
+                {
+                    rs.IsActive = false;
+                }
             }
         }
-        DEBUG_ONLY(CheckInvariants());
     }
 
     template<typename R>
@@ -257,7 +918,8 @@ namespace ConsensusCore
         ScorerType* scorer;
         try
         {
-            scorer = new MutationScorer<R>(ev, recursor);
+            scorer = new MutationScorer<R>(ev, recursor, config->Storage,
+                                           config->CheckpointInterval);
         }
         catch (AlphaBetaMismatchException& e)
         {
@@ -279,7 +941,19 @@ namespace ConsensusCore
         }
 
         bool isActive = scorer != NULL;
-        reads_.push_back(ReadStateType(new MappedRead(mr), scorer, isActive));
+        ScreeningScorerType* screeningScorer = NULL;
+        if (isActive && screening_)
+        {
+            screeningScorer = detail::MakeScorer<ScreeningScorerType>(
+                mr, ev.Template(), *config);
+        }
+        if (isActive)
+        {
+            readIntervals_.Add(reads_.size(), mr.TemplateStart, mr.TemplateEnd);
+        }
+        reads_.push_back(ReadStateType(new MappedRead(mr), scorer, isActive, screeningScorer));
+        deltaStats_.push_back(detail::ReadDeltaStats());
+        pendingDeltaStats_.push_back(detail::ReadDeltaStats());
         DEBUG_ONLY(CheckInvariants());
         return isActive;
     }
@@ -292,20 +966,20 @@ namespace ConsensusCore
         return AddRead(mr, config->AddThreshold);
     }
 
+    template<typename R>
+    float MultiReadMutationScorer<R>::SumScores(const Mutation& m, bool earlyExit) const
+    {
+        std::vector<int> touched = readIntervals_.Overlapping(m.Start(), m.End());
+        detail::MutationScoringTask<ReadStateType> task(reads_, touched, m, 0.0f,
+                                                        earlyExit, fastScoreThreshold_);
+        threadPool_->ParallelFor(task.NumItems(), task);
+        return task.Sum();
+    }
+
     template<typename R>
     float MultiReadMutationScorer<R>::Score(const Mutation& m) const
     {
-        float sum = 0;
-        foreach (const ReadStateType& rs, reads_)
-        {
-            if (rs.IsActive && ReadScoresMutation(*rs.Read, m))
-            {
-                Mutation orientedMut = OrientedMutation(*rs.Read, m);
-                sum += (rs.Scorer->ScoreMutation(orientedMut) -
-                        rs.Scorer->Score());
-            }
-        }
-        return sum;
+        return SumScores(m, false);
     }
 
     template<typename R>
@@ -319,42 +993,18 @@ namespace ConsensusCore
     template<typename R>
     float MultiReadMutationScorer<R>::FastScore(const Mutation& m) const
     {
-        float sum = 0;
-        foreach (const ReadStateType& rs, reads_)
-        {
-            if (rs.IsActive && ReadScoresMutation(*rs.Read, m))
-            {
-                Mutation orientedMut = OrientedMutation(*rs.Read, m);
-                sum += (rs.Scorer->ScoreMutation(orientedMut) -
-                        rs.Scorer->Score());
-                if (sum < fastScoreThreshold_)
-                {
-                    return sum;
-                }
-            }
-        }
-        return sum;
+        return SumScores(m, true);
     }
 
     template<typename R>
     std::vector<float>
     MultiReadMutationScorer<R>::Scores(const Mutation& m, float unscoredValue) const
     {
-        std::vector<float> scoreByRead;
-        foreach (const ReadStateType& rs, reads_)
-        {
-            if (rs.IsActive && ReadScoresMutation(*rs.Read, m))
-            {
-                Mutation orientedMut = OrientedMutation(*rs.Read, m);
-                scoreByRead.push_back(rs.Scorer->ScoreMutation(orientedMut) -
-                                      rs.Scorer->Score());
-            }
-            else
-            {
-                scoreByRead.push_back(unscoredValue);
-            }
-        }
-        return scoreByRead;
+        std::vector<int> touched = readIntervals_.Overlapping(m.Start(), m.End());
+        detail::MutationScoringTask<ReadStateType> task(reads_, touched, m, unscoredValue,
+                                                        false, fastScoreThreshold_);
+        threadPool_->ParallelFor(task.NumItems(), task);
+        return task.Scores();
     }
 
     template<typename R>
@@ -367,39 +1017,228 @@ namespace ConsensusCore
     }
 
     template<typename R>
-    bool MultiReadMutationScorer<R>::IsFavorable(const Mutation& m) const
+    std::vector<float>
+    MultiReadMutationScorer<R>::ScoreMutations(const std::vector<Mutation>& mutations) const
     {
-        float sum = 0;
-        foreach (const ReadStateType& rs, reads_)
+        detail::BatchScoringTask<ReadStateType> task(reads_, mutations, 0.0f,
+                                                     NumChunks(mutations.size()));
+        threadPool_->ParallelFor(task.NumItems(), task);
+        return task.Sums();
+    }
+
+    template<typename R>
+    std::vector<float>
+    MultiReadMutationScorer<R>::ScoresMatrix(const std::vector<Mutation>& mutations,
+                                             float unscoredValue) const
+    {
+        detail::BatchScoringTask<ReadStateType> task(reads_, mutations, unscoredValue,
+                                                     NumChunks(mutations.size()));
+        threadPool_->ParallelFor(task.NumItems(), task);
+        return task.ScoresMatrix();
+    }
+
+    template<typename R>
+    std::vector<float>
+    MultiReadMutationScorer<R>::SumSiteScores(const std::vector<Mutation>& alternatives,
+                                              bool earlyExit) const
+    {
+        std::vector<int> touched;
+        if (!alternatives.empty())
         {
-            if (rs.IsActive && ReadScoresMutation(*rs.Read, m))
+            int begin = alternatives[0].Start(), end = alternatives[0].End();
+            foreach (const Mutation& m, alternatives)
             {
-                Mutation orientedMut = OrientedMutation(*rs.Read, m);
-                sum += (rs.Scorer->ScoreMutation(orientedMut) -
-                        rs.Scorer->Score());
+                begin = std::min(begin, m.Start());
+                end = std::max(end, m.End());
             }
+            touched = readIntervals_.Overlapping(begin, end);
+        }
+        detail::SiteScoringTask<ReadStateType> task(reads_, touched, alternatives,
+                                                    earlyExit, fastScoreThreshold_);
+        threadPool_->ParallelFor(task.NumItems(), task);
+        return task.Sums();
+    }
+
+    template<typename R>
+    std::vector<float>
+    MultiReadMutationScorer<R>::SumSiteScores(int pos, bool earlyExit) const
+    {
+        int identity = -1;
+        std::vector<Mutation> alternatives = detail::SiteAlternatives(fwdTemplate_, pos, &identity);
+        std::vector<float> sums = SumSiteScores(alternatives, earlyExit);
+        if (identity >= 0)
+        {
+            sums.insert(sums.begin() + identity, 0.0f);
+        }
+        return sums;
+    }
+
+    template<typename R>
+    std::vector<float> MultiReadMutationScorer<R>::ScoreSite(int pos) const
+    {
+        return SumSiteScores(pos, false);
+    }
+
+    template<typename R>
+    std::vector<float> MultiReadMutationScorer<R>::FastScoreSite(int pos) const
+    {
+        return SumSiteScores(pos, true);
+    }
+
+    template<typename R>
+    std::vector<float>
+    MultiReadMutationScorer<R>::ScoreSite(const std::vector<Mutation>& alternatives) const
+    {
+        return SumSiteScores(alternatives, false);
+    }
+
+    template<typename R>
+    std::vector<float>
+    MultiReadMutationScorer<R>::FastScoreSite(const std::vector<Mutation>& alternatives) const
+    {
+        return SumSiteScores(alternatives, true);
+    }
+
+    template<typename R>
+    int MultiReadMutationScorer<R>::NumChunks(int numMutations) const
+    {
+        // Enough work items to keep every thread busy, if there are
+        // mutations enough to go round
+        int numThreads = threadPool_->NumThreads();
+        int numReads = std::max(1, NumReads());
+        int numChunks = (2 * numThreads + numReads - 1) / numReads;
+        numChunks = std::min(numChunks, numMutations / MIN_BATCH_CHUNK_SIZE);
+        return std::max(1, numThreads > 1 ? numChunks : 1);
+    }
+
+    template<typename R>
+    void MultiReadMutationScorer<R>::ScoreMutations(int numMutations,
+                                                    const int* mutationTypes,
+                                                    const int* positions,
+                                                    const char* bases,
+                                                    float* scores) const
+    {
+        std::vector<Mutation> mutations;
+        mutations.reserve(numMutations);
+        for (int k = 0; k < numMutations; k++)
+        {
+            mutations.push_back(Mutation(static_cast<MutationType>(mutationTypes[k]),
+                                         positions[k], bases[k]));
         }
-        return (sum > MIN_FAVORABLE_SCOREDIFF);
+        std::vector<float> sums = ScoreMutations(mutations);
+        std::copy(sums.begin(), sums.end(), scores);
+    }
+
+    template<typename R>
+    bool MultiReadMutationScorer<R>::IsFavorable(const Mutation& m) const
+    {
+        return (SumScores(m, false) > MIN_FAVORABLE_SCOREDIFF);
     }
 
     template<typename R>
     bool MultiReadMutationScorer<R>::FastIsFavorable(const Mutation& m) const
     {
-        float sum = 0;
-        foreach (const ReadStateType& rs, reads_)
+        if (screening_ && ScreenedOut(m))
+        {
+            return false;
+        }
+        if (adaptiveFastScoring_)
+        {
+            return AdaptiveIsFavorable(m);
+        }
+        // An early exit leaves sum < fastScoreThreshold_ <= 0
+        return (SumScores(m, true) > MIN_FAVORABLE_SCOREDIFF);
+    }
+
+    template<typename R>
+    bool MultiReadMutationScorer<R>::AdaptiveIsFavorable(const Mutation& m) const
+    {
+        const double infinity = std::numeric_limits<double>::infinity();
+
+        // The reads the mutation touches, and their histories
+        std::vector<int> touched;
+        foreach (int i, readIntervals_.Overlapping(m.Start(), m.End()))
+        {
+            if (ReadScoresMutation(*reads_[i].Read, m)) touched.push_back(i);
+        }
+        int N = touched.size();
+        std::vector<detail::ReadDeltaStats> stats(N);
+        for (int k = 0; k < N; k++)
         {
-            if (rs.IsActive && ReadScoresMutation(*rs.Read, m))
+            stats[k] = deltaStats_[touched[k]];
+        }
+
+        // Most often decisive first; and the widest differences any of
+        // them with a history has given, for bounding those without one
+        std::vector<int> ranks(N);
+        detail::ReadDeltaStats widest;
+        for (int k = 0; k < N; k++)
+        {
+            ranks[k] = k;
+            if (stats[k].Count >= ADAPTIVE_MIN_HISTORY)
             {
-                Mutation orientedMut = OrientedMutation(*rs.Read, m);
-                sum += (rs.Scorer->ScoreMutation(orientedMut) -
-                        rs.Scorer->Score());
-                if (sum < fastScoreThreshold_)
-                {
-                    return false;
-                }
+                widest.Add(stats[k].Min);
+                widest.Add(stats[k].Max);
             }
         }
-        return (sum > MIN_FAVORABLE_SCOREDIFF);
+        std::stable_sort(ranks.begin(), ranks.end(), detail::MoreDecisive(stats));
+        std::vector<int> order(N);
+        for (int k = 0; k < N; k++)
+        {
+            order[k] = touched[ranks[k]];
+        }
+
+        // Bounds on what the reads from each place in the order on could
+        // add to the sum; unbounded until some read has a history
+        double widestBound = widest.Count > 0 ? widest.Bound() : infinity;
+        std::vector<double> remainingUpper(N + 1, 0.0);
+        for (int k = N - 1; k >= 0; k--)
+        {
+            const detail::ReadDeltaStats& s = stats[ranks[k]];
+            double bound = s.Count >= ADAPTIVE_MIN_HISTORY ? s.Bound() : widestBound;
+            remainingUpper[k] = remainingUpper[k + 1] + bound;
+        }
+
+        detail::AdaptiveScoringTask<ReadStateType> task(reads_, m, order,
+                                                        remainingUpper, fastScoreThreshold_);
+        threadPool_->ParallelFor(N, task);
+
+        // Tallied apart from the history in use until the next template
+        // edit; the tally's sums and extremes come out the same whatever
+        // order the mutations are scored in
+        {
+            detail::ScopedLock lock(deltaStatsMutex_);
+            for (int k = 0; k < task.NumScored(); k++)
+            {
+                pendingDeltaStats_[order[k]].Add(task.Scores()[k]);
+            }
+            if (task.Decisive() >= 0) pendingDeltaStats_[task.Decisive()].Decisive++;
+        }
+        return task.Favorable();
+    }
+
+    template<typename R>
+    bool MultiReadMutationScorer<R>::ScreenedOut(const Mutation& m) const
+    {
+        // As for FastIsFavorable, an early exit leaves the sum below zero
+        std::vector<int> touched = readIntervals_.Overlapping(m.Start(), m.End());
+        detail::MutationScoringTask<ReadStateType> task(reads_, touched, m, 0.0f, true,
+                                                        fastScoreThreshold_,
+                                                        true, screeningMargin_);
+        threadPool_->ParallelFor(task.NumItems(), task);
+        bool screenedOut = !(task.Sum() > MIN_FAVORABLE_SCOREDIFF);
+
+        detail::ScopedLock lock(screeningMutex_);
+        screeningCounters_.MutationsScreened++;
+        if (screenedOut) screeningCounters_.MutationsScreenedOut++;
+        return screenedOut;
+    }
+
+    template<typename R>
+    void MultiReadMutationScorer<R>::UpdateScreeningScorers()
+    {
+        detail::ScreeningUpdateTask<ReadStateType> task(reads_, quiverConfigByChemistry_, *this);
+        threadPool_->ParallelFor(reads_.size(), task);
     }
 
 
@@ -455,6 +1294,45 @@ namespace ConsensusCore
     }
 
 
+    template<typename R>
+    ScorerCounters MultiReadMutationScorer<R>::Counters() const
+    {
+        ScorerCounters total;
+        foreach (const ReadStateType& rs, reads_)
+        {
+            if (rs.Scorer != NULL) total.Add(rs.Scorer->Counters());
+            if (rs.ScreeningScorer != NULL) total.Add(rs.ScreeningScorer->Counters());
+        }
+        detail::ScopedLock lock(screeningMutex_);
+        total.Add(screeningCounters_);
+        return total;
+    }
+
+
+    template<typename R>
+    ScorerCounters MultiReadMutationScorer<R>::Counters(int readIndex) const
+    {
+        const ReadStateType& rs = reads_[readIndex];
+        ScorerCounters counters;
+        if (rs.Scorer != NULL) counters.Add(rs.Scorer->Counters());
+        if (rs.ScreeningScorer != NULL) counters.Add(rs.ScreeningScorer->Counters());
+        return counters;
+    }
+
+
+    template<typename R>
+    void MultiReadMutationScorer<R>::ResetCounters()
+    {
+        foreach (ReadStateType& rs, reads_)
+        {
+            if (rs.Scorer != NULL) rs.Scorer->ResetCounters();
+            if (rs.ScreeningScorer != NULL) rs.ScreeningScorer->ResetCounters();
+        }
+        detail::ScopedLock lock(screeningMutex_);
+        screeningCounters_.Reset();
+    }
+
+
     template<typename R>
     float MultiReadMutationScorer<R>::BaselineScore() const
     {
@@ -478,13 +1356,101 @@ namespace ConsensusCore
         return scoreByRead;
     }
 
+    template<typename R>
+    int MultiReadMutationScorer<R>::NumThreads() const
+    {
+        return threadPool_->NumThreads();
+    }
+
+
+    template<typename R>
+    void MultiReadMutationScorer<R>::NumThreads(int numThreads)
+    {
+        detail::ThreadPool* pool = new detail::ThreadPool(numThreads);
+        delete threadPool_;
+        threadPool_ = pool;
+    }
+
+
+    template<typename R>
+    bool MultiReadMutationScorer<R>::BatchRefills() const
+    {
+        return batchRefills_;
+    }
+
+
+    template<typename R>
+    void MultiReadMutationScorer<R>::BatchRefills(bool batchRefills)
+    {
+        batchRefills_ = batchRefills;
+    }
+
+
+    template<typename R>
+    bool MultiReadMutationScorer<R>::Screening() const
+    {
+        return screening_;
+    }
+
+
+    template<typename R>
+    void MultiReadMutationScorer<R>::Screening(bool screening)
+    {
+        if (screening == screening_) return;
+        screening_ = screening;
+        if (screening_)
+        {
+            UpdateScreeningScorers();
+        }
+        else
+        {
+            foreach (ReadStateType& rs, reads_)
+            {
+                delete rs.ScreeningScorer;
+                rs.ScreeningScorer = NULL;
+            }
+        }
+        DEBUG_ONLY(CheckInvariants());
+    }
+
+
+    template<typename R>
+    float MultiReadMutationScorer<R>::ScreeningMargin() const
+    {
+        return screeningMargin_;
+    }
+
+
+    template<typename R>
+    void MultiReadMutationScorer<R>::ScreeningMargin(float margin)
+    {
+        screeningMargin_ = margin;
+    }
+
+
+    template<typename R>
+    bool MultiReadMutationScorer<R>::AdaptiveFastScoring() const
+    {
+        return adaptiveFastScoring_;
+    }
+
+
+    template<typename R>
+    void MultiReadMutationScorer<R>::AdaptiveFastScoring(bool adaptive)
+    {
+        adaptiveFastScoring_ = adaptive;
+    }
+
+
     template<typename R>
     void MultiReadMutationScorer<R>::CheckInvariants() const
     {
 #ifndef NDEBUG
         assert(revTemplate_ == ReverseComplement(fwdTemplate_));
+        int numActive = 0;
         foreach (const ReadStateType& rs, reads_)
         {
+            numActive += rs.IsActive;
             rs.CheckInvariants();
             if (rs.IsActive) {
                 assert(rs.Scorer->Template() == Template(rs.Read->Strand,
@@ -495,6 +1461,7 @@ namespace ConsensusCore
                 assert(rs.Read->TemplateStart <= rs.Read->TemplateEnd);
             }
         }
+        assert(readIntervals_.Size() == numActive);
 #endif  // !NDEBUG
     }
 
@@ -518,37 +1485,45 @@ namespace ConsensusCore
 
     namespace detail {
 
-        template<typename ScorerType>
-        ReadState<ScorerType>::ReadState(MappedRead* read,
-                                         ScorerType* scorer,
-                                         bool isActive)
+        template<typename S, typename T>
+        ReadState<S, T>::ReadState(MappedRead* read,
+                                   ScorerType* scorer,
+                                   bool isActive,
+                                   ScreeningScorerType* screeningScorer)
             : Read(read),
               Scorer(scorer),
-              IsActive(isActive)
+              IsActive(isActive),
+              ScreeningScorer(screeningScorer)
         {
             CheckInvariants();
         }
 
-        template<typename ScorerType>
-        ReadState<ScorerType>::ReadState(const ReadState& other)
+        template<typename S, typename T>
+        ReadState<S, T>::ReadState(const ReadState& other)
             : Read(NULL),
               Scorer(NULL),
-              IsActive(other.IsActive)
+              IsActive(other.IsActive),
+              ScreeningScorer(NULL)
         {
             if (other.Read != NULL) Read = new MappedRead(*other.Read);
             if (other.Scorer != NULL) Scorer = new ScorerType(*other.Scorer);
+            if (other.ScreeningScorer != NULL)
+            {
+                ScreeningScorer = new ScreeningScorerType(*other.ScreeningScorer);
+            }
             CheckInvariants();
         }
 
-        template<typename ScorerType>
-        ReadState<ScorerType>::~ReadState()
+        template<typename S, typename T>
+        ReadState<S, T>::~ReadState()
         {
             if (Read != NULL) delete Read;
             if (Scorer != NULL) delete Scorer;
+            if (ScreeningScorer != NULL) delete ScreeningScorer;
         }
 
-        template<typename ScorerType>
-        void ReadState<ScorerType>::CheckInvariants() const
+        template<typename S, typename T>
+        void ReadState<S, T>::CheckInvariants() const
         {
 #ifndef NDEBUG
             if (IsActive)
@@ -556,12 +1531,14 @@ namespace ConsensusCore
                 assert(Read != NULL && Scorer != NULL);
                 assert((int)Scorer->Template().length() ==
                        Read->TemplateEnd - Read->TemplateStart);
+                assert(ScreeningScorer == NULL ||
+                       ScreeningScorer->Template() == Scorer->Template());
             }
 #endif  // !NDEBUG
         }
 
-        template<typename ScorerType>
-        std::string ReadState<ScorerType>::ToString() const
+        template<typename S, typename T>
+        std::string ReadState<S, T>::ToString() const
         {
             std::string score;
             if (IsActive)
@@ -578,6 +1555,38 @@ namespace ConsensusCore
     }
 
 
+    namespace detail {
+
+        ReadDeltaStats::ReadDeltaStats()
+            : Count(0),
+              Min(FLT_MAX),
+              Max(-FLT_MAX),
+              Decisive(0)
+        {}
+
+        void ReadDeltaStats::Add(float delta)
+        {
+            Count++;
+            Min = std::min(Min, delta);
+            Max = std::max(Max, delta);
+        }
+
+        void ReadDeltaStats::Merge(const ReadDeltaStats& other)
+        {
+            Count += other.Count;
+            Min = std::min(Min, other.Min);
+            Max = std::max(Max, other.Max);
+            Decisive += other.Decisive;
+        }
+
+        float ReadDeltaStats::Bound() const
+        {
+            return std::max(-Min, Max);
+        }
+    }
+
+
     template class MultiReadMutationScorer<SparseSseQvRecursor>;
     template class MultiReadMutationScorer<SparseSseQvSumProductRecursor>;
+    template class MultiReadMutationScorer<SparseScaledQvSumProductRecursor>;
 }
@@ -48,10 +48,36 @@
 #include "Matrix/AbstractMatrix.hpp"
 #include "Quiver/MutationScorer.hpp"
 #include "Quiver/QuiverConfig.hpp"
+#include "Quiver/ScaledRecursor.hpp"
+#include "Quiver/ScorerCounters.hpp"
 #include "Quiver/SseRecursor.hpp"
+#include "Quiver/detail/Mutex.hpp"
+#include "Quiver/detail/ReadIntervalIndex.hpp"
+
+// The number of single-base edits ScoreSite scores at a position
+#define SITE_ALTERNATIVES 9
+
+// The least score difference IsFavorable and FastIsFavorable accept
+#define MIN_FAVORABLE_SCOREDIFF 0.04  // Chosen such that 0.49 = 1 / (1 + exp(minScoreDiff))
+
+// The allowance screening makes for each read's Viterbi score difference
+// falling short of the sum-product one; on simulated C2 reads the shortfall
+// stays under 1.5, the largest for insertions into homopolymers
+#define DEFAULT_SCREENING_MARGIN 2.0
+
+// How many score differences a read must have given before adaptive fast
+// scoring bounds its contribution by them, rather than by all the reads'
+#define ADAPTIVE_MIN_HISTORY 16
+
+// The thread count asking for one thread per online processor
+#define ALL_PROCESSORS -1
 
 namespace ConsensusCore {
 
+    namespace detail {
+        class ThreadPool;
+    }
+
     class AbstractMultiReadMutationScorer
     {
     protected:
@@ -63,6 +89,9 @@ namespace ConsensusCore {
         virtual int NumReads() const = 0;
         virtual const MappedRead* Read(int readIndex) const = 0;
 
+        // The number of active reads mapped over each template position
+        virtual std::vector<int> Coverage() const = 0;
+
         virtual std::string Template(StrandEnum strand = FORWARD_STRAND) const = 0;
         virtual std::string Template(StrandEnum strand,
                                      int templateStart,
@@ -91,6 +120,31 @@ namespace ConsensusCore {
         virtual bool IsFavorable(const Mutation& m) const = 0;
         virtual bool FastIsFavorable(const Mutation& m) const = 0;
 
+        // Score a batch of mutations in one call: entry k of the result
+        // is Score(mutations[k]).
+        virtual std::vector<float> ScoreMutations(const std::vector<Mutation>& mutations) const = 0;
+
+        // The per-read score differences for a batch of mutations, as a
+        // NumReads x mutations.size() matrix in row-major order (entry
+        // i * mutations.size() + k is Scores(mutations[k])[i]).
+        virtual std::vector<float> ScoresMatrix(const std::vector<Mutation>& mutations,
+                                                float unscoredValue) const = 0;
+
+        // The score differences of the SITE_ALTERNATIVES single-base edits
+        // at template position pos, scored together for each read: the
+        // substitutions by A, C, G and T, the insertions of A, C, G and T
+        // before pos, and the deletion of pos.  Entry k is Score (or, for
+        // FastScoreSite, FastScore) of alternative k; the substitution by
+        // the base already there scores 0.
+        virtual std::vector<float> ScoreSite(int pos) const = 0;
+        virtual std::vector<float> FastScoreSite(int pos) const = 0;
+
+        // Likewise for the given alternatives, which should all be at (or
+        // next to) one site, such as those a MutationEnumerator gives for
+        // one position.
+        virtual std::vector<float> ScoreSite(const std::vector<Mutation>& alternatives) const = 0;
+        virtual std::vector<float> FastScoreSite(const std::vector<Mutation>& alternatives) const = 0;
+
         // Rough estimate of memory consumption of scoring machinery
         virtual std::vector<int> AllocatedMatrixEntries() const = 0;
         virtual std::vector<int> UsedMatrixEntries() const = 0;
@@ -98,6 +152,13 @@ namespace ConsensusCore {
         virtual const AbstractMatrix* BetaMatrix(int i) const = 0;
         virtual std::vector<int> NumFlipFlops() const = 0;
 
+        // The work done filling matrices and scoring mutations for one
+        // read, and summed over all of them (see ScorerCounters).  Reads
+        // the scorer rejected have no counters.
+        virtual ScorerCounters Counters() const = 0;
+        virtual ScorerCounters Counters(int readIndex) const = 0;
+        virtual void ResetCounters() = 0;
+
 #if !defined(SWIG) || defined(SWIGCSHARP)
         // Alternate entry points for C# code, not requiring zillions of object
         // allocations.
@@ -107,6 +168,13 @@ namespace ConsensusCore {
                                           float unscoredValue) const = 0;
         virtual std::vector<float> Scores(MutationType mutationType,
                                           int position, char base) const = 0;
+        // Batch version of Score: mutation k is (mutationTypes[k],
+        // positions[k], bases[k]) and its score goes into scores[k].
+        virtual void ScoreMutations(int numMutations,
+                                    const int* mutationTypes,
+                                    const int* positions,
+                                    const char* bases,
+                                    float* scores) const = 0;
 #endif
 
         // Return the actual sum of scores for the current template.
@@ -115,6 +183,52 @@ namespace ConsensusCore {
         virtual float BaselineScore() const = 0;
         virtual std::vector<float> BaselineScores() const = 0;
 
+        // Number of threads used to score mutations and apply template
+        // edits across the reads (default 1; ALL_PROCESSORS means one per
+        // processor, and 0 is taken as 1).
+        // Results are identical to the single-threaded ones.
+        virtual int NumThreads() const = 0;
+        virtual void NumThreads(int numThreads) = 0;
+
+        // Whether ApplyMutations refills the reads' matrices a batch of
+        // reads at a time, with the BatchRecursor, rather than each with
+        // its own recursor (default false).
+        virtual bool BatchRefills() const = 0;
+        virtual void BatchRefills(bool batchRefills) = 0;
+
+        // Whether FastIsFavorable screens mutations first on Viterbi
+        // matrices kept alongside the reads' own (default false).  A
+        // mutation whose Viterbi score differences, each raised by
+        // ScreeningMargin, sum to no more than MIN_FAVORABLE_SCOREDIFF is
+        // rejected without being scored exactly; the others are scored
+        // as usual.
+        // This pays off for sum-product scorers, whose matrices are the
+        // dearer to score against; the counters record how many
+        // mutations were screened, and how many rejected.
+        virtual bool Screening() const = 0;
+        virtual void Screening(bool screening) = 0;
+        virtual float ScreeningMargin() const = 0;
+        virtual void ScreeningMargin(float margin) = 0;
+
+        // Whether FastIsFavorable scores the reads a mutation touches in
+        // adaptive order (default false): the reads that have most often
+        // been decisive in rejecting a mutation early go first, and
+        // scoring stops once the reads left seem unable to make it
+        // favorable, judging by the largest score difference, either way,
+        // each has given (reads with too short a history take the widest
+        // of the others').  The history gathered on one template is taken
+        // up at the next ApplyMutations, so the decisions do not depend on
+        // the order mutations are scored in, or on the threads scoring
+        // them.
+        // The bounds are a heuristic, not a proof: a read only adds to its
+        // history when scored before the early exit, and a real variant
+        // can differ by more than anything a read has given before, so a
+        // favorable mutation may be rejected.  Acceptances are those of
+        // IsFavorable, all reads being scored.  (On simulated reads, with
+        // errors planted after the history was gathered, none of the
+        // favorable mutations were rejected.)
+        virtual bool AdaptiveFastScoring() const = 0;
+        virtual void AdaptiveFastScoring(bool adaptive) = 0;
 
         virtual std::string ToString() const = 0;
     };
@@ -125,22 +239,48 @@ namespace ConsensusCore {
 
 
     namespace detail {
-        template<typename ScorerType>
+        template<typename ScorerT, typename ScreeningScorerT>
         struct ReadState
         {
+            typedef ScorerT          ScorerType;
+            typedef ScreeningScorerT ScreeningScorerType;
+
             MappedRead* Read;
             ScorerType* Scorer;
             bool IsActive;
 
+            // NULL unless screening, or if the read's Viterbi matrices
+            // disagree on the current template
+            ScreeningScorerType* ScreeningScorer;
+
             ReadState(MappedRead* read,
                       ScorerType* scorer,
-                      bool isActive);
+                      bool isActive,
+                      ScreeningScorerType* screeningScorer = NULL);
 
             ReadState(const ReadState& other);
             ~ReadState();
             void CheckInvariants() const;
             std::string ToString() const;
         };
+
+        // The score differences a read has given in adaptive fast scoring
+        struct ReadDeltaStats
+        {
+            int Count;
+            float Min;
+            float Max;
+            int Decisive;   // Times it tipped a mutation into early rejection
+
+            ReadDeltaStats();
+            void Add(float delta);
+            void Merge(const ReadDeltaStats& other);
+
+            // The largest difference, either way, it has given.  Undoing
+            // a mutation reverses its difference, so most of the reads'
+            // differences being losses does not make gains any smaller.
+            float Bound() const;
+        };
     }
 
     template<typename R>
@@ -150,7 +290,12 @@ namespace ConsensusCore {
         typedef R                                         RecursorType;
         typedef typename R::EvaluatorType                 EvaluatorType;
         typedef typename ConsensusCore::MutationScorer<R> ScorerType;
-        typedef typename detail::ReadState<ScorerType>    ReadStateType;
+        typedef SseRecursor<typename R::MatrixType,
+                            typename R::EvaluatorType,
+                            detail::ViterbiCombiner>      ScreeningRecursorType;
+        typedef typename ConsensusCore::MutationScorer<ScreeningRecursorType> ScreeningScorerType;
+        typedef typename detail::ReadState<ScorerType,
+                                           ScreeningScorerType> ReadStateType;
 
     public:
         MultiReadMutationScorer(const QuiverConfigTable& paramsByChemistry, std::string tpl);
@@ -160,6 +305,7 @@ namespace ConsensusCore {
         int TemplateLength() const;
         int NumReads() const;
         const MappedRead* Read(int readIndex) const;
+        std::vector<int> Coverage() const;
 
         std::string Template(StrandEnum strand = FORWARD_STRAND) const;
         std::string Template(StrandEnum strand, int templateStart, int templateEnd) const;
@@ -189,6 +335,15 @@ namespace ConsensusCore {
         bool IsFavorable(const Mutation& m) const;
         bool FastIsFavorable(const Mutation& m) const;
 
+        std::vector<float> ScoreMutations(const std::vector<Mutation>& mutations) const;
+        std::vector<float> ScoresMatrix(const std::vector<Mutation>& mutations,
+                                        float unscoredValue) const;
+
+        std::vector<float> ScoreSite(int pos) const;
+        std::vector<float> FastScoreSite(int pos) const;
+        std::vector<float> ScoreSite(const std::vector<Mutation>& alternatives) const;
+        std::vector<float> FastScoreSite(const std::vector<Mutation>& alternatives) const;
+
         // Rough estimate of memory consumption of scoring machinery
         std::vector<int> AllocatedMatrixEntries() const;
         std::vector<int> UsedMatrixEntries() const;
@@ -196,6 +351,10 @@ namespace ConsensusCore {
         const AbstractMatrix* BetaMatrix(int i) const;
         std::vector<int> NumFlipFlops() const;
 
+        ScorerCounters Counters() const;
+        ScorerCounters Counters(int readIndex) const;
+        void ResetCounters();
+
 #if !defined(SWIG) || defined(SWIGCSHARP)
         // Alternate entry points for C# code, not requiring zillions of object
         // allocations.
@@ -208,6 +367,11 @@ namespace ConsensusCore {
         {
             return Scores(mutationType, position, base, 0.0f);
         }
+        void ScoreMutations(int numMutations,
+                            const int* mutationTypes,
+                            const int* positions,
+                            const char* bases,
+                            float* scores) const;
 #endif
 
     public:
@@ -217,22 +381,86 @@ namespace ConsensusCore {
         float BaselineScore() const;
         std::vector<float> BaselineScores() const;
 
+    public:
+        int NumThreads() const;
+        void NumThreads(int numThreads);
+        bool BatchRefills() const;
+        void BatchRefills(bool batchRefills);
+        bool Screening() const;
+        void Screening(bool screening);
+        float ScreeningMargin() const;
+        void ScreeningMargin(float margin);
+        bool AdaptiveFastScoring() const;
+        void AdaptiveFastScoring(bool adaptive);
+
     public:
         std::string ToString() const;
 
     private:
         void CheckInvariants() const;
 
+        // Sum of the per-read score differences for the mutation, added
+        // in read order; if earlyExit, stops as soon as the running sum
+        // falls below fastScoreThreshold_.
+        float SumScores(const Mutation& m, bool earlyExit) const;
+
+        // Likewise for each of the alternatives at a site
+        std::vector<float> SumSiteScores(const std::vector<Mutation>& alternatives,
+                                         bool earlyExit) const;
+        std::vector<float> SumSiteScores(int pos, bool earlyExit) const;
+
+        // Would screening reject the mutation?  Reads that could not be
+        // screened are scored exactly.
+        bool ScreenedOut(const Mutation& m) const;
+
+        // Bring the reads' screening scorers onto the current template
+        void UpdateScreeningScorers();
+
+        // FastIsFavorable, scoring the reads in adaptive order
+        bool AdaptiveIsFavorable(const Mutation& m) const;
+
+        // How many pieces to split each read's share of a batch of
+        // mutations into, for scoring on the thread pool
+        int NumChunks(int numMutations) const;
+
+        // Move the active reads onto the current template, refilling
+        // their matrices with the BatchRecursor, the reads of each
+        // chemistry together
+        void BatchUpdateTemplates();
+
     private:
         QuiverConfigTable quiverConfigByChemistry_;
         float fastScoreThreshold_;
         std::string fwdTemplate_;
         std::string revTemplate_;
         std::vector<ReadStateType> reads_;
+        detail::ThreadPool* threadPool_;
+
+        // The active reads' template intervals, so that scoring a
+        // mutation visits only the reads over it
+        detail::ReadIntervalIndex readIntervals_;
+
+        bool batchRefills_;
+        bool screening_;
+        float screeningMargin_;
+
+        // Screening tallies, kept here rather than by the reads' scorers
+        mutable ScorerCounters screeningCounters_;
+        mutable detail::Mutex screeningMutex_;
+
+        // Each read's history for adaptive fast scoring, indexed as
+        // reads_: that in use, fixed between template edits, and that
+        // gathered since the last edit
+        bool adaptiveFastScoring_;
+        std::vector<detail::ReadDeltaStats> deltaStats_;
+        mutable std::vector<detail::ReadDeltaStats> pendingDeltaStats_;
+        mutable detail::Mutex deltaStatsMutex_;
     };
 
     typedef MultiReadMutationScorer<SparseSseQvRecursor> \
       SparseSseQvMultiReadMutationScorer;
     typedef MultiReadMutationScorer<SparseSseQvSumProductRecursor> \
       SparseSseQvSumProductMultiReadMutationScorer;
+    typedef MultiReadMutationScorer<SparseScaledQvSumProductRecursor> \
+      SparseScaledQvSumProductMultiReadMutationScorer;
 }
@@ -0,0 +1,248 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#include "Quiver/MutationScoreCache.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Utils.hpp"
+
+namespace ConsensusCore
+{
+    namespace {
+        // Whether m is within distance bases of any of the edits
+        bool NearEdits(const Mutation& m, const std::vector<Mutation>& edits, int distance)
+        {
+            foreach (const Mutation& e, edits)
+            {
+                if (m.Start() - distance <= e.End() && e.Start() <= m.End() + distance)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Whether m lies within any of the template spans
+        bool Covered(const Mutation& m, const std::vector<std::pair<int, int> >& spans)
+        {
+            for (unsigned int k = 0; k < spans.size(); k++)
+            {
+                if (m.Start() <= spans[k].second && spans[k].first <= m.End())
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    MutationScoreCache::Entry::Entry()
+        : Score(0),
+          FastScore(0),
+          HasScore(false),
+          HasFastScore(false)
+    {}
+
+    MutationScoreCache::MutationScoreCache(int invalidationDistance)
+        : invalidationDistance_(invalidationDistance),
+          scorer_(NULL),
+          scorerReads_(0),
+          hits_(0),
+          misses_(0)
+    {}
+
+    int MutationScoreCache::InvalidationDistance() const
+    {
+        return invalidationDistance_;
+    }
+
+    void MutationScoreCache::Follow(const AbstractMultiReadMutationScorer& mms)
+    {
+        // A read added since counts towards every score it covers
+        if (&mms != scorer_ || mms.NumReads() != scorerReads_)
+        {
+            entries_.clear();
+            scorer_ = &mms;
+            scorerReads_ = mms.NumReads();
+        }
+    }
+
+    bool MutationScoreCache::Lookup(const AbstractMultiReadMutationScorer& mms,
+                                    const Mutation& m, bool fast, float* score)
+    {
+        detail::ScopedLock lock(mutex_);
+        Follow(mms);
+        std::map<Mutation, Entry>::const_iterator it = entries_.find(m);
+        if (it != entries_.end() && (fast ? it->second.HasFastScore : it->second.HasScore))
+        {
+            *score = fast ? it->second.FastScore : it->second.Score;
+            hits_++;
+            return true;
+        }
+        misses_++;
+        return false;
+    }
+
+    void MutationScoreCache::Store(const Mutation& m, bool fast, float score)
+    {
+        detail::ScopedLock lock(mutex_);
+        Entry& entry = entries_[m];
+        if (fast)
+        {
+            entry.FastScore = score;
+            entry.HasFastScore = true;
+        }
+        else
+        {
+            entry.Score = score;
+            entry.HasScore = true;
+        }
+    }
+
+    float MutationScoreCache::Score(const AbstractMultiReadMutationScorer& mms,
+                                    const Mutation& m)
+    {
+        float score;
+        if (!Lookup(mms, m, false, &score))
+        {
+            // Scored outside the lock, so other threads' lookups go on
+            score = mms.Score(m);
+            Store(m, false, score);
+        }
+        return score;
+    }
+
+    float MutationScoreCache::FastScore(const AbstractMultiReadMutationScorer& mms,
+                                        const Mutation& m)
+    {
+        float score;
+        if (!Lookup(mms, m, true, &score))
+        {
+            score = mms.FastScore(m);
+            Store(m, true, score);
+        }
+        return score;
+    }
+
+    bool MutationScoreCache::FastIsFavorable(const AbstractMultiReadMutationScorer& mms,
+                                             const Mutation& m)
+    {
+        // A screening scorer rejects most mutations without a fast score
+        // to cache, and an adaptive one may decide without scoring every
+        // read, so only the ones already scored are looked up
+        float score;
+        if ((mms.Screening() || mms.AdaptiveFastScoring()) && !Lookup(mms, m, true, &score))
+        {
+            return mms.FastIsFavorable(m);
+        }
+        return FastScore(mms, m) > MIN_FAVORABLE_SCOREDIFF;
+    }
+
+    void MutationScoreCache::ApplyMutations(AbstractMultiReadMutationScorer& mms,
+                                            const std::vector<Mutation>& mutations)
+    {
+        std::vector<int> newPositions = TargetToQueryPositions(mutations, mms.Template());
+
+        // The spans of the reads active before the edits
+        int numReads = mms.NumReads();
+        std::vector<std::pair<int, int> > spans(numReads, std::make_pair(-1, -1));
+        for (int i = 0; i < numReads; i++)
+        {
+            const MappedRead* read = mms.Read(i);
+            if (read != NULL)
+            {
+                spans[i] = std::make_pair(read->TemplateStart, read->TemplateEnd);
+            }
+        }
+
+        mms.ApplyMutations(mutations);
+
+        // A read the edits deactivated no longer counts towards the scores
+        // of the mutations it covers, so those are forgotten too
+        std::vector<std::pair<int, int> > deactivated;
+        for (int i = 0; i < numReads; i++)
+        {
+            if (spans[i].first >= 0 && mms.Read(i) == NULL)
+            {
+                deactivated.push_back(spans[i]);
+            }
+        }
+
+        detail::ScopedLock lock(mutex_);
+        Follow(mms);
+        std::map<Mutation, Entry> shifted;
+        for (std::map<Mutation, Entry>::const_iterator it = entries_.begin();
+             it != entries_.end(); ++it)
+        {
+            const Mutation& m = it->first;
+            if (!NearEdits(m, mutations, invalidationDistance_) && !Covered(m, deactivated))
+            {
+                Mutation moved(m.Type(), newPositions[m.Start()], newPositions[m.End()],
+                               m.NewBases());
+                shifted.insert(std::make_pair(moved, it->second));
+            }
+        }
+        entries_.swap(shifted);
+    }
+
+    void MutationScoreCache::Clear()
+    {
+        detail::ScopedLock lock(mutex_);
+        entries_.clear();
+        hits_ = 0;
+        misses_ = 0;
+    }
+
+    int MutationScoreCache::Size() const
+    {
+        detail::ScopedLock lock(mutex_);
+        return entries_.size();
+    }
+
+    int MutationScoreCache::Hits() const
+    {
+        detail::ScopedLock lock(mutex_);
+        return hits_;
+    }
+
+    int MutationScoreCache::Misses() const
+    {
+        detail::ScopedLock lock(mutex_);
+        return misses_;
+    }
+}
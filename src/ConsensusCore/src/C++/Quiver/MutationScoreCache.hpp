@@ -0,0 +1,114 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Mutation.hpp"
+#include "Quiver/MultiReadMutationScorer.hpp"
+#include "Quiver/detail/Mutex.hpp"
+
+namespace ConsensusCore
+{
+    /// \brief Remembers the scores a MultiReadMutationScorer gives
+    ///        mutations, across edits to its template.
+    ///
+    /// Scores are keyed by mutation, in template coordinates.  Edits go
+    /// through ApplyMutations, which forgets the scores of mutations
+    /// within InvalidationDistance bases of an edit, or covered by a read
+    /// the edit deactivated, and shifts the rest to their new coordinates.
+    /// Scores carried over an edit are not exact: the edit also moves the
+    /// scores of distant mutations in reads spanning both, a little, so
+    /// the distance trades accuracy for hits.
+    ///
+    /// The cache holds the scores of one scorer at a time: it starts
+    /// afresh when given another, or when its scorer has gained reads.
+    /// The lookups may be made from several threads at once.
+    class MutationScoreCache
+    {
+    public:
+        explicit MutationScoreCache(int invalidationDistance);
+
+        int InvalidationDistance() const;
+
+        /// \brief mms.Score(m), mms.FastScore(m) and mms.FastIsFavorable(m),
+        ///        from the cache where possible.
+        float Score(const AbstractMultiReadMutationScorer& mms, const Mutation& m);
+        float FastScore(const AbstractMultiReadMutationScorer& mms, const Mutation& m);
+        bool FastIsFavorable(const AbstractMultiReadMutationScorer& mms, const Mutation& m);
+
+        /// \brief Apply mutations to the template of mms, and carry the
+        ///        cached scores over to it.
+        void ApplyMutations(AbstractMultiReadMutationScorer& mms,
+                            const std::vector<Mutation>& mutations);
+
+        void Clear();
+
+        int Size() const;
+        int Hits() const;
+        int Misses() const;
+
+    private:
+        struct Entry
+        {
+            float Score;
+            float FastScore;
+            bool HasScore;
+            bool HasFastScore;
+
+            Entry();
+        };
+
+        // Forget the scores unless they are of mms, with the reads it has
+        // now (called with mutex_ held)
+        void Follow(const AbstractMultiReadMutationScorer& mms);
+
+        bool Lookup(const AbstractMultiReadMutationScorer& mms,
+                    const Mutation& m, bool fast, float* score);
+        void Store(const Mutation& m, bool fast, float score);
+
+    private:
+        int invalidationDistance_;
+        std::map<Mutation, Entry> entries_;
+        const AbstractMultiReadMutationScorer* scorer_;
+        int scorerReads_;
+        int hits_;
+        int misses_;
+        mutable detail::Mutex mutex_;
+    };
+}
@@ -37,35 +37,117 @@
 
 #include "Quiver/MutationScorer.hpp"
 
+#include <algorithm>
 #include <string>
 
 #include "Edna/EdnaEvaluator.hpp"
 #include "Matrix/DenseMatrix.hpp"
 #include "Matrix/SparseMatrix.hpp"
 #include "Quiver/QvEvaluator.hpp"
+#include "Quiver/ScaledRecursor.hpp"
 #include "Quiver/SimpleRecursor.hpp"
 #include "Quiver/SseRecursor.hpp"
+#include "Quiver/detail/Instrumentation.hpp"
 #include "Mutation.hpp"
 
 #define EXTEND_BUFFER_COLUMNS 8
+#define CHECKPOINT_SEGMENTS   4
 
 namespace ConsensusCore
 {
+    namespace detail {
+        // Only SparseMatrix has a choice of storage
+        template<typename M>
+        M* NewMatrix(int rows, int cols, MatrixStorage)
+        {
+            return new M(rows, cols);
+        }
+
+        template<>
+        SparseMatrix* NewMatrix<SparseMatrix>(int rows, int cols, MatrixStorage storage)
+        {
+            return new SparseMatrix(rows, cols, storage);
+        }
+
+        // Likewise only SparseMatrix columns can be released, for
+        // checkpointing
+        inline bool CanReleaseColumns(const SparseMatrix&) { return true; }
+        inline bool CanReleaseColumns(const DenseMatrix&)  { return false; }
+
+        inline void ReleaseColumn(SparseMatrix& m, int j) { m.ReleaseColumn(j); }
+        inline void ReleaseColumn(DenseMatrix&, int)      {}
+
+        inline bool IsColumnReleased(const SparseMatrix& m, int j) { return m.IsColumnReleased(j); }
+        inline bool IsColumnReleased(const DenseMatrix&, int)      { return false; }
+
+        inline void Compact(SparseMatrix& m, int reserveColumns) { m.Compact(reserveColumns); }
+        inline void Compact(DenseMatrix&, int)                   {}
+
+        // Copy column fromCol of one matrix into column toCol of another
+        template<typename M>
+        void CopyColumn(const M& from, int fromCol, M& to, int toCol)
+        {
+            Interval used = from.UsedRowRange(fromCol);
+            to.StartEditingColumn(toCol, used.Begin, used.End);
+            for (int i = used.Begin; i < used.End; i++)
+            {
+                to.Set(i, toCol, from(i, fromCol));
+            }
+            to.FinishEditingColumn(toCol, used.Begin, used.End);
+        }
+
+        // Orders a site's alternatives so that those putting the same base
+        // at the same column come one after the other
+        class ByFirstColumn
+        {
+        public:
+            explicit ByFirstColumn(const std::vector<Mutation>& alternatives)
+                : alternatives_(alternatives)
+            {}
+
+            bool operator()(int a, int b) const
+            {
+                const Mutation& ma = alternatives_[a];
+                const Mutation& mb = alternatives_[b];
+                if (ma.Start() != mb.Start()) return ma.Start() < mb.Start();
+                return FirstBase(ma) < FirstBase(mb);
+            }
+
+        private:
+            static char FirstBase(const Mutation& m)
+            {
+                return m.Type() == DELETION ? '-' : m.NewBases()[0];
+            }
+
+            const std::vector<Mutation>& alternatives_;
+        };
+    }
+
     template<typename R>
-    MutationScorer<R>::MutationScorer(const EvaluatorType& evaluator, const R& recursor)
+    MutationScorer<R>::MutationScorer(const EvaluatorType& evaluator, const R& recursor,
+                                      MatrixStorage storage, int checkpointInterval)
         throw(AlphaBetaMismatchException)
         : evaluator_(new EvaluatorType(evaluator)),
-          recursor_(new R(recursor))
+          recursor_(new R(recursor)),
+          checkpointInterval_(0),
+          editWindow_(0, 0)
     {
         // Allocate alpha and beta
-        alpha_ = new MatrixType(evaluator.ReadLength() + 1,
-                                evaluator.TemplateLength() + 1);
-        beta_ = new MatrixType(evaluator.ReadLength() + 1,
-                               evaluator.TemplateLength() + 1);
-        // Buffer where we extend into
-        extendBuffer_ = new MatrixType(evaluator.ReadLength() + 1, EXTEND_BUFFER_COLUMNS);
+        alpha_ = detail::NewMatrix<MatrixType>(evaluator.ReadLength() + 1,
+                                               evaluator.TemplateLength() + 1, storage);
+        beta_ = detail::NewMatrix<MatrixType>(evaluator.ReadLength() + 1,
+                                              evaluator.TemplateLength() + 1, storage);
         // Initial alpha and beta
-        numFlipFlops_ = recursor.FillAlphaBeta(*evaluator_, *alpha_, *beta_);
+        numFlipFlops_ = recursor.FillAlphaBeta(*evaluator_, *alpha_, *beta_, &counters_);
+        counters_.FlipFlops = numFlipFlops_;
+        // Space for scoring mutations in
+        scratch_.push_back(new Scratch(*evaluator_));
+
+        if (checkpointInterval > 0 && detail::CanReleaseColumns(*alpha_))
+        {
+            checkpointInterval_ = checkpointInterval;
+            ReleaseColumns();
+        }
     }
 
     template<typename R>
@@ -77,9 +159,15 @@ namespace ConsensusCore
         // Copy alpha and beta
         alpha_ = new MatrixType(*other.alpha_);
         beta_ = new MatrixType(*other.beta_);
-        // Buffer where we extend into
-        extendBuffer_ = new MatrixType(*other.extendBuffer_);
         numFlipFlops_ = other.numFlipFlops_;
+        counters_ = other.Counters();
+        // Space for scoring mutations in
+        scratch_.push_back(new Scratch(*evaluator_));
+
+        checkpointInterval_ = other.checkpointInterval_;
+        editWindow_ = other.editWindow_;
+        detail::ScopedLock lock(other.checkpointMutex_);
+        segments_ = other.segments_;
     }
 
     template<typename R>
@@ -99,14 +187,102 @@ namespace ConsensusCore
     void MutationScorer<R>::Template(std::string tpl)
         throw(AlphaBetaMismatchException)
     {
-        delete alpha_;
-        delete beta_;
+        RefillType refill;
+        if (!BeginTemplate(tpl, &refill))
+        {
+            return;
+        }
+        refill.FlipFlops =
+            recursor_->RefillAlphaBeta(*evaluator_, *alpha_, *beta_,
+                                       refill.ChangeBegin, refill.ChangeEnd,
+                                       refill.LengthDiff, &counters_);
+        EndTemplate(refill);
+    }
+
+    template<typename R>
+    bool MutationScorer<R>::BeginTemplate(const std::string& tpl, RefillType* refill)
+    {
+        // Find the edited region, as the template's common prefix and
+        // suffix with the old one; only it needs refilling.
+        std::string oldTpl = evaluator_->Template();
+        int oldLength = oldTpl.length();
+        int newLength = tpl.length();
+        int prefix = 0, suffix = 0;
+        while (prefix < std::min(oldLength, newLength) &&
+               oldTpl[prefix] == tpl[prefix])
+        {
+            prefix++;
+        }
+        while (suffix < std::min(oldLength, newLength) - prefix &&
+               oldTpl[oldLength - 1 - suffix] == tpl[newLength - 1 - suffix])
+        {
+            suffix++;
+        }
+        if (prefix == oldLength && oldLength == newLength)
+        {
+            return false;
+        }
+
+        if (checkpointInterval_ > 0)
+        {
+            // The refill resumes from the alpha columns before the edited
+            // region and the beta columns after it, so they must be in
+            // place (rebuilt against the old template).
+            Scratch* scratch = AcquireScratch();
+            MakeResident(true, prefix - 2, prefix,
+                         scratch->ExtendBuffer, &scratch->Counters);
+            MakeResident(false, oldLength - suffix, oldLength - suffix + 2,
+                         scratch->ExtendBuffer, &scratch->Counters);
+            ReleaseScratch(scratch);
+        }
+
         evaluator_->Template(tpl);
-        alpha_ = new MatrixType(evaluator_->ReadLength() + 1,
-                                evaluator_->TemplateLength() + 1);
-        beta_  = new MatrixType(evaluator_->ReadLength() + 1,
-                                evaluator_->TemplateLength() + 1);
-        recursor_->FillAlphaBeta(*evaluator_, *alpha_, *beta_);
+        foreach (Scratch* scratch, scratch_)
+        {
+            scratch->Evaluator.Template(tpl);
+        }
+
+        refill->Evaluator = evaluator_;
+        refill->Alpha = alpha_;
+        refill->Beta = beta_;
+        refill->ChangeBegin = prefix;
+        refill->ChangeEnd = oldLength - suffix;
+        refill->LengthDiff = newLength - oldLength;
+        refill->Counters = &counters_;
+        refill->FlipFlops = 0;
+        return true;
+    }
+
+    template<typename R>
+    void MutationScorer<R>::EndTemplate(const RefillType& refill)
+        throw(AlphaBetaMismatchException)
+    {
+        if (refill.FlipFlops < 0)
+        {
+            throw AlphaBetaMismatchException();
+        }
+        counters_.FlipFlops += refill.FlipFlops;
+
+        if (checkpointInterval_ > 0)
+        {
+            // Mutations near the edit are likely to be tried next, so
+            // keep the columns around it---unless it is wide (several
+            // mutations applied at once), when that would keep too much.
+            int k = checkpointInterval_;
+            int prefix = refill.ChangeBegin;
+            int newLength = evaluator_->TemplateLength();
+            int editEnd = refill.ChangeEnd + refill.LengthDiff + 1;
+            if (editEnd - prefix <= CHECKPOINT_SEGMENTS * k)
+            {
+                editWindow_ = Interval(std::max(prefix - k, 0),
+                                       std::min(editEnd + k, newLength + 1));
+            }
+            else
+            {
+                editWindow_ = Interval(0, 0);
+            }
+            ReleaseColumns();
+        }
     }
 
     template<typename R>
@@ -130,28 +306,115 @@ namespace ConsensusCore
     template<typename R>
     const PairwiseAlignment* MutationScorer<R>::Alignment() const
     {
-        return recursor_->Alignment(*evaluator_, *alpha_);
+        if (checkpointInterval_ == 0)
+        {
+            return recursor_->Alignment(*evaluator_, *alpha_);
+        }
+        // Trace back through a fully rebuilt copy of alpha
+        MatrixType alpha(*alpha_);
+        Scratch* scratch = AcquireScratch();
+        {
+            detail::ScopedLock lock(checkpointMutex_);
+            for (int j = 0; j < alpha.Columns(); j++)
+            {
+                if (detail::IsColumnReleased(alpha, j))
+                {
+                    RebuildAlpha(alpha, j, scratch->ExtendBuffer, &scratch->Counters);
+                }
+            }
+        }
+        ReleaseScratch(scratch);
+        return recursor_->Alignment(*evaluator_, alpha);
     }
 
     template<typename R>
     float
     MutationScorer<R>::ScoreMutation(const Mutation& m) const
+    {
+        Scratch* scratch = AcquireScratch();
+        float score;
+        if (checkpointInterval_ > 0)
+        {
+            detail::ScopedLock lock(checkpointMutex_);
+            EvictSegments();
+            MakeResident(m, scratch->ExtendBuffer, &scratch->Counters);
+            score = ScoreMutation(m, scratch);
+        }
+        else
+        {
+            score = ScoreMutation(m, scratch);
+        }
+        ReleaseScratch(scratch);
+        return score;
+    }
+
+    template<typename R>
+    std::vector<float>
+    MutationScorer<R>::ScoreSite(const std::vector<Mutation>& alternatives) const
+    {
+        std::vector<int> order(alternatives.size());
+        for (unsigned int k = 0; k < order.size(); k++)
+        {
+            order[k] = k;
+        }
+        std::stable_sort(order.begin(), order.end(), detail::ByFirstColumn(alternatives));
+
+        std::vector<float> scores(alternatives.size());
+        Scratch* scratch = AcquireScratch();
+        scratch->ExtendedFrom = -1;
+        if (checkpointInterval_ > 0)
+        {
+            // Nothing is evicted until the next call, so the columns for
+            // every alternative can be put in place up front (rebuilding
+            // goes through the scratch buffer too)
+            detail::ScopedLock lock(checkpointMutex_);
+            EvictSegments();
+            foreach (const Mutation& m, alternatives)
+            {
+                MakeResident(m, scratch->ExtendBuffer, &scratch->Counters);
+            }
+            foreach (int k, order)
+            {
+                scores[k] = ScoreMutation(alternatives[k], scratch, true);
+            }
+        }
+        else
+        {
+            foreach (int k, order)
+            {
+                scores[k] = ScoreMutation(alternatives[k], scratch, true);
+            }
+        }
+        ReleaseScratch(scratch);
+        return scores;
+    }
+
+    template<typename R>
+    float
+    MutationScorer<R>::ScoreMutation(const Mutation& m, Scratch* scratch, bool resume) const
     {
         int betaLinkCol = 1 + m.End();
         int absoluteLinkColumn = 1 + m.End() + m.LengthDiff();
-        std::string oldTpl = evaluator_->Template();
-        std::string newTpl = ApplyMutation(m, oldTpl);
+        double start = detail::Now();
+        EvaluatorType& evaluator = scratch->Evaluator;
+        MatrixType& extendBuffer = scratch->ExtendBuffer;
+        ScorerCounters& counters = scratch->Counters;
+        int reallocs = detail::NumReallocs(extendBuffer);
+
+        int oldLength = evaluator.TemplateLength();
+        int newLength = oldLength + m.LengthDiff();
         float score;
 
         bool atBegin = (m.Start() < 3);
-        bool atEnd   = (m.End() > (int)oldTpl.length() - 2);
+        bool atEnd   = (m.End() > oldLength - 2);
+
+        // Install mutated template (in our copy of the evaluator)
+        evaluator.ApplyMutation(m);
 
         if (!atBegin && !atEnd)
         {
-            // Install mutated template
-            evaluator_->Template(newTpl);
-
             int extendStartCol, extendLength;
+            int firstExtColumn = 0;
 
             if (m.Type() == DELETION)
             {
@@ -166,28 +429,60 @@ namespace ConsensusCore
                 extendStartCol = m.Start();
                 extendLength   = 1 + m.NewBases().length();
                 assert(extendLength <= EXTEND_BUFFER_COLUMNS);
+
+                // The first column sees only the template up to the base
+                // put there
+                if (resume &&
+                    scratch->ExtendedFrom == extendStartCol &&
+                    scratch->ExtendedBase == m.NewBases()[0])
+                {
+                    firstExtColumn = 1;
+                }
             }
 
-            recursor_->ExtendAlpha(*evaluator_, *alpha_,
-                                   extendStartCol, *extendBuffer_, extendLength);
-            score = recursor_->LinkAlphaBeta(*evaluator_,
-                                             *extendBuffer_, extendLength,
+            recursor_->ExtendAlpha(evaluator, *alpha_,
+                                   extendStartCol, extendBuffer, extendLength,
+                                   firstExtColumn);
+            if (m.Type() != DELETION)
+            {
+                scratch->ExtendedFrom = extendStartCol;
+                scratch->ExtendedBase = m.NewBases()[0];
+            }
+            else
+            {
+                scratch->ExtendedFrom = -1;
+            }
+            double extended = detail::Now();
+            score = recursor_->LinkAlphaBeta(evaluator,
+                                             extendBuffer, extendLength,
                                              *beta_, betaLinkCol,
                                              absoluteLinkColumn);
+            double linked = detail::Now();
+
+            Interval linkRange = RangeUnion(extendBuffer.UsedRowRange(extendLength - 2),
+                                            extendBuffer.UsedRowRange(extendLength - 1),
+                                            beta_->UsedRowRange(betaLinkCol),
+                                            beta_->UsedRowRange(betaLinkCol + 1));
+            counters.ExtendAlphaSeconds += extended - start;
+            counters.ExtendAlphaCells += detail::UsedCells(extendBuffer,
+                                                           firstExtColumn, extendLength);
+            counters.LinkAlphaBetaSeconds += linked - extended;
+            counters.LinkAlphaBetaCells += linkRange.End - linkRange.Begin;
         }
         else if (!atBegin && atEnd)
         {
+            scratch->ExtendedFrom = -1;
             //
             // Extend alpha to end
             //
-            evaluator_->Template(newTpl);
-
             int extendStartCol = m.Start() - 1;
-            int extendLength = newTpl.length() - extendStartCol + 1;
+            int extendLength = newLength - extendStartCol + 1;
 
-            recursor_->ExtendAlpha(*evaluator_, *alpha_,
-                                   extendStartCol, *extendBuffer_, extendLength);
-            score = (*extendBuffer_)(evaluator_->ReadLength(), extendLength - 1);
+            recursor_->ExtendAlpha(evaluator, *alpha_,
+                                   extendStartCol, extendBuffer, extendLength);
+            score = extendBuffer(evaluator.ReadLength(), extendLength - 1);
+            counters.ExtendAlphaSeconds += detail::Now() - start;
+            counters.ExtendAlphaCells += detail::UsedCells(extendBuffer, 0, extendLength);
 
             // if (fabs(score - Score()) > 50) {
             //     // FIXME!  This happens on fluidigm amplicons, figure out why
@@ -196,18 +491,19 @@ namespace ConsensusCore
         }
         else if (atBegin && !atEnd)
         {
+            scratch->ExtendedFrom = -1;
             //
             // Extend beta back
             //
-            evaluator_->Template(newTpl);
-
             int extendLastCol = m.End();
             int extendLength = m.End() + m.LengthDiff() + 1;
 
-            recursor_->ExtendBeta(*evaluator_, *beta_,
-                                  extendLastCol, *extendBuffer_, extendLength,
+            recursor_->ExtendBeta(evaluator, *beta_,
+                                  extendLastCol, extendBuffer, extendLength,
                                   m.LengthDiff());
-            score = (*extendBuffer_)(0, 0);
+            score = extendBuffer(0, 0);
+            counters.ExtendBetaSeconds += detail::Now() - start;
+            counters.ExtendBetaCells += detail::UsedCells(extendBuffer, 0, extendLength);
         }
         else
         {
@@ -215,15 +511,21 @@ namespace ConsensusCore
             //
             // Just do the whole fill
             //
-            MatrixType alphaP(evaluator_->ReadLength() + 1,
-                              newTpl.length() + 1);
-            evaluator_->Template(newTpl);
-            recursor_->FillAlpha(*evaluator_, MatrixType::Null(), alphaP);
-            score = alphaP(evaluator_->ReadLength(), newTpl.length());
+            MatrixType alphaP(evaluator.ReadLength() + 1,
+                              newLength + 1);
+            recursor_->FillAlpha(evaluator, MatrixType::Null(), alphaP);
+            score = alphaP(evaluator.ReadLength(), newLength);
+            // Counted as an extension, since it is part of scoring
+            counters.ExtendAlphaSeconds += detail::Now() - start;
+            counters.ExtendAlphaCells += detail::UsedCells(alphaP, 0, newLength + 1);
+            counters.Reallocations += detail::NumReallocs(alphaP);
         }
 
         // Restore the original template.
-        evaluator_->Template(oldTpl);
+        evaluator.UndoMutation();
+        counters.Reallocations += detail::NumReallocs(extendBuffer) - reallocs;
+        counters.MutationsScored++;
+        counters.ScoreMutationSeconds += detail::Now() - start;
 
         // if (fabs(score - Score()) > 50) { Breakpoint(); }
 
@@ -231,10 +533,239 @@ namespace ConsensusCore
     }
 
 
+    template<typename R>
+    MutationScorer<R>::Segment::Segment(bool isAlpha, const Interval& columns)
+        : IsAlpha(isAlpha), Columns(columns)
+    {}
+
+    template<typename R>
+    bool MutationScorer<R>::IsCheckpoint(int j) const
+    {
+        // Checkpoints come in adjacent pairs, as alpha and beta columns
+        // each depend on the two before (after) them.
+        int J = alpha_->Columns() - 1;
+        return (j % checkpointInterval_ < 2 || j >= J - 1 ||
+                (editWindow_.Begin <= j && j < editWindow_.End));
+    }
+
+    template<typename R>
+    void MutationScorer<R>::ReleaseColumns()
+    {
+        for (int j = 0; j < alpha_->Columns(); j++)
+        {
+            if (!IsCheckpoint(j))
+            {
+                detail::ReleaseColumn(*alpha_, j);
+                detail::ReleaseColumn(*beta_, j);
+            }
+        }
+        segments_.clear();
+        // Leave room for the segments that will be rebuilt
+        int reserveColumns = CHECKPOINT_SEGMENTS * checkpointInterval_;
+        detail::Compact(*alpha_, reserveColumns);
+        detail::Compact(*beta_, reserveColumns);
+    }
+
+    template<typename R>
+    void MutationScorer<R>::MakeResident(bool isAlpha, int beginColumn, int endColumn,
+                                         MatrixType& buffer, ScorerCounters* counters) const
+    {
+        MatrixType& matrix = isAlpha ? *alpha_ : *beta_;
+        beginColumn = std::max(beginColumn, 0);
+        endColumn = std::min(endColumn, matrix.Columns());
+        for (int j = beginColumn; j < endColumn; j++)
+        {
+            if (detail::IsColumnReleased(matrix, j))
+            {
+                Interval columns = isAlpha ?
+                    RebuildAlpha(matrix, j, buffer, counters) :
+                    RebuildBeta(matrix, j, buffer, counters);
+                segments_.push_back(Segment(isAlpha, columns));
+                continue;
+            }
+            // Mark a cached segment used, moving it to the back
+            typename std::list<Segment>::iterator it;
+            for (it = segments_.begin(); it != segments_.end(); ++it)
+            {
+                if (it->IsAlpha == isAlpha &&
+                    it->Columns.Begin <= j && j < it->Columns.End)
+                {
+                    segments_.splice(segments_.end(), segments_, it);
+                    break;
+                }
+            }
+        }
+    }
+
+    template<typename R>
+    void MutationScorer<R>::MakeResident(const Mutation& m,
+                                         MatrixType& buffer, ScorerCounters* counters) const
+    {
+        // The columns ScoreMutation reads, for each of its cases
+        int J = evaluator_->TemplateLength();
+        bool atBegin = (m.Start() < 3);
+        bool atEnd   = (m.End() > J - 2);
+        if (!atBegin)
+        {
+            // Alpha is extended from the two columns before the mutation
+            // (and the merge move reads some within it)
+            int endColumn = atEnd ? J + 1 : m.End() + std::max(m.LengthDiff(), 0) + 1;
+            MakeResident(true, m.Start() - 3, endColumn, buffer, counters);
+        }
+        if (!atEnd)
+        {
+            // Beta is linked (or extended) from the two columns after it
+            int beginColumn = atBegin ? 0 : m.End() + 1;
+            MakeResident(false, beginColumn, m.End() + 3, buffer, counters);
+        }
+    }
+
+    template<typename R>
+    Interval MutationScorer<R>::RebuildAlpha(MatrixType& alpha, int j,
+                                             MatrixType& buffer,
+                                             ScorerCounters* counters) const
+    {
+        double start = detail::Now();
+        // Extend, two columns at a time, from the nearest pair of columns
+        // in place before j, up to the next column in place after it.
+        // The first two and last two columns are always in place.
+        int begin = j;
+        while (detail::IsColumnReleased(alpha, begin - 1) ||
+               detail::IsColumnReleased(alpha, begin - 2))
+        {
+            begin--;
+        }
+        int end = j + 1;
+        while (detail::IsColumnReleased(alpha, end))
+        {
+            end++;
+        }
+        for (int col = begin; col < end; col += 2)
+        {
+            recursor_->ExtendAlpha(*evaluator_, alpha, col, buffer, 2);
+            for (int k = 0; k < 2 && col + k < end; k++)
+            {
+                if (detail::IsColumnReleased(alpha, col + k))
+                {
+                    detail::CopyColumn(buffer, k, alpha, col + k);
+                }
+            }
+        }
+        counters->RebuildCells += detail::UsedCells(alpha, begin, end);
+        counters->RebuildSeconds += detail::Now() - start;
+        return Interval(begin, end);
+    }
+
+    template<typename R>
+    Interval MutationScorer<R>::RebuildBeta(MatrixType& beta, int j,
+                                            MatrixType& buffer,
+                                            ScorerCounters* counters) const
+    {
+        double start = detail::Now();
+        // As RebuildAlpha, but extending backwards from the nearest pair
+        // in place after j
+        int end = j + 1;
+        while (detail::IsColumnReleased(beta, end) ||
+               detail::IsColumnReleased(beta, end + 1))
+        {
+            end++;
+        }
+        int begin = j;
+        while (detail::IsColumnReleased(beta, begin - 1))
+        {
+            begin--;
+        }
+        for (int col = end - 1; col >= begin; col -= 2)
+        {
+            recursor_->ExtendBeta(*evaluator_, beta, col, buffer, 2, 0);
+            for (int k = 0; k < 2 && col - k >= begin; k++)
+            {
+                if (detail::IsColumnReleased(beta, col - k))
+                {
+                    detail::CopyColumn(buffer, 1 - k, beta, col - k);
+                }
+            }
+        }
+        counters->RebuildCells += detail::UsedCells(beta, begin, end);
+        counters->RebuildSeconds += detail::Now() - start;
+        return Interval(begin, end);
+    }
+
+    template<typename R>
+    void MutationScorer<R>::EvictSegments() const
+    {
+        while (segments_.size() > CHECKPOINT_SEGMENTS)
+        {
+            const Segment& oldest = segments_.front();
+            MatrixType& matrix = oldest.IsAlpha ? *alpha_ : *beta_;
+            for (int j = oldest.Columns.Begin; j < oldest.Columns.End; j++)
+            {
+                if (!IsCheckpoint(j))
+                {
+                    detail::ReleaseColumn(matrix, j);
+                }
+            }
+            segments_.pop_front();
+        }
+    }
+
+
+    template<typename R>
+    MutationScorer<R>::Scratch::Scratch(const EvaluatorType& evaluator)
+        : Evaluator(evaluator),
+          ExtendBuffer(evaluator.ReadLength() + 1, EXTEND_BUFFER_COLUMNS),
+          ExtendedFrom(-1),
+          ExtendedBase('-')
+    {}
+
+    template<typename R>
+    typename MutationScorer<R>::Scratch*
+    MutationScorer<R>::AcquireScratch() const
+    {
+        {
+            detail::ScopedLock lock(scratchMutex_);
+            if (!scratch_.empty())
+            {
+                Scratch* scratch = scratch_.back();
+                scratch_.pop_back();
+                return scratch;
+            }
+        }
+        // All in use by other threads
+        return new Scratch(*evaluator_);
+    }
+
+    template<typename R>
+    void MutationScorer<R>::ReleaseScratch(Scratch* scratch) const
+    {
+        detail::ScopedLock lock(scratchMutex_);
+        counters_.Add(scratch->Counters);
+        scratch->Counters.Reset();
+        scratch_.push_back(scratch);
+    }
+
+    template<typename R>
+    ScorerCounters MutationScorer<R>::Counters() const
+    {
+        detail::ScopedLock lock(scratchMutex_);
+        return counters_;
+    }
+
+    template<typename R>
+    void MutationScorer<R>::ResetCounters()
+    {
+        detail::ScopedLock lock(scratchMutex_);
+        counters_.Reset();
+    }
+
+
     template<typename R>
     MutationScorer<R>::~MutationScorer()
     {
-        delete extendBuffer_;
+        foreach (Scratch* scratch, scratch_)
+        {
+            delete scratch;
+        }
         delete beta_;
         delete alpha_;
         delete recursor_;
@@ -248,4 +779,5 @@ namespace ConsensusCore
     template class MutationScorer<SparseSseQvRecursor>;
     template class MutationScorer<SparseSseQvSumProductRecursor>;
     template class MutationScorer<SparseSseEdnaRecursor>;
+    template class MutationScorer<SparseScaledQvSumProductRecursor>;
 }
@@ -38,13 +38,20 @@
 #pragma once
 
 #include <boost/noncopyable.hpp>
+#include <list>
 #include <string>
+#include <vector>
 
 // TODO(dalexander): how can we remove this include??
 //  We should move all template instantiations out to another
 //  header, I presume.
+#include "Quiver/BatchRecursor.hpp"
+#include "Quiver/ScaledRecursor.hpp"
 #include "Quiver/SimpleRecursor.hpp"
+#include "Quiver/ScorerCounters.hpp"
 #include "Quiver/SseRecursor.hpp"
+#include "Quiver/detail/Mutex.hpp"
+#include "Interval.hpp"
 #include "Types.hpp"
 #include "Mutation.hpp"
 
@@ -57,9 +64,21 @@ namespace ConsensusCore
         typedef typename R::MatrixType    MatrixType;
         typedef typename R::EvaluatorType EvaluatorType;
         typedef R                         RecursorType;
+#ifndef SWIG
+        typedef AlphaBetaRefill<MatrixType, EvaluatorType> RefillType;
+#endif  // SWIG
 
     public:
-        MutationScorer(const EvaluatorType& evaluator, const R& recursor)
+        // The storage mode applies to the alpha and beta matrices, when
+        // they are SparseMatrix.  So does checkpointing: with a
+        // checkpointInterval k > 0, only the alpha and beta columns j
+        // with j % k < 2, the last two, and those within k of the latest
+        // template edit (if it was narrow) are kept.  Scoring rebuilds the others it needs
+        // from the nearest checkpoint, holding on to the last few
+        // segments rebuilt.
+        MutationScorer(const EvaluatorType& evaluator, const R& recursor,
+                       MatrixStorage storage = FLOAT_STORAGE,
+                       int checkpointInterval = 0)
             throw(AlphaBetaMismatchException);
 
         MutationScorer(const MutationScorer& other);
@@ -70,24 +89,131 @@ namespace ConsensusCore
         void Template(std::string tpl)
             throw(AlphaBetaMismatchException);
 
+#ifndef SWIG
+        // Template(tpl) in two halves, for refilling the matrices of many
+        // scorers together (see BatchRecursor): BeginTemplate moves the
+        // evaluator onto tpl and describes the refill needed, returning
+        // false if there is none; EndTemplate follows the refill.
+        bool BeginTemplate(const std::string& tpl, RefillType* refill);
+        void EndTemplate(const RefillType& refill)
+            throw(AlphaBetaMismatchException);
+#endif  // SWIG
+
         float Score() const;
+
+        // Scoring is reentrant: any number of threads may score mutations
+        // against one scorer at once (but not while its template changes).
+        // When checkpointing, calls are serialized, as they may rebuild
+        // columns.
         float ScoreMutation(const Mutation& m) const;
 
+        // ScoreMutation for each of a few alternative edits to one site
+        // (such as every single-base change at a position), in one go:
+        // they share the scratch space, the lock, and the columns
+        // rebuilt from checkpoints, and are extended while the alpha and
+        // beta columns around the site are still in cache.  Edits that put
+        // the same base at the same column (a substitution and the
+        // insertion of that base before it) share their first extended
+        // column, which is computed once.
+        std::vector<float> ScoreSite(const std::vector<Mutation>& alternatives) const;
+
+    public:
+        // The work this scorer has done filling its matrices and scoring
+        // mutations, since it was created or ResetCounters was called.
+        ScorerCounters Counters() const;
+        void ResetCounters();
+
     public:
-        // Accessors that are handy for debugging.
+        // Accessors that are handy for debugging.  When checkpointing,
+        // columns not currently kept read as empty.
         const MatrixType* Alpha() const;
         const MatrixType* Beta() const;
         const PairwiseAlignment* Alignment() const;
         const EvaluatorType* Evaluator() const;
         const int NumFlipFlops() const { return numFlipFlops_; }
 
+    private:
+#ifndef SWIG
+        // Working space for one ScoreMutation call: a copy of the
+        // evaluator to see the mutated template through, the buffer
+        // alpha is extended into, and the counters for the call (added
+        // to the scorer's on release).  Kept in a pool, one per
+        // concurrent call.
+        struct Scratch
+        {
+            EvaluatorType Evaluator;
+            MatrixType ExtendBuffer;
+            ScorerCounters Counters;
+
+            // The column ExtendBuffer's extension starts from and the base
+            // it puts there, or -1 when it holds no resumable extension
+            int ExtendedFrom;
+            char ExtendedBase;
+
+            explicit Scratch(const EvaluatorType& evaluator);
+        };
+
+        Scratch* AcquireScratch() const;
+        void ReleaseScratch(Scratch* scratch) const;
+
+        // ScoreMutation, with the columns it needs in place.  With resume,
+        // an extension left in the scratch buffer from the same column and
+        // base (by an edit at the same site, template unchanged) is picked
+        // up from its second column.
+        float ScoreMutation(const Mutation& m, Scratch* scratch,
+                            bool resume = false) const;
+
+        // A run of columns rebuilt from checkpoints
+        struct Segment
+        {
+            bool IsAlpha;
+            Interval Columns;
+
+            Segment(bool isAlpha, const Interval& columns);
+        };
+
+        bool IsCheckpoint(int j) const;
+
+        // Release the columns that are not checkpoints
+        void ReleaseColumns();
+
+        // Rebuild any released columns of alpha (or beta) in [beginColumn,
+        // endColumn), or those scoring m reads, extending into buffer.
+        void MakeResident(bool isAlpha, int beginColumn, int endColumn,
+                          MatrixType& buffer, ScorerCounters* counters) const;
+        void MakeResident(const Mutation& m,
+                          MatrixType& buffer, ScorerCounters* counters) const;
+
+        // Rebuild the released columns around column j, returning the
+        // range of columns recomputed
+        Interval RebuildAlpha(MatrixType& alpha, int j,
+                              MatrixType& buffer, ScorerCounters* counters) const;
+        Interval RebuildBeta(MatrixType& beta, int j,
+                             MatrixType& buffer, ScorerCounters* counters) const;
+
+        // Release the columns of the oldest segments beyond the number kept
+        void EvictSegments() const;
+#endif  // SWIG
+
     private:
         EvaluatorType* evaluator_;
         R* recursor_;
         MatrixType* alpha_;
         MatrixType* beta_;
-        MatrixType* extendBuffer_;
         int numFlipFlops_;
+#ifndef SWIG
+        // Scoring updates counters_ with scratchMutex_ held
+        mutable ScorerCounters counters_;
+        mutable std::vector<Scratch*> scratch_;
+        mutable detail::Mutex scratchMutex_;
+
+        // Checkpointing (off if checkpointInterval_ is 0).  Segments are
+        // oldest first; rebuilding holds checkpointMutex_.
+        int checkpointInterval_;
+        Interval editWindow_;
+        mutable std::list<Segment> segments_;
+        mutable detail::Mutex checkpointMutex_;
+#endif  // SWIG
     };
 
     typedef MutationScorer<SimpleQvRecursor>       SimpleQvMutationScorer;
@@ -97,4 +223,5 @@ namespace ConsensusCore
     typedef MutationScorer<SparseSimpleQvSumProductRecursor> SparseSimpleQvSumProductMutationScorer;
     typedef MutationScorer<SparseSseQvSumProductRecursor>    SparseSseQvSumProductMutationScorer;
     typedef MutationScorer<SparseSseEdnaRecursor>  SparseSseEdnaMutationScorer;
+    typedef MutationScorer<SparseScaledQvSumProductRecursor> SparseScaledQvSumProductMutationScorer;
 }
@@ -46,12 +46,16 @@ namespace ConsensusCore {
                                int movesAvailable,
                                const BandingOptions& bandingOptions,
                                float fastScoreThreshold,
-                               float addThreshold)
+                               float addThreshold,
+                               MatrixStorage storage,
+                               int checkpointInterval)
         : QvParams(qvParams),
           MovesAvailable(movesAvailable),
           Banding(bandingOptions),
           FastScoreThreshold(fastScoreThreshold),
-          AddThreshold(addThreshold)
+          AddThreshold(addThreshold),
+          Storage(storage),
+          CheckpointInterval(checkpointInterval)
     {}
 
     QuiverConfig::QuiverConfig(const QuiverConfig& qvConfig)
@@ -59,7 +63,9 @@ namespace ConsensusCore {
           MovesAvailable(qvConfig.MovesAvailable),
           Banding(qvConfig.Banding),
           FastScoreThreshold(qvConfig.FastScoreThreshold),
-          AddThreshold(qvConfig.AddThreshold)
+          AddThreshold(qvConfig.AddThreshold),
+          Storage(qvConfig.Storage),
+          CheckpointInterval(qvConfig.CheckpointInterval)
     {}
 
 
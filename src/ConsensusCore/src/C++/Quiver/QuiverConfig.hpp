@@ -186,12 +186,19 @@ namespace ConsensusCore
         BandingOptions Banding;
         float FastScoreThreshold;
         float AddThreshold;
+        MatrixStorage Storage;
+        // Keep only every CheckpointInterval-th alpha and beta column (and
+        // those around the latest template edit), rebuilding the others
+        // when scoring needs them; 0 keeps every column.
+        int CheckpointInterval;
 
         QuiverConfig(const QvModelParams& qvParams,
                      int movesAvailable,
                      const BandingOptions& bandingOptions,
                      float fastScoreThreshold,
-                     float addThreshold = 1.0f);
+                     float addThreshold = 1.0f,
+                     MatrixStorage storage = FLOAT_STORAGE,
+                     int checkpointInterval = 0);
 
         QuiverConfig(const QuiverConfig& qvConfig);
     };
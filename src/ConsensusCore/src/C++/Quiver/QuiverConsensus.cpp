@@ -44,12 +44,15 @@
 #include "Quiver/MultiReadMutationScorer.hpp"
 #include "Quiver/QuiverConsensus.hpp"
 #include "Quiver/MutationEnumerator.hpp"
+#include "Quiver/MutationScoreCache.hpp"
+#include "Quiver/detail/ThreadPool.hpp"
 #include "Mutation.hpp"
 
 #include "Utils.hpp"
 
 #include "Logging/Logging.hpp"
 
+#define MIN_SCREENING_BLOCK_SIZE 16  // Fewest candidates screened per work item
 
 namespace ConsensusCore
 {
@@ -61,7 +64,8 @@ namespace ConsensusCore
     struct RefineDinucleotideRepeatOptions : RefineOptions
     {
         RefineDinucleotideRepeatOptions(int minDinucleotideRepeatElements)
-            : MinDinucleotideRepeatElements(minDinucleotideRepeatElements)
+            : RefineOptions(DefaultRefineOptions),
+              MinDinucleotideRepeatElements(minDinucleotideRepeatElements)
         {
             MaximumIterations = 1;
         }
@@ -137,6 +141,77 @@ namespace ConsensusCore
         return min(cap, static_cast<int>(round(-10.0 * log10(probability))));
     }
 
+    //
+    // Screens candidate mutations, a block of them per work item: Run
+    // scores the favorable ones in its block, and Commit appends them in
+    // candidate order, so the list matches screening them one by one.
+    // With a cache, the scores are looked up there first.
+    //
+    class ScreeningTask : public detail::ParallelTask
+    {
+    public:
+        ScreeningTask(const AbstractMultiReadMutationScorer& mms,
+                      MutationScoreCache* cache,
+                      const vector<Mutation>& candidates,
+                      int numBlocks,
+                      vector<ScoredMutation>* favorable)
+            : mms_(mms),
+              cache_(cache),
+              candidates_(candidates),
+              numBlocks_(numBlocks),
+              blockFavorable_(numBlocks),
+              favorable_(favorable)
+        {}
+
+        void Run(int block)
+        {
+            for (int k = BlockBoundary(block); k < BlockBoundary(block + 1); k++)
+            {
+                const Mutation& m = candidates_[k];
+                bool isFavorable = (cache_ != NULL) ? cache_->FastIsFavorable(mms_, m)
+                                                    : mms_.FastIsFavorable(m);
+                if (isFavorable)
+                {
+                    float mutScore = (cache_ != NULL) ? cache_->Score(mms_, m) : mms_.Score(m);
+                    blockFavorable_[block].push_back(m.WithScore(mutScore));
+                }
+            }
+        }
+
+        bool Commit(int block)
+        {
+            favorable_->insert(favorable_->end(),
+                               blockFavorable_[block].begin(),
+                               blockFavorable_[block].end());
+            blockFavorable_[block].clear();
+            return true;
+        }
+
+    private:
+        int BlockBoundary(int block) const
+        {
+            return static_cast<int>(
+                (static_cast<long>(candidates_.size()) * block) / numBlocks_);
+        }
+
+    private:
+        const AbstractMultiReadMutationScorer& mms_;
+        MutationScoreCache* cache_;
+        const vector<Mutation>& candidates_;
+        int numBlocks_;
+        vector<vector<ScoredMutation> > blockFavorable_;
+        vector<ScoredMutation>* favorable_;
+    };
+
+    // Enough blocks for the threads to balance their load, if there are
+    // candidates enough to go round
+    int NumScreeningBlocks(int numCandidates, int numThreads)
+    {
+        if (numThreads <= 1) return 1;
+        int numBlocks = std::min(4 * numThreads, numCandidates / MIN_SCREENING_BLOCK_SIZE);
+        return std::max(1, numBlocks);
+    }
+
     template <typename E, typename O>
     E MutationEnumerator(const std::string& tpl, const O& opts)
     {
@@ -154,7 +229,8 @@ namespace ConsensusCore
     }
 
     template <typename E, typename O>
-    bool AbstractRefineConsensus(AbstractMultiReadMutationScorer& mms, const O& opts)
+    bool AbstractRefineConsensus(AbstractMultiReadMutationScorer& mms, const O& opts,
+                                 detail::ThreadPool* executor, MutationScoreCache* cache)
     {
         bool isConverged = false;
         float score = mms.BaselineScore();
@@ -198,12 +274,18 @@ namespace ConsensusCore
             // Screen for favorable mutations.  If none, we are done (converged).
             //
             favorableMutsAndScores.clear();
-            foreach (const Mutation& m, mutationsToTry)
+            int numBlocks = (executor != NULL)
+                ? NumScreeningBlocks(mutationsToTry.size(), executor->NumThreads())
+                : 1;
+            ScreeningTask screening(mms, cache, mutationsToTry, numBlocks, &favorableMutsAndScores);
+            if (executor != NULL)
             {
-                if (mms.FastIsFavorable(m)) {
-                    float mutScore = mms.Score(m);
-                    favorableMutsAndScores.push_back(m.WithScore(mutScore));
-                }
+                executor->ParallelFor(numBlocks, screening);
+            }
+            else
+            {
+                screening.Run(0);
+                screening.Commit(0);
             }
             if (favorableMutsAndScores.empty())
             {
@@ -236,42 +318,103 @@ namespace ConsensusCore
             }
 
             tplHistory.insert(hash(mms.Template()));
-            mms.ApplyMutations(ProjectDown(bestSubset));
+            if (cache != NULL)
+            {
+                cache->ApplyMutations(mms, ProjectDown(bestSubset));
+            }
+            else
+            {
+                mms.ApplyMutations(ProjectDown(bestSubset));
+            }
         }
 
         return isConverged;
     }
+
+    // Screens on a pool of opts.NumThreads threads, or, when that comes to
+    // one thread, on the calling thread without starting a pool
+    template <typename E, typename O>
+    bool ThreadedRefineConsensus(AbstractMultiReadMutationScorer& mms, const O& opts,
+                                 MutationScoreCache* cache)
+    {
+        if (opts.NumThreads == 0 || opts.NumThreads == 1)
+        {
+            return AbstractRefineConsensus<E>(mms, opts, NULL, cache);
+        }
+        detail::ThreadPool executor(opts.NumThreads);
+        return AbstractRefineConsensus<E>(mms, opts, &executor, cache);
+    }
     } // PRIVATE
 
 
     bool RefineConsensus(AbstractMultiReadMutationScorer& mms, const RefineOptions& opts)
     {
-        return AbstractRefineConsensus<UniqueSingleBaseMutationEnumerator>(mms, opts);
+        return ThreadedRefineConsensus<UniqueSingleBaseMutationEnumerator>(mms, opts, NULL);
+    }
+
+
+    bool RefineConsensus(AbstractMultiReadMutationScorer& mms, const RefineOptions& opts,
+                         detail::ThreadPool& executor)
+    {
+        return AbstractRefineConsensus<UniqueSingleBaseMutationEnumerator>(mms, opts, &executor, NULL);
     }
 
 
     void RefineDinucleotideRepeats(AbstractMultiReadMutationScorer& mms, int minDinucleotideRepeatElements)
     {
         RefineDinucleotideRepeatOptions opts(minDinucleotideRepeatElements);
-        AbstractRefineConsensus<DinucleotideRepeatMutationEnumerator>(mms, opts);
+        ThreadedRefineConsensus<DinucleotideRepeatMutationEnumerator>(mms, opts, NULL);
     }
 
 
-    std::vector<int> ConsensusQVs(AbstractMultiReadMutationScorer& mms)
+    bool RefineConsensus(AbstractMultiReadMutationScorer& mms, const RefineOptions& opts,
+                         MutationScoreCache& cache)
+    {
+        return ThreadedRefineConsensus<UniqueSingleBaseMutationEnumerator>(mms, opts, &cache);
+    }
+
+
+    namespace { // PRIVATE
+    std::vector<int> AbstractConsensusQVs(AbstractMultiReadMutationScorer& mms,
+                                          MutationScoreCache* cache)
     {
         std::vector<int> QVs;
         UniqueSingleBaseMutationEnumerator mutationEnumerator(mms.Template());
         for (size_t pos = 0; pos < mms.Template().length(); pos++)
         {
+            // Without a cache, the alternatives at pos are scored in one
+            // pass over the reads
+            vector<Mutation> alternatives = mutationEnumerator.Mutations(pos, pos + 1);
+            vector<float> siteScores;
+            if (cache == NULL)
+            {
+                siteScores = mms.FastScoreSite(alternatives);
+            }
+
             double scoreSum = 0.0;
-            foreach (const Mutation& m, mutationEnumerator.Mutations(pos, pos + 1))
+            for (int k = 0; k < (int)alternatives.size(); k++)
             {
-                scoreSum += exp(mms.FastScore(m));
+                float score = (cache != NULL) ? cache->FastScore(mms, alternatives[k]) : siteScores[k];
+                scoreSum += exp(score);
             }
             QVs.push_back(ProbabilityToQV(1.0 - 1.0 / (1.0 + scoreSum)));
         }
         return QVs;
     }
+    } // PRIVATE
+
+
+    std::vector<int> ConsensusQVs(AbstractMultiReadMutationScorer& mms)
+    {
+        return AbstractConsensusQVs(mms, NULL);
+    }
+
+
+    std::vector<int> ConsensusQVs(AbstractMultiReadMutationScorer& mms,
+                                  MutationScoreCache& cache)
+    {
+        return AbstractConsensusQVs(mms, &cache);
+    }
 
 
 #if 0
@@ -40,6 +40,7 @@
 #include <vector>
 
 #include "Quiver/MultiReadMutationScorer.hpp"
+#include "Quiver/MutationScoreCache.hpp"
 #include "Mutation.hpp"
 
 namespace ConsensusCore
@@ -49,24 +50,52 @@ namespace ConsensusCore
         int MaximumIterations;
         int MutationSeparation;
         int MutationNeighborhood;
+
+        // Threads screening the candidate mutations of each round, a
+        // block of candidates at a time (ALL_PROCESSORS means one per
+        // processor; 0, as in a value-initialized RefineOptions, is taken
+        // as 1).  The refined template does not depend on it.
+        int NumThreads;
     };
 
     static const RefineOptions DefaultRefineOptions =
     {
         40,  // MaximumIterations
         10,  // MutationSeparation
-        20   // MutationNeighborhood
+        20,  // MutationNeighborhood
+        1    // NumThreads
     };
 
 
     bool RefineConsensus(AbstractMultiReadMutationScorer& mms,
                          const RefineOptions& = DefaultRefineOptions);
 
+#ifndef SWIG
+    // As above, but screening candidates on the threads of executor
+    // (opts.NumThreads is ignored).  Each screening thread scores its
+    // candidates with mms, which spreads a candidate over its own
+    // threads only when they are free, so give one or the other the
+    // threads.
+    bool RefineConsensus(AbstractMultiReadMutationScorer& mms,
+                         const RefineOptions& opts,
+                         detail::ThreadPool& executor);
+#endif  // !SWIG
+
+    // As above, but taking the scores from cache where it has them, and
+    // applying the edits through it.  Passing the same cache on to
+    // ConsensusQVs then saves rescoring all the mutations there.
+    bool RefineConsensus(AbstractMultiReadMutationScorer& mms,
+                         const RefineOptions& opts,
+                         MutationScoreCache& cache);
+
     void RefineDinucleotideRepeats(AbstractMultiReadMutationScorer& mms,
                                    int minDinucleotideRepeatElements = 3);
 
     std::vector<int> ConsensusQVs(AbstractMultiReadMutationScorer& mms);
 
+    std::vector<int> ConsensusQVs(AbstractMultiReadMutationScorer& mms,
+                                  MutationScoreCache& cache);
+
     //
     // Lower priority:
     //
@@ -38,6 +38,7 @@
 #pragma once
 
 
+#include <immintrin.h>
 #include <xmmintrin.h>
 #include <pmmintrin.h>
 
@@ -51,8 +52,10 @@
 #include <utility>
 
 #include "Quiver/detail/SseMath.hpp"
+#include "Quiver/detail/TemplateView.hpp"
 #include "Quiver/QuiverConfig.hpp"
 #include "Features.hpp"
+#include "Mutation.hpp"
 #include "Types.hpp"
 #include "Utils.hpp"
 #include "Read.hpp"
@@ -64,6 +67,13 @@ using std::max;
 
 #define NEG_INF -FLT_MAX
 
+// Move score tables: rows for the template bases A, C, G, T, M and N,
+// then the end of the template; rows padded to a multiple of this many
+// entries (the widest vector load)
+#define QV_TABLE_ROWS           7
+#define QV_END_OF_TEMPLATE_ROW  6
+#define QV_TABLE_PADDING        16
+
 namespace ConsensusCore
 {
     //
@@ -103,8 +113,19 @@ namespace ConsensusCore
               params_(params),
               tpl_(tpl),
               pinStart_(pinStart),
-              pinEnd_(pinEnd)
-        {}
+              pinEnd_(pinEnd),
+              tableStride_(0),
+              incTable_(0),
+              delTable_(0),
+              extraTable_(0),
+              mergeTable_(0),
+              incProbTable_(0),
+              delProbTable_(0),
+              extraProbTable_(0),
+              mergeProbTable_(0)
+        {
+            BuildTables();
+        }
 
         ~QvEvaluator()
         {}
@@ -121,12 +142,24 @@ namespace ConsensusCore
 
         std::string Template() const
         {
-            return tpl_;
+            return tpl_.str();
         }
 
         void Template(std::string tpl)
         {
-            tpl_ = tpl;
+            tpl_.Reset(tpl);
+        }
+
+        /// \brief Evaluate against the template with m applied, until
+        ///        UndoMutation; the template itself is not copied.
+        void ApplyMutation(const Mutation& m)
+        {
+            tpl_.Patch(m.Start(), m.End(), m.IsDeletion() ? std::string() : m.NewBases());
+        }
+
+        void UndoMutation()
+        {
+            tpl_.Unpatch();
         }
 
 
@@ -161,49 +194,32 @@ namespace ConsensusCore
         {
             assert(0 <= j && j < TemplateLength() &&
                    0 <= i && i < ReadLength() );
-            return (IsMatch(i, j)) ?
-                    params_.Match :
-                    params_.Mismatch + params_.MismatchS * Features().SubsQv[i];
+            return TableRow(incTable_, j)[i];
         }
 
         float Del(int i, int j) const
         {
             assert(0 <= j && j < TemplateLength() &&
                    0 <= i && i <= ReadLength() );
-            if ( (!PinStart() && i == 0) || (!PinEnd() && i == ReadLength()) )
-            {
-                return 0.0f;
-            }
-            else
-            {
-                float tplBase = tpl_[j];
-                return (i < ReadLength() && tplBase == Features().DelTag[i]) ?
-                        params_.DeletionWithTag + params_.DeletionWithTagS * Features().DelQv[i] :
-                        params_.DeletionN;
-            }
+            return TableRow(delTable_, j)[i];
         }
 
         float Extra(int i, int j) const
         {
             assert(0 <= j && j <= TemplateLength() &&
                    0 <= i && i < ReadLength() );
-            return (j < TemplateLength() && IsMatch(i, j)) ?
-                    params_.Branch + params_.BranchS * Features().InsQv[i] :
-                    params_.Nce + params_.NceS * Features().InsQv[i];
+            return TableRow(extraTable_, j)[i];
         }
 
         float Merge(int i, int j) const
         {
             assert(0 <= j && j < TemplateLength() - 1 &&
                    0 <= i && i < ReadLength() );
-            if (!(Features()[i] == tpl_[j] && Features()[i] == tpl_[j + 1]) )
+            if (tpl_[j] != tpl_[j + 1])
             {
                 return -FLT_MAX;
             }
-            else
-            {   int tplBase = encodeTplBase(tpl_[j]);
-                return params_.Merge[tplBase] + params_.MergeS[tplBase] * Features().MergeQv[i];
-            }
+            return TableRow(mergeTable_, j)[i];
         }
 
         //
@@ -214,105 +230,275 @@ namespace ConsensusCore
         {
             assert (0 <= i && i <= ReadLength() - 4);
             assert (0 <= j && j < TemplateLength());
-            float tplBase = tpl_[j];
-            __m128 match = _mm_set_ps1(params_.Match);
-            __m128 mismatch = AFFINE4(params_.Mismatch, params_.MismatchS, &Features().SubsQv[i]);
-            // Mask to see it the base is equal to the template
-            __m128 mask = _mm_cmpeq_ps(_mm_loadu_ps(&Features().SequenceAsFloat[i]),
-                                       _mm_set_ps1(tplBase));
-            return MUX4(mask, match, mismatch);
+            return _mm_loadu_ps(TableRow(incTable_, j) + i);
         }
 
         __m128 Del4(int i, int j) const
         {
-            assert (0 <= i && i <= ReadLength());
+            assert (0 <= i && i <= ReadLength() - 3);
             assert (0 <= j && j < TemplateLength());
-            if (i != 0 && i + 3 != ReadLength())
-            {
-                float tplBase = tpl_[j];
-                __m128 delWTag = AFFINE4(params_.DeletionWithTag,
-                                         params_.DeletionWithTagS,
-                                         &Features().DelQv[i]);
-                __m128 delNoTag = _mm_set_ps1(params_.DeletionN);
-                __m128 mask = _mm_cmpeq_ps(_mm_loadu_ps(&Features().DelTag[i]),
-                                           _mm_set_ps1(tplBase));
-                return MUX4(mask, delWTag, delNoTag);
-            }
-            else
-            {
-                // Have to do PinStart/PinEnd logic, and weird
-                // logic for last row.  Punt.
-                __m128 res = _mm_setr_ps(Del(i + 0, j),
-                                         Del(i + 1, j),
-                                         Del(i + 2, j),
-                                         Del(i + 3, j));
-                return res;
-            }
+            return _mm_loadu_ps(TableRow(delTable_, j) + i);
         }
 
         __m128 Extra4(int i, int j) const
         {
             assert (0 <= i && i <= ReadLength() - 4);
             assert (0 <= j && j <= TemplateLength());
-            if (i != 0 && i + 3 != ReadLength())
-            {
-                float tplBase = tpl_[j];
-                __m128 branch = AFFINE4(params_.Branch, params_.BranchS, &Features().InsQv[i]);
-                __m128 nce    = AFFINE4(params_.Nce,    params_.NceS,    &Features().InsQv[i]);
+            return _mm_loadu_ps(TableRow(extraTable_, j) + i);
+        }
 
-                __m128 mask = _mm_cmpeq_ps(_mm_loadu_ps(&Features().SequenceAsFloat[i]),
-                                           _mm_set_ps1(tplBase));
-                return MUX4(mask, branch, nce);
+        __m128 Merge4(int i, int j) const
+        {
+            assert(0 <= i && i <= ReadLength() - 4);
+            assert(0 <= j && j < TemplateLength() - 1);
+            if (tpl_[j] != tpl_[j + 1])
+            {
+                return _mm_set_ps1(-FLT_MAX);
             }
-            else
+            return _mm_loadu_ps(TableRow(mergeTable_, j) + i);
+        }
+
+        //
+        // Move probabilities, exp() of the scores above, for recursors
+        // working in probability space; impossible moves have probability
+        // zero.
+        //
+
+        float IncProb(int i, int j) const
+        {
+            assert(0 <= j && j < TemplateLength() &&
+                   0 <= i && i < ReadLength() );
+            return TableRow(incProbTable_, j)[i];
+        }
+
+        float DelProb(int i, int j) const
+        {
+            assert(0 <= j && j < TemplateLength() &&
+                   0 <= i && i <= ReadLength() );
+            return TableRow(delProbTable_, j)[i];
+        }
+
+        float ExtraProb(int i, int j) const
+        {
+            assert(0 <= j && j <= TemplateLength() &&
+                   0 <= i && i < ReadLength() );
+            return TableRow(extraProbTable_, j)[i];
+        }
+
+        float MergeProb(int i, int j) const
+        {
+            assert(0 <= j && j < TemplateLength() - 1 &&
+                   0 <= i && i < ReadLength() );
+            if (tpl_[j] != tpl_[j + 1])
             {
-                __m128 res = _mm_setr_ps(Extra(i + 0, j),
-                                         Extra(i + 1, j),
-                                         Extra(i + 2, j),
-                                         Extra(i + 3, j));
-                return res;
+                return 0.0f;
             }
+            return TableRow(mergeProbTable_, j)[i];
         }
 
+        __m128 IncProb4(int i, int j) const
+        {
+            assert (0 <= i && i <= ReadLength() - 4);
+            assert (0 <= j && j < TemplateLength());
+            return _mm_loadu_ps(TableRow(incProbTable_, j) + i);
+        }
 
-        __m128 Merge4(int i, int j) const
+        __m128 DelProb4(int i, int j) const
+        {
+            assert (0 <= i && i <= ReadLength() - 3);
+            assert (0 <= j && j < TemplateLength());
+            return _mm_loadu_ps(TableRow(delProbTable_, j) + i);
+        }
+
+        __m128 ExtraProb4(int i, int j) const
+        {
+            assert (0 <= i && i <= ReadLength() - 4);
+            assert (0 <= j && j <= TemplateLength());
+            return _mm_loadu_ps(TableRow(extraProbTable_, j) + i);
+        }
+
+        __m128 MergeProb4(int i, int j) const
         {
             assert(0 <= i && i <= ReadLength() - 4);
             assert(0 <= j && j < TemplateLength() - 1);
+            if (tpl_[j] != tpl_[j + 1])
+            {
+                return _mm_setzero_ps();
+            }
+            return _mm_loadu_ps(TableRow(mergeProbTable_, j) + i);
+        }
 
-            float tplBase     = tpl_[j];
-            float tplBaseNext = tpl_[j + 1];
-            int tplBase_ = encodeTplBase(tpl_[j]);
+#ifndef SWIG
+        //
+        // AVX2 and AVX-512; only callable when the running CPU supports them
+        //
 
-            __m128 merge =  AFFINE4(params_.Merge[tplBase_],
-                                    params_.MergeS[tplBase_],
-                                    &Features().MergeQv[i]);
-            __m128 noMerge = _mm_set_ps1(-FLT_MAX);
+        TARGET_AVX2 __m256 Inc8(int i, int j) const
+        {
+            assert (0 <= i && i <= ReadLength() - 8);
+            assert (0 <= j && j < TemplateLength());
+            return _mm256_loadu_ps(TableRow(incTable_, j) + i);
+        }
+
+        TARGET_AVX2 __m256 Del8(int i, int j) const
+        {
+            assert (0 <= i && i <= ReadLength() - 7);
+            assert (0 <= j && j < TemplateLength());
+            return _mm256_loadu_ps(TableRow(delTable_, j) + i);
+        }
+
+        TARGET_AVX2 __m256 Extra8(int i, int j) const
+        {
+            assert (0 <= i && i <= ReadLength() - 8);
+            assert (0 <= j && j <= TemplateLength());
+            return _mm256_loadu_ps(TableRow(extraTable_, j) + i);
+        }
 
-            if (tplBase == tplBaseNext)
+        TARGET_AVX2 __m256 Merge8(int i, int j) const
+        {
+            assert(0 <= i && i <= ReadLength() - 8);
+            assert(0 <= j && j < TemplateLength() - 1);
+            if (tpl_[j] != tpl_[j + 1])
             {
-                __m128 mask = _mm_cmpeq_ps(_mm_loadu_ps(&Features().SequenceAsFloat[i]),
-                                           _mm_set_ps1(tplBase));
-                return MUX4(mask, merge, noMerge);
+                return _mm256_set1_ps(-FLT_MAX);
             }
-            else
+            return _mm256_loadu_ps(TableRow(mergeTable_, j) + i);
+        }
+
+        TARGET_AVX512 __m512 Inc16(int i, int j) const
+        {
+            assert (0 <= i && i <= ReadLength() - 16);
+            assert (0 <= j && j < TemplateLength());
+            return _mm512_loadu_ps(TableRow(incTable_, j) + i);
+        }
+
+        TARGET_AVX512 __m512 Del16(int i, int j) const
+        {
+            assert (0 <= i && i <= ReadLength() - 15);
+            assert (0 <= j && j < TemplateLength());
+            return _mm512_loadu_ps(TableRow(delTable_, j) + i);
+        }
+
+        TARGET_AVX512 __m512 Extra16(int i, int j) const
+        {
+            assert (0 <= i && i <= ReadLength() - 16);
+            assert (0 <= j && j <= TemplateLength());
+            return _mm512_loadu_ps(TableRow(extraTable_, j) + i);
+        }
+
+        TARGET_AVX512 __m512 Merge16(int i, int j) const
+        {
+            assert(0 <= i && i <= ReadLength() - 16);
+            assert(0 <= j && j < TemplateLength() - 1);
+            if (tpl_[j] != tpl_[j + 1])
             {
-                return noMerge;
+                return _mm512_set1_ps(-FLT_MAX);
             }
+            return _mm512_loadu_ps(TableRow(mergeTable_, j) + i);
         }
 
+#endif  // SWIG
+
     protected:
         inline const QvSequenceFeatures& Features() const
         {
             return read_.Features;
         }
 
+        // The scores of each move at every read position are tabulated
+        // up front, one row per template base (as numbered by
+        // encodeTplBase), so that the accessors need only look them up.
+        // Extra has a further row for the column past the end of the
+        // template.  Rows are padded to a multiple of 16 entries, and Del
+        // rows run to ReadLength() inclusive.  Each table has a twin
+        // holding the move probabilities.  The tables are shared by copies
+        // of the evaluator.
+        void BuildTables()
+        {
+            int I = ReadLength();
+            tableStride_ = (I + 1 + QV_TABLE_PADDING - 1) / QV_TABLE_PADDING * QV_TABLE_PADDING;
+            int size = QV_TABLE_ROWS * tableStride_ + QV_TABLE_PADDING;
+            incTable_   = Feature<float>(size);
+            delTable_   = Feature<float>(size);
+            extraTable_ = Feature<float>(size);
+            mergeTable_ = Feature<float>(size);
+
+            const char bases[] = "ACGTMN";
+            for (int row = 0; row < QV_TABLE_ROWS; row++)
+            {
+                float* inc   = &incTable_[row * tableStride_];
+                float* del   = &delTable_[row * tableStride_];
+                float* extra = &extraTable_[row * tableStride_];
+                float* merge = &mergeTable_[row * tableStride_];
+                // Past the end of the template, nothing matches
+                char base = (row < QV_END_OF_TEMPLATE_ROW) ? bases[row] : '\0';
+                for (int i = 0; i < I; i++)
+                {
+                    bool isMatch = (Features()[i] == base);
+                    inc[i] = isMatch ?
+                        params_.Match :
+                        params_.Mismatch + params_.MismatchS * Features().SubsQv(i);
+                    extra[i] = isMatch ?
+                        params_.Branch + params_.BranchS * Features().InsQv(i) :
+                        params_.Nce + params_.NceS * Features().InsQv(i);
+                    // Only A, C, G and T have merge parameters
+                    merge[i] = (isMatch && row < 4) ?
+                        params_.Merge[row] + params_.MergeS[row] * Features().MergeQv(i) :
+                        -FLT_MAX;
+                }
+                for (int i = 0; i <= I; i++)
+                {
+                    if ((!PinStart() && i == 0) || (!PinEnd() && i == I))
+                    {
+                        del[i] = 0.0f;
+                    }
+                    else
+                    {
+                        del[i] = (i < I && base == static_cast<char>(Features().DelTag(i))) ?
+                            params_.DeletionWithTag + params_.DeletionWithTagS * Features().DelQv(i) :
+                            params_.DeletionN;
+                    }
+                }
+            }
+
+            incProbTable_   = ExpTable(incTable_);
+            delProbTable_   = ExpTable(delTable_);
+            extraProbTable_ = ExpTable(extraTable_);
+            mergeProbTable_ = ExpTable(mergeTable_);
+        }
+
+        // The table of exp(score) for a table of move scores (whose length
+        // is a multiple of the padding)
+        static Feature<float> ExpTable(const Feature<float>& table)
+        {
+            Feature<float> probs(table.Length());
+            for (int k = 0; k < table.Length(); k += 4)
+            {
+                _mm_storeu_ps(&probs[k], detail::Exp4(_mm_loadu_ps(&table[k])));
+            }
+            return probs;
+        }
+
+        const float* TableRow(const Feature<float>& table, int j) const
+        {
+            int row = (j < TemplateLength()) ? encodeTplBase(tpl_[j]) : QV_END_OF_TEMPLATE_ROW;
+            return &table[row * tableStride_];
+        }
 
     protected:
         Read read_;
         QvModelParams params_;
-        std::string tpl_;
+        detail::TemplateView tpl_;
         bool pinStart_;
         bool pinEnd_;
+        int tableStride_;
+        Feature<float> incTable_;
+        Feature<float> delTable_;
+        Feature<float> extraTable_;
+        Feature<float> mergeTable_;
+        Feature<float> incProbTable_;
+        Feature<float> delProbTable_;
+        Feature<float> extraProbTable_;
+        Feature<float> mergeProbTable_;
     };
 }
@@ -0,0 +1,1150 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+
+#include "Quiver/ScaledRecursor.hpp"
+
+#include <algorithm>
+#include <boost/tuple/tuple.hpp>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <vector>
+
+#include "Interval.hpp"
+#include "Utils.hpp"
+#include "Matrix/SparseMatrix.hpp"
+#include "Quiver/detail/Combiner.hpp"
+#include "Quiver/detail/SseMath.hpp"
+#include "Quiver/QvEvaluator.hpp"
+
+using std::max;
+using std::min;
+
+#define NEG_INF -FLT_MAX
+
+// Zero rows kept either side of a column's window, so that vector loads
+// straddling its ends stay in bounds
+#define SCALED_PADDING  4
+
+namespace ConsensusCore {
+
+    namespace {
+
+        // Flushes denormal results and inputs to zero while it lives.  In
+        // probability space they turn up in the far tails of columns, where
+        // each would otherwise cost a microcode assist.
+        class FlushDenormals
+        {
+        public:
+            FlushDenormals()
+                : csr_(_mm_getcsr())
+            {
+                _mm_setcsr(csr_ | _MM_FLUSH_ZERO_ON | _MM_DENORMALS_ZERO_ON);
+            }
+
+            ~FlushDenormals()
+            {
+                _mm_setcsr(csr_);
+            }
+
+        private:
+            unsigned int csr_;
+        };
+
+        // The smallest probability trusted, relative to its column's scale
+        inline float FloorProb()
+        {
+            return std::exp(-static_cast<float>(SCALED_LOG_FLOOR));
+        }
+
+        // The log score of a probability p at scale base
+        inline float LogScore(float p, float base)
+        {
+            return p > 0.0f ? std::log(p) + base : NEG_INF;
+        }
+
+        inline __m128 LogScore4(__m128 p4, float base)
+        {
+            return _mm_add_ps(detail::Log4(p4), _mm_set_ps1(base));
+        }
+
+        inline float Sum4(__m128 v)
+        {
+            __m128 t = _mm_add_ps(v, _mm_movehl_ps(v, v));
+            t = _mm_add_ss(t, _mm_shuffle_ps(t, t, 1));
+            return _mm_cvtss_f32(t);
+        }
+
+        //
+        // The Extra cascade within a block of four rows, in probability
+        // space: the analogues of detail::PrefixScan4 and SuffixScan4, with
+        // lane k holding the map x -> a + b x.
+        //
+
+        // Returns p[1..4], where p[0] = first and
+        // p[k] = from[k] + ins[k-1] p[k-1].
+        inline __m128 PrefixScan4(float first, __m128 from4, __m128 ins4)
+        {
+            const __m128 fromLane1 = _mm_castsi128_ps(_mm_set_epi32(-1, -1, -1, 0));
+            const __m128 fromLane2 = _mm_castsi128_ps(_mm_set_epi32(-1, -1, 0, 0));
+            __m128 a = from4, b = ins4, sa, sb;
+
+            sa = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(a), 4));
+            sb = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(b), 4));
+            a = _mm_add_ps(a, _mm_mul_ps(b, sa));
+            b = MUX4(fromLane1, _mm_mul_ps(b, sb), b);
+
+            sa = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(a), 8));
+            sb = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(b), 8));
+            a = _mm_add_ps(a, _mm_mul_ps(b, sa));
+            b = MUX4(fromLane2, _mm_mul_ps(b, sb), b);
+
+            return _mm_add_ps(a, _mm_mul_ps(b, _mm_set_ps1(first)));
+        }
+
+        // Returns p[0..3], where p[4] = last and
+        // p[k] = from[k] + ins[k] p[k+1].
+        inline __m128 SuffixScan4(__m128 from4, __m128 ins4, float last)
+        {
+            const __m128 toLane2 = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+            const __m128 toLane1 = _mm_castsi128_ps(_mm_set_epi32(0, 0, -1, -1));
+            __m128 a = from4, b = ins4, sa, sb;
+
+            sa = _mm_castsi128_ps(_mm_srli_si128(_mm_castps_si128(a), 4));
+            sb = _mm_castsi128_ps(_mm_srli_si128(_mm_castps_si128(b), 4));
+            a = _mm_add_ps(a, _mm_mul_ps(b, sa));
+            b = MUX4(toLane2, _mm_mul_ps(b, sb), b);
+
+            sa = _mm_castsi128_ps(_mm_srli_si128(_mm_castps_si128(a), 8));
+            sb = _mm_castsi128_ps(_mm_srli_si128(_mm_castps_si128(b), 8));
+            a = _mm_add_ps(a, _mm_mul_ps(b, sa));
+            b = MUX4(toLane1, _mm_mul_ps(b, sb), b);
+
+            return _mm_add_ps(a, _mm_mul_ps(b, _mm_set_ps1(last)));
+        }
+
+        //
+        // A column of alpha or beta in probability space, over the rows
+        // [windowBegin, windowEnd): the cell in row i has log score
+        // Base + log(p(i)).  Rows outside the used rows [Begin, End) are
+        // zero.  Max is the largest probability (zero if the column is
+        // empty).
+        //
+        class ScaledColumn
+        {
+        public:
+            float Base;
+            float Max;
+            int Begin;
+            int End;
+
+        public:
+            ScaledColumn(int windowBegin, int windowEnd)
+                : Base(0.0f),
+                  Max(0.0f),
+                  Begin(windowBegin),
+                  End(windowBegin),
+                  windowBegin_(windowBegin),
+                  windowEnd_(windowEnd),
+                  storage_(windowEnd - windowBegin + 2 * SCALED_PADDING, 0.0f)
+            {}
+
+            float operator()(int i) const
+            {
+                return storage_[Index(i)];
+            }
+
+            __m128 Get4(int i) const
+            {
+                assert(Index(i + 3) < static_cast<int>(storage_.size()));
+                return _mm_loadu_ps(&storage_[Index(i)]);
+            }
+
+            void Set(int i, float p)
+            {
+                storage_[Index(i)] = p;
+            }
+
+            void Set4(int i, __m128 p4)
+            {
+                assert(Index(i + 3) < static_cast<int>(storage_.size()));
+                _mm_storeu_ps(&storage_[Index(i)], p4);
+            }
+
+            // Zero the column, ready to be filled
+            void Clear()
+            {
+                std::fill(storage_.begin() + Index(Begin),
+                          storage_.begin() + Index(End), 0.0f);
+                Base = 0.0f;
+                Max = 0.0f;
+                Begin = End = windowBegin_;
+            }
+
+            // Having set rows [begin, end), record them as used
+            void Finish(int begin, int end, float maxProb)
+            {
+                Begin = begin;
+                End = end;
+                Max = maxProb;
+            }
+
+            // Read column j of a matrix of log scores, within the window,
+            // at the scale of its largest score
+            template <typename M>
+            void Load(const M& matrix, int j)
+            {
+                Clear();
+                Interval used = matrix.UsedRowRange(j);
+                int begin = max(used.Begin, windowBegin_);
+                int end = min(used.End, windowEnd_);
+                int i;
+
+                __m128 max4 = _mm_set_ps1(NEG_INF);
+                for (i = begin; i + 4 <= end; i += 4)
+                {
+                    max4 = _mm_max_ps(max4, matrix.Get4(i, j));
+                }
+                float maxScore = detail::HorizontalMax4(max4);
+                for (; i < end; i++)
+                {
+                    maxScore = max(maxScore, matrix(i, j));
+                }
+                if (maxScore == NEG_INF)
+                {
+                    return;
+                }
+
+                Base = maxScore;
+                __m128 base4 = _mm_set_ps1(Base);
+                for (i = begin; i + 4 <= end; i += 4)
+                {
+                    Set4(i, detail::Exp4(_mm_sub_ps(matrix.Get4(i, j), base4)));
+                }
+                for (; i < end; i++)
+                {
+                    Set(i, std::exp(matrix(i, j) - Base));
+                }
+                Finish(begin, end, 1.0f);
+            }
+
+            // The factor taking this column's probabilities to the given
+            // scale
+            float RatioTo(float base) const
+            {
+                return Max > 0.0f ? std::exp(min(Base - base, 80.0f)) : 0.0f;
+            }
+
+            // The log score of the largest probability
+            float MaxScore() const
+            {
+                return Max > 0.0f ? Base + std::log(Max) : NEG_INF;
+            }
+
+        private:
+            int Index(int i) const
+            {
+                assert(i >= windowBegin_ - SCALED_PADDING &&
+                       i < windowEnd_ + SCALED_PADDING);
+                return i - windowBegin_ + SCALED_PADDING;
+            }
+
+        private:
+            int windowBegin_;
+            int windowEnd_;
+            std::vector<float> storage_;
+        };
+
+        // The scale of a column computed from the column from (and the
+        // column merge, if any): the larger of their maxima, so that its
+        // probabilities are of order one
+        inline float ScaleFrom(const ScaledColumn& from, const ScaledColumn* merge)
+        {
+            float base = from.MaxScore();
+            if (merge != NULL)
+            {
+                base = max(base, merge->MaxScore());
+            }
+            return base == NEG_INF ? 0.0f : base;
+        }
+
+        // The rows of column j that ExtendAlpha and ExtendBeta fill, as the
+        // SseRecursor: those used in the original matrix or, beyond its
+        // ends, those from its nearest column's first (alpha) or last
+        // (beta) used row to the edge
+        template <typename M>
+        inline Interval ExtendAlphaRows(const M& alpha, int j)
+        {
+            if (j < alpha.Columns())
+            {
+                return alpha.UsedRowRange(j);
+            }
+            return Interval(alpha.UsedRowRange(alpha.Columns() - 1).Begin, alpha.Rows());
+        }
+
+        template <typename M>
+        inline Interval ExtendBetaRows(const M& beta, int j)
+        {
+            if (j < 0)
+            {
+                return Interval(0, beta.UsedRowRange(0).End);
+            }
+            return beta.UsedRowRange(j);
+        }
+
+        // Whether a just-computed column has what matters beyond its band
+        // above the floor: the pinned row (if not -1), and some row of the
+        // guide's column j.  (The guide's tails may lie deeper, harmlessly;
+        // but if all of it does, the guide's mass and this column's have
+        // parted, and it is the cells far down that link them.  Cells
+        // within the band are above the floor so long as its threshold is.)
+        template <typename M>
+        inline bool AboveFloor(const ScaledColumn& column, const M& guide, int j,
+                               int pinnedRow, float floorProb)
+        {
+            if (pinnedRow >= column.Begin && pinnedRow < column.End &&
+                column(pinnedRow) < floorProb)
+            {
+                return false;
+            }
+            if (guide.IsNull())
+            {
+                return true;
+            }
+            Interval rows = guide.UsedRowRange(j);
+            float guideMax = 0.0f;
+            for (int i = max(rows.Begin, column.Begin); i < min(rows.End, column.End); i++)
+            {
+                guideMax = max(guideMax, column(i));
+            }
+            return rows.Begin >= rows.End || guideMax >= floorProb;
+        }
+    }
+
+
+    template <typename M, typename E>
+    void
+    ScaledRecursor<M, E>::FillAlpha(const E& e, const M& guide, M& alpha,
+                                    int beginColumn) const
+    {
+        if (!BandFits() || !TryFillAlpha(e, guide, alpha, beginColumn))
+        {
+            logSpace_.FillAlpha(e, guide, alpha, beginColumn);
+        }
+    }
+
+
+    template <typename M, typename E>
+    bool
+    ScaledRecursor<M, E>::TryFillAlpha(const E& e, const M& guide, M& alpha,
+                                       int beginColumn) const
+    {
+        FlushDenormals flushDenormals;
+        int I = e.ReadLength();
+        int J = e.TemplateLength();
+
+        assert(alpha.Rows() == I + 1 && alpha.Columns() == J + 1);
+        assert(guide.IsNull() ||
+               (guide.Rows() == alpha.Rows() && guide.Columns() == alpha.Columns()));
+
+        bool merge = (this->movesAvailable_ & MERGE);
+        // The band keeps rows within this factor of the column's maximum
+        float bandRatio = std::exp(-this->bandingOptions_.ScoreDiff);
+        float floorProb = FloorProb();
+
+        int hintBeginRow, hintEndRow;
+        boost::tie(hintBeginRow, hintEndRow) =
+            detail::AlphaResumeHints(beginColumn, alpha, this->bandingOptions_.ScoreDiff);
+
+        // Columns j - 2, j - 1 and j
+        ScaledColumn c0(0, I + 1), c1(0, I + 1), c2(0, I + 1);
+        ScaledColumn* before = &c0;
+        ScaledColumn* last = &c1;
+        ScaledColumn* cur = &c2;
+        if (beginColumn >= 2 && merge)
+        {
+            before->Load(alpha, beginColumn - 2);
+        }
+        if (beginColumn >= 1)
+        {
+            last->Load(alpha, beginColumn - 1);
+        }
+
+        for (int j = beginColumn; j <= J; ++j)
+        {
+            this->RangeGuide(j, guide, alpha, &hintBeginRow, &hintEndRow);
+
+            int requiredEndRow = min(I + 1, hintEndRow);
+
+            cur->Clear();
+            cur->Base = ScaleFrom(*last, merge ? before : NULL);
+            float r = last->RatioTo(cur->Base);
+            float rMerge = before->RatioTo(cur->Base);
+
+            float prob = 0.0f;
+            float thresholdProb = 0.0f;
+            float maxProb = 0.0f;
+
+            alpha.StartEditingColumn(j, hintBeginRow, hintEndRow);
+
+            int i;
+            int beginRow = hintBeginRow, endRow;
+            // As in the SseRecursor, handle the first rows (at least row
+            // 0) one at a time, leaving a multiple of 4 for the SSE loop
+            for (i = beginRow;
+                 (i == 0 || (I - i + 1) % 4 != 0) && i <= I;
+                 i++)
+            {
+                prob = (i == 0 && j == 0) ? 1.0f : 0.0f;
+
+                // Inc
+                if (i > 0 && j > 0)
+                {
+                    prob += (*last)(i - 1) * e.IncProb(i - 1, j - 1) * r;
+                }
+                // Merge
+                if (merge && (i > 0 && j > 1))
+                {
+                    prob += (*before)(i - 1) * e.MergeProb(i - 1, j - 2) * rMerge;
+                }
+                // Delete
+                if (j > 0)
+                {
+                    prob += (*last)(i) * e.DelProb(i, j - 1) * r;
+                }
+                // Extra
+                if (i > 0)
+                {
+                    prob += (*cur)(i - 1) * e.ExtraProb(i - 1, j);
+                }
+                cur->Set(i, prob);
+                alpha.Set(i, j, LogScore(prob, cur->Base));
+
+                if (prob > maxProb)
+                {
+                    maxProb = prob;
+                    thresholdProb = maxProb * bandRatio;
+                }
+            }
+            //
+            // Main SSE loop
+            //
+            assert(i > 0);
+            for (;
+                 i <= I && (prob >= thresholdProb || i < requiredEndRow);
+                 i += 4)
+            {
+                __m128 prob4 = _mm_setzero_ps();
+                // Incorporation and deletion:
+                if (j > 0)
+                {
+                    prob4 = _mm_add_ps(_mm_mul_ps(last->Get4(i - 1), e.IncProb4(i - 1, j - 1)),
+                                       _mm_mul_ps(last->Get4(i), e.DelProb4(i, j - 1)));
+                    prob4 = _mm_mul_ps(prob4, _mm_set_ps1(r));
+                }
+                // Merge
+                if (merge && j >= 2)
+                {
+                    prob4 = _mm_add_ps(prob4,
+                                       _mm_mul_ps(_mm_mul_ps(before->Get4(i - 1),
+                                                             e.MergeProb4(i - 1, j - 2)),
+                                                  _mm_set_ps1(rMerge)));
+                }
+                // Extra
+                prob4 = PrefixScan4((*cur)(i - 1), prob4, e.ExtraProb4(i - 1, j));
+                cur->Set4(i, prob4);
+                alpha.Set4(i, j, LogScore4(prob4, cur->Base));
+
+                float potentialNewMax = detail::HorizontalMax4(prob4);
+                prob = detail::HorizontalMin4(prob4);
+
+                if (potentialNewMax > maxProb)
+                {
+                    maxProb = potentialNewMax;
+                    thresholdProb = maxProb * bandRatio;
+                }
+            }
+
+            endRow = i;
+            alpha.FinishEditingColumn(j, beginRow, endRow);
+            cur->Finish(beginRow, endRow, maxProb);
+
+            if (thresholdProb < floorProb ||
+                !AboveFloor(*cur, guide, j, (j == J) ? I : -1, floorProb))
+            {
+                return false;
+            }
+
+            // Now, revise the hints to tell the caller where the mass of the
+            // distribution really lived in this column.
+            hintEndRow = endRow;
+            for (i = beginRow; i < endRow && (*cur)(i) < thresholdProb; ++i);
+            hintBeginRow = i;
+
+            ScaledColumn* spare = before;
+            before = last;
+            last = cur;
+            cur = spare;
+        }
+        return true;
+    }
+
+
+    template <typename M, typename E>
+    void
+    ScaledRecursor<M, E>::FillBeta(const E& e, const M& guide, M& beta,
+                                   int endColumn) const
+    {
+        if (!BandFits() || !TryFillBeta(e, guide, beta, endColumn))
+        {
+            logSpace_.FillBeta(e, guide, beta, endColumn);
+        }
+    }
+
+
+    template <typename M, typename E>
+    bool
+    ScaledRecursor<M, E>::TryFillBeta(const E& e, const M& guide, M& beta,
+                                      int endColumn) const
+    {
+        FlushDenormals flushDenormals;
+        int I = e.ReadLength();
+        int J = e.TemplateLength();
+
+        assert(beta.Rows() == I + 1 && beta.Columns() == J + 1);
+        assert(guide.IsNull() ||
+               (guide.Rows() == beta.Rows() && guide.Columns() == beta.Columns()));
+
+        bool merge = (this->movesAvailable_ & MERGE);
+        float bandRatio = std::exp(-this->bandingOptions_.ScoreDiff);
+        float floorProb = FloorProb();
+
+        int lastColumn = min(endColumn, J + 1) - 1;
+        int hintBeginRow, hintEndRow;
+        boost::tie(hintBeginRow, hintEndRow) =
+            detail::BetaResumeHints(lastColumn, beta, this->bandingOptions_.ScoreDiff);
+
+        // Columns j + 2, j + 1 and j
+        ScaledColumn c0(0, I + 1), c1(0, I + 1), c2(0, I + 1);
+        ScaledColumn* after = &c0;
+        ScaledColumn* next = &c1;
+        ScaledColumn* cur = &c2;
+        if (lastColumn + 2 <= J && merge)
+        {
+            after->Load(beta, lastColumn + 2);
+        }
+        if (lastColumn + 1 <= J)
+        {
+            next->Load(beta, lastColumn + 1);
+        }
+
+        for (int j = lastColumn; j >= 0; --j)
+        {
+            this->RangeGuide(j, guide, beta, &hintBeginRow, &hintEndRow);
+
+            int requiredBeginRow = max(0, hintBeginRow);
+
+            cur->Clear();
+            cur->Base = ScaleFrom(*next, merge ? after : NULL);
+            float r = next->RatioTo(cur->Base);
+            float rMerge = after->RatioTo(cur->Base);
+
+            float prob = 0.0f;
+            float thresholdProb = 0.0f;
+            float maxProb = 0.0f;
+
+            beta.StartEditingColumn(j, hintBeginRow, hintEndRow);
+
+            int i, beginRow, endRow = hintEndRow;
+            for (i = endRow - 1;
+                 (i == I || (i + 1) % 4 != 0) && i >= 0;
+                 i--)
+            {
+                prob = (i == I && j == J) ? 1.0f : 0.0f;
+
+                // Inc
+                if (i < I && j < J)
+                {
+                    prob += (*next)(i + 1) * e.IncProb(i, j) * r;
+                }
+                // Merge
+                if (merge && j < J - 1 && i < I)
+                {
+                    prob += (*after)(i + 1) * e.MergeProb(i, j) * rMerge;
+                }
+                // Delete
+                if (j < J)
+                {
+                    prob += (*next)(i) * e.DelProb(i, j) * r;
+                }
+                // Extra
+                if (i < I)
+                {
+                    prob += (*cur)(i + 1) * e.ExtraProb(i, j);
+                }
+                cur->Set(i, prob);
+                beta.Set(i, j, LogScore(prob, cur->Base));
+
+                if (prob > maxProb)
+                {
+                    maxProb = prob;
+                    thresholdProb = maxProb * bandRatio;
+                }
+            }
+            //
+            // SSE loop
+            //
+            i = i - 3;
+            for (;
+                 i >= 0 && (prob >= thresholdProb || i >= requiredBeginRow);
+                 i -= 4)
+            {
+                __m128 prob4 = _mm_setzero_ps();
+
+                // Incorporation and deletion:
+                if (j < J)
+                {
+                    prob4 = _mm_add_ps(_mm_mul_ps(next->Get4(i + 1), e.IncProb4(i, j)),
+                                       _mm_mul_ps(next->Get4(i), e.DelProb4(i, j)));
+                    prob4 = _mm_mul_ps(prob4, _mm_set_ps1(r));
+                }
+                // Merge
+                if (merge && j < J - 1)
+                {
+                    prob4 = _mm_add_ps(prob4,
+                                       _mm_mul_ps(_mm_mul_ps(after->Get4(i + 1), e.MergeProb4(i, j)),
+                                                  _mm_set_ps1(rMerge)));
+                }
+                // Extra
+                prob4 = SuffixScan4(prob4, e.ExtraProb4(i, j), (*cur)(i + 4));
+                cur->Set4(i, prob4);
+                beta.Set4(i, j, LogScore4(prob4, cur->Base));
+
+                float potentialNewMax = detail::HorizontalMax4(prob4);
+                prob = detail::HorizontalMin4(prob4);
+
+                if (potentialNewMax > maxProb)
+                {
+                    maxProb = potentialNewMax;
+                    thresholdProb = maxProb * bandRatio;
+                }
+            }
+
+            beginRow = i + 4;
+            beta.FinishEditingColumn(j, beginRow, endRow);
+            cur->Finish(beginRow, endRow, maxProb);
+
+            if (thresholdProb < floorProb ||
+                !AboveFloor(*cur, guide, j, (j == 0) ? 0 : -1, floorProb))
+            {
+                return false;
+            }
+
+            // Now, revise the hints to tell the caller where the mass of the
+            // distribution really lived in this column.
+            hintBeginRow = beginRow;
+            for (i = endRow;
+                 i > beginRow && (*cur)(i - 1) < thresholdProb;
+                 i--);
+            hintEndRow = i;
+
+            ScaledColumn* spare = after;
+            after = next;
+            next = cur;
+            cur = spare;
+        }
+        return true;
+    }
+
+
+    template <typename M, typename E>
+    float
+    ScaledRecursor<M, E>::LinkAlphaBeta(const E& e,
+                                        const M& alpha, int alphaColumn,
+                                        const M& beta, int betaColumn,
+                                        int absoluteColumn) const
+    {
+        float score;
+        if (!TryLinkAlphaBeta(e, alpha, alphaColumn, beta, betaColumn,
+                              absoluteColumn, &score))
+        {
+            score = logSpace_.LinkAlphaBeta(e, alpha, alphaColumn, beta, betaColumn,
+                                            absoluteColumn);
+        }
+        return score;
+    }
+
+
+    template <typename M, typename E>
+    bool
+    ScaledRecursor<M, E>::TryLinkAlphaBeta(const E& e,
+                                           const M& alpha, int alphaColumn,
+                                           const M& beta, int betaColumn,
+                                           int absoluteColumn, float* score) const
+    {
+        FlushDenormals flushDenormals;
+        const int I = e.ReadLength();
+
+        assert(alphaColumn > 1 && absoluteColumn > 1);
+        assert(absoluteColumn < e.TemplateLength());
+
+        bool merge = (this->movesAvailable_ & MERGE);
+
+        int usedBegin, usedEnd;
+        boost::tie(usedBegin, usedEnd) = \
+            RangeUnion(alpha.UsedRowRange(alphaColumn - 2),
+                       alpha.UsedRowRange(alphaColumn - 1),
+                       beta.UsedRowRange(betaColumn),
+                       beta.UsedRowRange(betaColumn + 1));
+        int windowEnd = min(usedEnd + 1, I + 1);
+
+        ScaledColumn alphaBefore(usedBegin, windowEnd), alphaLast(usedBegin, windowEnd);
+        ScaledColumn betaFirst(usedBegin, windowEnd), betaNext(usedBegin, windowEnd);
+        alphaLast.Load(alpha, alphaColumn - 1);
+        betaFirst.Load(beta, betaColumn);
+        if (merge)
+        {
+            alphaBefore.Load(alpha, alphaColumn - 2);
+            betaNext.Load(beta, betaColumn + 1);
+        }
+
+        // The paths through each pair of columns, summed at the scale of
+        // that pair: Inc and Delete from the last alpha column to the first
+        // beta one, and the two ways of Merging
+        float incDel = 0.0f, mergeBefore = 0.0f, mergeNext = 0.0f;
+        __m128 incDel4 = _mm_setzero_ps();
+        __m128 mergeBefore4 = _mm_setzero_ps();
+        __m128 mergeNext4 = _mm_setzero_ps();
+
+        // SSE loop
+        int i;
+        for (i = usedBegin; i < usedEnd - 4; i += 4)
+        {
+            __m128 moves4 = _mm_add_ps(_mm_mul_ps(e.IncProb4(i, absoluteColumn - 1),
+                                                  betaFirst.Get4(i + 1)),
+                                       _mm_mul_ps(e.DelProb4(i, absoluteColumn - 1),
+                                                  betaFirst.Get4(i)));
+            incDel4 = _mm_add_ps(incDel4, _mm_mul_ps(alphaLast.Get4(i), moves4));
+            if (merge)
+            {
+                mergeBefore4 = _mm_add_ps(mergeBefore4,
+                                          _mm_mul_ps(_mm_mul_ps(alphaBefore.Get4(i),
+                                                                e.MergeProb4(i, absoluteColumn - 2)),
+                                                     betaFirst.Get4(i + 1)));
+                mergeNext4 = _mm_add_ps(mergeNext4,
+                                        _mm_mul_ps(_mm_mul_ps(alphaLast.Get4(i),
+                                                              e.MergeProb4(i, absoluteColumn - 1)),
+                                                   betaNext.Get4(i + 1)));
+            }
+        }
+        // Handle the remaining rows non-SSE
+        for (; i < usedEnd; i++)
+        {
+            if (i < I)
+            {
+                incDel += alphaLast(i) * e.IncProb(i, absoluteColumn - 1) * betaFirst(i + 1);
+                if (merge)
+                {
+                    mergeBefore += alphaBefore(i) * e.MergeProb(i, absoluteColumn - 2) *
+                                   betaFirst(i + 1);
+                    mergeNext += alphaLast(i) * e.MergeProb(i, absoluteColumn - 1) *
+                                 betaNext(i + 1);
+                }
+            }
+            incDel += alphaLast(i) * e.DelProb(i, absoluteColumn - 1) * betaFirst(i);
+        }
+
+        float scale = alphaLast.Base + betaFirst.Base;
+        *score = LogScore(incDel + Sum4(incDel4), scale);
+        if (merge)
+        {
+            *score = detail::SumProductCombiner::Combine(
+                *score, LogScore(mergeBefore + Sum4(mergeBefore4),
+                                 alphaBefore.Base + betaFirst.Base));
+            *score = detail::SumProductCombiner::Combine(
+                *score, LogScore(mergeNext + Sum4(mergeNext4),
+                                 alphaLast.Base + betaNext.Base));
+            scale = max(scale, max(alphaBefore.Base + betaFirst.Base,
+                                   alphaLast.Base + betaNext.Base));
+        }
+        // Products of trusted cells can still fall beneath the floor, when
+        // alpha's mass and beta's lie apart
+        return *score >= scale - SCALED_LOG_FLOOR;
+    }
+
+
+    template <typename M, typename E>
+    void
+    ScaledRecursor<M, E>::ExtendAlpha(const E& e,
+                                      const M& alpha, int beginColumn,
+                                      M& ext, int numExtColumns,
+                                      int firstExtColumn) const
+    {
+        if (!TryExtendAlpha(e, alpha, beginColumn, ext, numExtColumns, firstExtColumn))
+        {
+            logSpace_.ExtendAlpha(e, alpha, beginColumn, ext, numExtColumns, firstExtColumn);
+        }
+    }
+
+
+    template <typename M, typename E>
+    bool
+    ScaledRecursor<M, E>::TryExtendAlpha(const E& e,
+                                         const M& alpha, int beginColumn,
+                                         M& ext, int numExtColumns,
+                                         int firstExtColumn) const
+    {
+        FlushDenormals flushDenormals;
+        assert(numExtColumns >= 2);
+        assert(0 <= firstExtColumn && firstExtColumn < numExtColumns);
+        assert(alpha.Rows() == e.ReadLength() + 1 &&
+               ext.Rows() == e.ReadLength() + 1);
+        assert(beginColumn + 1 < e.TemplateLength() + 1);
+        assert(ext.Columns() >= numExtColumns);
+        assert(beginColumn >= 2);
+
+        bool merge = (this->movesAvailable_ & MERGE);
+        int I = e.ReadLength();
+        int J = e.TemplateLength();
+        float floorProb = FloorProb();
+
+        // The rows read: those filled, and the row above each
+        int windowBegin = alpha.Rows(), windowEnd = 0;
+        for (int extCol = 0; extCol < numExtColumns; extCol++)
+        {
+            Interval rows = ExtendAlphaRows(alpha, beginColumn + extCol);
+            windowBegin = min(windowBegin, rows.Begin - 1);
+            windowEnd = max(windowEnd, rows.End);
+        }
+        windowBegin = max(windowBegin, 0);
+
+        // Alpha's columns beginColumn - 2 and beginColumn - 1, and the
+        // last two extension columns
+        ScaledColumn before(windowBegin, windowEnd), last(windowBegin, windowEnd);
+        ScaledColumn c0(windowBegin, windowEnd), c1(windowBegin, windowEnd);
+        if (merge)
+        {
+            before.Load(alpha, beginColumn - 2);
+        }
+        last.Load(alpha, beginColumn - 1);
+
+        // Resuming an extension, the column before comes from ext itself
+        const ScaledColumn* prev = &last;
+        ScaledColumn* cur = &c0;
+        if (firstExtColumn > 0)
+        {
+            c1.Load(ext, firstExtColumn - 1);
+            prev = &c1;
+        }
+        for (int extCol = firstExtColumn; extCol < numExtColumns; extCol++)
+        {
+            int j = beginColumn + extCol;
+            int beginRow, endRow;
+            boost::tie(beginRow, endRow) = ExtendAlphaRows(alpha, j);
+
+            // Merges come from alpha, even past the first extension column
+            // (as in the SseRecursor)
+            ScaledColumn older(0, 0);
+            const ScaledColumn* mergeFrom = NULL;
+            if (merge)
+            {
+                if (extCol == 0)
+                {
+                    mergeFrom = &before;
+                }
+                else if (extCol == 1)
+                {
+                    mergeFrom = &last;
+                }
+                else
+                {
+                    assert(j - 2 < alpha.Columns());
+                    older = ScaledColumn(windowBegin, windowEnd);
+                    older.Load(alpha, j - 2);
+                    mergeFrom = &older;
+                }
+            }
+
+            cur->Clear();
+            cur->Base = ScaleFrom(*prev, mergeFrom);
+            float r = prev->RatioTo(cur->Base);
+            float rMerge = (mergeFrom != NULL) ? mergeFrom->RatioTo(cur->Base) : 0.0f;
+            float maxProb = 0.0f;
+            __m128 maxProb4 = _mm_setzero_ps();
+
+            ext.StartEditingColumn(extCol, beginRow, endRow);
+            int i;
+            // Handle the first rows non-SSE, leaving a multiple of 4
+            // entries to be handed off to the SSE loop.  Need to always
+            // handle at least row 0 this way.
+            for (i = beginRow;
+                 (i == 0 || (endRow - i) % 4 != 0) && i < endRow;
+                 i++)
+            {
+                float prob = 0.0f;
+                if (i > 0)
+                {
+                    // Inc
+                    prob += (*prev)(i - 1) * e.IncProb(i - 1, j - 1) * r;
+                    // Extra
+                    prob += (*cur)(i - 1) * e.ExtraProb(i - 1, j);
+                    // Merge
+                    if (mergeFrom != NULL)
+                    {
+                        prob += (*mergeFrom)(i - 1) * e.MergeProb(i - 1, j - 2) * rMerge;
+                    }
+                }
+                // Delete
+                prob += (*prev)(i) * e.DelProb(i, j - 1) * r;
+                cur->Set(i, prob);
+                ext.Set(i, extCol, LogScore(prob, cur->Base));
+                maxProb = max(maxProb, prob);
+            }
+            for (; i < endRow - 3; i += 4)
+            {
+                // Incorporation and deletion:
+                __m128 prob4 = _mm_add_ps(_mm_mul_ps(prev->Get4(i - 1), e.IncProb4(i - 1, j - 1)),
+                                          _mm_mul_ps(prev->Get4(i), e.DelProb4(i, j - 1)));
+                prob4 = _mm_mul_ps(prob4, _mm_set_ps1(r));
+                // Merge
+                if (mergeFrom != NULL)
+                {
+                    prob4 = _mm_add_ps(prob4,
+                                       _mm_mul_ps(_mm_mul_ps(mergeFrom->Get4(i - 1),
+                                                             e.MergeProb4(i - 1, j - 2)),
+                                                  _mm_set_ps1(rMerge)));
+                }
+                // Extras:
+                prob4 = PrefixScan4((*cur)(i - 1), prob4, e.ExtraProb4(i - 1, j));
+                cur->Set4(i, prob4);
+                ext.Set4(i, extCol, LogScore4(prob4, cur->Base));
+                maxProb4 = _mm_max_ps(maxProb4, prob4);
+            }
+            assert (i == endRow);
+
+            ext.FinishEditingColumn(extCol, beginRow, endRow);
+            cur->Finish(beginRow, endRow, max(maxProb, detail::HorizontalMax4(maxProb4)));
+
+            if (!AboveFloor(*cur, M::Null(), j, (j == J) ? I : -1, floorProb))
+            {
+                return false;
+            }
+
+            prev = cur;
+            cur = (cur == &c0) ? &c1 : &c0;
+        }
+        return true;
+    }
+
+
+    template <typename M, typename E>
+    void
+    ScaledRecursor<M, E>::ExtendBeta(const E& e,
+                                     const M& beta, int endColumn,
+                                     M& ext, int numExtColumns,
+                                     int lengthDiff) const
+    {
+        if (!TryExtendBeta(e, beta, endColumn, ext, numExtColumns, lengthDiff))
+        {
+            logSpace_.ExtendBeta(e, beta, endColumn, ext, numExtColumns, lengthDiff);
+        }
+    }
+
+
+    template <typename M, typename E>
+    bool
+    ScaledRecursor<M, E>::TryExtendBeta(const E& e,
+                                        const M& beta, int endColumn,
+                                        M& ext, int numExtColumns,
+                                        int lengthDiff) const
+    {
+        FlushDenormals flushDenormals;
+        int I = beta.Rows() - 1;
+        int lastColumn = endColumn;
+        int lastExtColumn = numExtColumns - 1;
+
+        // (Beta's columns lastColumn + 1 and lastColumn + 2 must exist)
+        assert(ext.Rows() == I + 1);
+        assert(lastColumn + 2 <= beta.Columns() - 1);
+        assert(lastColumn >= 0);
+        assert(ext.Columns() >= numExtColumns);
+
+        bool merge = (this->movesAvailable_ & MERGE);
+        float floorProb = FloorProb();
+
+        // The rows read: those filled, and the row below each
+        int windowBegin = beta.Rows(), windowEnd = 0;
+        for (int j = lastColumn; j > lastColumn - numExtColumns; j--)
+        {
+            Interval rows = ExtendBetaRows(beta, j);
+            windowBegin = min(windowBegin, rows.Begin);
+            windowEnd = max(windowEnd, rows.End + 1);
+        }
+        windowEnd = min(windowEnd, I + 1);
+
+        // Beta's columns lastColumn + 2 and lastColumn + 1, and the last
+        // two extension columns
+        ScaledColumn after(windowBegin, windowEnd), next(windowBegin, windowEnd);
+        ScaledColumn c0(windowBegin, windowEnd), c1(windowBegin, windowEnd);
+        if (merge)
+        {
+            after.Load(beta, lastColumn + 2);
+        }
+        next.Load(beta, lastColumn + 1);
+
+        const ScaledColumn* prev = &next;
+        ScaledColumn* cur = &c0;
+        for (int j = lastColumn; j > lastColumn - numExtColumns; j--)
+        {
+            // Column j of the old template is column jp of the new one
+            int jp = j + lengthDiff;
+            int extCol = lastExtColumn - (lastColumn - j);
+            int beginRow, endRow;
+            boost::tie(beginRow, endRow) = ExtendBetaRows(beta, j);
+
+            // Merges always come from the old beta, as in the SseRecursor
+            ScaledColumn older(0, 0);
+            const ScaledColumn* mergeFrom = NULL;
+            if (merge)
+            {
+                if (extCol == lastExtColumn)
+                {
+                    mergeFrom = &after;
+                }
+                else if (extCol == lastExtColumn - 1)
+                {
+                    mergeFrom = &next;
+                }
+                else
+                {
+                    older = ScaledColumn(windowBegin, windowEnd);
+                    older.Load(beta, j + 2);
+                    mergeFrom = &older;
+                }
+            }
+
+            cur->Clear();
+            cur->Base = ScaleFrom(*prev, mergeFrom);
+            float r = prev->RatioTo(cur->Base);
+            float rMerge = (mergeFrom != NULL) ? mergeFrom->RatioTo(cur->Base) : 0.0f;
+            float maxProb = 0.0f;
+            __m128 maxProb4 = _mm_setzero_ps();
+
+            ext.StartEditingColumn(extCol, beginRow, endRow);
+            //
+            // As in FillBeta: handle the last rows non-SSE, including row
+            // I, leaving a multiple of 4 rows for the SSE loop.
+            //
+            int i;
+            for (i = endRow - 1;
+                 (i == I || (i + 1 - beginRow) % 4 != 0) && i >= beginRow;
+                 i--)
+            {
+                float prob = 0.0f;
+                if (i < I)
+                {
+                    // Incorporation:
+                    prob += (*prev)(i + 1) * e.IncProb(i, jp) * r;
+                    // Extra:
+                    prob += (*cur)(i + 1) * e.ExtraProb(i, jp);
+                    // Merge:
+                    if (mergeFrom != NULL)
+                    {
+                        prob += (*mergeFrom)(i + 1) * e.MergeProb(i, jp) * rMerge;
+                    }
+                }
+                // Delete:
+                prob += (*prev)(i) * e.DelProb(i, jp) * r;
+                cur->Set(i, prob);
+                ext.Set(i, extCol, LogScore(prob, cur->Base));
+                maxProb = max(maxProb, prob);
+            }
+            //
+            // SSE loop
+            //
+            for (i = i - 3; i >= beginRow; i -= 4)
+            {
+                // Incorporation and deletion:
+                __m128 prob4 = _mm_add_ps(_mm_mul_ps(prev->Get4(i + 1), e.IncProb4(i, jp)),
+                                          _mm_mul_ps(prev->Get4(i), e.DelProb4(i, jp)));
+                prob4 = _mm_mul_ps(prob4, _mm_set_ps1(r));
+                // Merge
+                if (mergeFrom != NULL)
+                {
+                    prob4 = _mm_add_ps(prob4,
+                                       _mm_mul_ps(_mm_mul_ps(mergeFrom->Get4(i + 1),
+                                                             e.MergeProb4(i, jp)),
+                                                  _mm_set_ps1(rMerge)));
+                }
+                // Extras:
+                prob4 = SuffixScan4(prob4, e.ExtraProb4(i, jp), (*cur)(i + 4));
+                cur->Set4(i, prob4);
+                ext.Set4(i, extCol, LogScore4(prob4, cur->Base));
+                maxProb4 = _mm_max_ps(maxProb4, prob4);
+            }
+            assert(i + 4 == beginRow);
+
+            ext.FinishEditingColumn(extCol, beginRow, endRow);
+            cur->Finish(beginRow, endRow, max(maxProb, detail::HorizontalMax4(maxProb4)));
+
+            if (!AboveFloor(*cur, M::Null(), j, (jp == 0) ? 0 : -1, floorProb))
+            {
+                return false;
+            }
+
+            prev = cur;
+            cur = (cur == &c0) ? &c1 : &c0;
+        }
+        return true;
+    }
+
+
+    template <typename M, typename E>
+    bool
+    ScaledRecursor<M, E>::BandFits() const
+    {
+        return this->bandingOptions_.ScoreDiff < SCALED_LOG_FLOOR;
+    }
+
+
+    template <typename M, typename E>
+    ScaledRecursor<M, E>::ScaledRecursor(int movesAvailable, const BandingOptions& banding)
+        : detail::RecursorBase<M, E, detail::SumProductCombiner>(movesAvailable, banding),
+          logSpace_(movesAvailable, banding)
+    {}
+
+    template class ScaledRecursor<SparseMatrix, QvEvaluator>;
+}
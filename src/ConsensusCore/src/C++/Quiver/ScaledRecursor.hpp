@@ -0,0 +1,136 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+
+#pragma once
+
+#include <climits>
+
+#include "Matrix/SparseMatrix.hpp"
+#include "Quiver/QvEvaluator.hpp"
+#include "Quiver/detail/Combiner.hpp"
+#include "Quiver/detail/RecursorBase.hpp"
+#include "Quiver/SseRecursor.hpp"
+
+// Scaled probabilities are trusted down to this many (natural log) units
+// below their column's scale.  A float reaches about 87; what is flushed to
+// zero beneath that is then negligible beside any cell that is trusted.
+#define SCALED_LOG_FLOOR  72
+
+namespace ConsensusCore {
+
+    /// \brief A sum-product recursor working in probability space.
+    ///
+    /// The log-space recursors combine paths with a log-add, which costs
+    /// an exp and a log per combine.  Here each column is computed in
+    /// probability space, relative to a scale factor taken from the
+    /// columns it depends on (the standard scaled forward/backward
+    /// recursion), so that combining paths is a multiply-add.  The
+    /// matrices still hold log scores---each cell the log of its scaled
+    /// probability plus the log of the column's scale---so that they can
+    /// be banded, checkpointed, linked and compared just as the
+    /// SseRecursor's; the columns a fill or extension starts from are
+    /// read back out of them with an exp apiece.
+    ///
+    /// A float spans only about 87 (natural log) units below its column's
+    /// scale.  For reads that belong to their template, the band keeps
+    /// well clear of that; but a read whose band has lost its path, or one
+    /// unrelated to its template, reaches the rows it is pinned to (and a
+    /// guide's rows) only through cells further down.  Whenever a call
+    /// produces a cell below SCALED_LOG_FLOOR, or the banding asks for
+    /// cells that deep, it is redone by the log-space SseRecursor.  Scores
+    /// thus agree with the SseRecursor's sum-product to within float
+    /// rounding, though cells far below their column's best may not.
+    template <typename M, typename E>
+    class ScaledRecursor : public detail::RecursorBase<M, E, detail::SumProductCombiner>
+    {
+    public:
+        void FillAlpha(const E& e, const M& guide, M& alpha,
+                       int beginColumn = 0) const;
+        void FillBeta(const E& e, const M& guide, M& beta,
+                      int endColumn = INT_MAX) const;
+
+        float LinkAlphaBeta(const E& e,
+                            const M& alpha, int alphaColumn,
+                            const M& beta, int betaColumn,
+                            int absoluteColumn) const;
+
+        void ExtendAlpha(const E& e,
+                         const M& alpha, int beginColumn,
+                         M& ext, int numExtColumns = 2,
+                         int firstExtColumn = 0) const;
+
+        void ExtendBeta(const E& e,
+                        const M& beta, int endColumn,
+                        M& ext, int numExtColumns = 2,
+                        int lengthDiff = 0) const;
+
+    public:
+        //
+        // Constructors
+        //
+        ScaledRecursor(int movesAvailable, const BandingOptions& banding);
+
+    private:
+        // The recursions in probability space.  Each returns false, having
+        // left its output half-written, as soon as it finds that a cell
+        // that matters (one in the band, the guide, or a pinned corner) is
+        // below SCALED_LOG_FLOOR.
+        bool TryFillAlpha(const E& e, const M& guide, M& alpha,
+                          int beginColumn) const;
+        bool TryFillBeta(const E& e, const M& guide, M& beta,
+                         int endColumn) const;
+        bool TryLinkAlphaBeta(const E& e,
+                              const M& alpha, int alphaColumn,
+                              const M& beta, int betaColumn,
+                              int absoluteColumn, float* score) const;
+        bool TryExtendAlpha(const E& e,
+                            const M& alpha, int beginColumn,
+                            M& ext, int numExtColumns,
+                            int firstExtColumn) const;
+        bool TryExtendBeta(const E& e,
+                           const M& beta, int endColumn,
+                           M& ext, int numExtColumns,
+                           int lengthDiff) const;
+
+        // Whether the band can be held in probability space at all
+        bool BandFits() const;
+
+    private:
+        SseRecursor<M, E, detail::SumProductCombiner> logSpace_;
+    };
+
+    typedef ScaledRecursor<SparseMatrix, QvEvaluator> SparseScaledQvSumProductRecursor;
+}
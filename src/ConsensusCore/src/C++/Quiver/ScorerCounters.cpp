@@ -0,0 +1,135 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#include "Quiver/ScorerCounters.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+namespace ConsensusCore {
+
+    ScorerCounters::ScorerCounters()
+    {
+        Reset();
+    }
+
+    float ScorerCounters::MeanBandWidth() const
+    {
+        if (BandColumns == 0)
+        {
+            return 0;
+        }
+        return (FillAlphaCells + FillBetaCells) / BandColumns;
+    }
+
+    double ScorerCounters::TotalCells() const
+    {
+        return FillAlphaCells + FillBetaCells + ExtendAlphaCells +
+               ExtendBetaCells + LinkAlphaBetaCells + RebuildCells;
+    }
+
+    double ScorerCounters::TotalSeconds() const
+    {
+        // The extend and link times are included in ScoreMutationSeconds
+        return FillAlphaSeconds + FillBetaSeconds + RebuildSeconds +
+               ScoreMutationSeconds;
+    }
+
+    void ScorerCounters::Add(const ScorerCounters& other)
+    {
+        FillAlphaCells       += other.FillAlphaCells;
+        FillBetaCells        += other.FillBetaCells;
+        ExtendAlphaCells     += other.ExtendAlphaCells;
+        ExtendBetaCells      += other.ExtendBetaCells;
+        LinkAlphaBetaCells   += other.LinkAlphaBetaCells;
+        RebuildCells         += other.RebuildCells;
+        FillAlphaSeconds     += other.FillAlphaSeconds;
+        FillBetaSeconds      += other.FillBetaSeconds;
+        ExtendAlphaSeconds   += other.ExtendAlphaSeconds;
+        ExtendBetaSeconds    += other.ExtendBetaSeconds;
+        LinkAlphaBetaSeconds += other.LinkAlphaBetaSeconds;
+        RebuildSeconds       += other.RebuildSeconds;
+        BandColumns          += other.BandColumns;
+        MaxBandWidth          = std::max(MaxBandWidth, other.MaxBandWidth);
+        Reallocations        += other.Reallocations;
+        FlipFlops            += other.FlipFlops;
+        MutationsScored      += other.MutationsScored;
+        ScoreMutationSeconds += other.ScoreMutationSeconds;
+        MutationsScreened    += other.MutationsScreened;
+        MutationsScreenedOut += other.MutationsScreenedOut;
+    }
+
+    void ScorerCounters::Reset()
+    {
+        FillAlphaCells       = 0;
+        FillBetaCells        = 0;
+        ExtendAlphaCells     = 0;
+        ExtendBetaCells      = 0;
+        LinkAlphaBetaCells   = 0;
+        RebuildCells         = 0;
+        FillAlphaSeconds     = 0;
+        FillBetaSeconds      = 0;
+        ExtendAlphaSeconds   = 0;
+        ExtendBetaSeconds    = 0;
+        LinkAlphaBetaSeconds = 0;
+        RebuildSeconds       = 0;
+        BandColumns          = 0;
+        MaxBandWidth         = 0;
+        Reallocations        = 0;
+        FlipFlops            = 0;
+        MutationsScored      = 0;
+        ScoreMutationSeconds = 0;
+        MutationsScreened    = 0;
+        MutationsScreenedOut = 0;
+    }
+
+    std::string ScorerCounters::ToString() const
+    {
+        std::stringstream ss;
+        ss << "FillAlpha: "     << FillAlphaCells     << " cells, " << FillAlphaSeconds     << " s; "
+           << "FillBeta: "      << FillBetaCells      << " cells, " << FillBetaSeconds      << " s; "
+           << "ExtendAlpha: "   << ExtendAlphaCells   << " cells, " << ExtendAlphaSeconds   << " s; "
+           << "ExtendBeta: "    << ExtendBetaCells    << " cells, " << ExtendBetaSeconds    << " s; "
+           << "LinkAlphaBeta: " << LinkAlphaBetaCells << " cells, " << LinkAlphaBetaSeconds << " s; "
+           << "Rebuild: "       << RebuildCells       << " cells, " << RebuildSeconds       << " s; "
+           << "band width: mean " << MeanBandWidth() << ", max " << MaxBandWidth << "; "
+           << "reallocations: " << Reallocations << "; "
+           << "flip-flops: " << FlipFlops << "; "
+           << "mutations scored: " << MutationsScored << " in " << ScoreMutationSeconds << " s; "
+           << "screened: " << MutationsScreened << ", " << MutationsScreenedOut << " rejected";
+        return ss.str();
+    }
+}
@@ -0,0 +1,99 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#pragma once
+
+#include <string>
+
+namespace ConsensusCore {
+
+    //
+    // Work done by a MutationScorer---or, summed over its reads, by a
+    // MultiReadMutationScorer---since it was created or its counters were
+    // last reset.  The cell counts are the number of DP matrix entries
+    // each routine computed; they are kept as doubles because the totals
+    // quickly outgrow an int.  Times are wall-clock seconds.
+    //
+    struct ScorerCounters
+    {
+        // DP cells computed
+        double FillAlphaCells;
+        double FillBetaCells;
+        double ExtendAlphaCells;
+        double ExtendBetaCells;
+        double LinkAlphaBetaCells;
+        double RebuildCells;  // recomputing columns released by checkpointing
+
+        // Time spent
+        double FillAlphaSeconds;
+        double FillBetaSeconds;
+        double ExtendAlphaSeconds;
+        double ExtendBetaSeconds;
+        double LinkAlphaBetaSeconds;
+        double RebuildSeconds;
+
+        // Number of alpha and beta columns filled (FillAlphaCells +
+        // FillBetaCells of them), and the widest band among them
+        double BandColumns;
+        int MaxBandWidth;
+
+        // Times matrix storage had to be regrown
+        int Reallocations;
+
+        // Extra alpha or beta fills needed to get the two to agree
+        int FlipFlops;
+
+        int MutationsScored;
+        double ScoreMutationSeconds;
+
+        // Mutations FastIsFavorable screened on the Viterbi matrices kept
+        // alongside the reads' own, and those it rejected there without
+        // scoring them exactly (see MultiReadMutationScorer's Screening).
+        // Counted by the MultiReadMutationScorer, not per read.
+        int MutationsScreened;
+        int MutationsScreenedOut;
+
+        ScorerCounters();
+
+        float MeanBandWidth() const;
+        double TotalCells() const;
+        double TotalSeconds() const;
+
+        void Add(const ScorerCounters& other);
+        void Reset();
+
+        std::string ToString() const;
+    };
+}
@@ -0,0 +1,123 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#pragma once
+
+#include "Matrix/DenseMatrix.hpp"
+#include "Matrix/SparseMatrix.hpp"
+#include "Quiver/QvEvaluator.hpp"
+#include "Edna/EdnaEvaluator.hpp"
+#include "Quiver/detail/Combiner.hpp"
+#include "Quiver/detail/RecursorBase.hpp"
+#include "Quiver/detail/SimdSupport.hpp"
+
+namespace ConsensusCore {
+
+    namespace detail {
+
+    /// \brief Vector operations on W floats at a time; specialized for
+    ///        W = 8 (AVX2) and W = 16 (AVX-512) in the translation unit
+    ///        compiled for that instruction set.
+    template <int W>
+    struct SimdLanes;
+    }
+
+    /// \brief A recursor processing W rows of a column at a time, using
+    ///        AVX2 (W = 8) or AVX-512 (W = 16) instructions.
+    ///
+    /// The kernels mirror those of the SseRecursor.  They are only safe to
+    /// call if the running CPU supports the instruction set in question
+    /// (see detail::SimdWidthSupported); the SseRecursor does this
+    /// dispatch itself, so most clients should just use it.
+    template <typename M, typename E, typename C, int W>
+    class SimdRecursor : public detail::RecursorBase<M, E, C>
+    {
+    public:
+        void FillAlpha(const E& e, const M& guide, M& alpha,
+                       int beginColumn = 0) const;
+        void FillBeta(const E& e, const M& guide, M& beta,
+                      int endColumn = INT_MAX) const;
+
+        float LinkAlphaBeta(const E& e,
+                            const M& alpha, int alphaColumn,
+                            const M& beta, int betaColumn,
+                            int absoluteColumn) const;
+
+        void ExtendAlpha(const E& e,
+                         const M& alpha, int beginColumn,
+                         M& ext, int numExtColumns = 2,
+                         int firstExtColumn = 0) const;
+
+        void ExtendBeta(const E& e,
+                        const M& beta, int endColumn,
+                        M& ext, int numExtColumns = 2,
+                        int lengthDiff = 0) const;
+
+    public:
+        //
+        // Constructors.  These are defined here rather than alongside the
+        // kernels, so that they are never compiled for the wider
+        // instruction set.
+        //
+        SimdRecursor(int movesAvailable, const BandingOptions& banding)
+            : detail::RecursorBase<M, E, C>(movesAvailable, banding)
+        {}
+
+        ~SimdRecursor()
+        {}
+
+        /// \brief Whether the running CPU can execute this recursor.
+        static bool IsSupported()
+        {
+            return detail::SimdWidthSupported(W);
+        }
+    };
+
+    typedef SimdRecursor<SparseMatrix,
+                         QvEvaluator,
+                         detail::ViterbiCombiner, 8> SparseAvx2QvRecursor;
+
+    typedef SimdRecursor<SparseMatrix,
+                         QvEvaluator,
+                         detail::SumProductCombiner, 8> SparseAvx2QvSumProductRecursor;
+
+    typedef SimdRecursor<SparseMatrix,
+                         QvEvaluator,
+                         detail::ViterbiCombiner, 16> SparseAvx512QvRecursor;
+
+    typedef SimdRecursor<SparseMatrix,
+                         QvEvaluator,
+                         detail::SumProductCombiner, 16> SparseAvx512QvSumProductRecursor;
+}
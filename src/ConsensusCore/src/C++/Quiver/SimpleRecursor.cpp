@@ -60,7 +60,8 @@ namespace ConsensusCore {
 
     template<typename M, typename E, typename C>
     void
-    SimpleRecursor<M, E, C>::FillAlpha(const E& e, const M& guide, M& alpha) const
+    SimpleRecursor<M, E, C>::FillAlpha(const E& e, const M& guide, M& alpha,
+                                       int beginColumn) const
     {
         int I = e.ReadLength();
         int J = e.TemplateLength();
@@ -69,9 +70,11 @@ namespace ConsensusCore {
         assert(guide.IsNull() ||
                (guide.Rows() == alpha.Rows() && guide.Columns() == alpha.Columns()));
 
-        int hintBeginRow = 0, hintEndRow = 0;
+        int hintBeginRow, hintEndRow;
+        boost::tie(hintBeginRow, hintEndRow) =
+            detail::AlphaResumeHints(beginColumn, alpha, this->bandingOptions_.ScoreDiff);
 
-        for (int j = 0; j <= J; ++j)
+        for (int j = beginColumn; j <= J; ++j)
         {
             this->RangeGuide(j, guide, alpha, &hintBeginRow, &hintEndRow);
 
@@ -150,7 +153,8 @@ namespace ConsensusCore {
 
     template<typename M, typename E, typename C>
     void
-    SimpleRecursor<M, E, C>::FillBeta(const E& e, const M& guide, M& beta) const
+    SimpleRecursor<M, E, C>::FillBeta(const E& e, const M& guide, M& beta,
+                                      int endColumn) const
     {
         int I = e.ReadLength();
         int J = e.TemplateLength();
@@ -159,9 +163,12 @@ namespace ConsensusCore {
         assert(guide.IsNull() ||
                (guide.Rows() == beta.Rows() && guide.Columns() == beta.Columns()));
 
-        int hintBeginRow = I + 1, hintEndRow = I + 1;
+        int lastColumn = min(endColumn, J + 1) - 1;
+        int hintBeginRow, hintEndRow;
+        boost::tie(hintBeginRow, hintEndRow) =
+            detail::BetaResumeHints(lastColumn, beta, this->bandingOptions_.ScoreDiff);
 
-        for (int j = J; j >= 0; --j)
+        for (int j = lastColumn; j >= 0; --j)
         {
             this->RangeGuide(j, guide, beta, &hintBeginRow, &hintEndRow);
 
@@ -308,9 +315,11 @@ namespace ConsensusCore {
     void
     SimpleRecursor<M, E, C>::ExtendAlpha(const E& e,
                                          const M& alpha, int beginColumn,
-                                         M& ext, int numExtColumns) const
+                                         M& ext, int numExtColumns,
+                                         int firstExtColumn) const
     {
         assert(numExtColumns >= 2);
+        assert(0 <= firstExtColumn && firstExtColumn < numExtColumns);
         assert(alpha.Rows() == e.ReadLength() + 1 &&
                ext.Rows() == e.ReadLength() + 1);
 
@@ -320,7 +329,7 @@ namespace ConsensusCore {
         assert(ext.Columns() >= numExtColumns);
         assert(beginColumn >= 2);
 
-        for (int extCol = 0; extCol < numExtColumns; extCol++)
+        for (int extCol = firstExtColumn; extCol < numExtColumns; extCol++)
         {
             int j = beginColumn + extCol;
             int beginRow, endRow;
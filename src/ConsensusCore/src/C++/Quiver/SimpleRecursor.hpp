@@ -48,8 +48,10 @@ namespace ConsensusCore {
     class SimpleRecursor : public detail::RecursorBase<M, E, C>
     {
     public:
-        void FillAlpha(const E& e, const M& guide, M& alpha) const;
-        void FillBeta(const E& e, const M& guide, M& beta) const;
+        void FillAlpha(const E& e, const M& guide, M& alpha,
+                       int beginColumn = 0) const;
+        void FillBeta(const E& e, const M& guide, M& beta,
+                      int endColumn = INT_MAX) const;
 
         float LinkAlphaBeta(const E& e,
                             const M& alpha, int alphaColumn,
@@ -58,7 +60,8 @@ namespace ConsensusCore {
 
         void ExtendAlpha(const E& e,
                          const M& alpha, int beginColumn,
-                         M& ext, int numExtColumns = 2) const;
+                         M& ext, int numExtColumns = 2,
+                         int firstExtColumn = 0) const;
 
         void ExtendBeta(const E& e,
                         const M& beta, int endColumn,
@@ -49,7 +49,9 @@
 #include "Matrix/DenseMatrix.hpp"
 #include "Matrix/SparseMatrix.hpp"
 #include "Quiver/detail/Combiner.hpp"
+#include "Quiver/detail/SimdSupport.hpp"
 #include "Quiver/QvEvaluator.hpp"
+#include "Quiver/SimdRecursor.hpp"
 #include "Quiver/SimpleRecursor.hpp"
 
 using std::max;
@@ -71,8 +73,20 @@ namespace ConsensusCore {
 
     template<typename M, typename E, typename C>
     void
-    SseRecursor<M, E, C>::FillAlpha(const E& e, const M& guide, M& alpha) const
+    SseRecursor<M, E, C>::FillAlpha(const E& e, const M& guide, M& alpha,
+                                    int beginColumn) const
     {
+        if (simdWidth_ == 16)
+        {
+            avx512Recursor_.FillAlpha(e, guide, alpha, beginColumn);
+            return;
+        }
+        if (simdWidth_ == 8)
+        {
+            avx2Recursor_.FillAlpha(e, guide, alpha, beginColumn);
+            return;
+        }
+
         int I = e.ReadLength();
         int J = e.TemplateLength();
 
@@ -80,9 +94,11 @@ namespace ConsensusCore {
         assert(guide.IsNull() ||
                (guide.Rows() == alpha.Rows() && guide.Columns() == alpha.Columns()));
 
-        int hintBeginRow = 0, hintEndRow = 0;
+        int hintBeginRow, hintEndRow;
+        boost::tie(hintBeginRow, hintEndRow) =
+            detail::AlphaResumeHints(beginColumn, alpha, this->bandingOptions_.ScoreDiff);
 
-        for (int j = 0; j <= J; ++j)
+        for (int j = beginColumn; j <= J; ++j)
         {
             this->RangeGuide(j, guide, alpha, &hintBeginRow, &hintEndRow);
 
@@ -171,27 +187,14 @@ namespace ConsensusCore {
                 }
 
                 //
-                // Extra (non-SSE cascade)
+                // Extra (in-register cascade)
                 //
-                float insScores4_[4], score5_[5];
-
-                __m128 insScores4 = e.Extra4(i - 1, j);
-                _mm_storeu_ps(insScores4_, insScores4);
-
-                score5_[0] = alpha.Get(i - 1, j);
-                _mm_storeu_ps(&score5_[1], score4);
-
-                for (int ii = 1; ii < 5; ii++)
-                {
-                    float v = C::Combine(score5_[ii], score5_[ii - 1] + insScores4_[ii - 1]);
-                    score5_[ii] = v;
-                }
-                score4 = _mm_loadu_ps(&score5_[1]);
+                score4 = detail::PrefixScan4<C>(alpha.Get(i - 1, j), score4, e.Extra4(i - 1, j));
                 alpha.Set4(i, j, score4);
 
                 // Update score, potentialNewMax
-                float potentialNewMax = *std::max_element(score5_ + 1, score5_ + 5);
-                score = *std::min_element(score5_ + 1, score5_ + 5);
+                float potentialNewMax = detail::HorizontalMax4(score4);
+                score = detail::HorizontalMin4(score4);
 
                 if (potentialNewMax > maxScore)
                 {
@@ -214,8 +217,20 @@ namespace ConsensusCore {
 
     template<typename M, typename E, typename C>
     void
-    SseRecursor<M, E, C>::FillBeta(const E& e, const M& guide, M& beta) const
+    SseRecursor<M, E, C>::FillBeta(const E& e, const M& guide, M& beta,
+                                   int endColumn) const
     {
+        if (simdWidth_ == 16)
+        {
+            avx512Recursor_.FillBeta(e, guide, beta, endColumn);
+            return;
+        }
+        if (simdWidth_ == 8)
+        {
+            avx2Recursor_.FillBeta(e, guide, beta, endColumn);
+            return;
+        }
+
         int I = e.ReadLength();
         int J = e.TemplateLength();
 
@@ -223,9 +238,12 @@ namespace ConsensusCore {
         assert(guide.IsNull() ||
                (guide.Rows() == beta.Rows() && guide.Columns() == beta.Columns()));
 
-        int hintBeginRow = I + 1, hintEndRow = I + 1;
+        int lastColumn = min(endColumn, J + 1) - 1;
+        int hintBeginRow, hintEndRow;
+        boost::tie(hintBeginRow, hintEndRow) =
+            detail::BetaResumeHints(lastColumn, beta, this->bandingOptions_.ScoreDiff);
 
-        for (int j = J; j >= 0; --j)
+        for (int j = lastColumn; j >= 0; --j)
         {
             this->RangeGuide(j, guide, beta, &hintBeginRow, &hintEndRow);
 
@@ -309,27 +327,14 @@ namespace ConsensusCore {
                 }
 
                 //
-                // Extra (non-SSE cascade)
+                // Extra (in-register cascade)
                 //
-                float insScores4_[4], score5_[5];
-
-                __m128 insScores4 = e.Extra4(i, j);
-                _mm_storeu_ps(insScores4_, insScores4);
-
-                score5_[4] = beta.Get(i + 4, j);
-                _mm_storeu_ps(score5_, score4);
-
-                for (int ii = 3; ii >= 0; ii--)
-                {
-                    float v = C::Combine(score5_[ii], score5_[ii + 1] + insScores4_[ii]);
-                    score5_[ii] = v;
-                }
-                score4 = _mm_loadu_ps(score5_);
+                score4 = detail::SuffixScan4<C>(score4, e.Extra4(i, j), beta.Get(i + 4, j));
                 beta.Set4(i, j, score4);
 
                 // Update score, potentialNewMax
-                float potentialNewMax = *std::max_element(score5_, score5_ + 4);
-                score = *std::min_element(score5_, score5_ + 4);
+                float potentialNewMax = detail::HorizontalMax4(score4);
+                score = detail::HorizontalMin4(score4);
 
                 if (potentialNewMax > maxScore)
                 {
@@ -358,6 +363,19 @@ namespace ConsensusCore {
                                         const M& beta, int betaColumn,
                                         int absoluteColumn) const
     {
+        if (simdWidth_ == 16)
+        {
+            return avx512Recursor_.LinkAlphaBeta(e, alpha, alphaColumn,
+                                                  beta, betaColumn,
+                                                  absoluteColumn);
+        }
+        if (simdWidth_ == 8)
+        {
+            return avx2Recursor_.LinkAlphaBeta(e, alpha, alphaColumn,
+                                                beta, betaColumn,
+                                                absoluteColumn);
+        }
+
         const int I = e.ReadLength();
 
         assert(alphaColumn > 1 && absoluteColumn > 1);
@@ -433,9 +451,24 @@ namespace ConsensusCore {
     INLINE_CALLEES void
     SseRecursor<M, E, C>::ExtendAlpha(const E& e,
                                       const M& alpha, int beginColumn,
-                                      M& ext, int numExtColumns) const
+                                      M& ext, int numExtColumns,
+                                      int firstExtColumn) const
     {
+        if (simdWidth_ == 16)
+        {
+            avx512Recursor_.ExtendAlpha(e, alpha, beginColumn, ext, numExtColumns,
+                                        firstExtColumn);
+            return;
+        }
+        if (simdWidth_ == 8)
+        {
+            avx2Recursor_.ExtendAlpha(e, alpha, beginColumn, ext, numExtColumns,
+                                      firstExtColumn);
+            return;
+        }
+
         assert(numExtColumns >= 2);
+        assert(0 <= firstExtColumn && firstExtColumn < numExtColumns);
         assert(alpha.Rows() == e.ReadLength() + 1 &&
                ext.Rows() == e.ReadLength() + 1);
 
@@ -445,7 +478,7 @@ namespace ConsensusCore {
         assert(ext.Columns() >= numExtColumns);
         assert(beginColumn >= 2);
 
-        for (int extCol = 0; extCol < numExtColumns; extCol++)
+        for (int extCol = firstExtColumn; extCol < numExtColumns; extCol++)
         {
             int j = beginColumn + extCol;
             int beginRow, endRow;
@@ -527,20 +560,7 @@ namespace ConsensusCore {
                 score4 = C::Combine4(score4, prev4 + e.Del4(i, j - 1));
 
                 // Extras:
-                float insScores4_[4], score5_[5];
-
-                __m128 insScores4 = e.Extra4(i - 1, j);
-                _mm_storeu_ps(insScores4_, insScores4);
-
-                score5_[0] = ext.Get(i - 1, extCol);
-                _mm_storeu_ps(&score5_[1], score4);
-
-                for (int ii = 1; ii < 5; ii++)
-                {
-                    float v = C::Combine(score5_[ii], score5_[ii - 1] + insScores4_[ii - 1]);
-                    score5_[ii] = v;
-                }
-                score4 = _mm_loadu_ps(&score5_[1]);
+                score4 = detail::PrefixScan4<C>(ext.Get(i - 1, extCol), score4, e.Extra4(i - 1, j));
                 ext.Set4(i, extCol, score4);
             }
             assert (i == endRow);
@@ -557,7 +577,124 @@ namespace ConsensusCore {
                                      M& ext, int numExtColumns,
                                      int lengthDiff) const
     {
-        simpleRecursor_.ExtendBeta(e, beta, endColumn, ext, numExtColumns, lengthDiff);
+        if (simdWidth_ == 16)
+        {
+            avx512Recursor_.ExtendBeta(e, beta, endColumn, ext, numExtColumns, lengthDiff);
+            return;
+        }
+        if (simdWidth_ == 8)
+        {
+            avx2Recursor_.ExtendBeta(e, beta, endColumn, ext, numExtColumns, lengthDiff);
+            return;
+        }
+
+        int I = beta.Rows() - 1;
+        int J = beta.Columns() - 1;
+        int lastColumn = endColumn;
+        int lastExtColumn = numExtColumns - 1;
+
+        assert(ext.Rows() == I + 1);
+
+        // The new template may not be the same length as the old template.
+        // Just make sure that we have anough room to fill out the extend buffer
+        assert(lastColumn + 2 <= J);
+        assert(lastColumn >= 0);
+        assert(ext.Columns() >= numExtColumns);
+
+        for (int j = lastColumn; j > lastColumn - numExtColumns; j--)
+        {
+            // Column j of the old template is column jp of the new one
+            int jp = j + lengthDiff;
+            int extCol = lastExtColumn - (lastColumn - j);
+            int beginRow, endRow;
+
+            if (j < 0)
+            {
+                beginRow = 0;
+                endRow = beta.UsedRowRange(0).End;
+            }
+            else
+            {
+                boost::tie(beginRow, endRow) = beta.UsedRowRange(j);
+            }
+
+            ext.StartEditingColumn(extCol, beginRow, endRow);
+            //
+            // As in FillBeta: handle the last rows non-SSE, including row
+            // I, leaving a multiple of 4 rows for the SSE loop.
+            //
+            int i;
+            for (i = endRow - 1;
+                 (i == I || (i + 1 - beginRow) % 4 != 0) && i >= beginRow;
+                 i--)
+            {
+                float prev, score = NEG_INF;
+
+                // Incorporation:
+                if (i < I && j < J)
+                {
+                    prev = (extCol == lastExtColumn ?
+                                beta(i + 1, j + 1) :
+                                ext(i + 1, extCol + 1));
+                    score = C::Combine(score, prev + e.Inc(i, jp));
+                }
+                // Extra:
+                if (i < I)
+                {
+                    score = C::Combine(score, ext(i + 1, extCol) + e.Extra(i, jp));
+                }
+                // Delete:
+                if (j < J)
+                {
+                    prev = (extCol == lastExtColumn ?
+                                beta(i, j + 1) :
+                                ext(i, extCol + 1));
+                    score = C::Combine(score, prev + e.Del(i, jp));
+                }
+                // Merge (always against the old beta, as SimpleRecursor):
+                if ((this->movesAvailable_ & MERGE) && j < J - 1 && i < I)
+                {
+                    score = C::Combine(score, beta(i + 1, j + 2) + e.Merge(i, jp));
+                }
+                ext.Set(i, extCol, score);
+            }
+            //
+            // SSE loop
+            //
+            for (i = i - 3; i >= beginRow; i -= 4)
+            {
+                __m128 prev4, score4 = NEG_INF_4;
+
+                // Incorporation:
+                if (j < J)
+                {
+                    prev4 = (extCol == lastExtColumn ?
+                                beta.Get4(i + 1, j + 1) :
+                                ext.Get4(i + 1, extCol + 1));
+                    score4 = C::Combine4(score4, prev4 + e.Inc4(i, jp));
+                }
+                // Deletion:
+                if (j < J)
+                {
+                    prev4 = (extCol == lastExtColumn ?
+                                beta.Get4(i, j + 1) :
+                                ext.Get4(i, extCol + 1));
+                    score4 = C::Combine4(score4, prev4 + e.Del4(i, jp));
+                }
+                // Merge
+                if ((this->movesAvailable_ & MERGE) && j < J - 1)
+                {
+                    score4 = C::Combine4(score4, beta.Get4(i + 1, j + 2) + e.Merge4(i, jp));
+                }
+
+                // Extras (in-register cascade):
+                score4 = detail::SuffixScan4<C>(score4, e.Extra4(i, jp), ext.Get(i + 4, extCol));
+                ext.Set4(i, extCol, score4);
+            }
+            assert(i + 4 == beginRow);
+
+            ext.FinishEditingColumn(extCol, beginRow, endRow);
+        }
     }
 
 
@@ -565,9 +702,19 @@ namespace ConsensusCore {
     template<typename M, typename E, typename C>
     SseRecursor<M, E, C>::SseRecursor(int movesAvailable, const BandingOptions& banding)
         : detail::RecursorBase<M, E, C>(movesAvailable, banding),
-          simpleRecursor_(movesAvailable, banding)
+          simpleRecursor_(movesAvailable, banding),
+          simdWidth_(detail::MaxSimdWidth()),
+          avx2Recursor_(movesAvailable, banding),
+          avx512Recursor_(movesAvailable, banding)
     {}
 
+    template<typename M, typename E, typename C>
+    int
+    SseRecursor<M, E, C>::SimdWidth() const
+    {
+        return simdWidth_;
+    }
+
     template class SseRecursor<DenseMatrix,  QvEvaluator, detail::ViterbiCombiner>;
     template class SseRecursor<SparseMatrix, QvEvaluator, detail::ViterbiCombiner>;
     template class SseRecursor<SparseMatrix, QvEvaluator, detail::SumProductCombiner>;
@@ -43,6 +43,7 @@
 #include "Edna/EdnaEvaluator.hpp"
 #include "Quiver/detail/Combiner.hpp"
 #include "Quiver/detail/RecursorBase.hpp"
+#include "Quiver/SimdRecursor.hpp"
 #include "Quiver/SimpleRecursor.hpp"
 
 namespace ConsensusCore {
@@ -51,8 +52,10 @@ namespace ConsensusCore {
     class SseRecursor : public detail::RecursorBase<M, E, C>
     {
     public:
-        void FillAlpha(const E& e, const M& guide, M& alpha) const;
-        void FillBeta(const E& e, const M& guide, M& beta) const;
+        void FillAlpha(const E& e, const M& guide, M& alpha,
+                       int beginColumn = 0) const;
+        void FillBeta(const E& e, const M& guide, M& beta,
+                      int endColumn = INT_MAX) const;
 
         float LinkAlphaBeta(const E& e,
                             const M& alpha, int alphaColumn,
@@ -61,7 +64,8 @@ namespace ConsensusCore {
 
         void ExtendAlpha(const E& e,
                          const M& alpha, int beginColumn,
-                         M& ext, int numExtColumns = 2) const;
+                         M& ext, int numExtColumns = 2,
+                         int firstExtColumn = 0) const;
 
         void ExtendBeta(const E& e,
                         const M& beta, int endColumn,
@@ -74,9 +78,19 @@ namespace ConsensusCore {
         //
         SseRecursor(int movesAvailable, const BandingOptions& banding);
 
+        /// \brief The number of rows processed per vector instruction:
+        ///        4 (SSE3), 8 (AVX2) or 16 (AVX-512), according to what the
+        ///        running CPU supports.
+        int SimdWidth() const;
+
     private:
         // Used during bringup
         SimpleRecursor<M, E, C> simpleRecursor_;
+
+        // Wider kernels, used in place of the SSE ones when available
+        int simdWidth_;
+        SimdRecursor<M, E, C, 8>  avx2Recursor_;
+        SimdRecursor<M, E, C, 16> avx512Recursor_;
     };
 
     typedef SseRecursor<DenseMatrix,
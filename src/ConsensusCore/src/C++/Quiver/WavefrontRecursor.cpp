@@ -0,0 +1,456 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#include "Quiver/WavefrontRecursor.hpp"
+
+#include <algorithm>
+#include <boost/tuple/tuple.hpp>
+#include <cfloat>
+#include <vector>
+
+#include "Interval.hpp"
+#include "Utils.hpp"
+#include "Matrix/DenseMatrix.hpp"
+#include "Matrix/SparseMatrix.hpp"
+#include "Quiver/detail/Combiner.hpp"
+#include "Quiver/QvEvaluator.hpp"
+
+using std::max;
+using std::min;
+
+#define NEG_INF -FLT_MAX
+
+namespace ConsensusCore {
+
+    namespace {
+        //
+        // One lane of a strip: the column it fills, and how far it has
+        // got.  Rows [BeginRow, EndRow) are filled.
+        //
+        struct Lane
+        {
+            bool Done;
+            int Column;
+            int BeginRow;
+            int EndRow;
+            int RequiredRow;
+            float MaxScore;
+            float ThresholdScore;
+        };
+
+        // The lanes (x, v0, v1, v2)
+        inline __m128 ShiftIn(__m128 v, float x)
+        {
+            __m128 shifted = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4));
+            return _mm_move_ss(shifted, _mm_set_ss(x));
+        }
+
+        // The lanes (x0, x1, v0, v1)
+        inline __m128 ShiftIn2(__m128 v, float x0, float x1)
+        {
+            return _mm_shuffle_ps(_mm_setr_ps(x0, x1, 0.0f, 0.0f), v, _MM_SHUFFLE(1, 0, 1, 0));
+        }
+
+        // Cell (i, j) of a matrix, or NEG_INF if there is no such cell
+        template<typename M>
+        inline float CellOrNegInf(const M& m, int i, int j)
+        {
+            if (i < 0 || i >= m.Rows() || j < 0 || j >= m.Columns())
+            {
+                return NEG_INF;
+            }
+            return m(i, j);
+        }
+
+        inline void UpdateThreshold(Lane& lane, float score, float scoreDiff)
+        {
+            if (score > lane.MaxScore)
+            {
+                lane.MaxScore = score;
+                lane.ThresholdScore = score - scoreDiff;
+            }
+        }
+    }
+
+    template<typename M, typename E, typename C>
+    void
+    WavefrontRecursor<M, E, C>::FillAlpha(const E& e, const M& guide, M& alpha,
+                                          int beginColumn) const
+    {
+        int I = e.ReadLength();
+        int J = e.TemplateLength();
+
+        assert(alpha.Rows() == I + 1 && alpha.Columns() == J + 1);
+        assert(guide.IsNull() ||
+               (guide.Rows() == alpha.Rows() && guide.Columns() == alpha.Columns()));
+
+        float scoreDiff = this->bandingOptions_.ScoreDiff;
+        bool useMerge = (this->movesAvailable_ & MERGE);
+        const __m128 negInf4 = _mm_set_ps1(NEG_INF);
+
+        int hintBeginRow, hintEndRow;
+        boost::tie(hintBeginRow, hintEndRow) =
+            detail::AlphaResumeHints(beginColumn, alpha, scoreDiff);
+
+        // The strip's columns, lane c's at offset c * (I + 1)
+        std::vector<float> columns(WAVEFRONT_LANES * (I + 1));
+        float start[WAVEFRONT_LANES], inc[WAVEFRONT_LANES], extra[WAVEFRONT_LANES],
+              del[WAVEFRONT_LANES], merge[WAVEFRONT_LANES], score[WAVEFRONT_LANES];
+        bool active[WAVEFRONT_LANES];
+
+        for (int j0 = beginColumn; j0 <= J; j0 += WAVEFRONT_LANES)
+        {
+            int numLanes = min(WAVEFRONT_LANES, J + 1 - j0);
+
+            // Lane 0 takes the hints as the SimpleRecursor would; the
+            // others start from its first row, widened by their guides
+            Lane lanes[WAVEFRONT_LANES];
+            this->RangeGuide(j0, guide, alpha, &hintBeginRow, &hintEndRow);
+            int firstStep = INT_MAX;
+            for (int c = 0; c < numLanes; c++)
+            {
+                int beginRow = hintBeginRow;
+                int endRow = (c == 0) ? hintEndRow : hintBeginRow;
+                if (c > 0)
+                {
+                    this->RangeGuide(j0 + c, guide, alpha, &beginRow, &endRow);
+                }
+                Lane& lane = lanes[c];
+                lane.Column = j0 + c;
+                lane.BeginRow = lane.EndRow = beginRow;
+                lane.RequiredRow = min(I + 1, endRow);
+                lane.MaxScore = lane.ThresholdScore = NEG_INF;
+                lane.Done = (beginRow >= I + 1);
+                if (!lane.Done)
+                {
+                    firstStep = min(firstStep, beginRow + c);
+                }
+            }
+            for (int c = numLanes; c < WAVEFRONT_LANES; c++)
+            {
+                lanes[c].Done = true;
+            }
+
+            // At step s, lane c fills row s - c
+            __m128 prev1 = negInf4, prev2 = negInf4, prev3 = negInf4;
+            bool anyRunning = (firstStep < INT_MAX);
+            for (int s = firstStep; anyRunning; s++)
+            {
+                for (int c = 0; c < WAVEFRONT_LANES; c++)
+                {
+                    const Lane& lane = lanes[c];
+                    int r = s - c;
+                    int j = lane.Column;
+                    active[c] = !lane.Done && r >= lane.BeginRow;
+                    start[c] = (active[c] && r == 0 && j == 0) ? 0.0f : NEG_INF;
+                    inc[c] = extra[c] = del[c] = 0.0f;
+                    merge[c] = NEG_INF;
+                    if (!active[c]) continue;
+
+                    // Where a move is not possible, the cell it comes
+                    // from is NEG_INF, and its score need only be finite
+                    int ip = max(r - 1, 0);
+                    if (I > 0)
+                    {
+                        extra[c] = e.Extra(ip, j);
+                        if (j > 0) inc[c] = e.Inc(ip, j - 1);
+                        if (useMerge && j > 1) merge[c] = e.Merge(ip, j - 2);
+                    }
+                    if (j > 0) del[c] = e.Del(r, j - 1);
+                }
+
+                // The cells lanes 0 and 1 depend on in the strip before
+                __m128 fromLeft1 = ShiftIn(prev1, CellOrNegInf(alpha, s, j0 - 1));
+                __m128 fromLeft2 = ShiftIn(prev2, CellOrNegInf(alpha, s - 1, j0 - 1));
+
+                __m128 score4 = _mm_loadu_ps(start);
+                score4 = C::Combine4(score4, _mm_add_ps(fromLeft2, _mm_loadu_ps(inc)));
+                score4 = C::Combine4(score4, _mm_add_ps(prev1, _mm_loadu_ps(extra)));
+                score4 = C::Combine4(score4, _mm_add_ps(fromLeft1, _mm_loadu_ps(del)));
+                if (useMerge)
+                {
+                    __m128 fromLeft3 = ShiftIn2(prev3,
+                                                CellOrNegInf(alpha, s - 1, j0 - 2),
+                                                CellOrNegInf(alpha, s - 2, j0 - 1));
+                    score4 = C::Combine4(score4, _mm_add_ps(fromLeft3, _mm_loadu_ps(merge)));
+                }
+                _mm_storeu_ps(score, score4);
+
+                // Store the lanes' cells, and see which carry on
+                anyRunning = false;
+                for (int c = 0; c < WAVEFRONT_LANES; c++)
+                {
+                    Lane& lane = lanes[c];
+                    if (!active[c])
+                    {
+                        score[c] = NEG_INF;
+                        anyRunning |= !lane.Done;
+                        continue;
+                    }
+
+                    int r = s - c;
+                    columns[c * (I + 1) + r] = score[c];
+                    UpdateThreshold(lane, score[c], scoreDiff);
+                    lane.EndRow = r + 1;
+
+                    // A column runs at least as far as the one before it
+                    bool required = (r + 1 < lane.RequiredRow) ||
+                        (c > 0 && (!lanes[c - 1].Done || r + 1 < lanes[c - 1].EndRow));
+                    lane.Done = !(r + 1 < I + 1 &&
+                                  (score[c] >= lane.ThresholdScore || required));
+                    anyRunning |= !lane.Done;
+                }
+
+                prev3 = prev2;
+                prev2 = prev1;
+                prev1 = _mm_loadu_ps(score);
+            }
+
+            // Write the strip's columns into the matrix, and revise the
+            // hints from its last column
+            for (int c = 0; c < numLanes; c++)
+            {
+                const Lane& lane = lanes[c];
+                const float* column = &columns[c * (I + 1)];
+                alpha.StartEditingColumn(lane.Column, lane.BeginRow, lane.EndRow);
+                for (int i = lane.BeginRow; i < lane.EndRow; i++)
+                {
+                    alpha.Set(i, lane.Column, column[i]);
+                }
+                alpha.FinishEditingColumn(lane.Column, lane.BeginRow, lane.EndRow);
+            }
+
+            const Lane& last = lanes[numLanes - 1];
+            const float* column = &columns[(numLanes - 1) * (I + 1)];
+            int i;
+            for (i = last.BeginRow; i < last.EndRow && column[i] < last.ThresholdScore; ++i);
+            hintBeginRow = i;
+            hintEndRow = last.EndRow;
+        }
+    }
+
+    template<typename M, typename E, typename C>
+    void
+    WavefrontRecursor<M, E, C>::FillBeta(const E& e, const M& guide, M& beta,
+                                         int endColumn) const
+    {
+        int I = e.ReadLength();
+        int J = e.TemplateLength();
+
+        assert(beta.Rows() == I + 1 && beta.Columns() == J + 1);
+        assert(guide.IsNull() ||
+               (guide.Rows() == beta.Rows() && guide.Columns() == beta.Columns()));
+
+        float scoreDiff = this->bandingOptions_.ScoreDiff;
+        bool useMerge = (this->movesAvailable_ & MERGE);
+        const __m128 negInf4 = _mm_set_ps1(NEG_INF);
+
+        int lastColumn = min(endColumn, J + 1) - 1;
+        int hintBeginRow, hintEndRow;
+        boost::tie(hintBeginRow, hintEndRow) =
+            detail::BetaResumeHints(lastColumn, beta, scoreDiff);
+
+        std::vector<float> columns(WAVEFRONT_LANES * (I + 1));
+        float start[WAVEFRONT_LANES], inc[WAVEFRONT_LANES], extra[WAVEFRONT_LANES],
+              del[WAVEFRONT_LANES], merge[WAVEFRONT_LANES], score[WAVEFRONT_LANES];
+        bool active[WAVEFRONT_LANES];
+
+        for (int j0 = lastColumn; j0 >= 0; j0 -= WAVEFRONT_LANES)
+        {
+            int numLanes = min(WAVEFRONT_LANES, j0 + 1);
+
+            // Lane c fills column j0 - c, upwards from its end row
+            Lane lanes[WAVEFRONT_LANES];
+            this->RangeGuide(j0, guide, beta, &hintBeginRow, &hintEndRow);
+            int firstStep = INT_MAX;
+            for (int c = 0; c < numLanes; c++)
+            {
+                int beginRow = (c == 0) ? hintBeginRow : hintEndRow;
+                int endRow = hintEndRow;
+                if (c > 0)
+                {
+                    this->RangeGuide(j0 - c, guide, beta, &beginRow, &endRow);
+                }
+                Lane& lane = lanes[c];
+                lane.Column = j0 - c;
+                lane.BeginRow = lane.EndRow = endRow;
+                lane.RequiredRow = max(0, beginRow);
+                lane.MaxScore = lane.ThresholdScore = NEG_INF;
+                lane.Done = (endRow <= 0);
+                if (!lane.Done)
+                {
+                    firstStep = min(firstStep, I - (endRow - 1) + c);
+                }
+            }
+            for (int c = numLanes; c < WAVEFRONT_LANES; c++)
+            {
+                lanes[c].Done = true;
+            }
+
+            // At step s, lane c fills row I - s + c
+            __m128 prev1 = negInf4, prev2 = negInf4, prev3 = negInf4;
+            bool anyRunning = (firstStep < INT_MAX);
+            for (int s = firstStep; anyRunning; s++)
+            {
+                for (int c = 0; c < WAVEFRONT_LANES; c++)
+                {
+                    const Lane& lane = lanes[c];
+                    int r = I - s + c;
+                    int j = lane.Column;
+                    active[c] = !lane.Done && r < lane.EndRow;
+                    start[c] = (active[c] && r == I && j == J) ? 0.0f : NEG_INF;
+                    inc[c] = extra[c] = del[c] = 0.0f;
+                    merge[c] = NEG_INF;
+                    if (!active[c]) continue;
+
+                    int im = min(r, I - 1);
+                    if (I > 0)
+                    {
+                        extra[c] = e.Extra(im, j);
+                        if (j < J) inc[c] = e.Inc(im, j);
+                        if (useMerge && j < J - 1) merge[c] = e.Merge(im, j);
+                    }
+                    if (j < J) del[c] = e.Del(r, j);
+                }
+
+                int r0 = I - s;
+                __m128 fromRight1 = ShiftIn(prev1, CellOrNegInf(beta, r0, j0 + 1));
+                __m128 fromRight2 = ShiftIn(prev2, CellOrNegInf(beta, r0 + 1, j0 + 1));
+
+                __m128 score4 = _mm_loadu_ps(start);
+                score4 = C::Combine4(score4, _mm_add_ps(fromRight2, _mm_loadu_ps(inc)));
+                score4 = C::Combine4(score4, _mm_add_ps(prev1, _mm_loadu_ps(extra)));
+                score4 = C::Combine4(score4, _mm_add_ps(fromRight1, _mm_loadu_ps(del)));
+                if (useMerge)
+                {
+                    __m128 fromRight3 = ShiftIn2(prev3,
+                                                 CellOrNegInf(beta, r0 + 1, j0 + 2),
+                                                 CellOrNegInf(beta, r0 + 2, j0 + 1));
+                    score4 = C::Combine4(score4, _mm_add_ps(fromRight3, _mm_loadu_ps(merge)));
+                }
+                _mm_storeu_ps(score, score4);
+
+                anyRunning = false;
+                for (int c = 0; c < WAVEFRONT_LANES; c++)
+                {
+                    Lane& lane = lanes[c];
+                    if (!active[c])
+                    {
+                        score[c] = NEG_INF;
+                        anyRunning |= !lane.Done;
+                        continue;
+                    }
+
+                    int r = I - s + c;
+                    columns[c * (I + 1) + r] = score[c];
+                    UpdateThreshold(lane, score[c], scoreDiff);
+                    lane.BeginRow = r;
+
+                    // A column runs at least as far up as the one before it
+                    bool required = (r - 1 >= lane.RequiredRow) ||
+                        (c > 0 && (!lanes[c - 1].Done || r - 1 >= lanes[c - 1].BeginRow));
+                    lane.Done = !(r - 1 >= 0 &&
+                                  (score[c] >= lane.ThresholdScore || required));
+                    anyRunning |= !lane.Done;
+                }
+
+                prev3 = prev2;
+                prev2 = prev1;
+                prev1 = _mm_loadu_ps(score);
+            }
+
+            for (int c = 0; c < numLanes; c++)
+            {
+                const Lane& lane = lanes[c];
+                const float* column = &columns[c * (I + 1)];
+                beta.StartEditingColumn(lane.Column, lane.BeginRow, lane.EndRow);
+                for (int i = lane.BeginRow; i < lane.EndRow; i++)
+                {
+                    beta.Set(i, lane.Column, column[i]);
+                }
+                beta.FinishEditingColumn(lane.Column, lane.BeginRow, lane.EndRow);
+            }
+
+            const Lane& last = lanes[numLanes - 1];
+            const float* column = &columns[(numLanes - 1) * (I + 1)];
+            int i;
+            for (i = last.EndRow; i > last.BeginRow && column[i - 1] < last.ThresholdScore; --i);
+            hintBeginRow = last.BeginRow;
+            hintEndRow = i;
+        }
+    }
+
+    template<typename M, typename E, typename C>
+    float
+    WavefrontRecursor<M, E, C>::LinkAlphaBeta(const E& e,
+                                              const M& alpha, int alphaColumn,
+                                              const M& beta, int betaColumn,
+                                              int absoluteColumn) const
+    {
+        return sseRecursor_.LinkAlphaBeta(e, alpha, alphaColumn,
+                                          beta, betaColumn, absoluteColumn);
+    }
+
+    template<typename M, typename E, typename C>
+    void
+    WavefrontRecursor<M, E, C>::ExtendAlpha(const E& e,
+                                            const M& alpha, int beginColumn,
+                                            M& ext, int numExtColumns,
+                                            int firstExtColumn) const
+    {
+        sseRecursor_.ExtendAlpha(e, alpha, beginColumn, ext, numExtColumns, firstExtColumn);
+    }
+
+    template<typename M, typename E, typename C>
+    void
+    WavefrontRecursor<M, E, C>::ExtendBeta(const E& e,
+                                           const M& beta, int endColumn,
+                                           M& ext, int numExtColumns,
+                                           int lengthDiff) const
+    {
+        sseRecursor_.ExtendBeta(e, beta, endColumn, ext, numExtColumns, lengthDiff);
+    }
+
+    template<typename M, typename E, typename C>
+    WavefrontRecursor<M, E, C>::WavefrontRecursor(int movesAvailable,
+                                                  const BandingOptions& banding)
+        : detail::RecursorBase<M, E, C>(movesAvailable, banding),
+          sseRecursor_(movesAvailable, banding)
+    {}
+
+    template class WavefrontRecursor<DenseMatrix,  QvEvaluator, detail::ViterbiCombiner>;
+    template class WavefrontRecursor<SparseMatrix, QvEvaluator, detail::ViterbiCombiner>;
+    template class WavefrontRecursor<SparseMatrix, QvEvaluator, detail::SumProductCombiner>;
+}
@@ -0,0 +1,111 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#pragma once
+
+#include <climits>
+
+#include "Matrix/DenseMatrix.hpp"
+#include "Matrix/SparseMatrix.hpp"
+#include "Quiver/QvEvaluator.hpp"
+#include "Quiver/detail/Combiner.hpp"
+#include "Quiver/detail/RecursorBase.hpp"
+#include "Quiver/SseRecursor.hpp"
+
+// The number of columns a WavefrontRecursor fills at once, one per SSE lane
+#define WAVEFRONT_LANES 4
+
+namespace ConsensusCore {
+
+    /// \brief A recursor that fills alpha and beta along anti-diagonals.
+    ///
+    /// The other recursors fill a column at a time, where each cell
+    /// waits on the one above it (the Extra move).  Here the matrix is
+    /// filled in strips of four columns, one per SSE lane, with lane c
+    /// running c rows behind lane c - 1: the four cells computed at each
+    /// step lie on an anti-diagonal, and depend only on the cells of the
+    /// previous three steps, so there is no dependence within a vector.
+    ///
+    /// Each lane bands its column as the SimpleRecursor does, except
+    /// that within a strip the columns start at the first column's first
+    /// row (the band is narrowed only at the end of a strip), and a
+    /// column runs at least as far as the column before it.  Extension
+    /// and linking are the SseRecursor's.
+    template <typename M, typename E, typename C>
+    class WavefrontRecursor : public detail::RecursorBase<M, E, C>
+    {
+    public:
+        void FillAlpha(const E& e, const M& guide, M& alpha,
+                       int beginColumn = 0) const;
+        void FillBeta(const E& e, const M& guide, M& beta,
+                      int endColumn = INT_MAX) const;
+
+        float LinkAlphaBeta(const E& e,
+                            const M& alpha, int alphaColumn,
+                            const M& beta, int betaColumn,
+                            int absoluteColumn) const;
+
+        void ExtendAlpha(const E& e,
+                         const M& alpha, int beginColumn,
+                         M& ext, int numExtColumns = 2,
+                         int firstExtColumn = 0) const;
+
+        void ExtendBeta(const E& e,
+                        const M& beta, int endColumn,
+                        M& ext, int numExtColumns = 2,
+                        int lengthDiff = 0) const;
+
+    public:
+        //
+        // Constructors
+        //
+        WavefrontRecursor(int movesAvailable, const BandingOptions& banding);
+
+    private:
+        SseRecursor<M, E, C> sseRecursor_;
+    };
+
+    typedef WavefrontRecursor<DenseMatrix,
+                              QvEvaluator,
+                              detail::ViterbiCombiner> WavefrontQvRecursor;
+
+    typedef WavefrontRecursor<SparseMatrix,
+                              QvEvaluator,
+                              detail::ViterbiCombiner> SparseWavefrontQvRecursor;
+
+    typedef WavefrontRecursor<SparseMatrix,
+                              QvEvaluator,
+                              detail::SumProductCombiner> SparseWavefrontQvSumProductRecursor;
+}
@@ -61,6 +61,20 @@ namespace detail {
         {
             return _mm_max_ps(x4, y4);
         }
+
+#ifndef SWIG
+        static TARGET_AVX2 __m256 Combine8(__m256 x8, __m256 y8)
+        {
+            return _mm256_max_ps(x8, y8);
+        }
+
+        static TARGET_AVX512 __m512 Combine16(__m512 x16, __m512 y16)
+        {
+            // (here and below, the all-lanes maskz forms of the AVX-512
+            // intrinsics avoid a spurious -Wmaybe-uninitialized from GCC)
+            return _mm512_maskz_max_ps(0xFFFF, x16, y16);
+        }
+#endif
     };
 
     /// \brief A tag dispatch class calculating path-join score in the
@@ -77,6 +91,152 @@ namespace detail {
         {
             return logAdd4(x4, y4);
         }
+
+#ifndef SWIG
+        static TARGET_AVX2 __m256 Combine8(__m256 x8, __m256 y8)
+        {
+            return logAdd8(x8, y8);
+        }
+
+        static TARGET_AVX512 __m512 Combine16(__m512 x16, __m512 y16)
+        {
+            return logAdd16(x16, y16);
+        }
+#endif
     };
-}}
 
+    //
+    // The Extra (insertion) moves within a block of W rows of a column form
+    // the linear recurrence
+    //
+    //     s[k] = Combine(s[k], s[k-1] + ins[k-1])
+    //
+    // over the (Combine, +) semiring---a max-plus scan for Viterbi, a
+    // log-add scan for sum-product.  Rather than unrolling it through memory
+    // we scan it in registers: lane k holds the map x -> Combine(A, x + B),
+    // and log2(W) shift-and-compose steps give each lane the composition of
+    // the maps above it, which is then applied to the cell preceding the
+    // block.  The additions are reassociated, so results can differ from the
+    // sequential cascade in the last bit or so.
+    //
+
+    /// \brief Extra cascade down a block (alpha direction): returns s[1..W]
+    ///        given s[0] = first, score = s[1..W] and ins[0..W-1].
+    template <typename C>
+    inline __m128 PrefixScan4(float first, __m128 score4, __m128 ins4)
+    {
+        const __m128 fromLane1 = _mm_castsi128_ps(_mm_set_epi32(-1, -1, -1, 0));
+        const __m128 fromLane2 = _mm_castsi128_ps(_mm_set_epi32(-1, -1, 0, 0));
+        __m128 a = score4, b = ins4, sa, sb;
+
+        // compose with the map one lane up
+        sa = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(a), 4));
+        sb = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(b), 4));
+        a = MUX4(fromLane1, C::Combine4(a, _mm_add_ps(sa, b)), a);
+        b = _mm_add_ps(b, sb);
+
+        // ... then with the (composed) map two lanes up
+        sa = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(a), 8));
+        sb = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(b), 8));
+        a = MUX4(fromLane2, C::Combine4(a, _mm_add_ps(sa, b)), a);
+        b = _mm_add_ps(b, sb);
+
+        return C::Combine4(a, _mm_add_ps(_mm_set_ps1(first), b));
+    }
+
+    /// \brief Extra cascade up a block (beta direction), where
+    ///        s[k] = Combine(s[k], s[k+1] + ins[k]): returns s[0..W-1]
+    ///        given score = s[0..W-1], ins[0..W-1] and s[W] = last.
+    template <typename C>
+    inline __m128 SuffixScan4(__m128 score4, __m128 ins4, float last)
+    {
+        const __m128 toLane2 = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+        const __m128 toLane1 = _mm_castsi128_ps(_mm_set_epi32(0, 0, -1, -1));
+        __m128 a = score4, b = ins4, sa, sb;
+
+        sa = _mm_castsi128_ps(_mm_srli_si128(_mm_castps_si128(a), 4));
+        sb = _mm_castsi128_ps(_mm_srli_si128(_mm_castps_si128(b), 4));
+        a = MUX4(toLane2, C::Combine4(a, _mm_add_ps(sa, b)), a);
+        b = _mm_add_ps(b, sb);
+
+        sa = _mm_castsi128_ps(_mm_srli_si128(_mm_castps_si128(a), 8));
+        sb = _mm_castsi128_ps(_mm_srli_si128(_mm_castps_si128(b), 8));
+        a = MUX4(toLane1, C::Combine4(a, _mm_add_ps(sa, b)), a);
+        b = _mm_add_ps(b, sb);
+
+        return C::Combine4(a, _mm_add_ps(_mm_set_ps1(last), b));
+    }
+
+#ifndef SWIG
+    template <typename C>
+    inline TARGET_AVX2 __m256 PrefixScan8(float first, __m256 score8, __m256 ins8)
+    {
+        const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256 a = score8, b = ins8;
+        for (int d = 1; d < 8; d *= 2)
+        {
+            // (lanes below d wrap around, but are kept unchanged)
+            __m256i from = _mm256_sub_epi32(lane, _mm256_set1_epi32(d));
+            __m256 keep = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(d), lane));
+            __m256 sa = _mm256_permutevar8x32_ps(a, from);
+            __m256 sb = _mm256_permutevar8x32_ps(b, from);
+            a = _mm256_blendv_ps(C::Combine8(a, _mm256_add_ps(sa, b)), a, keep);
+            b = _mm256_blendv_ps(_mm256_add_ps(b, sb), b, keep);
+        }
+        return C::Combine8(a, _mm256_add_ps(_mm256_set1_ps(first), b));
+    }
+
+    template <typename C>
+    inline TARGET_AVX2 __m256 SuffixScan8(__m256 score8, __m256 ins8, float last)
+    {
+        const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256 a = score8, b = ins8;
+        for (int d = 1; d < 8; d *= 2)
+        {
+            __m256i from = _mm256_add_epi32(lane, _mm256_set1_epi32(d));
+            __m256 keep = _mm256_castsi256_ps(_mm256_cmpgt_epi32(lane, _mm256_set1_epi32(7 - d)));
+            __m256 sa = _mm256_permutevar8x32_ps(a, from);
+            __m256 sb = _mm256_permutevar8x32_ps(b, from);
+            a = _mm256_blendv_ps(C::Combine8(a, _mm256_add_ps(sa, b)), a, keep);
+            b = _mm256_blendv_ps(_mm256_add_ps(b, sb), b, keep);
+        }
+        return C::Combine8(a, _mm256_add_ps(_mm256_set1_ps(last), b));
+    }
+
+    template <typename C>
+    inline TARGET_AVX512 __m512 PrefixScan16(float first, __m512 score16, __m512 ins16)
+    {
+        const __m512i lane = _mm512_setr_epi32(0, 1, 2,  3,  4,  5,  6,  7,
+                                               8, 9, 10, 11, 12, 13, 14, 15);
+        __m512 a = score16, b = ins16;
+        for (int d = 1; d < 16; d *= 2)
+        {
+            __m512i from = _mm512_sub_epi32(lane, _mm512_set1_epi32(d));
+            __mmask16 keep = static_cast<__mmask16>((1 << d) - 1);
+            __m512 sa = _mm512_maskz_permutexvar_ps(0xFFFF, from, a);
+            __m512 sb = _mm512_maskz_permutexvar_ps(0xFFFF, from, b);
+            a = _mm512_mask_blend_ps(keep, C::Combine16(a, _mm512_add_ps(sa, b)), a);
+            b = _mm512_mask_blend_ps(keep, _mm512_add_ps(b, sb), b);
+        }
+        return C::Combine16(a, _mm512_add_ps(_mm512_set1_ps(first), b));
+    }
+
+    template <typename C>
+    inline TARGET_AVX512 __m512 SuffixScan16(__m512 score16, __m512 ins16, float last)
+    {
+        const __m512i lane = _mm512_setr_epi32(0, 1, 2,  3,  4,  5,  6,  7,
+                                               8, 9, 10, 11, 12, 13, 14, 15);
+        __m512 a = score16, b = ins16;
+        for (int d = 1; d < 16; d *= 2)
+        {
+            __m512i from = _mm512_add_epi32(lane, _mm512_set1_epi32(d));
+            __mmask16 keep = static_cast<__mmask16>(~((1 << (16 - d)) - 1));
+            __m512 sa = _mm512_maskz_permutexvar_ps(0xFFFF, from, a);
+            __m512 sb = _mm512_maskz_permutexvar_ps(0xFFFF, from, b);
+            a = _mm512_mask_blend_ps(keep, C::Combine16(a, _mm512_add_ps(sa, b)), a);
+            b = _mm512_mask_blend_ps(keep, _mm512_add_ps(b, sb), b);
+        }
+        return C::Combine16(a, _mm512_add_ps(_mm512_set1_ps(last), b));
+    }
+#endif  // SWIG
+}}
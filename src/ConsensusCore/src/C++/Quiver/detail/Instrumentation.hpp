@@ -0,0 +1,104 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+/// \file  Instrumentation.hpp
+/// \brief Helpers for keeping ScorerCounters: a clock, and cell and
+///        reallocation counts read off the matrices after a fill.
+
+#pragma once
+
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <chrono>
+#else
+#include <time.h>
+#endif
+
+#include "Interval.hpp"
+#include "Matrix/DenseMatrix.hpp"
+#include "Matrix/SparseMatrix.hpp"
+
+namespace ConsensusCore {
+namespace detail {
+
+    /// \brief Seconds on a monotonic clock, from an arbitrary origin.
+    inline double Now()
+    {
+#ifdef _MSC_VER
+        using namespace std::chrono;
+        return duration<double>(steady_clock::now().time_since_epoch()).count();
+#else
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + 1e-9 * ts.tv_nsec;
+#endif
+    }
+
+    /// \brief The number of entries used in columns [beginColumn,
+    ///        endColumn) of m---the cells a fill of them computed---and,
+    ///        in *maxWidth, the larger of its value and the widest of them.
+    template<typename M>
+    inline double UsedCells(const M& m, int beginColumn, int endColumn, int* maxWidth)
+    {
+        double cells = 0;
+        for (int j = beginColumn; j < endColumn; j++)
+        {
+            Interval range = m.UsedRowRange(j);
+            int width = range.End - range.Begin;
+            cells += width;
+            *maxWidth = std::max(*maxWidth, width);
+        }
+        return cells;
+    }
+
+    template<typename M>
+    inline double UsedCells(const M& m, int beginColumn, int endColumn)
+    {
+        int maxWidth = 0;
+        return UsedCells(m, beginColumn, endColumn, &maxWidth);
+    }
+
+    /// \brief Times the storage of a matrix has been regrown.
+    inline int NumReallocs(const SparseMatrix& m)
+    {
+        return m.NumSlabReallocs();
+    }
+
+    inline int NumReallocs(const DenseMatrix&)
+    {
+        return 0;
+    }
+}}
@@ -0,0 +1,92 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+/// \file  Mutex.hpp
+/// \brief A minimal mutex, for guarding the little shared state the
+///        scorers have.
+
+#pragma once
+
+#include <boost/noncopyable.hpp>
+
+#ifdef _MSC_VER
+#include <mutex>
+#else
+#include <pthread.h>
+#endif
+
+namespace ConsensusCore {
+namespace detail {
+
+    class Mutex : private boost::noncopyable
+    {
+    public:
+#ifdef _MSC_VER
+        void Lock()   { mutex_.lock(); }
+        void Unlock() { mutex_.unlock(); }
+
+    private:
+        std::mutex mutex_;
+#else
+        Mutex()  { pthread_mutex_init(&mutex_, NULL); }
+        ~Mutex() { pthread_mutex_destroy(&mutex_); }
+
+        void Lock()   { pthread_mutex_lock(&mutex_); }
+        void Unlock() { pthread_mutex_unlock(&mutex_); }
+
+    private:
+        pthread_mutex_t mutex_;
+#endif
+    };
+
+    /// \brief Holds a Mutex locked for its lifetime.
+    class ScopedLock : private boost::noncopyable
+    {
+    public:
+        explicit ScopedLock(Mutex& mutex)
+            : mutex_(mutex)
+        {
+            mutex_.Lock();
+        }
+
+        ~ScopedLock()
+        {
+            mutex_.Unlock();
+        }
+
+    private:
+        Mutex& mutex_;
+    };
+}}
@@ -0,0 +1,177 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+
+#include "Quiver/detail/ReadIntervalIndex.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+#include "Utils.hpp"
+
+namespace ConsensusCore {
+namespace detail {
+
+    ReadIntervalIndex::ReadIntervalIndex()
+        : entries_(),
+          bins_()
+    {}
+
+    bool ReadIntervalIndex::ReadBefore(const Entry& a, const Entry& b)
+    {
+        return a.Read < b.Read;
+    }
+
+    int ReadIntervalIndex::Size() const
+    {
+        return entries_.size();
+    }
+
+    void ReadIntervalIndex::File(const Entry& e)
+    {
+        // Ends included, as Overlapping takes them
+        int lastBin = e.End / READ_INDEX_BIN_WIDTH;
+        if ((int)bins_.size() <= lastBin) bins_.resize(lastBin + 1);
+        for (int b = e.Start / READ_INDEX_BIN_WIDTH; b <= lastBin; b++)
+        {
+            // Reads mostly come in order, so this is usually an append
+            std::vector<Entry>& bin = bins_[b];
+            bin.insert(std::upper_bound(bin.begin(), bin.end(), e, ReadBefore), e);
+        }
+    }
+
+    void ReadIntervalIndex::Rebuild()
+    {
+        std::stable_sort(entries_.begin(), entries_.end(), ReadBefore);
+        bins_.clear();
+        for (unsigned int k = 0; k < entries_.size(); k++)
+        {
+            File(entries_[k]);
+        }
+    }
+
+    void ReadIntervalIndex::Add(int readIndex, int start, int end)
+    {
+        assert(0 <= start && start <= end);
+        Entry e = { start, end, readIndex };
+        entries_.push_back(e);
+        File(e);
+    }
+
+    void ReadIntervalIndex::Retain(const std::vector<char>& keep)
+    {
+        std::vector<Entry> kept;
+        kept.reserve(entries_.size());
+        for (unsigned int k = 0; k < entries_.size(); k++)
+        {
+            if (keep[entries_[k].Read]) kept.push_back(entries_[k]);
+        }
+        if (kept.size() == entries_.size()) return;
+        entries_.swap(kept);
+        Rebuild();
+    }
+
+    void ReadIntervalIndex::Remap(const std::vector<int>& positions)
+    {
+        for (unsigned int k = 0; k < entries_.size(); k++)
+        {
+            Entry& e = entries_[k];
+            e.Start = positions[e.Start];
+            e.End   = positions[e.End];
+        }
+        Rebuild();
+    }
+
+    void ReadIntervalIndex::BinRange(int begin, int end, int* firstBin, int* lastBin) const
+    {
+        *firstBin = std::max(begin, 0) / READ_INDEX_BIN_WIDTH;
+        *lastBin  = end < 0 ? -1 : std::min(end / READ_INDEX_BIN_WIDTH, (int)bins_.size() - 1);
+    }
+
+    std::vector<int> ReadIntervalIndex::Overlapping(int begin, int end) const
+    {
+        int firstBin, lastBin;
+        BinRange(begin, end, &firstBin, &lastBin);
+
+        std::vector<int> reads;
+        for (int b = firstBin; b <= lastBin; b++)
+        {
+            // Past the first bin, a read starting before this one was met
+            // already; the new ones are merged in, keeping read order
+            int binStart = (b == firstBin) ? 0 : b * READ_INDEX_BIN_WIDTH;
+            int numBefore = reads.size();
+            foreach (const Entry& e, bins_[b])
+            {
+                if (e.Start >= binStart && e.Start <= end && e.End >= begin)
+                {
+                    reads.push_back(e.Read);
+                }
+            }
+            std::inplace_merge(reads.begin(), reads.begin() + numBefore, reads.end());
+        }
+        return reads;
+    }
+
+    int ReadIntervalIndex::NumCandidates(int begin, int end) const
+    {
+        int firstBin, lastBin;
+        BinRange(begin, end, &firstBin, &lastBin);
+        int candidates = 0;
+        for (int b = firstBin; b <= lastBin; b++)
+        {
+            candidates += bins_[b].size();
+        }
+        return candidates;
+    }
+
+    std::vector<int> ReadIntervalIndex::Coverage(int length) const
+    {
+        // Mark where each interval begins and ends, then add up
+        std::vector<int> coverage(length + 1, 0);
+        for (unsigned int k = 0; k < entries_.size(); k++)
+        {
+            const Entry& e = entries_[k];
+            coverage[std::max(0, std::min(e.Start, length))]++;
+            coverage[std::max(0, std::min(e.End, length))]--;
+        }
+        for (int j = 1; j < length; j++)
+        {
+            coverage[j] += coverage[j - 1];
+        }
+        coverage.resize(length);
+        return coverage;
+    }
+}}
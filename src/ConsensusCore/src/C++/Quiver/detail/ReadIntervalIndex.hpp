@@ -0,0 +1,114 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+
+/// \file  ReadIntervalIndex.hpp
+/// \brief An index of the template intervals reads are mapped to, for
+///        finding the reads a mutation touches.
+
+#pragma once
+
+#include <vector>
+
+// The width, in template positions, of the bins reads are filed in
+#ifndef READ_INDEX_BIN_WIDTH
+#define READ_INDEX_BIN_WIDTH 32
+#endif
+
+namespace ConsensusCore {
+namespace detail {
+
+    /// \brief The template intervals [start, end) of a set of reads,
+    ///        filed in fixed-width bins of template.
+    ///
+    /// Each bin lists, in read order, the reads meeting it, so a query
+    /// looks only at the reads meeting the bins it spans: its cost goes
+    /// with the coverage there, not with the number of reads, even when
+    /// some reads span the whole template.
+    class ReadIntervalIndex
+    {
+    public:
+        ReadIntervalIndex();
+
+        int Size() const;
+
+        /// \brief Index read readIndex as mapped to [start, end).
+        void Add(int readIndex, int start, int end);
+
+        /// \brief Drop the reads for which keep[readIndex] is false.
+        void Retain(const std::vector<char>& keep);
+
+        /// \brief Move every interval onto an edited template, where
+        ///        position j of the old one became positions[j].
+        ///        positions must be nondecreasing, as
+        ///        TargetToQueryPositions gives.
+        void Remap(const std::vector<int>& positions);
+
+        /// \brief The reads whose intervals meet [begin, end], ends
+        ///        included, in increasing order.  This takes in every
+        ///        read for which ReadScoresMutation could be true of a
+        ///        mutation spanning [begin, end).
+        std::vector<int> Overlapping(int begin, int end) const;
+
+        /// \brief The number of intervals Overlapping(begin, end) looks
+        ///        at, to find those it returns.
+        int NumCandidates(int begin, int end) const;
+
+        /// \brief The number of reads covering each of positions
+        ///        [0, length).
+        std::vector<int> Coverage(int length) const;
+
+    private:
+        struct Entry
+        {
+            int Start;
+            int End;
+            int Read;
+        };
+
+        static bool ReadBefore(const Entry& a, const Entry& b);
+
+        // The bins [firstBin, lastBin] holding the reads that may meet
+        // [begin, end]; empty when lastBin < firstBin
+        void BinRange(int begin, int end, int* firstBin, int* lastBin) const;
+
+        void File(const Entry& e);
+        void Rebuild();
+
+    private:
+        std::vector<Entry> entries_;
+        std::vector<std::vector<Entry> > bins_;
+    };
+}}
@@ -82,6 +82,32 @@ namespace detail {
         return Interval(beginRow, endRow);
     }
 
+    /// \brief The banding hints with which a fill of alpha arrives at
+    ///        column j, recovered from the already-filled column j - 1.
+    template<typename M>
+    inline Interval AlphaResumeHints(int j, const M& alpha, float scoreDiff)
+    {
+        if (j == 0)
+        {
+            return Interval(0, 0);
+        }
+        return Interval(RowRange(j - 1, alpha, scoreDiff).Begin,
+                        alpha.UsedRowRange(j - 1).End);
+    }
+
+    /// \brief The banding hints with which a fill of beta arrives at
+    ///        column j, recovered from the already-filled column j + 1.
+    template<typename M>
+    inline Interval BetaResumeHints(int j, const M& beta, float scoreDiff)
+    {
+        if (j == beta.Columns() - 1)
+        {
+            return Interval(beta.Rows(), beta.Rows());
+        }
+        return Interval(beta.UsedRowRange(j + 1).Begin,
+                        RowRange(j + 1, beta, scoreDiff).End);
+    }
+
     template<typename M, typename E, typename C>
     inline bool
     RecursorBase<M, E, C>::RangeGuide(int j, const M& guide, const M& matrix,
@@ -51,6 +51,8 @@
 #include "Edna/EdnaEvaluator.hpp"
 #include "Quiver/QuiverConfig.hpp"
 #include "Quiver/QvEvaluator.hpp"
+#include "Quiver/ScorerCounters.hpp"
+#include "Quiver/detail/Instrumentation.hpp"
 #include "Types.hpp"
 #include "Utils.hpp"
 
@@ -69,11 +71,12 @@ namespace detail {
 
     template<typename M, typename E, typename C>
     int
-    RecursorBase<M, E, C>::FillAlphaBeta(const E& e, M& a, M& b) const
+    RecursorBase<M, E, C>::FillAlphaBeta(const E& e, M& a, M& b,
+                                         ScorerCounters* counters) const
         throw(AlphaBetaMismatchException)
     {
-        FillAlpha(e, M::Null(), a);
-        FillBeta(e, a, b);
+        CountedFillAlpha(e, M::Null(), a, 0, counters);
+        CountedFillBeta(e, a, b, INT_MAX, counters);
 
         int I = e.ReadLength();
         int J = e.TemplateLength();
@@ -85,9 +88,9 @@ namespace detail {
         if (a.UsedEntries() >= maxSize ||
             b.UsedEntries() >= maxSize)
         {
-            FillAlpha(e, b, a);
-            FillBeta(e, a, b);
-            FillAlpha(e, b, a);
+            CountedFillAlpha(e, b, a, 0, counters);
+            CountedFillBeta(e, a, b, INT_MAX, counters);
+            CountedFillAlpha(e, b, a, 0, counters);
             flipflops += 3;
         }
 
@@ -96,11 +99,11 @@ namespace detail {
         {
             if (flipflops % 2 == 0)
             {
-                FillAlpha(e, b, a);
+                CountedFillAlpha(e, b, a, 0, counters);
             }
             else
             {
-                FillBeta(e, a, b);
+                CountedFillBeta(e, a, b, INT_MAX, counters);
             }
             flipflops++;
         }
@@ -114,6 +117,93 @@ namespace detail {
         return flipflops;
     }
 
+    template<typename M, typename E, typename C>
+    int
+    RecursorBase<M, E, C>::RefillAlphaBeta(const E& e, M& a, M& b,
+                                           int changeBegin, int changeEnd,
+                                           int lengthDiff,
+                                           ScorerCounters* counters) const
+        throw(AlphaBetaMismatchException)
+    {
+        int J = e.TemplateLength();
+
+        assert(a.Rows() == e.ReadLength() + 1 && a.Columns() == J + 1 - lengthDiff);
+        assert(b.Rows() == e.ReadLength() + 1 && b.Columns() == J + 1 - lengthDiff);
+        assert(0 <= changeBegin && changeBegin <= changeEnd &&
+               changeEnd + lengthDiff >= changeBegin);
+
+        // Alpha column j depends only on template positions [0, j], and
+        // beta column j only on [j, J), so alpha columns before the change
+        // and beta columns after it are still good.  Resize the matrices
+        // around them, and fill in the rest, each guided by the other.
+        int newChangeEnd = changeEnd + lengthDiff;
+        a.ReplaceColumns(changeBegin, a.Columns(), J + 1 - changeBegin);
+        b.ReplaceColumns(0, changeEnd, newChangeEnd);
+        CountedFillAlpha(e, b, a, changeBegin, counters);
+        CountedFillBeta(e, a, b, newChangeEnd, counters);
+        return FinishRefill(e, a, b, counters);
+    }
+
+    template<typename M, typename E, typename C>
+    int
+    RecursorBase<M, E, C>::FinishRefill(const E& e, M& a, M& b,
+                                        ScorerCounters* counters) const
+        throw(AlphaBetaMismatchException)
+    {
+        int I = e.ReadLength();
+        int J = e.TemplateLength();
+
+        if (fabs(a(I, J) - b(0, 0)) > ALPHA_BETA_MISMATCH_TOLERANCE)
+        {
+            a.Reset(I + 1, J + 1);
+            b.Reset(I + 1, J + 1);
+            return FillAlphaBeta(e, a, b, counters);
+        }
+        return 0;
+    }
+
+    template<typename M, typename E, typename C>
+    void
+    RecursorBase<M, E, C>::CountedFillAlpha(const E& e, const M& guide, M& a,
+                                            int beginColumn,
+                                            ScorerCounters* counters) const
+    {
+        if (counters == NULL)
+        {
+            FillAlpha(e, guide, a, beginColumn);
+            return;
+        }
+        int reallocs = NumReallocs(a);
+        double start = Now();
+        FillAlpha(e, guide, a, beginColumn);
+        counters->FillAlphaSeconds += Now() - start;
+        counters->FillAlphaCells += UsedCells(a, beginColumn, a.Columns(),
+                                              &counters->MaxBandWidth);
+        counters->BandColumns += a.Columns() - beginColumn;
+        counters->Reallocations += NumReallocs(a) - reallocs;
+    }
+
+    template<typename M, typename E, typename C>
+    void
+    RecursorBase<M, E, C>::CountedFillBeta(const E& e, const M& guide, M& b,
+                                           int endColumn,
+                                           ScorerCounters* counters) const
+    {
+        if (counters == NULL)
+        {
+            FillBeta(e, guide, b, endColumn);
+            return;
+        }
+        int reallocs = NumReallocs(b);
+        double start = Now();
+        FillBeta(e, guide, b, endColumn);
+        counters->FillBetaSeconds += Now() - start;
+        int end = std::min(endColumn, b.Columns());
+        counters->FillBetaCells += UsedCells(b, 0, end, &counters->MaxBandWidth);
+        counters->BandColumns += end;
+        counters->Reallocations += NumReallocs(b) - reallocs;
+    }
+
     struct MoveSpec {
         Move MoveType;
         int ReadDelta;
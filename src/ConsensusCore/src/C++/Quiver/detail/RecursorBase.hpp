@@ -38,11 +38,13 @@
 #pragma once
 
 #include <algorithm>
+#include <climits>
 #include <utility>
 #include <string>
 
 #include "Types.hpp"
 #include "Quiver/QuiverConfig.hpp"
+#include "Quiver/ScorerCounters.hpp"
 
 namespace ConsensusCore {
 
@@ -73,9 +75,25 @@ namespace ConsensusCore {
         /// \brief Fill the alpha and beta matrices.
         /// This routine will fill the alpha and beta matrices, ensuring
         /// that the score computed from the alpha and beta recursions are
-        /// identical, refilling back-and-forth if necessary.
+        /// identical, refilling back-and-forth if necessary.  The work
+        /// done is added to counters, if given.
         virtual int
-        FillAlphaBeta(const E& e, M& alpha, M& beta) const
+        FillAlphaBeta(const E& e, M& alpha, M& beta,
+                      ScorerCounters* counters = NULL) const
+            throw(AlphaBetaMismatchException);
+
+        /// \brief Refill alpha and beta, previously filled by FillAlphaBeta,
+        ///        after the template has been edited.
+        /// The template positions [changeBegin, changeEnd) of the previous
+        /// template have been replaced, changing its length by lengthDiff;
+        /// e holds the new template.  Alpha columns before the change and
+        /// beta columns after it are kept (the latter shifted), and only the
+        /// rest are recomputed.  Falls back to a full FillAlphaBeta if the
+        /// recomputed matrices do not mate.
+        virtual int
+        RefillAlphaBeta(const E& e, M& alpha, M& beta,
+                        int changeBegin, int changeEnd, int lengthDiff,
+                        ScorerCounters* counters = NULL) const
             throw(AlphaBetaMismatchException);
 
         /// \brief Reband alpha and beta matrices.
@@ -87,17 +105,27 @@ namespace ConsensusCore {
 
         /// \brief Raw FillAlpha, provided primarily for testing purposes.
         ///        Client code should use FillAlphaBeta.
-        virtual void FillAlpha(const E& e, const M& guide, M& alpha) const = 0;
+        /// Columns before beginColumn are taken to be filled already.
+        virtual void FillAlpha(const E& e, const M& guide, M& alpha,
+                               int beginColumn = 0) const = 0;
 
         /// \brief Raw FillBeta, provided primarily for testing purposes.
         ///        Client code should use FillAlphaBeta.
-        virtual void FillBeta(const E& e, const M& guide, M& beta) const = 0;
+        /// Columns from endColumn on are taken to be filled already.
+        virtual void FillBeta(const E& e, const M& guide, M& beta,
+                              int endColumn = INT_MAX) const = 0;
 
         /// \brief Compute two columns of the alpha matrix starting at columnBegin,
         ///        storing the output in ext.
+        /// Columns of ext before firstExtColumn are taken to hold an
+        /// extension from the same column already, against a template
+        /// that agrees with e's as far as they reach, so only the rest are
+        /// computed.  Alternative edits at one site share their first
+        /// column this way.
         virtual void ExtendAlpha(const E& e,
                                  const M& alphaIn, int columnBegin,
-                                 M& ext, int numExtColumns = 2) const = 0;
+                                 M& ext, int numExtColumns = 2,
+                                 int firstExtColumn = 0) const = 0;
 
 
         /// \brief Read out the alignment from the computed alpha matrix.
@@ -107,6 +135,21 @@ namespace ConsensusCore {
         RecursorBase(int movesAvailable, const BandingOptions& banding);
         virtual ~RecursorBase();
 
+    protected:
+        // The end of RefillAlphaBeta, once alpha and beta have been
+        // refilled: if they do not mate, fill them again from scratch
+        int FinishRefill(const E& e, M& alpha, M& beta,
+                         ScorerCounters* counters) const
+            throw(AlphaBetaMismatchException);
+
+    private:
+        // FillAlpha and FillBeta, adding the work done to counters if
+        // they are given
+        void CountedFillAlpha(const E& e, const M& guide, M& alpha,
+                              int beginColumn, ScorerCounters* counters) const;
+        void CountedFillBeta(const E& e, const M& guide, M& beta,
+                             int endColumn, ScorerCounters* counters) const;
+
     protected:
         int movesAvailable_;
         BandingOptions bandingOptions_;
@@ -0,0 +1,620 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+/// \file  SimdRecursorKernels.hpp
+/// \brief Width-generic bodies of the SimdRecursor methods.
+///
+/// This is not an ordinary header: it must be included by a translation
+/// unit that compiles for the target instruction set, after all other
+/// headers and after specializing detail::SimdLanes<W> (see
+/// Avx2Recursor.cpp).  The code is a transliteration of the SseRecursor
+/// kernels, with 4 replaced by W.
+
+#pragma once
+
+#include <algorithm>
+#include <boost/tuple/tuple.hpp>
+#include <cfloat>
+#include <numeric>
+
+#include "Interval.hpp"
+#include "Quiver/SimdRecursor.hpp"
+
+namespace ConsensusCore {
+
+    template<typename M, typename E, typename C, int W>
+    void
+    SimdRecursor<M, E, C, W>::FillAlpha(const E& e, const M& guide, M& alpha,
+                                        int beginColumn) const
+    {
+        typedef detail::SimdLanes<W> L;
+        typedef typename L::Vec Vec;
+
+        int I = e.ReadLength();
+        int J = e.TemplateLength();
+
+        assert(alpha.Rows() == I + 1 && alpha.Columns() == J + 1);
+        assert(guide.IsNull() ||
+               (guide.Rows() == alpha.Rows() && guide.Columns() == alpha.Columns()));
+
+        int hintBeginRow, hintEndRow;
+        boost::tie(hintBeginRow, hintEndRow) =
+            detail::AlphaResumeHints(beginColumn, alpha, this->bandingOptions_.ScoreDiff);
+
+        for (int j = beginColumn; j <= J; ++j)
+        {
+            this->RangeGuide(j, guide, alpha, &hintBeginRow, &hintEndRow);
+
+            int requiredEndRow = std::min(I + 1, hintEndRow);
+
+            float score = -FLT_MAX;
+            float thresholdScore = -FLT_MAX;
+            float maxScore = -FLT_MAX;
+
+            alpha.StartEditingColumn(j, hintBeginRow, hintEndRow);
+
+            int i;
+            int beginRow = hintBeginRow, endRow;
+            // Scalar prologue, as in SseRecursor, leaving a multiple of W
+            // rows for the vector loop.
+            for (i = beginRow;
+                 (i == 0 || (I - i + 1) % W != 0) && i <= I;
+                 i++)
+            {
+                score = -FLT_MAX;
+
+                // Start:
+                if (i == 0 && j == 0)
+                {
+                    score = 0.0f;
+                }
+                // Inc
+                if (i > 0 && j > 0)
+                {
+                    score = C::Combine(score, alpha(i - 1, j - 1) + e.Inc(i - 1, j - 1));
+                }
+                // Merge
+                if ((this->movesAvailable_ & MERGE) && (i > 0 && j > 1))
+                {
+                    score = C::Combine(score, alpha(i - 1, j - 2) + e.Merge(i - 1, j - 2));
+                }
+                // Delete
+                if (j > 0)
+                {
+                    score = C::Combine(score, alpha(i, j - 1) + e.Del(i, j - 1));
+                }
+                // Extra
+                if (i > 0)
+                {
+                    score = C::Combine(score, alpha(i - 1, j) + e.Extra(i - 1, j));
+                }
+                alpha.Set(i, j, score);
+
+                if (score > maxScore)
+                {
+                    maxScore = score;
+                    thresholdScore = maxScore - this->bandingOptions_.ScoreDiff;
+                }
+            }
+            //
+            // Main vector loop
+            //
+            assert(i > 0);
+            for (;
+                 i <= I && (score >= thresholdScore || i < requiredEndRow);
+                 i += W)
+            {
+                Vec scoreW = L::NegInf();
+                // Incorporation:
+                if (j > 0)
+                {
+                    scoreW = L::template Combine<C>(scoreW,
+                        L::Add(L::Get(alpha, i - 1, j - 1), L::Inc(e, i - 1, j - 1)));
+                }
+                // Merge
+                if ((this->movesAvailable_ & MERGE) && j >= 2)
+                {
+                    scoreW = L::template Combine<C>(scoreW,
+                        L::Add(L::Get(alpha, i - 1, j - 2), L::Merge(e, i - 1, j - 2)));
+                }
+                // Deletion:
+                if (j > 0)
+                {
+                    scoreW = L::template Combine<C>(scoreW,
+                        L::Add(L::Get(alpha, i, j - 1), L::Del(e, i, j - 1)));
+                }
+
+                //
+                // Extra (in-register cascade)
+                //
+                scoreW = L::template PrefixScan<C>(alpha.Get(i - 1, j), scoreW,
+                                                   L::Extra(e, i - 1, j));
+                L::Set(alpha, i, j, scoreW);
+
+                // Update score, potentialNewMax
+                float potentialNewMax = L::HorizontalMax(scoreW);
+                score = L::HorizontalMin(scoreW);
+
+                if (potentialNewMax > maxScore)
+                {
+                    maxScore = potentialNewMax;
+                    thresholdScore = maxScore - this->bandingOptions_.ScoreDiff;
+                }
+            }
+
+            endRow = i;
+            alpha.FinishEditingColumn(j, beginRow, endRow);
+
+            // Now, revise the hints to tell the caller where the mass of the
+            // distribution really lived in this column.
+            hintEndRow = endRow;
+            for (i = beginRow; i < endRow && alpha(i, j) < thresholdScore; ++i);
+            hintBeginRow = i;
+        }
+    }
+
+
+    template<typename M, typename E, typename C, int W>
+    void
+    SimdRecursor<M, E, C, W>::FillBeta(const E& e, const M& guide, M& beta,
+                                       int endColumn) const
+    {
+        typedef detail::SimdLanes<W> L;
+        typedef typename L::Vec Vec;
+
+        int I = e.ReadLength();
+        int J = e.TemplateLength();
+
+        assert(beta.Rows() == I + 1 && beta.Columns() == J + 1);
+        assert(guide.IsNull() ||
+               (guide.Rows() == beta.Rows() && guide.Columns() == beta.Columns()));
+
+        int lastColumn = std::min(endColumn, J + 1) - 1;
+        int hintBeginRow, hintEndRow;
+        boost::tie(hintBeginRow, hintEndRow) =
+            detail::BetaResumeHints(lastColumn, beta, this->bandingOptions_.ScoreDiff);
+
+        for (int j = lastColumn; j >= 0; --j)
+        {
+            this->RangeGuide(j, guide, beta, &hintBeginRow, &hintEndRow);
+
+            int requiredBeginRow = std::max(0, hintBeginRow);
+
+            float score = -FLT_MAX;
+            float thresholdScore = -FLT_MAX;
+            float maxScore = -FLT_MAX;
+
+            beta.StartEditingColumn(j, hintBeginRow, hintEndRow);
+
+            int i, beginRow, endRow = hintEndRow;
+            for (i = endRow - 1;
+                 (i == I || (i + 1) % W != 0) && i >= 0;
+                 i--)
+            {
+                score = -FLT_MAX;
+
+                // Start:
+                if (i == I && j == J)
+                {
+                    score = 0.0f;
+                }
+                // Inc
+                if (i < I && j < J)
+                {
+                    score = C::Combine(score, beta(i + 1, j + 1) + e.Inc(i, j));
+                }
+                // Merge
+                if ((this->movesAvailable_ & MERGE) && j < J - 1 && i < I)
+                {
+                    score = C::Combine(score, beta(i + 1, j + 2) + e.Merge(i, j));
+                }
+                // Delete
+                if (j < J)
+                {
+                    score = C::Combine(score, beta(i, j + 1) + e.Del(i, j));
+                }
+                // Extra
+                if (i < I)
+                {
+                    score = C::Combine(score, beta(i + 1, j) + e.Extra(i, j));
+                }
+
+                beta.Set(i, j, score);
+
+                if (score > maxScore)
+                {
+                    maxScore = score;
+                    thresholdScore = maxScore - this->bandingOptions_.ScoreDiff;
+                }
+            }
+            //
+            // Vector loop
+            //
+            i = i - (W - 1);
+            for (;
+                 i >= 0 && (score >= thresholdScore || i >= requiredBeginRow);
+                 i -= W)
+            {
+                Vec scoreW = L::NegInf();
+
+                // Incorporation:
+                if (i < I && j < J)
+                {
+                    scoreW = L::template Combine<C>(scoreW,
+                        L::Add(L::Get(beta, i + 1, j + 1), L::Inc(e, i, j)));
+                }
+                // Merge
+                if ((this->movesAvailable_ & MERGE) && j < J - 1 && i < I)
+                {
+                    scoreW = L::template Combine<C>(scoreW,
+                        L::Add(L::Get(beta, i + 1, j + 2), L::Merge(e, i, j)));
+                }
+                // Deletion:
+                if (j < J)
+                {
+                    scoreW = L::template Combine<C>(scoreW,
+                        L::Add(L::Get(beta, i, j + 1), L::Del(e, i, j)));
+                }
+
+                //
+                // Extra (in-register cascade)
+                //
+                scoreW = L::template SuffixScan<C>(scoreW, L::Extra(e, i, j),
+                                                   beta.Get(i + W, j));
+                L::Set(beta, i, j, scoreW);
+
+                // Update score, potentialNewMax
+                float potentialNewMax = L::HorizontalMax(scoreW);
+                score = L::HorizontalMin(scoreW);
+
+                if (potentialNewMax > maxScore)
+                {
+                    maxScore = potentialNewMax;
+                    thresholdScore = maxScore - this->bandingOptions_.ScoreDiff;
+                }
+            }
+
+            beginRow = i + W;
+            beta.FinishEditingColumn(j, beginRow, endRow);
+
+            // Now, revise the hints to tell the caller where the mass of the
+            // distribution really lived in this column.
+            hintBeginRow = beginRow;
+            for (i = endRow;
+                 i > beginRow && beta(i - 1, j) < thresholdScore;
+                 i--);
+            hintEndRow = i;
+        }
+    }
+
+    template<typename M, typename E, typename C, int W>
+    INLINE_CALLEES float
+    SimdRecursor<M, E, C, W>::LinkAlphaBeta(const E& e,
+                                            const M& alpha, int alphaColumn,
+                                            const M& beta, int betaColumn,
+                                            int absoluteColumn) const
+    {
+        typedef detail::SimdLanes<W> L;
+        typedef typename L::Vec Vec;
+
+        const int I = e.ReadLength();
+
+        assert(alphaColumn > 1 && absoluteColumn > 1);
+        assert(absoluteColumn < e.TemplateLength());
+
+        int usedBegin, usedEnd;
+        boost::tie(usedBegin, usedEnd) = \
+            RangeUnion(alpha.UsedRowRange(alphaColumn - 2),
+                       alpha.UsedRowRange(alphaColumn - 1),
+                       beta.UsedRowRange(betaColumn),
+                       beta.UsedRowRange(betaColumn + 1));
+
+        float v = -FLT_MAX;
+        Vec vW = L::NegInf();
+
+        // Vector loop
+        int i;
+        for (i = usedBegin; i < usedEnd - W; i += W)
+        {
+            // Incorporate
+            vW = L::template Combine<C>(vW,
+                L::Add(L::Add(L::Get(alpha, i, alphaColumn - 1),
+                              L::Inc(e, i, absoluteColumn - 1)),
+                       L::Get(beta, i + 1, betaColumn)));
+            // Merge (2 possible ways):
+            if (this->movesAvailable_ & MERGE)
+            {
+                vW = L::template Combine<C>(vW,
+                    L::Add(L::Add(L::Get(alpha, i, alphaColumn - 2),
+                                  L::Merge(e, i, absoluteColumn - 2)),
+                           L::Get(beta, i + 1, betaColumn)));
+                vW = L::template Combine<C>(vW,
+                    L::Add(L::Add(L::Get(alpha, i, alphaColumn - 1),
+                                  L::Merge(e, i, absoluteColumn - 1)),
+                           L::Get(beta, i + 1, betaColumn + 1)));
+            }
+            // Delete
+            vW = L::template Combine<C>(vW,
+                L::Add(L::Add(L::Get(alpha, i, alphaColumn - 1),
+                              L::Del(e, i, absoluteColumn - 1)),
+                       L::Get(beta, i, betaColumn)));
+        }
+        // Handle the remaining rows non-vector
+        for (; i < usedEnd; i++)
+        {
+            if (i < I)
+            {
+                // Incorporate
+                v = C::Combine(v, alpha(i, alphaColumn - 1) +
+                                  e.Inc(i, absoluteColumn - 1) +
+                                  beta(i + 1, betaColumn));
+                // Merge (2 possible ways):
+                if (this->movesAvailable_ & MERGE)
+                {
+                    v = C::Combine(v, alpha(i, alphaColumn - 2) +
+                                      e.Merge(i, absoluteColumn - 2) +
+                                      beta(i + 1, betaColumn));
+                    v = C::Combine(v, alpha(i, alphaColumn - 1) +
+                                      e.Merge(i, absoluteColumn - 1) +
+                                      beta(i + 1, betaColumn + 1));
+                }
+            }
+            // Delete:
+            v = C::Combine(v, alpha(i, alphaColumn - 1) +
+                              e.Del(i, absoluteColumn - 1) +
+                              beta(i, betaColumn));
+        }
+        // Combine vW and v
+        float v_array[W + 1];
+        L::Store(v_array, vW);
+        v_array[W] = v;
+        v = std::accumulate(v_array, v_array + W + 1, -FLT_MAX, C::Combine);
+        return v;
+    }
+
+    template<typename M, typename E, typename C, int W>
+    INLINE_CALLEES void
+    SimdRecursor<M, E, C, W>::ExtendAlpha(const E& e,
+                                          const M& alpha, int beginColumn,
+                                          M& ext, int numExtColumns,
+                                          int firstExtColumn) const
+    {
+        typedef detail::SimdLanes<W> L;
+        typedef typename L::Vec Vec;
+
+        assert(numExtColumns >= 2);
+        assert(0 <= firstExtColumn && firstExtColumn < numExtColumns);
+        assert(alpha.Rows() == e.ReadLength() + 1 &&
+               ext.Rows() == e.ReadLength() + 1);
+        assert(beginColumn + 1 < e.TemplateLength() + 1);
+        assert(ext.Columns() >= numExtColumns);
+        assert(beginColumn >= 2);
+
+        for (int extCol = firstExtColumn; extCol < numExtColumns; extCol++)
+        {
+            int j = beginColumn + extCol;
+            int beginRow, endRow;
+
+            if (j < alpha.Columns())
+            {
+                boost::tie(beginRow, endRow) = alpha.UsedRowRange(j);
+            }
+            else
+            {
+                beginRow = alpha.UsedRowRange(alpha.Columns() - 1).Begin;
+                endRow = alpha.Rows();
+            }
+
+            ext.StartEditingColumn(extCol, beginRow, endRow);
+            int i;
+            // Scalar prologue, including row 0, leaving a multiple of W
+            // rows for the vector loop.
+            for (i = beginRow;
+                 (i == 0 || (endRow - i) % W != 0) && i < endRow;
+                 i++)
+            {
+                float prev, score = -FLT_MAX;
+                if (i > 0)
+                {
+                    // Inc
+                    prev = (extCol == 0 ?
+                                alpha(i - 1, j - 1) :
+                                ext(i - 1, extCol - 1));
+                    score = C::Combine(score, prev + e.Inc(i - 1, j - 1));
+
+                    // Extra
+                    prev = ext(i - 1, extCol);
+                    score = C::Combine(score, prev + e.Extra(i - 1, j));
+
+                    // Merge
+                    if (this->movesAvailable_ & MERGE)
+                    {
+                        prev = alpha(i - 1, j - 2);
+                        score = C::Combine(score, prev + e.Merge(i - 1, j - 2));
+                    }
+                }
+                // Delete
+                prev = (extCol == 0 ?
+                            alpha(i, j - 1) :
+                            ext(i, extCol - 1));
+                score = C::Combine(score, prev + e.Del(i, j - 1));
+                ext.Set(i, extCol, score);
+            }
+            for (; i < endRow - (W - 1); i += W)
+            {
+                Vec prevW, scoreW = L::NegInf();
+
+                // Incorporation:
+                prevW = (extCol == 0 ?
+                            L::Get(alpha, i - 1, j - 1) :
+                            L::Get(ext, i - 1, extCol - 1));
+                scoreW = L::template Combine<C>(scoreW, L::Add(prevW, L::Inc(e, i - 1, j - 1)));
+
+                // Merge
+                if ((this->movesAvailable_ & MERGE) && j >= 2)
+                {
+                    prevW = L::Get(alpha, i - 1, j - 2);
+                    scoreW = L::template Combine<C>(scoreW, L::Add(prevW, L::Merge(e, i - 1, j - 2)));
+                }
+
+                // Deletion:
+                prevW = (extCol == 0 ?
+                            L::Get(alpha, i, j - 1) :
+                            L::Get(ext, i, extCol - 1));
+                scoreW = L::template Combine<C>(scoreW, L::Add(prevW, L::Del(e, i, j - 1)));
+
+                // Extras:
+                scoreW = L::template PrefixScan<C>(ext.Get(i - 1, extCol), scoreW,
+                                                   L::Extra(e, i - 1, j));
+                L::Set(ext, i, extCol, scoreW);
+            }
+            assert (i == endRow);
+
+            ext.FinishEditingColumn(extCol, beginRow, endRow);
+        }
+    }
+
+    template<typename M, typename E, typename C, int W>
+    void
+    SimdRecursor<M, E, C, W>::ExtendBeta(const E& e,
+                                         const M& beta, int endColumn,
+                                         M& ext, int numExtColumns,
+                                         int lengthDiff) const
+    {
+        typedef detail::SimdLanes<W> L;
+        typedef typename L::Vec Vec;
+
+        int I = beta.Rows() - 1;
+        int J = beta.Columns() - 1;
+        int lastColumn = endColumn;
+        int lastExtColumn = numExtColumns - 1;
+
+        assert(ext.Rows() == I + 1);
+        assert(lastColumn + 2 <= J);
+        assert(lastColumn >= 0);
+        assert(ext.Columns() >= numExtColumns);
+
+        for (int j = lastColumn; j > lastColumn - numExtColumns; j--)
+        {
+            int jp = j + lengthDiff;
+            int extCol = lastExtColumn - (lastColumn - j);
+            int beginRow, endRow;
+
+            if (j < 0)
+            {
+                beginRow = 0;
+                endRow = beta.UsedRowRange(0).End;
+            }
+            else
+            {
+                boost::tie(beginRow, endRow) = beta.UsedRowRange(j);
+            }
+
+            ext.StartEditingColumn(extCol, beginRow, endRow);
+            // Scalar epilogue, including row I, leaving a multiple of W
+            // rows for the vector loop.
+            int i;
+            for (i = endRow - 1;
+                 (i == I || (i + 1 - beginRow) % W != 0) && i >= beginRow;
+                 i--)
+            {
+                float prev, score = -FLT_MAX;
+
+                // Incorporation:
+                if (i < I && j < J)
+                {
+                    prev = (extCol == lastExtColumn ?
+                                beta(i + 1, j + 1) :
+                                ext(i + 1, extCol + 1));
+                    score = C::Combine(score, prev + e.Inc(i, jp));
+                }
+                // Extra:
+                if (i < I)
+                {
+                    score = C::Combine(score, ext(i + 1, extCol) + e.Extra(i, jp));
+                }
+                // Delete:
+                if (j < J)
+                {
+                    prev = (extCol == lastExtColumn ?
+                                beta(i, j + 1) :
+                                ext(i, extCol + 1));
+                    score = C::Combine(score, prev + e.Del(i, jp));
+                }
+                // Merge:
+                if ((this->movesAvailable_ & MERGE) && j < J - 1 && i < I)
+                {
+                    score = C::Combine(score, beta(i + 1, j + 2) + e.Merge(i, jp));
+                }
+                ext.Set(i, extCol, score);
+            }
+            for (i = i - (W - 1); i >= beginRow; i -= W)
+            {
+                Vec prevW, scoreW = L::NegInf();
+
+                // Incorporation:
+                if (j < J)
+                {
+                    prevW = (extCol == lastExtColumn ?
+                                L::Get(beta, i + 1, j + 1) :
+                                L::Get(ext, i + 1, extCol + 1));
+                    scoreW = L::template Combine<C>(scoreW, L::Add(prevW, L::Inc(e, i, jp)));
+                }
+                // Deletion:
+                if (j < J)
+                {
+                    prevW = (extCol == lastExtColumn ?
+                                L::Get(beta, i, j + 1) :
+                                L::Get(ext, i, extCol + 1));
+                    scoreW = L::template Combine<C>(scoreW, L::Add(prevW, L::Del(e, i, jp)));
+                }
+                // Merge
+                if ((this->movesAvailable_ & MERGE) && j < J - 1)
+                {
+                    prevW = L::Get(beta, i + 1, j + 2);
+                    scoreW = L::template Combine<C>(scoreW, L::Add(prevW, L::Merge(e, i, jp)));
+                }
+
+                // Extras:
+                scoreW = L::template SuffixScan<C>(scoreW, L::Extra(e, i, jp),
+                                                   ext.Get(i + W, extCol));
+                L::Set(ext, i, extCol, scoreW);
+            }
+            assert(i + W == beginRow);
+
+            ext.FinishEditingColumn(extCol, beginRow, endRow);
+        }
+    }
+}
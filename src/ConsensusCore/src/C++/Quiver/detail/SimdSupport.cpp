@@ -0,0 +1,103 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#include "Quiver/detail/SimdSupport.hpp"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace ConsensusCore {
+namespace detail {
+
+#ifdef _MSC_VER
+    static int DetectSimdWidth()
+    {
+        int regs[4];
+        __cpuid(regs, 0);
+        if (regs[0] < 7) return 4;
+
+        // The OS must also save the YMM (and for AVX-512, ZMM and opmask)
+        // state on context switch.
+        __cpuid(regs, 1);
+        bool osxsave = (regs[2] & (1 << 27)) != 0;
+        if (!osxsave) return 4;
+        unsigned long long xcr0 = _xgetbv(0);
+
+        __cpuidex(regs, 7, 0);
+        bool avx2    = (regs[1] & (1 << 5))  != 0;
+        bool avx512f = (regs[1] & (1 << 16)) != 0;
+
+        if (avx512f && (xcr0 & 0xe6) == 0xe6) return 16;
+        if (avx2    && (xcr0 & 0x06) == 0x06) return 8;
+        return 4;
+    }
+#else
+    static int DetectSimdWidth()
+    {
+        // libgcc checks OS support (XGETBV) for us here
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) return 16;
+        if (__builtin_cpu_supports("avx2"))    return 8;
+        return 4;
+    }
+#endif
+
+    static int DetectedSimdWidth()
+    {
+        static const int width = DetectSimdWidth();
+        return width;
+    }
+
+    static int simdWidthLimit = 0;
+
+    int MaxSimdWidth()
+    {
+        int width = DetectedSimdWidth();
+        return (simdWidthLimit > 0 && simdWidthLimit < width) ? simdWidthLimit : width;
+    }
+
+    bool SimdWidthSupported(int width)
+    {
+        return (width == 4 || width == 8 || width == 16) &&
+               width <= DetectedSimdWidth();
+    }
+
+    void LimitSimdWidth(int maxWidth)
+    {
+        simdWidthLimit = maxWidth;
+    }
+}}
@@ -0,0 +1,64 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#include "Quiver/detail/SseMath.hpp"
+
+#include <cmath>
+
+namespace ConsensusCore {
+namespace detail {
+
+    // Taylor coefficients of f(d) = log1p(exp(-d)) about the midpoint of
+    // each interval.  With s = 1 / (1 + exp(d)):
+    //   f' = -s,   f'' = s (1 - s),   f''' = -s (1 - s) (1 - 2s)
+    Log1pExpTable::Log1pExpTable()
+    {
+        const double step = 1.0 / (1 << LOGADD_TABLE_BITS);
+        for (int k = 0; k < LOGADD_TABLE_SIZE - 1; k++)
+        {
+            double mid = (k + 0.5) * step;
+            double e = exp(-mid);
+            double s = e / (1.0 + e);
+            Rows[k][0] = static_cast<float>(log(1.0 + e));
+            Rows[k][1] = static_cast<float>(-s);
+            Rows[k][2] = static_cast<float>(s * (1 - s) / 2);
+            Rows[k][3] = static_cast<float>(-s * (1 - s) * (1 - 2 * s) / 6);
+        }
+        for (int c = 0; c < 4; c++)
+        {
+            Rows[LOGADD_TABLE_SIZE - 1][c] = 0.0f;
+        }
+    }
+}}
@@ -37,10 +37,13 @@
 
 #pragma once
 
+#include <immintrin.h>
 #include <xmmintrin.h>
+#include <cfloat>
 #include <limits>
 
 #include "Quiver/detail/sse_mathfun.h"
+#include "Utils.hpp"
 
 
 // todo: turn these into inline functions
@@ -55,24 +58,133 @@
 
 #define MAX4(a, b) _mm_max_ps((a), (b))
 
+// Wide analogues, for use within TARGET_AVX2 / TARGET_AVX512 code
+#define AFFINE8(offset, slope, dataptr)                 \
+  (_mm256_add_ps(_mm256_set1_ps(offset),                \
+                 _mm256_mul_ps(_mm256_set1_ps(slope),   \
+                               _mm256_loadu_ps((dataptr)))))
+
+#define AFFINE16(offset, slope, dataptr)                \
+  (_mm512_add_ps(_mm512_set1_ps(offset),                \
+                 _mm512_mul_ps(_mm512_set1_ps(slope),   \
+                               _mm512_loadu_ps((dataptr)))))
+
+#define MUX8(mask, a, b) _mm256_blendv_ps((b), (a), (mask))
+
+#define MUX16(mask, a, b) _mm512_mask_blend_ps((mask), (b), (a))
+
 
 namespace ConsensusCore {
 namespace detail {
     //
     // Log-space arithmetic
     //
-    static const __m128 ones    = _mm_set_ps1(1.0f);
+    // log1p(exp(-d)), d >= 0, is tabulated as piecewise cubics (Taylor
+    // expansions about the midpoints of intervals of width
+    // h = 2^-LOGADD_TABLE_BITS), and taken to be zero for d >= LOGADD_CUTOFF.
+    // The absolute error is bounded by the larger of
+    //
+    //     truncation:  max|f''''| (h/2)^4 / 24  =  h^4 / 3072
+    //     cutoff:      exp(-LOGADD_CUTOFF)
+    //
+    // plus float rounding (~1e-7); the defaults give ~1e-7 overall:
+    //
+    //     LOGADD_TABLE_BITS   2        3        4
+    //     truncation bound    1.3e-6   8.0e-8   5.0e-9
+    //
+    // (The exp_ps/log_ps pair this replaces was accurate to a few ulp but
+    // cost two polynomial evaluations per combine; logAddApprox_ps was too
+    // imprecise for Edna.)
+    //
+#ifndef LOGADD_TABLE_BITS
+#define LOGADD_TABLE_BITS   3
+#endif
+#ifndef LOGADD_CUTOFF
+#define LOGADD_CUTOFF       17
+#endif
+#define LOGADD_TABLE_SIZE   ((LOGADD_CUTOFF << LOGADD_TABLE_BITS) + 1)
+
+    // Rows of Taylor coefficients (c0, c1, c2, c3) for each interval; the
+    // last row, used from the cutoff on, is zero.
+    struct Log1pExpTable
+    {
+        ALIGN16_BEG float Rows[LOGADD_TABLE_SIZE][4] ALIGN16_END;
+
+        Log1pExpTable();  // SseMath.cpp
+    };
+
+    // Built on first use, so a log-add run during another translation
+    // unit's static initialization still sees a filled table.
+    inline const Log1pExpTable& log1pExpTable()
+    {
+        static const Log1pExpTable table;
+        return table;
+    }
+
+    inline __m128 log1pExp4(__m128 d)
+    {
+        const float step = 1.0f / (1 << LOGADD_TABLE_BITS);
+
+        // Clamp to the zero row; this also sends NaN (from -inf inputs) there
+        d = _mm_min_ps(d, _mm_set_ps1(static_cast<float>(LOGADD_CUTOFF)));
+        __m128i k = _mm_cvttps_epi32(_mm_mul_ps(d, _mm_set_ps1(1 << LOGADD_TABLE_BITS)));
+        __m128 mid = _mm_mul_ps(_mm_add_ps(_mm_cvtepi32_ps(k), _mm_set_ps1(0.5f)),
+                                _mm_set_ps1(step));
+        __m128 t = _mm_sub_ps(d, mid);
+
+        const float (*rows)[4] = log1pExpTable().Rows;
+        ALIGN16_BEG int kk[4] ALIGN16_END;
+        _mm_store_si128(reinterpret_cast<__m128i*>(kk), k);
+        __m128 c0 = _mm_load_ps(rows[kk[0]]);
+        __m128 c1 = _mm_load_ps(rows[kk[1]]);
+        __m128 c2 = _mm_load_ps(rows[kk[2]]);
+        __m128 c3 = _mm_load_ps(rows[kk[3]]);
+        _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+        __m128 p = _mm_add_ps(c2, _mm_mul_ps(t, c3));
+        p = _mm_add_ps(c1, _mm_mul_ps(t, p));
+        return _mm_add_ps(c0, _mm_mul_ps(t, p));
+    }
 
     inline __m128 logAdd4(__m128 aa, __m128 bb)
     {
         __m128 max = _mm_max_ps(aa, bb);
         __m128 min = _mm_min_ps(aa, bb);
-        __m128 diff = _mm_sub_ps(min, max);
-        return _mm_add_ps(max, log_ps(_mm_add_ps(ones, exp_ps(diff))));
+        return _mm_add_ps(max, log1pExp4(_mm_sub_ps(max, min)));
+    }
+
+    //
+    // Horizontal reductions
+    //
+    inline float HorizontalMax4(__m128 v)
+    {
+        __m128 t = _mm_max_ps(v, _mm_movehl_ps(v, v));
+        t = _mm_max_ss(t, _mm_shuffle_ps(t, t, 1));
+        return _mm_cvtss_f32(t);
+    }
+
+    inline float HorizontalMin4(__m128 v)
+    {
+        __m128 t = _mm_min_ps(v, _mm_movehl_ps(v, v));
+        t = _mm_min_ss(t, _mm_shuffle_ps(t, t, 1));
+        return _mm_cvtss_f32(t);
+    }
+
+    //
+    // Conversions between log and probability space.  The log-space zero
+    // (-FLT_MAX) and probability zero map to each other exactly; inputs
+    // whose exponential would be denormal are taken to be zero.
+    //
+    inline __m128 Exp4(__m128 x)
+    {
+        __m128 representable = _mm_cmpge_ps(x, _mm_set_ps1(-87.0f));
+        return _mm_and_ps(representable, exp_ps(x));
+    }
 
-        // Precision of this is currently too low -- causes problems w/ Edna
-        // need a more accurate impl.
-        // return logAddApprox_ps(aa, bb);
+    inline __m128 Log4(__m128 p)
+    {
+        __m128 positive = _mm_cmpgt_ps(p, _mm_setzero_ps());
+        return MUX4(positive, log_ps(p), _mm_set_ps1(-FLT_MAX));
     }
 
     inline float logAdd(float a, float b)
@@ -86,4 +198,68 @@ namespace detail {
         _mm_store_ps(&buf[0], acc);
         return buf[0];
     }
+
+    //
+    // The wide log-add works lane-group by lane-group through logAdd4, so
+    // the wide recursors produce bit-identical results to the SSE one.
+    //
+#ifndef SWIG
+    inline TARGET_AVX2 __m256 logAdd8(__m256 aa, __m256 bb)
+    {
+        __m128 lo = logAdd4(_mm256_castps256_ps128(aa),
+                            _mm256_castps256_ps128(bb));
+        __m128 hi = logAdd4(_mm256_extractf128_ps(aa, 1),
+                            _mm256_extractf128_ps(bb, 1));
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+    }
+
+    inline TARGET_AVX512 __m512 logAdd16(__m512 aa, __m512 bb)
+    {
+        ALIGN16_BEG float abuf[16] ALIGN16_END;
+        ALIGN16_BEG float bbuf[16] ALIGN16_END;
+        _mm512_storeu_ps(abuf, aa);
+        _mm512_storeu_ps(bbuf, bb);
+        for (int k = 0; k < 16; k += 4)
+        {
+            _mm_store_ps(&abuf[k], logAdd4(_mm_load_ps(&abuf[k]),
+                                           _mm_load_ps(&bbuf[k])));
+        }
+        return _mm512_loadu_ps(abuf);
+    }
+
+    inline TARGET_AVX2 float HorizontalMax8(__m256 v)
+    {
+        return HorizontalMax4(_mm_max_ps(_mm256_castps256_ps128(v),
+                                         _mm256_extractf128_ps(v, 1)));
+    }
+
+    inline TARGET_AVX2 float HorizontalMin8(__m256 v)
+    {
+        return HorizontalMin4(_mm_min_ps(_mm256_castps256_ps128(v),
+                                         _mm256_extractf128_ps(v, 1)));
+    }
+
+    // (_mm512_reduce_max_ps or _mm512_castps512_ps256 would do, but trip a
+    // spurious -Wmaybe-uninitialized in GCC's intrinsics; the all-lanes
+    // maskz form of the extract does not)
+    inline TARGET_AVX512 __m256 LowerHalf16(__m512 v)
+    {
+        return _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xFF, _mm512_castps_pd(v), 0));
+    }
+
+    inline TARGET_AVX512 __m256 UpperHalf16(__m512 v)
+    {
+        return _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xFF, _mm512_castps_pd(v), 1));
+    }
+
+    inline TARGET_AVX512 float HorizontalMax16(__m512 v)
+    {
+        return HorizontalMax8(_mm256_max_ps(LowerHalf16(v), UpperHalf16(v)));
+    }
+
+    inline TARGET_AVX512 float HorizontalMin16(__m512 v)
+    {
+        return HorizontalMin8(_mm256_min_ps(LowerHalf16(v), UpperHalf16(v)));
+    }
+#endif
 }}
@@ -0,0 +1,127 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+/// \file  TemplateView.hpp
+/// \brief A template string with an optional local edit applied on read,
+///        so evaluators can score a mutated template without copying it.
+
+#pragma once
+
+#include <cassert>
+#include <climits>
+#include <string>
+
+namespace ConsensusCore {
+namespace detail {
+
+    /// \brief A template, as seen through at most one patch replacing
+    ///        the bases [Start, End) with some new ones.
+    class TemplateView
+    {
+    public:
+        explicit TemplateView(const std::string& tpl)
+            : tpl_(tpl)
+        {
+            Unpatch();
+        }
+
+        // As with std::string, position length() reads as '\0'
+        char operator[](int j) const
+        {
+            assert(0 <= j && j <= length());
+            if (j < patchStart_) return tpl_[j];
+            if (j < patchEnd_)   return patch_[j - patchStart_];
+            return tpl_[j - shift_];
+        }
+
+        int length() const
+        {
+            return length_;
+        }
+
+        /// \brief The template as seen, patch applied.
+        std::string str() const
+        {
+            if (!IsPatched()) return tpl_;
+            std::string tpl(tpl_, 0, patchStart_);
+            tpl += patch_;
+            tpl.append(tpl_, patchEnd_ - shift_, std::string::npos);
+            return tpl;
+        }
+
+        /// \brief Replace the underlying template, dropping any patch.
+        void Reset(const std::string& tpl)
+        {
+            tpl_ = tpl;
+            Unpatch();
+        }
+
+        /// \brief See bases [start, end) of the underlying template as
+        ///        newBases instead (replacing any previous patch).
+        void Patch(int start, int end, const std::string& newBases)
+        {
+            assert(0 <= start && start <= end && end <= (int)tpl_.length());
+            patch_ = newBases;
+            patchStart_ = start;
+            patchEnd_ = start + newBases.length();
+            shift_ = patchEnd_ - end;
+            length_ = tpl_.length() + shift_;
+        }
+
+        void Unpatch()
+        {
+            patch_.clear();
+            patchStart_ = INT_MAX;
+            patchEnd_ = INT_MAX;
+            shift_ = 0;
+            length_ = tpl_.length();
+        }
+
+        bool IsPatched() const
+        {
+            return patchStart_ != INT_MAX;
+        }
+
+    private:
+        std::string tpl_;
+        std::string patch_;
+        // The patch covers [patchStart_, patchEnd_) of the view, and
+        // view position j >= patchEnd_ is template position j - shift_
+        int patchStart_;
+        int patchEnd_;
+        int shift_;
+        int length_;
+    };
+}}
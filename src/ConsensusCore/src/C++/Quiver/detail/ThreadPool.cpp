@@ -0,0 +1,292 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#include "Quiver/detail/ThreadPool.hpp"
+
+#ifndef _MSC_VER
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+
+#include "Types.hpp"
+
+namespace ConsensusCore {
+namespace detail {
+
+    namespace {
+        // Run and commit the items one after another on this thread
+        void RunSerially(int numItems, ParallelTask& task)
+        {
+            for (int i = 0; i < numItems; i++)
+            {
+                task.Run(i);
+                if (!task.Commit(i)) break;
+            }
+        }
+
+#ifndef _MSC_VER
+        // The exception being handled, kept so that it can be rethrown on
+        // another thread.  Plain boost::current_exception only knows the
+        // standard types, so the library's are copied explicitly.
+        boost::exception_ptr CurrentException()
+        {
+            try
+            {
+                throw;
+            }
+            catch (const AlphaBetaMismatchException& e)
+            {
+                return boost::copy_exception(e);
+            }
+            catch (const InternalError& e)
+            {
+                return boost::copy_exception(e);
+            }
+            catch (const InvalidInputError& e)
+            {
+                return boost::copy_exception(e);
+            }
+            catch (const NotYetImplementedException& e)
+            {
+                return boost::copy_exception(e);
+            }
+            catch (...)
+            {
+                return boost::current_exception();
+            }
+        }
+#endif
+    }
+
+    int ThreadPool::HardwareConcurrency()
+    {
+#ifdef _SC_NPROCESSORS_ONLN
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        return n > 0 ? static_cast<int>(n) : 1;
+#else
+        return 1;
+#endif
+    }
+
+    int ThreadPool::NumThreads() const
+    {
+        return numThreads_;
+    }
+
+#ifdef _MSC_VER
+    // No pthreads: everything runs on the calling thread.
+
+    ThreadPool::ThreadPool(int numThreads)
+        : numThreads_(1)
+    {}
+
+    ThreadPool::~ThreadPool()
+    {}
+
+    void ThreadPool::ParallelFor(int numItems, ParallelTask& task)
+    {
+        RunSerially(numItems, task);
+    }
+#else
+    ThreadPool::ThreadPool(int numThreads)
+        : shutdown_(false),
+          generation_(0),
+          task_(NULL),
+          numItems_(0),
+          nextItem_(0),
+          nextCommit_(0),
+          numBusy_(0),
+          cancelled_(false),
+          errorItem_(0),
+          numThreads_(numThreads < 0 ? HardwareConcurrency() : std::max(1, numThreads))
+    {
+        pthread_mutex_init(&mutex_, NULL);
+        pthread_cond_init(&jobPosted_, NULL);
+        pthread_cond_init(&jobDone_, NULL);
+        // The calling thread is the pool's first
+        for (int t = 1; t < numThreads_; t++)
+        {
+            pthread_t thread;
+            if (pthread_create(&thread, NULL, &ThreadPool::WorkerMain, this) != 0)
+            {
+                break;
+            }
+            workers_.push_back(thread);
+        }
+        numThreads_ = 1 + workers_.size();
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        pthread_mutex_lock(&mutex_);
+        shutdown_ = true;
+        pthread_cond_broadcast(&jobPosted_);
+        pthread_mutex_unlock(&mutex_);
+        for (unsigned int t = 0; t < workers_.size(); t++)
+        {
+            pthread_join(workers_[t], NULL);
+        }
+        pthread_cond_destroy(&jobDone_);
+        pthread_cond_destroy(&jobPosted_);
+        pthread_mutex_destroy(&mutex_);
+    }
+
+    void* ThreadPool::WorkerMain(void* pool)
+    {
+        static_cast<ThreadPool*>(pool)->WorkerLoop();
+        return NULL;
+    }
+
+    void ThreadPool::WorkerLoop()
+    {
+        unsigned long seen = 0;
+        pthread_mutex_lock(&mutex_);
+        while (true)
+        {
+            while (!shutdown_ && generation_ == seen)
+            {
+                pthread_cond_wait(&jobPosted_, &mutex_);
+            }
+            if (shutdown_) break;
+            seen = generation_;
+            Work();
+        }
+        pthread_mutex_unlock(&mutex_);
+    }
+
+    // Take and run items of the current task until there are none left.
+    // Called, and returns, with the mutex held.
+    void ThreadPool::Work()
+    {
+        ParallelTask* task = task_;
+        while (task != NULL && !cancelled_ && nextItem_ < numItems_)
+        {
+            int item = nextItem_++;
+            numBusy_++;
+            pthread_mutex_unlock(&mutex_);
+            boost::exception_ptr error;
+            try
+            {
+                task->Run(item);
+            }
+            catch (...)
+            {
+                error = CurrentException();
+            }
+            pthread_mutex_lock(&mutex_);
+            numBusy_--;
+            finished_[item] = true;
+            if (error)
+            {
+                Fail(item, error);
+            }
+
+            // Commit whatever prefix of the items is now complete
+            while (!cancelled_ && nextCommit_ < numItems_ && finished_[nextCommit_])
+            {
+                try
+                {
+                    cancelled_ = !task->Commit(nextCommit_);
+                }
+                catch (...)
+                {
+                    Fail(nextCommit_, CurrentException());
+                }
+                nextCommit_++;
+            }
+        }
+        if (numBusy_ == 0)
+        {
+            pthread_cond_broadcast(&jobDone_);
+        }
+    }
+
+    // Record that item threw error, and cancel the rest.  Called with the
+    // mutex held.
+    void ThreadPool::Fail(int item, const boost::exception_ptr& error)
+    {
+        if (!error_ || item < errorItem_)
+        {
+            error_ = error;
+            errorItem_ = item;
+        }
+        cancelled_ = true;
+    }
+
+    void ThreadPool::ParallelFor(int numItems, ParallelTask& task)
+    {
+        if (workers_.empty() || numItems <= 1)
+        {
+            RunSerially(numItems, task);
+            return;
+        }
+
+        pthread_mutex_lock(&mutex_);
+        if (task_ != NULL)
+        {
+            // Busy with another caller's task (or this is a nested call
+            // from one of its items), so work serially instead
+            pthread_mutex_unlock(&mutex_);
+            RunSerially(numItems, task);
+            return;
+        }
+        task_ = &task;
+        numItems_ = numItems;
+        nextItem_ = 0;
+        nextCommit_ = 0;
+        numBusy_ = 0;
+        cancelled_ = false;
+        finished_.assign(numItems, false);
+        generation_++;
+        pthread_cond_broadcast(&jobPosted_);
+
+        Work();
+        while (numBusy_ > 0)
+        {
+            pthread_cond_wait(&jobDone_, &mutex_);
+        }
+        task_ = NULL;
+        boost::exception_ptr error = error_;
+        error_ = boost::exception_ptr();
+        pthread_mutex_unlock(&mutex_);
+
+        if (error)
+        {
+            boost::rethrow_exception(error);
+        }
+    }
+#endif  // _MSC_VER
+}}
@@ -0,0 +1,129 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+/// \file  ThreadPool.hpp
+/// \brief A small pool of worker threads, for spreading per-read work
+///        across cores.
+
+#pragma once
+
+#include <boost/exception_ptr.hpp>
+#include <boost/noncopyable.hpp>
+#include <vector>
+
+#ifndef _MSC_VER
+#include <pthread.h>
+#endif
+
+namespace ConsensusCore {
+namespace detail {
+
+    /// \brief Work over items [0, n), for ThreadPool::ParallelFor.
+    ///
+    /// Run may be called concurrently for different items.  Commit is
+    /// called once per item that has been Run, strictly in item order and
+    /// never concurrently, so a reduction done there gives the same result
+    /// however the items were scheduled.  Commit returning false cancels
+    /// the remaining items.
+    ///
+    /// An exception thrown from Run or Commit cancels the remaining items
+    /// too, and once the items under way have finished, ParallelFor
+    /// rethrows it on the calling thread (the earliest item's, if several
+    /// throw).  The library's own exceptions and the standard ones keep
+    /// their types; any other arrives as a boost::unknown_exception.
+    class ParallelTask
+    {
+    public:
+        virtual ~ParallelTask() {}
+        virtual void Run(int item) = 0;
+        virtual bool Commit(int item) { return true; }
+    };
+
+    /// \brief A fixed set of worker threads, which together with the
+    ///        calling thread execute ParallelTasks.
+    ///
+    /// With a single thread (or where threads are not supported) tasks run
+    /// serially on the calling thread.  A pool runs one task at a time; a
+    /// ParallelFor made while it is busy, from another thread or from
+    /// inside a task, runs serially on its calling thread.
+    class ThreadPool : private boost::noncopyable
+    {
+    public:
+        /// \brief A pool of numThreads threads, including the caller's;
+        ///        a negative count means one per online processor, and 0
+        ///        is taken as 1.
+        explicit ThreadPool(int numThreads);
+        ~ThreadPool();
+
+        int NumThreads() const;
+
+        /// \brief Run task over items [0, numItems), returning once they
+        ///        have all been committed or the task cancelled itself.
+        ///        Items are handed out in increasing order.
+        void ParallelFor(int numItems, ParallelTask& task);
+
+        /// \brief The number of processors online, or 1 if unknown.
+        static int HardwareConcurrency();
+
+    private:
+#ifndef _MSC_VER
+        static void* WorkerMain(void* pool);
+        void WorkerLoop();
+        void Work();
+        void Fail(int item, const boost::exception_ptr& error);
+
+        std::vector<pthread_t> workers_;
+        pthread_mutex_t mutex_;
+        pthread_cond_t jobPosted_;
+        pthread_cond_t jobDone_;
+        bool shutdown_;
+        unsigned long generation_;
+
+        // The task being run, and its progress
+        ParallelTask* task_;
+        int numItems_;
+        int nextItem_;
+        int nextCommit_;
+        int numBusy_;
+        bool cancelled_;
+        std::vector<char> finished_;
+
+        // The exception of the earliest item that threw one, if any
+        boost::exception_ptr error_;
+        int errorItem_;
+#endif
+        int numThreads_;
+    };
+}}
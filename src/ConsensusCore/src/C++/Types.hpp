@@ -62,6 +62,16 @@ namespace ConsensusCore {
     struct Interval;
 }
 
+namespace ConsensusCore {
+    /// \brief How a SparseMatrix stores its entries: as floats, or as
+    ///        16-bit fixed point relative to a per-column base, which
+    ///        halves the memory (see SparseMatrix.hpp).
+    enum MatrixStorage
+    {
+        FLOAT_STORAGE = 0, INT16_STORAGE = 1
+    };
+}
+
 namespace ConsensusCore {
 namespace detail {
     class ViterbiCombiner;
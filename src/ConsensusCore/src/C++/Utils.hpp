@@ -83,3 +83,14 @@ bool AlmostEqual(float A, float B, int maxUlps = 4);
 #else
 #    define INLINE_CALLEES __attribute__((flatten))
 #endif
+
+// Per-function instruction set selection, for the wide vector kernels
+// that are chosen at runtime (see Quiver/detail/SimdSupport.hpp).  MSVC
+// allows AVX intrinsics anywhere, so needs no annotation.
+#ifdef _MSC_VER
+#    define TARGET_AVX2
+#    define TARGET_AVX512
+#else
+#    define TARGET_AVX2    __attribute__((target("avx2")))
+#    define TARGET_AVX512  __attribute__((target("avx512f")))
+#endif
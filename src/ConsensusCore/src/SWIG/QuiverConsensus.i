@@ -6,10 +6,12 @@
 #include "Quiver/MultiReadMutationScorer.hpp"
 #include "Quiver/MutationScorer.hpp"
 #include "Quiver/QuiverConfig.hpp"
+#include "Quiver/ScorerCounters.hpp"
 #include "Quiver/SimpleRecursor.hpp"
 #include "Quiver/SseRecursor.hpp"
 #include "Quiver/ReadScorer.hpp"
 #include "Quiver/Diploid.hpp"
+#include "Quiver/MutationScoreCache.hpp"
 #include "Quiver/QuiverConsensus.hpp"
 
 using namespace ConsensusCore;
@@ -31,6 +33,13 @@ using namespace ConsensusCore;
 
 #ifdef SWIGCSHARP
 %csmethodmodifiers *::ToString() const "public override"
+
+// Batch mutation scoring: marshal the mutations in, and the scores out,
+// as plain arrays so a whole batch costs a single call
+%include "arrays_csharp.i"
+%apply int INPUT[]    { const int* mutationTypes, const int* positions }
+%apply char INPUT[]   { const char* bases }
+%apply float OUTPUT[] { float* scores }
 #endif // SWIGCSHARP
 
 
@@ -38,6 +47,7 @@ using namespace ConsensusCore;
 %include "Sequence.hpp"
 %include "Mutation.hpp"
 %include "Read.hpp"
+%include "Quiver/ScorerCounters.hpp"
 %include "Quiver/detail/Combiner.hpp"
 %include "Quiver/detail/RecursorBase.hpp"
 %include "Quiver/MultiReadMutationScorer.hpp"
@@ -47,6 +57,7 @@ using namespace ConsensusCore;
 %include "Quiver/SseRecursor.hpp"
 %include "Quiver/ReadScorer.hpp"
 %include "Quiver/Diploid.hpp"
+%include "Quiver/MutationScoreCache.hpp"
 %include "Quiver/QuiverConsensus.hpp"
 
  
@@ -39,6 +39,7 @@
 
 #include <algorithm>
 #include <boost/tuple/tuple.hpp>
+#include <cfloat>
 #include <climits>
 #include <iostream>
 #include <string>
@@ -267,3 +268,303 @@ TYPED_TEST(MatrixTest, CopyTest)
 
     ASSERT_EQ(5, mCopy(1, 1));
 }
+
+TYPED_TEST(MatrixTest, Reset)
+{
+    TypeParam m(10, 10);
+    for (int j = 0; j < 10; j++)
+    {
+        m.StartEditingColumn(j, 0, 10);
+        m.Set(j, j, 1);
+        m.FinishEditingColumn(j, j, j + 1);
+    }
+    m.Reset(12, 6);
+    EXPECT_EQ(12, m.Rows());
+    EXPECT_EQ(6, m.Columns());
+    EXPECT_EQ(0, m.UsedEntries());
+    for (int i = 0; i < 12; i++)
+    {
+        for (int j = 0; j < 6; j++)
+        {
+            EXPECT_EQ(lfloat(), m(i, j));
+        }
+    }
+    m.StartEditingColumn(5, 0, 12);
+    m.Set(11, 5, 2);
+    m.FinishEditingColumn(5, 11, 12);
+    EXPECT_EQ(2, m(11, 5));
+}
+
+TEST(SparseMatrixTest, SlabRelocation)
+{
+    // Re-edit columns out of order, growing them past their bands with
+    // scattered Sets, and compare against a dense reference.
+    const int M = 200;
+    const int N = 60;
+    SparseMatrix m(M, N);
+    DenseMatrix ref(M, N);
+    srand(42);
+    for (int round = 0; round < 20; round++)
+    {
+        for (int n = 0; n < N; n++)
+        {
+            int j = (round % 2 == 0) ? n : rand() % N;
+            int begin = rand() % M;
+            int end = std::min(M, begin + rand() % 20);
+            m.StartEditingColumn(j, begin, end);
+            ref.StartEditingColumn(j, begin, end);
+            for (int k = 0; k < 5; k++)
+            {
+                int i = rand() % M;
+                m.Set(i, j, i + j + round);
+                ref.Set(i, j, i + j + round);
+            }
+            m.FinishEditingColumn(j, 0, M);
+            ref.FinishEditingColumn(j, 0, M);
+        }
+        for (int j = 0; j < N; j++)
+        {
+            for (int i = 0; i < M; i++)
+            {
+                ASSERT_EQ(ref(i, j), m(i, j)) << i << ", " << j;
+            }
+        }
+    }
+    EXPECT_LE(m.AllocatedEntries(), m.SlabEntries());
+}
+
+TEST(SparseMatrixTest, ResetReusesSlab)
+{
+    const int bandWidth = 5;
+    const int M = 1000;
+    const int N = 1000;
+    SparseMatrix m(M, N);
+    for (int pass = 0; pass < 3; pass++)
+    {
+        m.Reset(M, N);
+        for (int j = 0; j < N; j++)
+        {
+            int start = std::max(0, j - bandWidth);
+            int end   = std::min(M, j + bandWidth + 1);
+            m.StartEditingColumn(j, start, end);
+            for (int i = start; i < end; i++)
+            {
+                m.Set(i, j, i / (1. + j));
+            }
+            m.FinishEditingColumn(j, start, end);
+        }
+    }
+    // Geometric growth during the first fill only
+    EXPECT_GT(20, m.NumSlabReallocs());
+    SparseMatrix fresh(M, N);
+    EXPECT_EQ(0, fresh.NumSlabReallocs());
+    int reallocs = m.NumSlabReallocs();
+    m.Reset(M, N);
+    m.StartEditingColumn(0, 0, 10);
+    m.FinishEditingColumn(0, 0, 10);
+    EXPECT_EQ(reallocs, m.NumSlabReallocs());
+}
+
+TEST(SparseMatrixTest, ReleaseColumn)
+{
+    const int M = 100;
+    const int N = 100;
+    SparseMatrix m(M, N);
+    for (int j = 0; j < N; j++)
+    {
+        m.StartEditingColumn(j, j / 2, j / 2 + 20);
+        for (int i = j / 2; i < j / 2 + 20; i++)
+        {
+            m.Set(i, j, i + j);
+        }
+        m.FinishEditingColumn(j, j / 2, j / 2 + 20);
+    }
+    int allocated = m.AllocatedEntries();
+    for (int j = 0; j < N; j++)
+    {
+        if (j % 10 != 0)
+        {
+            m.ReleaseColumn(j);
+        }
+    }
+    EXPECT_FALSE(m.IsColumnReleased(0));
+    EXPECT_TRUE(m.IsColumnReleased(1));
+    EXPECT_EQ(ConsensusCore::Interval(0, 20), m.UsedRowRange(1));
+    EXPECT_EQ(-FLT_MAX, m(5, 1));
+    EXPECT_GE(allocated, 5 * m.AllocatedEntries());
+
+    // Compacting frees the space, and keeps the columns in place
+    m.Compact();
+    EXPECT_EQ(m.AllocatedEntries(), m.SlabEntries());
+    for (int j = 0; j < N; j += 10)
+    {
+        EXPECT_EQ(j / 2 + j, m(j / 2, j));
+    }
+    m.Compact(10);
+    EXPECT_LT(m.AllocatedEntries(), m.SlabEntries());
+
+    // A released column can be filled again
+    m.StartEditingColumn(1, 0, 20);
+    m.Set(5, 1, 6);
+    m.FinishEditingColumn(1, 0, 20);
+    EXPECT_FALSE(m.IsColumnReleased(1));
+    EXPECT_EQ(6, m(5, 1));
+}
+
+//
+// INT16_STORAGE
+//
+
+#define INT16_TOLERANCE  (1.0f / 1024)
+
+TEST(SparseMatrixTest, Int16RoundTrip)
+{
+    const int M = 100;
+    const int N = 20;
+    SparseMatrix m(M, N, ConsensusCore::INT16_STORAGE);
+    DenseMatrix ref(M, N);
+    EXPECT_EQ(ConsensusCore::INT16_STORAGE, m.Storage());
+    srand(42);
+    for (int j = 0; j < N; j++)
+    {
+        m.StartEditingColumn(j, 0, M);
+        ref.StartEditingColumn(j, 0, M);
+        for (int i = 0; i < M; i++)
+        {
+            // Log-scale values spanning well under the representable range
+            float v = -1000.0f * j - 30.0f * rand() / RAND_MAX;
+            m.Set(i, j, v);
+            ref.Set(i, j, v);
+        }
+        m.FinishEditingColumn(j, 0, M);
+        ref.FinishEditingColumn(j, 0, M);
+    }
+    for (int j = 0; j < N; j++)
+    {
+        for (int i = 0; i < M; i++)
+        {
+            ASSERT_NEAR(ref(i, j), m(i, j), INT16_TOLERANCE) << i << ", " << j;
+        }
+    }
+    EXPECT_EQ(m.AllocatedEntries(), ref.AllocatedEntries());
+}
+
+TEST(SparseMatrixTest, Int16Empty)
+{
+    SparseMatrix m(10, 10, ConsensusCore::INT16_STORAGE);
+    m.StartEditingColumn(0, 0, 10);
+    m.Set(0, 0, -FLT_MAX);
+    m.Set(1, 0, 5.0f);
+    m.Set(2, 0, -FLT_MAX);
+    m.FinishEditingColumn(0, 0, 3);
+    EXPECT_EQ(-FLT_MAX, m(0, 0));
+    EXPECT_EQ(5.0f, m(1, 0));
+    EXPECT_EQ(-FLT_MAX, m(2, 0));
+    EXPECT_EQ(-FLT_MAX, m(3, 0));
+    EXPECT_EQ(lfloat(), m(5, 5));
+}
+
+TEST(SparseMatrixTest, Int16Rebase)
+{
+    SparseMatrix m(10, 10, ConsensusCore::INT16_STORAGE);
+    m.StartEditingColumn(0, 0, 10);
+    m.Set(0, 0, -100.0f);
+    m.Set(1, 0, -90.5f);
+    // Raising the base by more than the range drops entries far below it
+    m.Set(2, 0, -60.25f);
+    m.Set(3, 0, -80.0f);
+    m.FinishEditingColumn(0, 0, 4);
+    EXPECT_EQ(-FLT_MAX, m(0, 0));
+    EXPECT_NEAR(-90.5f, m(1, 0), INT16_TOLERANCE);
+    EXPECT_NEAR(-60.25f, m(2, 0), INT16_TOLERANCE);
+    EXPECT_NEAR(-80.0f, m(3, 0), INT16_TOLERANCE);
+
+    // Re-editing the column starts it afresh
+    m.StartEditingColumn(0, 0, 10);
+    m.Set(0, 0, -500.0f);
+    m.FinishEditingColumn(0, 0, 1);
+    EXPECT_NEAR(-500.0f, m(0, 0), INT16_TOLERANCE);
+}
+
+TEST(SparseMatrixTest, Int16SSE)
+{
+    SparseMatrix m(16, 4, ConsensusCore::INT16_STORAGE);
+    const float first[]  = { 0.5f, -3.25f, -FLT_MAX, 7.0f };
+    const float second[] = { 1.0f, -20.0f, -40.0f, 2.125f };
+    float out[4];
+
+    m.StartEditingColumn(0, 0, 8);
+    m.Set4(0, 0, _mm_loadu_ps(first));   // column has no base yet
+    m.Set4(4, 0, _mm_loadu_ps(second));  // in range of the base
+    m.FinishEditingColumn(0, 0, 8);
+
+    _mm_storeu_ps(out, m.Get4(0, 0));
+    for (int k = 0; k < 4; k++)
+    {
+        EXPECT_EQ(first[k], out[k]);
+        EXPECT_EQ(first[k], m(k, 0));
+    }
+    _mm_storeu_ps(out, m.Get4(4, 0));
+    EXPECT_EQ(second[0], out[0]);
+    EXPECT_EQ(second[1], out[1]);
+    EXPECT_EQ(-FLT_MAX, out[2]);  // more than 32 below the base
+    EXPECT_EQ(second[3], out[3]);
+
+    // A vector exceeding the range rebases the column
+    const float third[] = { 100.0f, 99.0f, 98.0f, 97.0f };
+    m.StartEditingColumn(1, 0, 8);
+    m.Set(0, 1, 10.0f);
+    m.Set4(4, 1, _mm_loadu_ps(third));
+    m.FinishEditingColumn(1, 0, 8);
+    _mm_storeu_ps(out, m.Get4(4, 1));
+    for (int k = 0; k < 4; k++)
+    {
+        EXPECT_EQ(third[k], out[k]);
+    }
+    EXPECT_EQ(-FLT_MAX, m(0, 1));
+}
+
+TEST(SparseMatrixTest, Int16SlabRelocation)
+{
+    // As SlabRelocation, with values kept within the int16 range of
+    // each column
+    const int M = 200;
+    const int N = 60;
+    SparseMatrix m(M, N, ConsensusCore::INT16_STORAGE);
+    DenseMatrix ref(M, N);
+    srand(42);
+    for (int round = 0; round < 20; round++)
+    {
+        for (int n = 0; n < N; n++)
+        {
+            int j = (round % 2 == 0) ? n : rand() % N;
+            int begin = rand() % M;
+            int end = std::min(M, begin + rand() % 20);
+            m.StartEditingColumn(j, begin, end);
+            ref.StartEditingColumn(j, begin, end);
+            for (int k = 0; k < 5; k++)
+            {
+                int i = rand() % M;
+                float v = -0.1f * i - j - round;
+                m.Set(i, j, v);
+                ref.Set(i, j, v);
+            }
+            m.FinishEditingColumn(j, 0, M);
+            ref.FinishEditingColumn(j, 0, M);
+        }
+        for (int j = 0; j < N; j++)
+        {
+            for (int i = 0; i < M; i++)
+            {
+                ASSERT_NEAR(ref(i, j), m(i, j), INT16_TOLERANCE) << i << ", " << j;
+            }
+        }
+    }
+    EXPECT_LE(m.AllocatedEntries(), m.SlabEntries());
+
+    SparseMatrix copy(m);
+    EXPECT_EQ(ConsensusCore::INT16_STORAGE, copy.Storage());
+    EXPECT_EQ(m(10, 10), copy(10, 10));
+    copy.Reset(M, N);
+    EXPECT_EQ(ConsensusCore::INT16_STORAGE, copy.Storage());
+}
@@ -40,14 +40,22 @@
 #include <string>
 #include <vector>
 
+#include "Poa/PoaConsensus.hpp"
 #include "Quiver/MultiReadMutationScorer.hpp"
+#include "Quiver/MutationEnumerator.hpp"
+#include "Quiver/MutationScoreCache.hpp"
 #include "Quiver/QuiverConfig.hpp"
+#include "Quiver/QuiverConsensus.hpp"
 #include "Quiver/ReadScorer.hpp"
 #include "Quiver/SimpleRecursor.hpp"
 #include "Quiver/SseRecursor.hpp"
+#include "Quiver/detail/ThreadPool.hpp"
 #include "Sequence.hpp"
+#include "Simulation/Random.hpp"
+#include "Simulation/Simulator.hpp"
 
 #include "ParameterSettings.hpp"
+#include "Random.hpp"
 
 using namespace ConsensusCore;  // NOLINT
 using namespace boost::assign;  // NOLINT
@@ -65,6 +73,47 @@ MappedRead AnonymousMappedRead(std::string seq, StrandEnum strand, int tStart, i
     return MappedRead(AnonymousRead(seq), strand, tStart, tEnd);
 }
 
+//
+// Refinement test data: C2 reads simulated from a random template, the
+// POA consensus of the reads (the template to refine), and a config table
+// of realistic parameters for them
+//
+QuiverConfig SimulationConfig(float fastScoreThreshold,
+                              MatrixStorage storage = FLOAT_STORAGE,
+                              int checkpointInterval = 0)
+{
+    QvModelParams qvParams(0.f, -10.13f, -0.17f, -5.31f, -0.11f, -6.07f, -7.29f,
+                           -0.13f, -8.41f, -0.19f, -2.23f, 0.f);
+    return QuiverConfig(qvParams, ALL_MOVES, BandingOptions(4, 20), fastScoreThreshold,
+                        1.0f, storage, checkpointInterval);
+}
+
+struct SimulatedRefinement
+{
+    QuiverConfigTable Configs;
+    std::string Template;
+    std::vector<std::string> Reads;
+};
+
+SimulatedRefinement SimulateRefinement(int seed, int templateLength, int numReads,
+                                       float fastScoreThreshold = -12.5f)
+{
+    SimulatedRefinement sim;
+    sim.Configs.Insert("unknown", SimulationConfig(fastScoreThreshold));
+
+    RandomNumberGenerator rng(seed);
+    std::string tpl;
+    for (int j = 0; j < templateLength; j++) tpl += rng.RandomBase();
+    for (int n = 0; n < numReads; n++)
+    {
+        sim.Reads.push_back(SimulateRead(SequencingParameters::C2(), tpl, rng));
+    }
+    const PoaConsensus* pc = PoaConsensus::FindConsensus(sim.Reads);
+    sim.Template = pc->Sequence();
+    delete pc;
+    return sim;
+}
+
 //
 // Tests for supporting code: OrientedMutation, ReadScoresMutation
 //
@@ -518,6 +567,335 @@ TYPED_TEST(MultiReadMutationScorerTest, NonSpanningReadsTest1)
 }
 
 
+TYPED_TEST(MultiReadMutationScorerTest, ApplyMutationsMatchesFreshScorer)
+{
+    // After applying mutations, the incrementally refilled scorers must
+    // score just as scorers built from scratch on the new template would.
+    // read1:                     >>>>>>>>>>>
+    // read2:          <<<<<<<<<<<
+    // read3:          >>>>>>>>>>>>>>>>>>>>>>
+    //                 0123456789012345678901
+    std::string tpl = "AATGTAATCAATTGATTACATT";
+    MMS mScorer(this->testingConfigs_, tpl);
+    mScorer.AddRead(AnonymousMappedRead("TTGATTACATT", FORWARD_STRAND, 11, 22));
+    mScorer.AddRead(AnonymousMappedRead("TTGATTACATT", REVERSE_STRAND,  0, 11));
+    mScorer.AddRead(AnonymousMappedRead("AATGTAATCAATGATTACAT", FORWARD_STRAND, 0, 22));
+
+    std::vector<Mutation> round1, round2, round3;
+    round1 += Mutation(INSERTION, 5, 'T'), Mutation(SUBSTITUTION, 17, 'G');
+    round2 += Mutation(DELETION, 13, '-');
+    round3 += Mutation(SUBSTITUTION, 0, 'C'), Mutation(INSERTION, 21, 'G');
+
+    std::vector<Mutation>* rounds[] = { &round1, &round2, &round3 };
+    for (int r = 0; r < 3; r++)
+    {
+        mScorer.ApplyMutations(*rounds[r]);
+
+        MMS fresh(this->testingConfigs_, mScorer.Template());
+        for (int i = 0; i < mScorer.NumReads(); i++)
+        {
+            fresh.AddRead(*mScorer.Read(i));
+        }
+        std::vector<float> scores = mScorer.BaselineScores();
+        std::vector<float> freshScores = fresh.BaselineScores();
+        ASSERT_EQ(freshScores.size(), scores.size());
+        for (int i = 0; i < (int)scores.size(); i++)
+        {
+            EXPECT_NEAR(freshScores[i], scores[i], 1e-3) << "round " << r << ", read " << i;
+        }
+        for (int pos = 0; pos < mScorer.TemplateLength(); pos++)
+        {
+            Mutation m(SUBSTITUTION, pos, 'A');
+            EXPECT_NEAR(fresh.Score(m), mScorer.Score(m), 1e-3) << m.ToString();
+        }
+    }
+}
+
+TYPED_TEST(MultiReadMutationScorerTest, BatchedRefillsMatchFreshScorer)
+{
+    // Likewise when the matrices are refilled in batches, over more reads
+    // than one batch holds, on two threads; the refinement must then come
+    // out as it does unbatched.
+    boost::random::mt19937 rng(42);
+    boost::random::uniform_int_distribution<> startDist(0, 60);
+    boost::random::uniform_int_distribution<> baseDist(0, 3);
+    std::string tpl = RandomSequence(rng, 100);
+
+    MMS mScorer(this->testingConfigs_, tpl);
+    MMS batched(this->testingConfigs_, tpl);
+    batched.BatchRefills(true);
+    batched.NumThreads(2);
+    EXPECT_FALSE(mScorer.BatchRefills());
+    EXPECT_TRUE(batched.BatchRefills());
+    for (int n = 0; n < 11; n++)
+    {
+        int start = startDist(rng);
+        int end = start + 40;
+        std::string seq = tpl.substr(start, end - start);
+        seq[10 + n % 20] = "ACGT"[baseDist(rng)];
+        StrandEnum strand = (n % 2 == 0) ? FORWARD_STRAND : REVERSE_STRAND;
+        if (strand == REVERSE_STRAND) seq = ReverseComplement(seq);
+        MappedRead mr = AnonymousMappedRead(seq, strand, start, end);
+        ASSERT_EQ(mScorer.AddRead(mr), batched.AddRead(mr));
+    }
+
+    std::vector<Mutation> round1, round2, round3;
+    round1 += Mutation(INSERTION, 5, 'T'), Mutation(SUBSTITUTION, 47, 'G');
+    round2 += Mutation(DELETION, 63, '-');
+    round3 += Mutation(SUBSTITUTION, 0, 'C'), Mutation(INSERTION, 99, 'G');
+
+    std::vector<Mutation>* rounds[] = { &round1, &round2, &round3 };
+    for (int r = 0; r < 3; r++)
+    {
+        mScorer.ApplyMutations(*rounds[r]);
+        batched.ApplyMutations(*rounds[r]);
+        ASSERT_EQ(mScorer.Template(), batched.Template());
+
+        MMS fresh(this->testingConfigs_, batched.Template());
+        for (int i = 0; i < batched.NumReads(); i++)
+        {
+            ASSERT_TRUE(batched.Read(i) != NULL);
+            fresh.AddRead(*batched.Read(i));
+        }
+        std::vector<float> scores = batched.BaselineScores();
+        std::vector<float> freshScores = fresh.BaselineScores();
+        ASSERT_EQ(freshScores.size(), scores.size());
+        for (int i = 0; i < (int)scores.size(); i++)
+        {
+            EXPECT_NEAR(freshScores[i], scores[i], 1e-3) << "round " << r << ", read " << i;
+        }
+        for (int pos = 0; pos < batched.TemplateLength(); pos++)
+        {
+            Mutation m(SUBSTITUTION, pos, 'A');
+            EXPECT_NEAR(fresh.Score(m), batched.Score(m), 1e-3) << m.ToString();
+        }
+    }
+
+    RefineConsensus(mScorer);
+    RefineConsensus(batched);
+    EXPECT_EQ(mScorer.Template(), batched.Template());
+    EXPECT_NEAR(mScorer.BaselineScore(), batched.BaselineScore(), 1e-2);
+    EXPECT_LT(0, batched.Counters().FillAlphaCells);
+}
+
+TYPED_TEST(MultiReadMutationScorerTest, Counters)
+{
+    // read1:                     >>>>>>>>>>>
+    // read2:          <<<<<<<<<<<
+    // read3:          >>>>>>>>>>>>>>>>>>>>>>
+    //                 0123456789012345678901
+    std::string tpl = "AATGTAATCAATTGATTACATT";
+    MMS mScorer(this->testingConfigs_, tpl);
+    mScorer.AddRead(AnonymousMappedRead("TTGATTACATT", FORWARD_STRAND, 11, 22));
+    mScorer.AddRead(AnonymousMappedRead("TTGATTACATT", REVERSE_STRAND,  0, 11));
+    mScorer.AddRead(AnonymousMappedRead("AATGTAATCAATGATTACAT", FORWARD_STRAND, 0, 22));
+
+    mScorer.Score(Mutation(SUBSTITUTION, 16, 'A'));
+    mScorer.Score(Mutation(SUBSTITUTION, 5, 'A'));
+
+    // Each read counts the mutations it scored; the total is their sum
+    EXPECT_EQ(1, mScorer.Counters(0).MutationsScored);
+    EXPECT_EQ(1, mScorer.Counters(1).MutationsScored);
+    EXPECT_EQ(2, mScorer.Counters(2).MutationsScored);
+    ScorerCounters total = mScorer.Counters();
+    EXPECT_EQ(4, total.MutationsScored);
+    double fillCells = 0;
+    for (int i = 0; i < mScorer.NumReads(); i++)
+    {
+        EXPECT_LT(0, mScorer.Counters(i).FillAlphaCells);
+        fillCells += mScorer.Counters(i).FillAlphaCells + mScorer.Counters(i).FillBetaCells;
+    }
+    EXPECT_EQ(fillCells, total.FillAlphaCells + total.FillBetaCells);
+    EXPECT_EQ(mScorer.Counters(2).MaxBandWidth, total.MaxBandWidth);
+
+    mScorer.ResetCounters();
+    EXPECT_EQ(0, mScorer.Counters().TotalCells());
+    EXPECT_EQ(0, mScorer.Counters().MutationsScored);
+}
+
+
+TYPED_TEST(MultiReadMutationScorerTest, MultithreadedMatchesSerial)
+{
+    // Scoring across threads must give exactly the serial results,
+    // including where FastScore/FastIsFavorable bail out early.
+    boost::random::mt19937 rng(42);
+    boost::random::uniform_int_distribution<> startDist(0, 60);
+    boost::random::uniform_int_distribution<> baseDist(0, 3);
+    std::string tpl = RandomSequence(rng, 100);
+
+    // A threshold most bad mutations will cross partway through the reads
+    QuiverConfigTable configs;
+    configs.Insert("unknown", QuiverConfig(params, ALL_MOVES, BandingOptions(4, 200), -20));
+
+    MMS serial(configs, tpl);
+    MMS threaded(configs, tpl);
+    threaded.NumThreads(4);
+    ASSERT_EQ(1, serial.NumThreads());
+    ASSERT_EQ(4, threaded.NumThreads());
+
+    for (int n = 0; n < 32; n++)
+    {
+        int start = startDist(rng);
+        int end = start + 40;
+        std::string seq = tpl.substr(start, end - start);
+        seq[10 + n % 20] = "ACGT"[baseDist(rng)];
+        StrandEnum strand = (n % 2 == 0) ? FORWARD_STRAND : REVERSE_STRAND;
+        if (strand == REVERSE_STRAND) seq = ReverseComplement(seq);
+        MappedRead mr = AnonymousMappedRead(seq, strand, start, end);
+        ASSERT_EQ(serial.AddRead(mr), threaded.AddRead(mr));
+    }
+
+    int numEarlyExits = 0;
+    for (int round = 0; round < 2; round++)
+    {
+        EXPECT_EQ(serial.Template(), threaded.Template());
+        EXPECT_EQ(serial.BaselineScores(), threaded.BaselineScores());
+        for (int pos = 0; pos < serial.TemplateLength(); pos++)
+        {
+            std::vector<Mutation> muts;
+            muts += Mutation(SUBSTITUTION, pos, "ACGT"[(pos + round) % 4]),
+                    Mutation(INSERTION, pos, 'G'),
+                    Mutation(DELETION, pos, '-');
+            foreach (const Mutation& m, muts)
+            {
+                EXPECT_EQ(serial.Score(m), threaded.Score(m)) << m.ToString();
+                EXPECT_EQ(serial.FastScore(m), threaded.FastScore(m)) << m.ToString();
+                EXPECT_EQ(serial.Scores(m, -1.0f), threaded.Scores(m, -1.0f)) << m.ToString();
+                EXPECT_EQ(serial.IsFavorable(m), threaded.IsFavorable(m)) << m.ToString();
+                EXPECT_EQ(serial.FastIsFavorable(m), threaded.FastIsFavorable(m)) << m.ToString();
+                if (serial.FastScore(m) != serial.Score(m)) numEarlyExits++;
+            }
+        }
+
+        std::vector<Mutation> edits;
+        edits += Mutation(SUBSTITUTION, 30, 'A'), Mutation(INSERTION, 55, 'C'),
+                 Mutation(DELETION, 80, '-');
+        serial.ApplyMutations(edits);
+        threaded.ApplyMutations(edits);
+    }
+
+    EXPECT_LT(0, numEarlyExits);
+
+    MMS copy(threaded);
+    EXPECT_EQ(4, copy.NumThreads());
+}
+
+TYPED_TEST(MultiReadMutationScorerTest, ScoreSiteMatchesScore)
+{
+    // Scoring a site's alternatives together must match scoring them
+    // one at a time, exactly, early exits and all, with or without
+    // threads and checkpointing.
+    boost::random::mt19937 rng(7);
+    boost::random::uniform_int_distribution<> startDist(0, 60);
+    boost::random::uniform_int_distribution<> baseDist(0, 3);
+    std::string tpl = RandomSequence(rng, 100);
+
+    for (int checkpointInterval = 0; checkpointInterval <= 8; checkpointInterval += 8)
+    {
+        QuiverConfigTable configs;
+        configs.Insert("unknown", QuiverConfig(params, ALL_MOVES, BandingOptions(4, 200), -20,
+                                               1.0f, FLOAT_STORAGE, checkpointInterval));
+        MMS mms(configs, tpl);
+        for (int n = 0; n < 16; n++)
+        {
+            int start = startDist(rng);
+            int end = start + 40;
+            std::string seq = tpl.substr(start, end - start);
+            seq[10 + n % 20] = "ACGT"[baseDist(rng)];
+            StrandEnum strand = (n % 2 == 0) ? FORWARD_STRAND : REVERSE_STRAND;
+            if (strand == REVERSE_STRAND) seq = ReverseComplement(seq);
+            mms.AddRead(AnonymousMappedRead(seq, strand, start, end));
+        }
+
+        for (int numThreads = 1; numThreads <= 4; numThreads += 3)
+        {
+            mms.NumThreads(numThreads);
+            for (int pos = 0; pos < mms.TemplateLength(); pos++)
+            {
+                std::vector<float> siteScores = mms.ScoreSite(pos);
+                std::vector<float> fastSiteScores = mms.FastScoreSite(pos);
+                ASSERT_EQ(SITE_ALTERNATIVES, (int)siteScores.size());
+                ASSERT_EQ(SITE_ALTERNATIVES, (int)fastSiteScores.size());
+                for (int b = 0; b < 4; b++)
+                {
+                    Mutation subs(SUBSTITUTION, pos, "ACGT"[b]);
+                    Mutation ins(INSERTION, pos, "ACGT"[b]);
+                    float subsScore = (tpl[pos] == "ACGT"[b]) ? 0.0f : mms.Score(subs);
+                    float fastSubsScore = (tpl[pos] == "ACGT"[b]) ? 0.0f : mms.FastScore(subs);
+                    EXPECT_EQ(subsScore, siteScores[b]) << subs;
+                    EXPECT_EQ(fastSubsScore, fastSiteScores[b]) << subs;
+                    EXPECT_EQ(mms.Score(ins), siteScores[4 + b]) << ins;
+                    EXPECT_EQ(mms.FastScore(ins), fastSiteScores[4 + b]) << ins;
+                }
+                Mutation del(DELETION, pos, '-');
+                EXPECT_EQ(mms.Score(del), siteScores[8]) << del;
+                EXPECT_EQ(mms.FastScore(del), fastSiteScores[8]) << del;
+
+                std::vector<Mutation> alternatives;
+                alternatives += Mutation(INSERTION, pos, 'T'), del;
+                std::vector<float> listScores = mms.FastScoreSite(alternatives);
+                ASSERT_EQ(2, (int)listScores.size());
+                EXPECT_EQ(fastSiteScores[7], listScores[0]);
+                EXPECT_EQ(fastSiteScores[8], listScores[1]);
+            }
+        }
+    }
+}
+
+TYPED_TEST(MultiReadMutationScorerTest, ScoreMutationsBatch)
+{
+    // read1:                     >>>>>>>>>>>
+    // read2:          <<<<<<<<<<<
+    // read3:          >>>>>>>>>>>>>>>>>>>>>>
+    //                 0123456789012345678901
+    std::string tpl = "AATGTAATCAATTGATTACATT";
+    MMS mScorer(this->testingConfigs_, tpl);
+    mScorer.AddRead(AnonymousMappedRead("TTGATTACATT", FORWARD_STRAND, 11, 22));
+    mScorer.AddRead(AnonymousMappedRead("TTGATTACATT", REVERSE_STRAND,  0, 11));
+    mScorer.AddRead(AnonymousMappedRead("AATGTAATCAATGATTACAT", FORWARD_STRAND, 0, 22));
+
+    std::vector<Mutation> muts;
+    std::vector<int> types, positions;
+    std::vector<char> bases;
+    for (int pos = 0; pos < mScorer.TemplateLength(); pos++)
+    {
+        muts += Mutation(SUBSTITUTION, pos, 'A'),
+                Mutation(INSERTION, pos, 'C'),
+                Mutation(DELETION, pos, '-');
+    }
+    foreach (const Mutation& m, muts)
+    {
+        types.push_back(m.Type());
+        positions.push_back(m.Start());
+        bases.push_back(m.IsDeletion() ? '-' : m.NewBases()[0]);
+    }
+    int M = muts.size();
+
+    for (int numThreads = 1; numThreads <= 4; numThreads += 3)
+    {
+        mScorer.NumThreads(numThreads);
+        std::vector<float> scores = mScorer.ScoreMutations(muts);
+        std::vector<float> matrix = mScorer.ScoresMatrix(muts, -1.0f);
+        std::vector<float> arrayScores(M);
+        mScorer.ScoreMutations(M, &types[0], &positions[0], &bases[0], &arrayScores[0]);
+
+        ASSERT_EQ(M, (int)scores.size());
+        ASSERT_EQ(mScorer.NumReads() * M, (int)matrix.size());
+        for (int k = 0; k < M; k++)
+        {
+            EXPECT_EQ(mScorer.Score(muts[k]), scores[k]) << muts[k].ToString();
+            EXPECT_EQ(scores[k], arrayScores[k]) << muts[k].ToString();
+            std::vector<float> byRead = mScorer.Scores(muts[k], -1.0f);
+            for (int i = 0; i < mScorer.NumReads(); i++)
+            {
+                EXPECT_EQ(byRead[i], matrix[i * M + k]) << muts[k].ToString();
+            }
+        }
+    }
+
+    EXPECT_TRUE(mScorer.ScoreMutations(std::vector<Mutation>()).empty());
+}
+
 TYPED_TEST(MultiReadMutationScorerTest, CopyTest)
 {
     // read1:                     >>>>>>>>>>>
@@ -584,3 +962,611 @@ TYPED_TEST(MultiReadMutationScorerTest, MultiBaseIndelsAtBounds)
     EXPECT_EQ(params.Nce                 ,  mScorer.Score(Mutation(DELETION, 19, 21, "")));
     EXPECT_EQ(0                          ,  mScorer.Score(Mutation(DELETION, 20, 22, "")));
 }
+
+
+TEST(MultiReadMutationScorerStorageTest, Int16ConsensusMatchesFloat)
+{
+    // Refining the POA consensus of simulated reads must come out the
+    // same whether alpha and beta are stored as float or as int16.
+    QuiverConfigTable int16Configs;
+    int16Configs.Insert("unknown", SimulationConfig(-12.5f, INT16_STORAGE));
+
+    for (int seed = 0; seed < 3; seed++)
+    {
+        SimulatedRefinement sim = SimulateRefinement(seed, 300, 10);
+
+        SparseSseQvSumProductMultiReadMutationScorer floatMms(sim.Configs, sim.Template);
+        SparseSseQvSumProductMultiReadMutationScorer int16Mms(int16Configs, sim.Template);
+        foreach (const std::string& seq, sim.Reads)
+        {
+            MappedRead mr = AnonymousMappedRead(seq, FORWARD_STRAND, 0, sim.Template.length());
+            ASSERT_EQ(floatMms.AddRead(mr), int16Mms.AddRead(mr));
+        }
+        int numScored = 0;
+        for (int i = 0; i < int16Mms.NumReads(); i++)
+        {
+            if (int16Mms.Read(i) == NULL) continue;
+            EXPECT_EQ(INT16_STORAGE,
+                      dynamic_cast<const SparseMatrix*>(int16Mms.AlphaMatrix(i))->Storage());
+            numScored++;
+        }
+        EXPECT_LE(5, numScored);
+
+        RefineConsensus(floatMms);
+        RefineConsensus(int16Mms);
+        EXPECT_EQ(floatMms.Template(), int16Mms.Template()) << "seed " << seed;
+        EXPECT_NEAR(floatMms.BaselineScore(), int16Mms.BaselineScore(), 0.05f);
+    }
+}
+
+TEST(MultiReadMutationScorerStorageTest, CheckpointedConsensusMatchesFull)
+{
+    // Likewise, keeping only every 16th alpha and beta column, and
+    // scoring on two threads.
+    QuiverConfigTable checkpointedConfigs;
+    checkpointedConfigs.Insert("unknown", SimulationConfig(-12.5f, FLOAT_STORAGE, 16));
+
+    for (int seed = 0; seed < 3; seed++)
+    {
+        SimulatedRefinement sim = SimulateRefinement(seed, 300, 10);
+
+        SparseSseQvSumProductMultiReadMutationScorer fullMms(sim.Configs, sim.Template);
+        SparseSseQvSumProductMultiReadMutationScorer checkpointedMms(checkpointedConfigs,
+                                                                     sim.Template);
+        checkpointedMms.NumThreads(2);
+        foreach (const std::string& seq, sim.Reads)
+        {
+            MappedRead mr = AnonymousMappedRead(seq, FORWARD_STRAND, 0, sim.Template.length());
+            ASSERT_EQ(fullMms.AddRead(mr), checkpointedMms.AddRead(mr));
+        }
+
+        RefineConsensus(fullMms);
+        RefineConsensus(checkpointedMms);
+        EXPECT_EQ(fullMms.Template(), checkpointedMms.Template()) << "seed " << seed;
+        EXPECT_NEAR(fullMms.BaselineScore(), checkpointedMms.BaselineScore(), 0.05f);
+
+        for (int i = 0; i < fullMms.NumReads(); i++)
+        {
+            if (fullMms.Read(i) == NULL) continue;
+            EXPECT_GT(fullMms.AlphaMatrix(i)->AllocatedEntries(),
+                      2 * checkpointedMms.AlphaMatrix(i)->AllocatedEntries()) << "read " << i;
+            EXPECT_GT(fullMms.BetaMatrix(i)->AllocatedEntries(),
+                      2 * checkpointedMms.BetaMatrix(i)->AllocatedEntries()) << "read " << i;
+        }
+        EXPECT_LT(0, checkpointedMms.Counters().RebuildCells);
+    }
+}
+
+TEST(MultiReadMutationScorerScreeningTest, FastIsFavorableMatchesUnscreened)
+{
+    // Screening on the Viterbi matrices must not change which mutations
+    // FastIsFavorable accepts, before or after template edits, yet
+    // should reject most of them without exact scoring.
+    for (int seed = 0; seed < 3; seed++)
+    {
+        SimulatedRefinement sim = SimulateRefinement(seed, 200, 10);
+
+        SparseSseQvSumProductMultiReadMutationScorer exactMms(sim.Configs, sim.Template);
+        SparseSseQvSumProductMultiReadMutationScorer screenedMms(sim.Configs, sim.Template);
+        EXPECT_FALSE(screenedMms.Screening());
+        screenedMms.Screening(true);
+        EXPECT_FLOAT_EQ(DEFAULT_SCREENING_MARGIN, screenedMms.ScreeningMargin());
+        for (int n = 0; n < (int)sim.Reads.size(); n++)
+        {
+            MappedRead mr = AnonymousMappedRead(sim.Reads[n], FORWARD_STRAND, 0,
+                                                sim.Template.length());
+            exactMms.AddRead(mr);
+            screenedMms.AddRead(mr);
+            // Reads added before and after screening is turned on
+            if (n == 4) screenedMms.Screening(false);
+            if (n == 6) screenedMms.Screening(true);
+        }
+
+        for (int round = 0; round < 2; round++)
+        {
+            std::vector<Mutation> mutations =
+                UniqueSingleBaseMutationEnumerator(exactMms.Template()).Mutations();
+            std::vector<Mutation> favorable;
+            screenedMms.ResetCounters();
+            foreach (const Mutation& m, mutations)
+            {
+                bool isFavorable = exactMms.FastIsFavorable(m);
+                EXPECT_EQ(isFavorable, screenedMms.FastIsFavorable(m))
+                    << "seed " << seed << ", round " << round << ", " << m.ToString();
+                if (isFavorable) favorable.push_back(m);
+            }
+            ScorerCounters counters = screenedMms.Counters();
+            EXPECT_EQ((int)mutations.size(), counters.MutationsScreened);
+            EXPECT_LT(counters.MutationsScreened / 2, counters.MutationsScreenedOut);
+            EXPECT_EQ(0, exactMms.Counters().MutationsScreened);
+
+            ASSERT_FALSE(favorable.empty());
+            favorable.resize(1);
+            exactMms.ApplyMutations(favorable);
+            screenedMms.ApplyMutations(favorable);
+        }
+
+        screenedMms.ResetCounters();
+        EXPECT_EQ(0, screenedMms.Counters().MutationsScreened);
+        EXPECT_EQ(0, screenedMms.Counters().MutationsScreenedOut);
+    }
+}
+
+TEST(MultiReadMutationScorerScreeningTest, ScreenedRefinementMatchesExact)
+{
+    // Refining with screening comes out the same, on fewer exact scorings
+    for (int seed = 0; seed < 3; seed++)
+    {
+        SimulatedRefinement sim = SimulateRefinement(seed, 300, 10);
+
+        SparseSseQvSumProductMultiReadMutationScorer exactMms(sim.Configs, sim.Template);
+        SparseSseQvSumProductMultiReadMutationScorer screenedMms(sim.Configs, sim.Template);
+        screenedMms.Screening(true);
+        screenedMms.NumThreads(2);
+        foreach (const std::string& seq, sim.Reads)
+        {
+            MappedRead mr = AnonymousMappedRead(seq, FORWARD_STRAND, 0, sim.Template.length());
+            exactMms.AddRead(mr);
+            screenedMms.AddRead(mr);
+        }
+
+        bool converged = RefineConsensus(exactMms);
+        EXPECT_EQ(converged, RefineConsensus(screenedMms));
+        EXPECT_EQ(exactMms.Template(), screenedMms.Template()) << "seed " << seed;
+        EXPECT_EQ(exactMms.BaselineScore(), screenedMms.BaselineScore());
+
+        ScorerCounters counters = screenedMms.Counters();
+        EXPECT_LT(0, counters.MutationsScreenedOut);
+        EXPECT_LT(counters.MutationsScreenedOut, counters.MutationsScreened);
+    }
+}
+
+TEST(MultiReadMutationScorerAdaptiveTest, AdaptiveFastIsFavorable)
+{
+    // With many reads, scoring them in adaptive order should decide
+    // mutations as in-order FastIsFavorable does, scoring fewer reads once
+    // a template edit has taken up their history.  The fast score
+    // threshold is set low, so the bounds do the work.
+    int numFavorable = 0;
+    for (int seed = 0; seed < 3; seed++)
+    {
+        SimulatedRefinement sim = SimulateRefinement(seed, 200, 60, -500.0f);
+
+        SparseSseQvSumProductMultiReadMutationScorer inOrderMms(sim.Configs, sim.Template);
+        SparseSseQvSumProductMultiReadMutationScorer adaptiveMms(sim.Configs, sim.Template);
+        EXPECT_FALSE(adaptiveMms.AdaptiveFastScoring());
+        adaptiveMms.AdaptiveFastScoring(true);
+        foreach (const std::string& seq, sim.Reads)
+        {
+            MappedRead mr = AnonymousMappedRead(seq, FORWARD_STRAND, 0, sim.Template.length());
+            inOrderMms.AddRead(mr);
+            adaptiveMms.AddRead(mr);
+        }
+
+        std::vector<Mutation> mutations =
+            UniqueSingleBaseMutationEnumerator(sim.Template).Mutations();
+        foreach (const Mutation& m, mutations)
+        {
+            adaptiveMms.FastIsFavorable(m);
+        }
+        // An empty edit still moves on to the "next" template
+        adaptiveMms.ApplyMutations(std::vector<Mutation>());
+        adaptiveMms.ResetCounters();
+
+        int numDiffering = 0;
+        foreach (const Mutation& m, mutations)
+        {
+            bool isFavorable = inOrderMms.FastIsFavorable(m);
+            numFavorable += isFavorable;
+            numDiffering += (isFavorable != adaptiveMms.FastIsFavorable(m));
+        }
+        EXPECT_EQ(0, numDiffering) << "seed " << seed;
+        EXPECT_LT(adaptiveMms.Counters().MutationsScored,
+                  inOrderMms.Counters().MutationsScored * 4 / 5) << "seed " << seed;
+    }
+    EXPECT_LT(0, numFavorable);
+}
+
+TEST(MultiReadMutationScorerAdaptiveTest, FalseRejectRate)
+{
+    // The adaptive bounds are only the differences the reads have given
+    // so far.  Gather them on the POA consensus, which is nearly right,
+    // then plant errors whose fixes gain far more than anything seen, and
+    // measure how many favorable mutations adaptive scoring then rejects
+    // (none, on this data; at most one in twenty passes).  It must never
+    // accept one that exact fast scoring rejects.
+    int numFavorable = 0, numFalseRejects = 0, numFalseAccepts = 0;
+    for (int seed = 0; seed < 3; seed++)
+    {
+        SimulatedRefinement sim = SimulateRefinement(seed, 300, 40, -500.0f);
+
+        SparseSseQvSumProductMultiReadMutationScorer exactMms(sim.Configs, sim.Template);
+        SparseSseQvSumProductMultiReadMutationScorer adaptiveMms(sim.Configs, sim.Template);
+        adaptiveMms.AdaptiveFastScoring(true);
+        foreach (const std::string& seq, sim.Reads)
+        {
+            MappedRead mr = AnonymousMappedRead(seq, FORWARD_STRAND, 0, sim.Template.length());
+            exactMms.AddRead(mr);
+            adaptiveMms.AddRead(mr);
+        }
+
+        foreach (const Mutation& m, UniqueSingleBaseMutationEnumerator(sim.Template).Mutations())
+        {
+            adaptiveMms.FastIsFavorable(m);
+        }
+
+        std::vector<Mutation> errors;
+        for (int k = 0; k < 8; k++)
+        {
+            int pos = 20 + 35 * k;
+            char other = (sim.Template[pos] == 'A') ? 'C' : 'A';
+            errors.push_back(k % 3 == 0 ? Mutation(INSERTION, pos, other) :
+                             k % 3 == 1 ? Mutation(DELETION, pos, '-') :
+                                          Mutation(SUBSTITUTION, pos, other));
+        }
+        exactMms.ApplyMutations(errors);
+        adaptiveMms.ApplyMutations(errors);
+
+        foreach (const Mutation& m,
+                 UniqueSingleBaseMutationEnumerator(exactMms.Template()).Mutations())
+        {
+            bool isFavorable = exactMms.FastIsFavorable(m);
+            bool adaptiveFavorable = adaptiveMms.FastIsFavorable(m);
+            numFavorable += isFavorable;
+            numFalseRejects += (isFavorable && !adaptiveFavorable);
+            numFalseAccepts += (!isFavorable && adaptiveFavorable);
+        }
+    }
+    EXPECT_EQ(0, numFalseAccepts);
+    EXPECT_LT(0, numFavorable);
+    EXPECT_LE(20 * numFalseRejects, numFavorable);
+}
+
+TEST(MultiReadMutationScorerIntervalTest, ShortReadsOnLongTemplate)
+{
+    // Reads tiling a long template, each covering a little of it: every
+    // read's score difference must be that of a scorer holding it alone,
+    // and the coverage must follow the reads through template edits.
+    QuiverConfigTable configs;
+    configs.Insert("unknown", SimulationConfig(-500.0f));
+
+    RandomNumberGenerator rng(42);
+    std::string tpl;
+    for (int j = 0; j < 1000; j++) tpl += rng.RandomBase();
+
+    SparseSseQvMultiReadMutationScorer mms(configs, tpl);
+    for (int start = 0; start + 60 <= 1000; start += 37)
+    {
+        int end = std::min(1000, start + 60 + start % 50);
+        std::string seq = SimulateRead(SequencingParameters::C2(),
+                                       tpl.substr(start, end - start), rng);
+        if (start % 2)
+        {
+            mms.AddRead(AnonymousMappedRead(ReverseComplement(seq), REVERSE_STRAND, start, end));
+        }
+        else
+        {
+            mms.AddRead(AnonymousMappedRead(seq, FORWARD_STRAND, start, end));
+        }
+    }
+
+    for (int round = 0; round < 2; round++)
+    {
+        std::vector<int> coverage(mms.TemplateLength(), 0);
+        for (int i = 0; i < mms.NumReads(); i++)
+        {
+            if (mms.Read(i) == NULL) continue;
+            for (int j = mms.Read(i)->TemplateStart; j < mms.Read(i)->TemplateEnd; j++)
+            {
+                coverage[j]++;
+            }
+        }
+        EXPECT_EQ(coverage, mms.Coverage());
+
+        for (int k = 0; k < 40; k++)
+        {
+            int pos = 25 * k + 3;
+            Mutation m = (k % 3 == 0 ? Mutation(INSERTION, pos, 'G') :
+                          k % 3 == 1 ? Mutation(DELETION, pos, '-') :
+                                       Mutation(SUBSTITUTION, pos, 'T'));
+            std::vector<float> scores = mms.Scores(m);
+            float sum = 0;
+            for (int i = 0; i < mms.NumReads(); i++)
+            {
+                const MappedRead* mr = mms.Read(i);
+                if (mr == NULL) continue;
+                SparseSseQvMultiReadMutationScorer alone(configs, mms.Template());
+                alone.AddRead(*mr);
+                EXPECT_EQ(alone.Score(m), scores[i]) << m.ToString() << ", read " << i;
+                sum += scores[i];
+            }
+            EXPECT_EQ(sum, mms.Score(m)) << m.ToString();
+            EXPECT_EQ(sum > MIN_FAVORABLE_SCOREDIFF, mms.IsFavorable(m)) << m.ToString();
+        }
+
+        std::vector<Mutation> edits;
+        edits.push_back(Mutation(DELETION, 100, '-'));
+        edits.push_back(Mutation(INSERTION, 500, 'A'));
+        edits.push_back(Mutation(INSERTION, 500, 'C'));
+        mms.ApplyMutations(edits);
+    }
+}
+
+TEST(RefineConsensusTest, ParallelScreeningMatchesSerial)
+{
+    // Screening candidates on several threads must refine to the very
+    // same template, also when the screening threads contend for the
+    // scorer's own threads.
+    RefineOptions parallelOpts = DefaultRefineOptions;
+    parallelOpts.NumThreads = 4;
+    detail::ThreadPool executor(3);
+
+    for (int seed = 0; seed < 3; seed++)
+    {
+        SimulatedRefinement sim = SimulateRefinement(seed, 300, 10);
+
+        SparseSseQvSumProductMultiReadMutationScorer serialMms(sim.Configs, sim.Template);
+        SparseSseQvSumProductMultiReadMutationScorer parallelMms(sim.Configs, sim.Template);
+        SparseSseQvSumProductMultiReadMutationScorer executorMms(sim.Configs, sim.Template);
+        executorMms.NumThreads(2);
+        foreach (const std::string& seq, sim.Reads)
+        {
+            MappedRead mr = AnonymousMappedRead(seq, FORWARD_STRAND, 0, sim.Template.length());
+            serialMms.AddRead(mr);
+            parallelMms.AddRead(mr);
+            executorMms.AddRead(mr);
+        }
+
+        bool converged = RefineConsensus(serialMms);
+        EXPECT_EQ(converged, RefineConsensus(parallelMms, parallelOpts));
+        EXPECT_EQ(converged, RefineConsensus(executorMms, DefaultRefineOptions, executor));
+        EXPECT_NE(sim.Template, serialMms.Template()) << "seed " << seed;
+        EXPECT_EQ(serialMms.Template(), parallelMms.Template()) << "seed " << seed;
+        EXPECT_EQ(serialMms.Template(), executorMms.Template()) << "seed " << seed;
+        EXPECT_EQ(serialMms.BaselineScore(), parallelMms.BaselineScore());
+        EXPECT_EQ(serialMms.BaselineScore(), executorMms.BaselineScore());
+    }
+}
+
+TEST(RefineConsensusTest, AdaptiveParallelScreeningMatchesSerial)
+{
+    // Adaptive fast scoring orders and bounds the reads by their history,
+    // which parallel screening must not make depend on the threads.  The
+    // fast score threshold is set low, so the bounds do the work.
+    RefineOptions parallelOpts = DefaultRefineOptions;
+    parallelOpts.NumThreads = 4;
+
+    for (int seed = 0; seed < 3; seed++)
+    {
+        SimulatedRefinement sim = SimulateRefinement(seed, 300, 30, -500.0f);
+
+        SparseSseQvSumProductMultiReadMutationScorer serialMms(sim.Configs, sim.Template);
+        SparseSseQvSumProductMultiReadMutationScorer parallelMms(sim.Configs, sim.Template);
+        serialMms.AdaptiveFastScoring(true);
+        parallelMms.AdaptiveFastScoring(true);
+        foreach (const std::string& seq, sim.Reads)
+        {
+            MappedRead mr = AnonymousMappedRead(seq, FORWARD_STRAND, 0, sim.Template.length());
+            serialMms.AddRead(mr);
+            parallelMms.AddRead(mr);
+        }
+
+        bool converged = RefineConsensus(serialMms);
+        EXPECT_EQ(converged, RefineConsensus(parallelMms, parallelOpts));
+        EXPECT_EQ(serialMms.Template(), parallelMms.Template()) << "seed " << seed;
+        EXPECT_EQ(serialMms.Counters().MutationsScored,
+                  parallelMms.Counters().MutationsScored) << "seed " << seed;
+    }
+}
+
+TEST(MutationScoreCacheTest, CarriesScoresAwayFromEdits)
+{
+    boost::random::mt19937 rng(42);
+    std::string tpl = RandomSequence(rng, 120);
+    QuiverConfigTable configs;
+    configs.Insert("unknown", QuiverConfig(TestingParams<QvModelParams>(), ALL_MOVES,
+                                           BandingOptions(4, 200), -500));
+    SparseSseQvMultiReadMutationScorer mms(configs, tpl);
+    for (int n = 0; n < 4; n++)
+    {
+        std::string seq = tpl;
+        seq[20 + 25 * n] = (seq[20 + 25 * n] == 'A') ? 'C' : 'A';
+        mms.AddRead(AnonymousMappedRead(seq, FORWARD_STRAND, 0, tpl.length()));
+    }
+
+    MutationScoreCache cache(8);
+    std::vector<Mutation> muts;
+    for (int pos = 0; pos < mms.TemplateLength(); pos++)
+    {
+        muts += Mutation(SUBSTITUTION, pos, 'A'), Mutation(INSERTION, pos, 'G'),
+                Mutation(DELETION, pos, '-');
+    }
+    foreach (const Mutation& m, muts)
+    {
+        EXPECT_EQ(mms.FastScore(m), cache.FastScore(mms, m));
+        EXPECT_EQ(mms.FastIsFavorable(m), cache.FastIsFavorable(mms, m));
+    }
+    EXPECT_EQ((int)muts.size(), cache.Misses());
+    EXPECT_EQ((int)muts.size(), cache.Hits());
+    EXPECT_EQ((int)muts.size(), cache.Size());
+
+    // Inserting a base at 60 forgets the substitutions and deletions at
+    // 51..68 and the insertions at 52..68, and shifts the rest along
+    std::vector<Mutation> edits;
+    edits += Mutation(INSERTION, 60, 'T');
+    cache.ApplyMutations(mms, edits);
+    ASSERT_EQ(ApplyMutations(edits, tpl), mms.Template());
+    EXPECT_EQ(3 * 120 - (18 + 17 + 18), cache.Size());
+
+    int hits = cache.Hits();
+    int misses = cache.Misses();
+    foreach (const Mutation& m, muts)
+    {
+        int shift = (m.Start() > 60) ? 1 : 0;
+        Mutation moved(m.Type(), m.Start() + shift, m.End() + shift, m.NewBases());
+        EXPECT_NEAR(mms.FastScore(moved), cache.FastScore(mms, moved), 1e-3) << moved;
+    }
+    EXPECT_EQ(hits + 3 * 120 - (18 + 17 + 18), cache.Hits());
+    EXPECT_EQ(misses + 18 + 17 + 18, cache.Misses());
+
+    cache.Clear();
+    EXPECT_EQ(0, cache.Size());
+    EXPECT_EQ(0, cache.Hits());
+}
+
+TEST(MutationScoreCacheTest, ForgetsScoresOfDeactivatedReads)
+{
+    boost::random::mt19937 rng(42);
+    std::string tpl = RandomSequence(rng, 200);
+    QuiverConfigTable configs;
+    configs.Insert("unknown", QuiverConfig(TestingParams<QvModelParams>(), ALL_MOVES,
+                                           BandingOptions(4, 5), -500));
+    SparseSseQvMultiReadMutationScorer mms(configs, tpl);
+    mms.AddRead(AnonymousMappedRead(tpl.substr(0, 100), FORWARD_STRAND, 0, 100));
+    mms.AddRead(AnonymousMappedRead(tpl.substr(100), FORWARD_STRAND, 100, 200));
+
+    MutationScoreCache cache(8);
+    std::vector<Mutation> muts;
+    for (int pos = 0; pos < mms.TemplateLength(); pos++)
+    {
+        muts += Mutation(SUBSTITUTION, pos, 'A'), Mutation(DELETION, pos, '-');
+    }
+    foreach (const Mutation& m, muts)
+    {
+        cache.FastScore(mms, m);
+    }
+
+    // Deleting 30..34 leaves the first read too far off its band to
+    // follow, which deactivates it
+    std::vector<Mutation> edits;
+    for (int pos = 30; pos < 35; pos++)
+    {
+        edits += Mutation(DELETION, pos, '-');
+    }
+    cache.ApplyMutations(mms, edits);
+    ASSERT_TRUE(mms.Read(0) == NULL);
+    ASSERT_TRUE(mms.Read(1) != NULL);
+
+    // Only the mutations the second read alone covers are still cached,
+    // and those it covers are scored as the scorer now scores them
+    EXPECT_EQ(2 * (200 - 101), cache.Size());
+    for (int pos = 0; pos < mms.TemplateLength(); pos++)
+    {
+        Mutation m(SUBSTITUTION, pos, 'A');
+        EXPECT_EQ(mms.FastScore(m), cache.FastScore(mms, m)) << m;
+    }
+}
+
+TEST(MutationScoreCacheTest, FollowsItsScorer)
+{
+    // Scores cached before a read was added leave it out, and those of
+    // another scorer are not this one's, so either starts the cache afresh
+    boost::random::mt19937 rng(42);
+    std::string tpl = RandomSequence(rng, 120);
+    QuiverConfigTable configs;
+    configs.Insert("unknown", QuiverConfig(TestingParams<QvModelParams>(), ALL_MOVES,
+                                           BandingOptions(4, 200), -500));
+    SparseSseQvMultiReadMutationScorer mms(configs, tpl);
+    SparseSseQvMultiReadMutationScorer other(configs, tpl);
+    for (int n = 0; n < 3; n++)
+    {
+        std::string seq = tpl;
+        seq[20 + 30 * n] = (seq[20 + 30 * n] == 'A') ? 'C' : 'A';
+        MappedRead mr = AnonymousMappedRead(seq, FORWARD_STRAND, 0, tpl.length());
+        if (n < 2) mms.AddRead(mr);
+        other.AddRead(mr);
+    }
+
+    MutationScoreCache cache(8);
+    std::vector<Mutation> muts;
+    for (int pos = 0; pos < mms.TemplateLength(); pos++)
+    {
+        muts += Mutation(SUBSTITUTION, pos, 'G'), Mutation(DELETION, pos, '-');
+    }
+    foreach (const Mutation& m, muts)
+    {
+        cache.FastScore(mms, m);
+    }
+    EXPECT_EQ((int)muts.size(), cache.Size());
+
+    foreach (const Mutation& m, muts)
+    {
+        EXPECT_EQ(other.FastScore(m), cache.FastScore(other, m)) << m;
+    }
+    EXPECT_EQ(2 * (int)muts.size(), cache.Misses());
+
+    other.AddRead(AnonymousMappedRead(tpl, FORWARD_STRAND, 0, tpl.length()));
+    foreach (const Mutation& m, muts)
+    {
+        EXPECT_EQ(other.FastScore(m), cache.FastScore(other, m)) << m;
+    }
+    EXPECT_EQ(3 * (int)muts.size(), cache.Misses());
+    EXPECT_EQ(0, cache.Hits());
+}
+
+TEST(MutationScoreCacheTest, KeepsAdaptiveFastScoring)
+{
+    // Refining an adaptive scorer through a cache decides as it does
+    // without one, on as many read scorings
+    for (int seed = 0; seed < 3; seed++)
+    {
+        SimulatedRefinement sim = SimulateRefinement(seed, 300, 30, -500.0f);
+
+        SparseSseQvSumProductMultiReadMutationScorer plainMms(sim.Configs, sim.Template);
+        SparseSseQvSumProductMultiReadMutationScorer cachedMms(sim.Configs, sim.Template);
+        plainMms.AdaptiveFastScoring(true);
+        cachedMms.AdaptiveFastScoring(true);
+        foreach (const std::string& seq, sim.Reads)
+        {
+            MappedRead mr = AnonymousMappedRead(seq, FORWARD_STRAND, 0, sim.Template.length());
+            plainMms.AddRead(mr);
+            cachedMms.AddRead(mr);
+        }
+
+        MutationScoreCache cache(DefaultRefineOptions.MutationNeighborhood);
+        bool converged = RefineConsensus(plainMms);
+        EXPECT_EQ(converged, RefineConsensus(cachedMms, DefaultRefineOptions, cache));
+        EXPECT_EQ(plainMms.Template(), cachedMms.Template()) << "seed " << seed;
+        EXPECT_EQ(plainMms.Counters().MutationsScored,
+                  cachedMms.Counters().MutationsScored) << "seed " << seed;
+    }
+}
+
+TEST(MutationScoreCacheTest, RefineConsensusAndQVs)
+{
+    // Refining through a cache comes out the same here, and leaves the
+    // QV pass mostly cache hits with QVs close to the uncached ones.
+    for (int seed = 0; seed < 3; seed++)
+    {
+        SimulatedRefinement sim = SimulateRefinement(seed, 300, 10);
+
+        SparseSseQvSumProductMultiReadMutationScorer plainMms(sim.Configs, sim.Template);
+        SparseSseQvSumProductMultiReadMutationScorer cachedMms(sim.Configs, sim.Template);
+        foreach (const std::string& seq, sim.Reads)
+        {
+            MappedRead mr = AnonymousMappedRead(seq, FORWARD_STRAND, 0, sim.Template.length());
+            plainMms.AddRead(mr);
+            cachedMms.AddRead(mr);
+        }
+
+        MutationScoreCache cache(DefaultRefineOptions.MutationNeighborhood);
+        RefineConsensus(plainMms);
+        RefineConsensus(cachedMms, DefaultRefineOptions, cache);
+        ASSERT_EQ(plainMms.Template(), cachedMms.Template()) << "seed " << seed;
+
+        int hits = cache.Hits();
+        int misses = cache.Misses();
+        std::vector<int> QVs = ConsensusQVs(plainMms);
+        std::vector<int> cachedQVs = ConsensusQVs(cachedMms, cache);
+        ASSERT_EQ(QVs.size(), cachedQVs.size());
+        EXPECT_LT(10 * (cache.Misses() - misses), cache.Hits() - hits) << "seed " << seed;
+
+        int numDiffering = 0;
+        for (int pos = 0; pos < (int)QVs.size(); pos++)
+        {
+            EXPECT_NEAR(QVs[pos], cachedQVs[pos], 5) << "seed " << seed << ", pos " << pos;
+            if (QVs[pos] != cachedQVs[pos]) numDiffering++;
+        }
+        EXPECT_GT(QVs.size() / 10, numDiffering) << "seed " << seed;
+    }
+}
@@ -37,6 +37,7 @@
 
 #include <gtest/gtest.h>
 #include <boost/assign.hpp>
+#include <boost/type_traits.hpp>
 #include <string>
 #include <vector>
 
@@ -44,14 +45,18 @@
 #include "Mutation.hpp"
 #include "Read.hpp"
 #include "Sequence.hpp"
+#include "Quiver/MutationEnumerator.hpp"
 #include "Quiver/MutationScorer.hpp"
 #include "Quiver/QuiverConfig.hpp"
 #include "Quiver/QvEvaluator.hpp"
 #include "Quiver/ReadScorer.hpp"
+#include "Quiver/ScaledRecursor.hpp"
 #include "Quiver/SimpleRecursor.hpp"
 #include "Quiver/SseRecursor.hpp"
+#include "Quiver/detail/ThreadPool.hpp"
 
 #include "ParameterSettings.hpp"
+#include "Random.hpp"
 
 using namespace ConsensusCore;  // NOLINT
 using namespace boost::assign;  // NOLINT
@@ -222,6 +227,213 @@ TYPED_TEST(MutationScorerTest, TemplateMutationWorkflow)
 }
 
 
+namespace {
+
+    // Scores each mutation against one shared scorer
+    template<typename ScorerType>
+    class ConcurrentScoringTask : public detail::ParallelTask
+    {
+    public:
+        ConcurrentScoringTask(const ScorerType& scorer,
+                              const std::vector<Mutation>& mutations)
+            : Scores(mutations.size()),
+              scorer_(scorer),
+              mutations_(mutations)
+        {}
+
+        void Run(int k)
+        {
+            Scores[k] = scorer_.ScoreMutation(mutations_[k % mutations_.size()]);
+        }
+
+        std::vector<float> Scores;
+
+    private:
+        const ScorerType& scorer_;
+        const std::vector<Mutation>& mutations_;
+    };
+}
+
+TYPED_TEST(MutationScorerTest, ConcurrentScoring)
+{
+    // Many threads scoring different mutations against the same read
+    // must see exactly the serial scores
+    Rng rng(42);
+    std::string tpl = RandomSequence(rng, 60);
+    std::string seq = tpl.substr(0, 20) + "A" + tpl.substr(20, 25) + tpl.substr(46);
+    E ev(AnonymousRead(seq), tpl, params, true, true);
+    MS ms(ev, recursor);
+
+    std::vector<Mutation> muts;
+    for (int pos = 0; pos < (int)tpl.length(); pos++)
+    {
+        muts += Mutation(SUBSTITUTION, pos, 'A'), Mutation(SUBSTITUTION, pos, 'T'),
+                Mutation(INSERTION, pos, 'C'), Mutation(DELETION, pos, '-');
+    }
+    muts += Mutation(INSERTION, tpl.length(), 'G');
+
+    std::vector<float> expected;
+    foreach (const Mutation& m, muts)
+    {
+        expected.push_back(ms.ScoreMutation(m));
+    }
+
+    detail::ThreadPool pool(8);
+    for (int round = 0; round < 5; round++)
+    {
+        ConcurrentScoringTask<MS> task(ms, muts);
+        pool.ParallelFor(muts.size(), task);
+        for (unsigned int k = 0; k < muts.size(); k++)
+        {
+            ASSERT_EQ(expected[k], task.Scores[k]) << muts[k].ToString();
+        }
+        EXPECT_EQ(tpl, ms.Template());
+    }
+    EXPECT_EQ(6 * (int)muts.size(), ms.Counters().MutationsScored);
+}
+
+
+TYPED_TEST(MutationScorerTest, Counters)
+{
+    Rng rng(42);
+    std::string tpl = RandomSequence(rng, 60);
+    std::string seq = tpl.substr(0, 20) + "A" + tpl.substr(20, 25) + tpl.substr(46);
+    E ev(AnonymousRead(seq), tpl, params, true, true);
+    MS ms(ev, recursor);
+
+    // The initial fill
+    ScorerCounters c = ms.Counters();
+    EXPECT_LT(0, c.FillAlphaCells);
+    EXPECT_LT(0, c.FillBetaCells);
+    EXPECT_LE(2 * (tpl.length() + 1), c.BandColumns);
+    EXPECT_LT(0, c.MaxBandWidth);
+    EXPECT_GE((int)seq.length() + 1, c.MaxBandWidth);
+    EXPECT_LT(0, c.MeanBandWidth());
+    EXPECT_GE(c.MaxBandWidth, c.MeanBandWidth());
+    EXPECT_EQ(ms.NumFlipFlops(), c.FlipFlops);
+    EXPECT_EQ(0, c.MutationsScored);
+    EXPECT_EQ(0, c.ExtendAlphaCells + c.ExtendBetaCells + c.LinkAlphaBetaCells);
+
+    // Scoring, in the middle and at either end
+    ms.ScoreMutation(Mutation(SUBSTITUTION, 30, 'A'));
+    ms.ScoreMutation(Mutation(INSERTION, 31, 'C'));
+    c = ms.Counters();
+    EXPECT_EQ(2, c.MutationsScored);
+    EXPECT_LT(0, c.ExtendAlphaCells);
+    EXPECT_LT(0, c.LinkAlphaBetaCells);
+    EXPECT_EQ(0, c.ExtendBetaCells);
+    EXPECT_LE(c.ExtendAlphaSeconds + c.LinkAlphaBetaSeconds, c.ScoreMutationSeconds);
+
+    ms.ScoreMutation(Mutation(SUBSTITUTION, 0, 'A'));
+    ms.ScoreMutation(Mutation(SUBSTITUTION, tpl.length() - 1, 'A'));
+    EXPECT_EQ(4, ms.Counters().MutationsScored);
+    EXPECT_LT(0, ms.Counters().ExtendBetaCells);
+
+    // Refilling after a template edit
+    ms.Template(ApplyMutation(Mutation(INSERTION, 20, 'A'), tpl));
+    EXPECT_LT(c.FillAlphaCells, ms.Counters().FillAlphaCells);
+    EXPECT_LT(c.FillBetaCells, ms.Counters().FillBetaCells);
+
+    ms.ResetCounters();
+    c = ms.Counters();
+    EXPECT_EQ(0, c.TotalCells());
+    EXPECT_EQ(0, c.TotalSeconds());
+    EXPECT_EQ(0, c.MutationsScored);
+    EXPECT_EQ(0, c.BandColumns);
+}
+
+
+TYPED_TEST(MutationScorerTest, ScoreSite)
+{
+    // Scoring a site's alternatives together must give exactly the
+    // scores of scoring them one by one, while computing the first column
+    // shared by a substitution and the insertion of the same base once.
+    Rng rng(42);
+    std::string tpl = RandomSequence(rng, 80);
+    std::string seq = tpl.substr(0, 30) + "A" + tpl.substr(30, 25) + tpl.substr(56);
+    E ev(AnonymousRead(seq), tpl, params, true, true);
+
+    for (int checkpointInterval = 0; checkpointInterval <= 8; checkpointInterval += 8)
+    {
+        MS ms(ev, recursor, FLOAT_STORAGE, checkpointInterval);
+        int siteCells = 0, oneByOneCells = 0;
+        for (int pos = 0; pos < (int)tpl.length(); pos++)
+        {
+            std::vector<Mutation> alternatives;
+            for (int b = 0; b < 4; b++)
+            {
+                if (tpl[pos] != "ACGT"[b])
+                {
+                    alternatives.push_back(Mutation(SUBSTITUTION, pos, "ACGT"[b]));
+                }
+            }
+            for (int b = 0; b < 4; b++)
+            {
+                alternatives.push_back(Mutation(INSERTION, pos, "ACGT"[b]));
+            }
+            alternatives.push_back(Mutation(DELETION, pos, '-'));
+
+            ms.ResetCounters();
+            std::vector<float> scores = ms.ScoreSite(alternatives);
+            siteCells += ms.Counters().ExtendAlphaCells;
+
+            ms.ResetCounters();
+            ASSERT_EQ(alternatives.size(), scores.size());
+            for (unsigned int k = 0; k < alternatives.size(); k++)
+            {
+                EXPECT_EQ(ms.ScoreMutation(alternatives[k]), scores[k])
+                    << alternatives[k].ToString();
+            }
+            oneByOneCells += ms.Counters().ExtendAlphaCells;
+        }
+        EXPECT_LT(siteCells, oneByOneCells);
+    }
+}
+
+
+TYPED_TEST(MutationScorerTest, Checkpointing)
+{
+    // Keeping only every eighth column (for SparseMatrix recursors)
+    // should give the scores keeping them all does, before and after
+    // template edits.
+    Rng rng(42);
+    std::string tpl = RandomSequence(rng, 200);
+    std::string seq = tpl.substr(0, 50) + "A" + tpl.substr(50, 60) + tpl.substr(111);
+    E ev(AnonymousRead(seq), tpl, params, true, true);
+    MS full(ev, recursor);
+    MS checkpointed(ev, recursor, FLOAT_STORAGE, 8);
+
+    std::vector<Mutation> edits;
+    edits += Mutation(INSERTION, 120, 'G'), Mutation(DELETION, 20, '-'),
+             Mutation(SUBSTITUTION, 197, 'T');
+    for (unsigned int round = 0; round <= edits.size(); round++)
+    {
+        ASSERT_EQ(full.Template(), checkpointed.Template());
+        EXPECT_NEAR(full.Score(), checkpointed.Score(), 1e-3);
+        UniqueSingleBaseMutationEnumerator enumerator(full.Template());
+        foreach (const Mutation& m, enumerator.Mutations())
+        {
+            ASSERT_NEAR(full.ScoreMutation(m), checkpointed.ScoreMutation(m), 1e-3)
+                << "round " << round << ": " << m.ToString();
+        }
+        if (round < edits.size())
+        {
+            std::string newTpl = ApplyMutation(edits[round], full.Template());
+            full.Template(newTpl);
+            checkpointed.Template(newTpl);
+        }
+    }
+
+    if (boost::is_same<typename TypeParam::MatrixType, SparseMatrix>::value)
+    {
+        EXPECT_GT(full.Alpha()->AllocatedEntries(),
+                  2 * checkpointed.Alpha()->AllocatedEntries());
+        EXPECT_GT(full.Beta()->AllocatedEntries(),
+                  2 * checkpointed.Beta()->AllocatedEntries());
+        EXPECT_LT(0, checkpointed.Counters().RebuildCells);
+    }
+    EXPECT_EQ(0, full.Counters().RebuildCells);
+}
 
 
 TYPED_TEST(MutationScorerTest, DinucleotideInsertionTest)
@@ -233,7 +445,7 @@ TYPED_TEST(MutationScorerTest, DinucleotideInsertionTest)
     std::string tplAATT = "CCCCCGAAATTACACCCCC";
 
     Read read = AnonymousRead("CCCCCGATTTTACACCCCC");
-    ReadScorer ez(config);
+    ReadScorer<SparseSseQvRecursor> ez(config);
     float scoreTTTT = ez.Score(tplTTTT, read);
     EXPECT_EQ(0, scoreTTTT);
 
@@ -258,7 +470,7 @@ TYPED_TEST(MutationScorerTest, DinucleotideDeletionTest)
     std::string tplGCTT = "CCCCCGAGCTTACACCCCC";
 
     Read read = AnonymousRead("CCCCCGATTACACCCCC");
-    ReadScorer ez(config);
+    ReadScorer<SparseSseQvRecursor> ez(config);
     float scoreTT = ez.Score(tplTT, read);
     EXPECT_EQ(0, scoreTT);
 
@@ -275,3 +487,41 @@ TYPED_TEST(MutationScorerTest, DinucleotideDeletionTest)
     SparseSimpleQvMutationScorer ms2(e2, r2);
     EXPECT_EQ(scoreTT, ms2.ScoreMutation(Mutation(DELETION, 7, 9, "")));
 }
+
+
+TEST(ScaledMutationScorerTest, MatchesSseSumProduct)
+{
+    // The probability-space recursor must score mutations, including
+    // those at the ends of the template, as the log-space one does
+    QuiverConfig testingConfig = TestingConfig<QuiverConfig>();
+    Rng rng(42);
+    std::string tpl = RandomSequence(rng, 100);
+    std::string seq = tpl.substr(0, 20) + "A" + tpl.substr(20, 45) + tpl.substr(66, 30) + "GG";
+    QvEvaluator ev(AnonymousRead(seq), tpl, testingConfig.QvParams, true, true);
+
+    SparseScaledQvSumProductRecursor scaled(testingConfig.MovesAvailable, testingConfig.Banding);
+    SparseSseQvSumProductRecursor reference(testingConfig.MovesAvailable, testingConfig.Banding);
+    SparseScaledQvSumProductMutationScorer ms(ev, scaled);
+    SparseSseQvSumProductMutationScorer refMs(ev, reference);
+
+    EXPECT_NEAR(refMs.Score(), ms.Score(), 1e-3);
+    for (int pos = 0; pos < (int)tpl.length(); pos++)
+    {
+        std::vector<Mutation> muts;
+        muts += Mutation(SUBSTITUTION, pos, 'A'), Mutation(SUBSTITUTION, pos, 'G'),
+                Mutation(INSERTION, pos, 'C'), Mutation(DELETION, pos, '-');
+        foreach (const Mutation& m, muts)
+        {
+            ASSERT_NEAR(refMs.ScoreMutation(m), ms.ScoreMutation(m), 1e-3) << m.ToString();
+        }
+
+        // Sharing the substitution's first column with the insertion
+        std::vector<Mutation> site;
+        site += Mutation(SUBSTITUTION, pos, 'G'), Mutation(INSERTION, pos, 'G');
+        std::vector<float> siteScores = ms.ScoreSite(site);
+        EXPECT_EQ(ms.ScoreMutation(site[0]), siteScores[0]) << site[0].ToString();
+        EXPECT_EQ(ms.ScoreMutation(site[1]), siteScores[1]) << site[1].ToString();
+    }
+    EXPECT_NEAR(refMs.ScoreMutation(Mutation(INSERTION, tpl.length(), 'T')),
+                ms.ScoreMutation(Mutation(INSERTION, tpl.length(), 'T')), 1e-3);
+}
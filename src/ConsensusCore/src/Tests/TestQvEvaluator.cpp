@@ -37,6 +37,7 @@
 
 #include <gtest/gtest.h>
 
+#include <boost/assign.hpp>
 #include <boost/bind.hpp>
 #include <boost/function.hpp>
 #include <iostream>
@@ -45,6 +46,7 @@
 
 #include "Quiver/QvEvaluator.hpp"
 #include "Features.hpp"
+#include "Mutation.hpp"
 #include "Utils.hpp"
 
 #include "ParameterSettings.hpp"
@@ -52,6 +54,7 @@
 #include "SseTestingUtils.hpp"
 
 using namespace ConsensusCore; // NOLINT
+using namespace boost::assign;  // NOLINT
 using std::cout;
 using std::endl;
 
@@ -134,6 +137,113 @@ TEST_F(QvEvaluatorTest, MergeVsMerge4)
 }
 
 
+TEST_F(QvEvaluatorTest, MoveScoresFollowModel)
+{
+    // The tabulated move scores must be those of the QV model, including
+    // the pinning of the first and last rows and the column past the end
+    // of the template
+    QvModelParams params = TestingParams<QvModelParams>();
+    std::string seq = "GATTACA";
+    float insQv[]   = { 1, 2, 3, 4, 5, 6, 7 };
+    float subsQv[]  = { 7, 6, 5, 4, 3, 2, 1 };
+    float delQv[]   = { 2, 4, 6, 8, 10, 12, 14 };
+    float delTag[]  = { 'A', 'N', 'T', 'G', 'A', 'N', 'C' };
+    float mergeQv[] = { 3, 3, 9, 9, 3, 3, 3 };
+    QvSequenceFeatures f(seq, insQv, subsQv, delQv, delTag, mergeQv);
+    Read read(f, "anonymous", "unknown");
+    std::string tpl = "GATTTACAA";
+    int I = seq.length();
+    int J = tpl.length();
+
+    for (int pins = 0; pins < 4; pins++)
+    {
+        bool pinStart = pins & 1, pinEnd = pins & 2;
+        QvEvaluator e(read, tpl, params, pinStart, pinEnd);
+        for (int j = 0; j <= J; j++)
+        {
+            for (int i = 0; i <= I; i++)
+            {
+                if (i < I && j < J)
+                {
+                    ASSERT_EQ(seq[i] == tpl[j] ?
+                              params.Match :
+                              params.Mismatch + params.MismatchS * subsQv[i],
+                              e.Inc(i, j));
+                }
+                if (j < J)
+                {
+                    float del;
+                    if ((!pinStart && i == 0) || (!pinEnd && i == I))
+                        del = 0;
+                    else if (i < I && delTag[i] == tpl[j])
+                        del = params.DeletionWithTag + params.DeletionWithTagS * delQv[i];
+                    else
+                        del = params.DeletionN;
+                    ASSERT_EQ(del, e.Del(i, j)) << i << ", " << j;
+                }
+                if (i < I)
+                {
+                    ASSERT_EQ(j < J && seq[i] == tpl[j] ?
+                              params.Branch + params.BranchS * insQv[i] :
+                              params.Nce + params.NceS * insQv[i],
+                              e.Extra(i, j));
+                }
+                if (i < I && j < J - 1)
+                {
+                    int b = std::string("ACGT").find(tpl[j]);
+                    ASSERT_EQ(seq[i] == tpl[j] && seq[i] == tpl[j + 1] ?
+                              params.Merge[b] + params.MergeS[b] * mergeQv[i] :
+                              -FLT_MAX,
+                              e.Merge(i, j));
+                }
+            }
+        }
+    }
+}
+
+
+TEST_F(QvEvaluatorTest, ApplyMutationVsCopiedTemplate)
+{
+    // An evaluator viewing its template through a mutation must score
+    // exactly as one given the mutated template outright
+    std::vector<Mutation> muts;
+    muts += Mutation(SUBSTITUTION, 0, 'C'), Mutation(SUBSTITUTION, 7, 'G'),
+            Mutation(SUBSTITUTION, 19, 'T'), Mutation(SUBSTITUTION, 5, 8, "TTA"),
+            Mutation(INSERTION, 0, 'A'), Mutation(INSERTION, 11, 'C'),
+            Mutation(INSERTION, 20, 'G'), Mutation(INSERTION, 4, 4, "GAT"),
+            Mutation(DELETION, 0, '-'), Mutation(DELETION, 12, '-'),
+            Mutation(DELETION, 19, '-'), Mutation(DELETION, 3, 6, "");
+
+    for (int n = 0; n < 20; n++)
+    {
+        QvEvaluator e = this->fuzzEvaluators_[n];
+        std::string tpl = e.Template();
+        foreach (const Mutation& m, muts)
+        {
+            QvEvaluator expected = e;
+            expected.Template(ApplyMutation(m, tpl));
+
+            e.ApplyMutation(m);
+            ASSERT_EQ(expected.Template(), e.Template()) << m.ToString();
+            ASSERT_EQ(expected.TemplateLength(), e.TemplateLength());
+
+            int I = e.ReadLength();
+            int J = e.TemplateLength();
+            for (int j = 0; j <= J; j++)
+                for (int i = 0; i < I; i++)
+                {
+                    if (j < J)     ASSERT_EQ(expected.Inc(i, j), e.Inc(i, j));
+                    if (j < J)     ASSERT_EQ(expected.Del(i, j), e.Del(i, j));
+                    ASSERT_EQ(expected.Extra(i, j), e.Extra(i, j));
+                    if (j < J - 1) ASSERT_EQ(expected.Merge(i, j), e.Merge(i, j));
+                }
+            e.UndoMutation();
+            ASSERT_EQ(tpl, e.Template());
+        }
+    }
+}
+
+
 TEST_F(QvEvaluatorTest, BadTagTest)
 {
     Rng rng(42);
@@ -159,3 +269,41 @@ TEST_F(QvEvaluatorTest, BadTagTest)
     delete[] delTag;
     delete[] mergeQv;
 }
+
+
+TEST(QvSequenceFeaturesTest, CompactChannels)
+{
+    // QVs are held as bytes, rounded and clamped from float input, in
+    // aligned channels shared between copies
+    std::string seq = "GATTACA";
+    float insQv[]   = { 0, 1, 2.4f, 2.6f, 254, 300, -5 };
+    float subsQv[]  = { 7, 6, 5, 4, 3, 2, 1 };
+    float delQv[]   = { 2, 4, 6, 8, 10, 12, 14 };
+    float delTag[]  = { 'A', 'N', 'T', 'G', 0, 'N', 'C' };
+    float mergeQv[] = { 3, 3, 9, 9, 3, 3, 3 };
+    QvSequenceFeatures f(seq, insQv, subsQv, delQv, delTag, mergeQv);
+    unsigned char expectedInsQv[] = { 0, 1, 2, 3, 254, 255, 0 };
+
+    ASSERT_EQ(7, f.Length());
+    ASSERT_EQ(seq, std::string(f.Sequence()));
+    for (int i = 0; i < f.Length(); i++)
+    {
+        EXPECT_EQ(expectedInsQv[i], f.InsQv(i));
+        EXPECT_EQ(subsQv[i], f.SubsQv(i));
+        EXPECT_EQ(delQv[i], f.DelQv(i));
+        EXPECT_EQ(delTag[i], f.DelTag(i));
+        EXPECT_EQ(mergeQv[i], f.MergeQv(i));
+    }
+    EXPECT_EQ(0u, reinterpret_cast<size_t>(f.Sequence().get()) % 64);
+
+    unsigned char byteQvs[]  = { 0, 1, 2, 3, 254, 255, 0 };
+    unsigned char byteTags[] = { 'A', 'N', 'T', 'G', 0, 'N', 'C' };
+    QvSequenceFeatures g(seq, byteQvs, byteQvs, byteQvs, byteTags, byteQvs);
+    QvSequenceFeatures copy = g;
+    EXPECT_EQ(g.Sequence().get(), copy.Sequence().get());
+    for (int i = 0; i < g.Length(); i++)
+    {
+        EXPECT_EQ(f.InsQv(i), copy.InsQv(i));
+        EXPECT_EQ(f.DelTag(i), copy.DelTag(i));
+    }
+}
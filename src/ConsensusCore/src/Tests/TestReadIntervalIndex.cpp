@@ -0,0 +1,195 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+
+#include <gtest/gtest.h>
+#include <boost/random.hpp>
+#include <algorithm>
+#include <vector>
+
+#include "Quiver/detail/ReadIntervalIndex.hpp"
+
+using ConsensusCore::detail::ReadIntervalIndex;
+
+namespace {
+
+    struct Interval
+    {
+        int Start;
+        int End;
+    };
+
+    // The reads meeting [begin, end], by looking at every one
+    std::vector<int> BruteForceOverlapping(const std::vector<Interval>& reads,
+                                           const std::vector<char>& indexed,
+                                           int begin, int end)
+    {
+        std::vector<int> overlapping;
+        for (int i = 0; i < (int)reads.size(); i++)
+        {
+            if (indexed[i] && reads[i].Start <= end && reads[i].End >= begin)
+            {
+                overlapping.push_back(i);
+            }
+        }
+        return overlapping;
+    }
+
+    std::vector<int> BruteForceCoverage(const std::vector<Interval>& reads,
+                                        const std::vector<char>& indexed,
+                                        int length)
+    {
+        std::vector<int> coverage(length, 0);
+        for (int i = 0; i < (int)reads.size(); i++)
+        {
+            if (!indexed[i]) continue;
+            for (int j = reads[i].Start; j < reads[i].End; j++) coverage[j]++;
+        }
+        return coverage;
+    }
+}
+
+TEST(ReadIntervalIndexTest, MatchesBruteForce)
+{
+    const int L = 1000;
+    boost::random::mt19937 rng(42);
+    boost::random::uniform_int_distribution<> position(0, L);
+    boost::random::uniform_int_distribution<> span(0, 120);
+
+    // Reads of uneven lengths, added out of order, some of them dropped
+    std::vector<Interval> reads;
+    std::vector<char> indexed;
+    ReadIntervalIndex index;
+    for (int i = 0; i < 300; i++)
+    {
+        Interval r;
+        r.Start = position(rng);
+        r.End = std::min(L, r.Start + span(rng) + (i % 50 == 0 ? 400 : 0));
+        reads.push_back(r);
+        indexed.push_back(i % 7 != 3);
+        index.Add(i, r.Start, r.End);
+    }
+    index.Retain(indexed);
+    EXPECT_EQ(std::count(indexed.begin(), indexed.end(), 1), index.Size());
+
+    for (int round = 0; round < 2; round++)
+    {
+        for (int begin = 0; begin <= L; begin += 7)
+        {
+            for (int width = 0; width < 3; width++)
+            {
+                EXPECT_EQ(BruteForceOverlapping(reads, indexed, begin, begin + width),
+                          index.Overlapping(begin, begin + width))
+                    << "round " << round << ", [" << begin << ", " << begin + width << "]";
+            }
+        }
+        EXPECT_EQ(BruteForceCoverage(reads, indexed, L), index.Coverage(L));
+
+        // Delete every tenth position and insert after every seventeenth
+        std::vector<int> positions(L + 1);
+        int shift = 0;
+        for (int j = 0; j <= L; j++)
+        {
+            positions[j] = j + shift;
+            if (j % 10 == 5) shift--;
+            if (j % 17 == 0) shift++;
+        }
+        for (int i = 0; i < (int)reads.size(); i++)
+        {
+            reads[i].Start = positions[reads[i].Start];
+            reads[i].End = positions[reads[i].End];
+        }
+        index.Remap(positions);
+    }
+}
+
+TEST(ReadIntervalIndexTest, Empty)
+{
+    ReadIntervalIndex index;
+    EXPECT_EQ(0, index.Size());
+    EXPECT_TRUE(index.Overlapping(0, 10).empty());
+    EXPECT_EQ(std::vector<int>(5, 0), index.Coverage(5));
+}
+
+TEST(ReadIntervalIndexTest, SpanningReadKeepsLookupsLocal)
+{
+    // One read spanning the whole template among thousands of short ones:
+    // a lookup must look at no more than the reads near it, before and
+    // after the spanning read is dropped
+    const int L = 10000;
+    boost::random::mt19937 rng(42);
+    boost::random::uniform_int_distribution<> position(0, L - 100);
+    boost::random::uniform_int_distribution<> span(40, 100);
+
+    std::vector<Interval> reads;
+    std::vector<char> indexed;
+    ReadIntervalIndex index;
+    Interval spanning = { 0, L };
+    reads.push_back(spanning);
+    indexed.push_back(true);
+    index.Add(0, 0, L);
+    for (int i = 1; i <= 3000; i++)
+    {
+        Interval r;
+        r.Start = position(rng);
+        r.End = r.Start + span(rng);
+        reads.push_back(r);
+        indexed.push_back(true);
+        index.Add(i, r.Start, r.End);
+    }
+
+    for (int round = 0; round < 2; round++)
+    {
+        int maxCandidates = 0;
+        for (int begin = 0; begin < L; begin += 3)
+        {
+            int end = begin + 1;
+            int candidates = index.NumCandidates(begin, end);
+            int nearby = BruteForceOverlapping(reads, indexed, begin - READ_INDEX_BIN_WIDTH,
+                                               end + READ_INDEX_BIN_WIDTH).size();
+            // (across a bin boundary, the reads meeting both bins are
+            // looked at twice)
+            EXPECT_LE(candidates, 2 * nearby) << "[" << begin << ", " << end << "]";
+            EXPECT_EQ(BruteForceOverlapping(reads, indexed, begin, end),
+                      index.Overlapping(begin, end));
+            maxCandidates = std::max(maxCandidates, candidates);
+        }
+        EXPECT_LT(20 * maxCandidates, (int)reads.size()) << "round " << round;
+
+        indexed[0] = false;
+        index.Retain(indexed);
+        EXPECT_EQ(3000, index.Size());
+    }
+}
@@ -38,17 +38,25 @@
 #include <gtest/gtest.h>
 
 #include <boost/format.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
 #include <iostream>
 #include <string>
 #include <vector>
 
 #include "Matrix/DenseMatrix.hpp"
 #include "Matrix/SparseMatrix.hpp"
+#include "Quiver/detail/Combiner.hpp"
+#include "Quiver/detail/SimdSupport.hpp"
+#include "Quiver/BatchRecursor.hpp"
 #include "Quiver/QvEvaluator.hpp"
 #include "Quiver/QuiverConfig.hpp"
+#include "Quiver/ScaledRecursor.hpp"
+#include "Quiver/SimdRecursor.hpp"
 #include "Quiver/SimpleRecursor.hpp"
 #include "Quiver/SseRecursor.hpp"
+#include "Quiver/WavefrontRecursor.hpp"
 #include "Features.hpp"
+#include "Mutation.hpp"
 #include "PairwiseAlignment.hpp"
 
 #include "MatrixPrinting.hpp"
@@ -62,8 +70,10 @@ using namespace ConsensusCore; // NOLINT
 //
 typedef testing::Types<SimpleQvRecursor,
                        SseQvRecursor,
+                       WavefrontQvRecursor,
                        SparseSimpleQvRecursor,
-                       SparseSseQvRecursor> Implementations;
+                       SparseSseQvRecursor,
+                       SparseWavefrontQvRecursor> Implementations;
 
 TYPED_TEST_CASE(RecursorTest    , Implementations);
 TYPED_TEST_CASE(RecursorFuzzTest, Implementations);
@@ -440,3 +450,858 @@ TYPED_TEST(RecursorFuzzTest, ExtendBeta)
         }
     }
 }
+
+
+TYPED_TEST(RecursorFuzzTest, RefillAlphaBeta)
+{
+    R recursor(BASIC_MOVES | MERGE, this->banding_);
+
+    int n = 0;
+    foreach (const QvEvaluator& e, this->fuzzEvaluators_)
+    {
+        int tplLength = e.TemplateLength();
+        int readLength = e.ReadLength();
+
+        M alpha(readLength + 1, tplLength + 1);
+        M beta(readLength + 1, tplLength + 1);
+        recursor.FillAlphaBeta(e, alpha, beta);
+
+        // Cycle through mutation types and positions, including the ends
+        int pos = (n * 7) % tplLength;
+        Mutation m = (n % 3 == 0) ? Mutation(SUBSTITUTION, pos, 'A') :
+                     (n % 3 == 1) ? Mutation(INSERTION, pos, 'C') :
+                                    Mutation(DELETION, pos, '-');
+        n++;
+        std::string newTpl = ApplyMutation(m, e.Template());
+        int newLength = newTpl.length();
+        QvEvaluator ee(e);
+        ee.Template(newTpl);
+
+        recursor.RefillAlphaBeta(ee, alpha, beta,
+                                 m.Start(), m.End(), m.LengthDiff());
+        ASSERT_EQ(newLength + 1, alpha.Columns());
+        ASSERT_EQ(newLength + 1, beta.Columns());
+
+        M refAlpha(readLength + 1, newLength + 1);
+        M refBeta(readLength + 1, newLength + 1);
+        recursor.FillAlphaBeta(ee, refAlpha, refBeta);
+
+        float score = refBeta(0, 0);
+        ASSERT_NEAR(score, alpha(readLength, newLength), 1e-3) << m.ToString();
+        ASSERT_NEAR(score, beta(0, 0), 1e-3) << m.ToString();
+        for (int j = 2; j < newLength - 1; j++)
+        {
+            ASSERT_NEAR(score, recursor.LinkAlphaBeta(ee, alpha, j, beta, j, j), 1e-3)
+                << m.ToString() << " (Column " << j << ")";
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Wide (AVX2 / AVX-512) kernels, checked against the simple recursor.  These
+// are skipped on CPUs lacking the instruction set.
+// ----------------------------------------------------------------------------
+
+typedef testing::Types<SparseAvx2QvRecursor,
+                       SparseAvx2QvSumProductRecursor,
+                       SparseAvx512QvRecursor,
+                       SparseAvx512QvSumProductRecursor> WideImplementations;
+
+template <typename T>
+class WideRecursorFuzzTest : public RecursorFuzzTest<T>
+{
+protected:
+    typedef SimpleRecursor<typename T::MatrixType,
+                           typename T::EvaluatorType,
+                           typename T::CombinerType> ReferenceRecursor;
+};
+
+TYPED_TEST_CASE(WideRecursorFuzzTest, WideImplementations);
+
+
+TYPED_TEST(WideRecursorFuzzTest, FillAlphaBetaVsSimple)
+{
+    if (!R::IsSupported()) return;
+
+    R recursor(BASIC_MOVES | MERGE, this->banding_);
+    typename TestFixture::ReferenceRecursor reference(BASIC_MOVES | MERGE, this->banding_);
+
+    foreach (const QvEvaluator& e, this->fuzzEvaluators_)
+    {
+        int tplLength = e.TemplateLength();
+        int readLength = e.ReadLength();
+
+        M alpha(readLength + 1, tplLength + 1);
+        M beta(readLength + 1, tplLength + 1);
+        M refAlpha(readLength + 1, tplLength + 1);
+        M refBeta(readLength + 1, tplLength + 1);
+
+        recursor.FillAlphaBeta(e, alpha, beta);
+        reference.FillAlphaBeta(e, refAlpha, refBeta);
+
+        EXPECT_NEAR(refAlpha(readLength, tplLength), alpha(readLength, tplLength), 1e-3);
+        EXPECT_NEAR(refBeta(0, 0), beta(0, 0), 1e-3);
+        for (int j = 0; j <= tplLength; j++)
+        {
+            for (int i = 0; i <= readLength; i++)
+            {
+                if (refAlpha(i, j) > -FLT_MAX && alpha(i, j) > -FLT_MAX)
+                    ASSERT_NEAR(refAlpha(i, j), alpha(i, j), 1e-3) << i << " " << j;
+            }
+        }
+    }
+}
+
+
+TYPED_TEST(WideRecursorFuzzTest, LinkAlphaBeta)
+{
+    if (!R::IsSupported()) return;
+
+    R recursor(BASIC_MOVES | MERGE, this->banding_);
+
+    foreach (const QvEvaluator& e, this->fuzzEvaluators_)
+    {
+        int tplLength = e.TemplateLength();
+        int readLength = e.ReadLength();
+
+        M alpha(readLength + 1, tplLength + 1);
+        M beta(readLength + 1, tplLength + 1);
+
+        recursor.FillAlphaBeta(e, alpha, beta);
+        float score = beta(0, 0);
+        for (int j = 2; j < tplLength - 1; j++)
+        {
+            float linkScore = recursor.LinkAlphaBeta(e, alpha, j, beta, j, j);
+            ASSERT_NEAR(score, linkScore, 1e-3)
+                << "(Column " << j << ")";
+        }
+    }
+}
+
+
+TYPED_TEST(WideRecursorFuzzTest, ExtendAlpha)
+{
+    if (!R::IsSupported()) return;
+
+    R recursor(BASIC_MOVES | MERGE, this->banding_);
+
+    foreach (const QvEvaluator& e, this->fuzzEvaluators_)
+    {
+        int tplLength = e.TemplateLength();
+        int readLength = e.ReadLength();
+
+        M alpha(readLength + 1, tplLength + 1);
+        M beta(readLength + 1, tplLength + 1);
+        M ext(readLength + 1, 2);
+
+        recursor.FillAlphaBeta(e, alpha, beta);
+        for (int j = 2; j <= tplLength - 1; j++)
+        {
+            recursor.ExtendAlpha(e, alpha, j, ext);
+            for (int extCol = 0; extCol < 2; extCol++)
+            {
+                for (int i = 0; i <= readLength; i++)
+                {
+                    ASSERT_NEAR(alpha(i, j + extCol), ext(i, extCol), 1e-3)
+                            << i << " " << j << " " << extCol << std::endl;
+                }
+            }
+        }
+    }
+}
+
+
+// ExtendBeta as MutationScorer uses it, to score mutations near the start of
+// the template (possibly changing its length), checked against the simple
+// recursor on the fuzz evaluators and a few longer ones.
+template <typename R>
+static void
+CheckExtendBetaVsSimple(const R& recursor, const std::vector<QvEvaluator>& fuzzEvaluators)
+{
+    typedef typename R::MatrixType MatrixType;
+    SimpleRecursor<MatrixType, QvEvaluator, typename R::CombinerType>
+        reference(BASIC_MOVES | MERGE, BandingOptions(4, 200));
+
+    std::vector<QvEvaluator> evaluators(fuzzEvaluators);
+    Rng rng(7);
+    for (int n = 0; n < 10; n++)
+    {
+        evaluators.push_back(RandomQvEvaluator(rng, 100));
+    }
+
+    std::vector<Mutation> muts;
+    for (int start = 0; start < 3; start++)
+    {
+        muts.push_back(Mutation(SUBSTITUTION, start, 'A'));
+        muts.push_back(Mutation(INSERTION, start, 'C'));
+        muts.push_back(Mutation(DELETION, start, '-'));
+    }
+
+    foreach (const QvEvaluator& e, evaluators)
+    {
+        int tplLength = e.TemplateLength();
+        int readLength = e.ReadLength();
+
+        MatrixType alpha(readLength + 1, tplLength + 1);
+        MatrixType beta(readLength + 1, tplLength + 1);
+        recursor.FillAlphaBeta(e, alpha, beta);
+
+        foreach (const Mutation& m, muts)
+        {
+            if (m.End() + 2 > tplLength) continue;
+
+            QvEvaluator mutated = e;
+            mutated.ApplyMutation(m);
+            int extendLength = m.End() + m.LengthDiff() + 1;
+
+            MatrixType ext(readLength + 1, extendLength);
+            MatrixType refExt(readLength + 1, extendLength);
+            recursor.ExtendBeta(mutated, beta, m.End(), ext, extendLength, m.LengthDiff());
+            reference.ExtendBeta(mutated, beta, m.End(), refExt, extendLength, m.LengthDiff());
+
+            for (int extCol = 0; extCol < extendLength; extCol++)
+            {
+                ASSERT_EQ(refExt.UsedRowRange(extCol).Begin, ext.UsedRowRange(extCol).Begin);
+                ASSERT_EQ(refExt.UsedRowRange(extCol).End, ext.UsedRowRange(extCol).End);
+                for (int i = 0; i <= readLength; i++)
+                {
+                    if (refExt(i, extCol) > -FLT_MAX || ext(i, extCol) > -FLT_MAX)
+                        ASSERT_NEAR(refExt(i, extCol), ext(i, extCol), 1e-3)
+                            << m.ToString() << " " << i << " " << extCol;
+                }
+            }
+        }
+    }
+}
+
+TYPED_TEST(WideRecursorFuzzTest, ExtendBetaVsSimple)
+{
+    if (!R::IsSupported()) return;
+
+    R recursor(BASIC_MOVES | MERGE, this->banding_);
+    CheckExtendBetaVsSimple(recursor, this->fuzzEvaluators_);
+}
+
+
+// ----------------------------------------------------------------------------
+// The in-register Extra cascade, checked against the sequential cascade it
+// replaced, and the SSE kernels (which are otherwise bypassed on AVX
+// machines) checked against the simple recursor.
+// ----------------------------------------------------------------------------
+
+template <typename C>
+static void
+CheckExtraScans(float tolerance)
+{
+    Rng rng(42);
+    boost::random::uniform_real_distribution<float> scoreDist(-30.0f, 0.0f);
+
+    for (int trial = 0; trial < 1000; trial++)
+    {
+        float score[4], ins[4], first, last;
+        for (int k = 0; k < 4; k++)
+        {
+            score[k] = (trial % 7 == k) ? -FLT_MAX : scoreDist(rng);
+            ins[k] = scoreDist(rng);
+        }
+        first = (trial % 5 == 0) ? -FLT_MAX : scoreDist(rng);
+        last  = scoreDist(rng);
+
+        float prefix[4], suffix[4];
+        _mm_storeu_ps(prefix, detail::PrefixScan4<C>(first, _mm_loadu_ps(score),
+                                                     _mm_loadu_ps(ins)));
+        _mm_storeu_ps(suffix, detail::SuffixScan4<C>(_mm_loadu_ps(score),
+                                                     _mm_loadu_ps(ins), last));
+
+        float expected[6];
+        expected[0] = first;
+        for (int k = 0; k < 4; k++)
+            expected[k + 1] = C::Combine(score[k], expected[k] + ins[k]);
+        for (int k = 0; k < 4; k++)
+            ASSERT_NEAR(expected[k + 1], prefix[k], tolerance) << trial << " " << k;
+
+        expected[4] = last;
+        for (int k = 3; k >= 0; k--)
+            expected[k] = C::Combine(score[k], expected[k + 1] + ins[k]);
+        for (int k = 0; k < 4; k++)
+            ASSERT_NEAR(expected[k], suffix[k], tolerance) << trial << " " << k;
+    }
+}
+
+TEST(ExtraScanTest, Viterbi)
+{
+    CheckExtraScans<detail::ViterbiCombiner>(1e-4);
+}
+
+TEST(ExtraScanTest, SumProduct)
+{
+    CheckExtraScans<detail::SumProductCombiner>(1e-4);
+}
+
+
+template <typename T>
+class SseKernelFuzzTest : public RecursorFuzzTest<T>
+{
+protected:
+    typedef SimpleRecursor<typename T::MatrixType,
+                           typename T::EvaluatorType,
+                           typename T::CombinerType> ReferenceRecursor;
+
+    void SetUp()
+    {
+        RecursorFuzzTest<T>::SetUp();
+        detail::LimitSimdWidth(4);
+    }
+
+    void TearDown()
+    {
+        detail::LimitSimdWidth(0);
+    }
+};
+
+typedef testing::Types<SparseSseQvRecursor,
+                       SparseSseQvSumProductRecursor> SseImplementations;
+
+TYPED_TEST_CASE(SseKernelFuzzTest, SseImplementations);
+
+TYPED_TEST(SseKernelFuzzTest, FillAlphaBetaVsSimple)
+{
+    R recursor(BASIC_MOVES | MERGE, this->banding_);
+    typename TestFixture::ReferenceRecursor reference(BASIC_MOVES | MERGE, this->banding_);
+    ASSERT_EQ(4, recursor.SimdWidth());
+
+    foreach (const QvEvaluator& e, this->fuzzEvaluators_)
+    {
+        int tplLength = e.TemplateLength();
+        int readLength = e.ReadLength();
+
+        M alpha(readLength + 1, tplLength + 1);
+        M beta(readLength + 1, tplLength + 1);
+        M refAlpha(readLength + 1, tplLength + 1);
+        M refBeta(readLength + 1, tplLength + 1);
+        M ext(readLength + 1, 2);
+
+        recursor.FillAlphaBeta(e, alpha, beta);
+        reference.FillAlphaBeta(e, refAlpha, refBeta);
+
+        EXPECT_NEAR(refAlpha(readLength, tplLength), alpha(readLength, tplLength), 1e-3);
+        EXPECT_NEAR(refBeta(0, 0), beta(0, 0), 1e-3);
+        for (int j = 0; j <= tplLength; j++)
+        {
+            for (int i = 0; i <= readLength; i++)
+            {
+                if (refAlpha(i, j) > -FLT_MAX && alpha(i, j) > -FLT_MAX)
+                    ASSERT_NEAR(refAlpha(i, j), alpha(i, j), 1e-3) << i << " " << j;
+                if (refBeta(i, j) > -FLT_MAX && beta(i, j) > -FLT_MAX)
+                    ASSERT_NEAR(refBeta(i, j), beta(i, j), 1e-3) << i << " " << j;
+            }
+        }
+
+        for (int j = 2; j <= tplLength - 1; j++)
+        {
+            recursor.ExtendAlpha(e, alpha, j, ext);
+            for (int extCol = 0; extCol < 2; extCol++)
+                for (int i = 0; i <= readLength; i++)
+                    ASSERT_NEAR(alpha(i, j + extCol), ext(i, extCol), 1e-3);
+        }
+    }
+}
+
+
+TYPED_TEST(SseKernelFuzzTest, ExtendBetaVsSimple)
+{
+    R recursor(BASIC_MOVES | MERGE, this->banding_);
+    ASSERT_EQ(4, recursor.SimdWidth());
+    CheckExtendBetaVsSimple(recursor, this->fuzzEvaluators_);
+}
+
+
+// ----------------------------------------------------------------------------
+// The batch recursor, whose lanes each follow the simple recursor's
+// recursion and banding.  The batches mix reads and templates of different
+// lengths, and are not all a multiple of the lane count.
+// ----------------------------------------------------------------------------
+
+template <typename T>
+class BatchRecursorFuzzTest : public RecursorFuzzTest<T>
+{
+protected:
+    typedef SimpleRecursor<typename T::MatrixType,
+                           typename T::EvaluatorType,
+                           typename T::CombinerType> ReferenceRecursor;
+
+    void SetUp()
+    {
+        RecursorFuzzTest<T>::SetUp();
+
+        Rng rng(17);
+        for (int n = 0; n < 10; n++)
+        {
+            this->fuzzEvaluators_.insert(this->fuzzEvaluators_.begin() + 7 * n,
+                                         RandomQvEvaluator(rng, 100));
+        }
+        this->fuzzEvaluators_.pop_back();
+    }
+};
+
+typedef testing::Types<BatchQvRecursor,
+                       SparseBatchQvRecursor,
+                       SparseBatchQvSumProductRecursor> BatchImplementations;
+
+TYPED_TEST_CASE(BatchRecursorFuzzTest, BatchImplementations);
+
+
+template <typename MatrixType>
+static void
+ExpectSameCells(const MatrixType& expected, const MatrixType& actual, const std::string& what)
+{
+    ASSERT_EQ(expected.Rows(), actual.Rows());
+    ASSERT_EQ(expected.Columns(), actual.Columns());
+    for (int j = 0; j < expected.Columns(); j++)
+    {
+        for (int i = 0; i < expected.Rows(); i++)
+        {
+            if (expected(i, j) > -FLT_MAX && actual(i, j) > -FLT_MAX)
+                ASSERT_NEAR(expected(i, j), actual(i, j), 1e-3) << what << " " << i << " " << j;
+        }
+    }
+}
+
+
+TYPED_TEST(BatchRecursorFuzzTest, FillAlphasBetasVsSimple)
+{
+    R recursor(BASIC_MOVES | MERGE, this->banding_);
+    typename TestFixture::ReferenceRecursor reference(BASIC_MOVES | MERGE, this->banding_);
+
+    std::vector<M> alphas, betas;
+    foreach (const QvEvaluator& e, this->fuzzEvaluators_)
+    {
+        alphas.push_back(M(e.ReadLength() + 1, e.TemplateLength() + 1));
+        betas.push_back(M(e.ReadLength() + 1, e.TemplateLength() + 1));
+    }
+
+    std::vector<const QvEvaluator*> evaluators;
+    std::vector<const M*> nullGuides, alphaGuides;
+    std::vector<M*> alphaPtrs, betaPtrs;
+    std::vector<int> beginColumns, endColumns;
+    for (unsigned int k = 0; k < this->fuzzEvaluators_.size(); k++)
+    {
+        evaluators.push_back(&this->fuzzEvaluators_[k]);
+        nullGuides.push_back(&NULL_MATRIX);
+        alphaGuides.push_back(&alphas[k]);
+        alphaPtrs.push_back(&alphas[k]);
+        betaPtrs.push_back(&betas[k]);
+        beginColumns.push_back(0);
+        endColumns.push_back(INT_MAX);
+    }
+
+    recursor.FillAlphas(evaluators, nullGuides, alphaPtrs, beginColumns);
+    recursor.FillBetas(evaluators, alphaGuides, betaPtrs, endColumns);
+
+    for (unsigned int k = 0; k < this->fuzzEvaluators_.size(); k++)
+    {
+        const QvEvaluator& e = this->fuzzEvaluators_[k];
+        int tplLength = e.TemplateLength();
+        int readLength = e.ReadLength();
+
+        M refAlpha(readLength + 1, tplLength + 1);
+        M refBeta(readLength + 1, tplLength + 1);
+        reference.FillAlpha(e, NULL_MATRIX, refAlpha);
+        reference.FillBeta(e, refAlpha, refBeta);
+
+        ExpectSameCells(refAlpha, alphas[k], "alpha");
+        ExpectSameCells(refBeta, betas[k], "beta");
+        EXPECT_NEAR(refAlpha(readLength, tplLength), alphas[k](readLength, tplLength), 1e-3);
+        EXPECT_NEAR(refBeta(0, 0), betas[k](0, 0), 1e-3);
+
+        // One read on its own fills just as it does in the batch
+        M alpha(readLength + 1, tplLength + 1);
+        M beta(readLength + 1, tplLength + 1);
+        recursor.FillAlpha(e, NULL_MATRIX, alpha);
+        recursor.FillBeta(e, alpha, beta);
+        ExpectSameCells(alphas[k], alpha, "single alpha");
+        ExpectSameCells(betas[k], beta, "single beta");
+    }
+}
+
+
+TYPED_TEST(BatchRecursorFuzzTest, RefillAlphaBetasVsRefill)
+{
+    R recursor(BASIC_MOVES | MERGE, this->banding_);
+    typename TestFixture::ReferenceRecursor reference(BASIC_MOVES | MERGE, this->banding_);
+
+    int numReads = this->fuzzEvaluators_.size();
+    std::vector<QvEvaluator> mutated;
+    std::vector<Mutation> mutations;
+    std::vector<M> alphas, betas, refAlphas, refBetas;
+    for (int n = 0; n < numReads; n++)
+    {
+        const QvEvaluator& e = this->fuzzEvaluators_[n];
+        int tplLength = e.TemplateLength();
+        int pos = (n * 7) % tplLength;
+        Mutation m = (n % 3 == 0) ? Mutation(SUBSTITUTION, pos, 'A') :
+                     (n % 3 == 1) ? Mutation(INSERTION, pos, 'C') :
+                                    Mutation(DELETION, pos, '-');
+        mutations.push_back(m);
+        mutated.push_back(e);
+        mutated.back().Template(ApplyMutation(m, e.Template()));
+
+        M alpha(e.ReadLength() + 1, tplLength + 1);
+        M beta(e.ReadLength() + 1, tplLength + 1);
+        reference.FillAlphaBeta(e, alpha, beta);
+        alphas.push_back(alpha);
+        betas.push_back(beta);
+        refAlphas.push_back(alpha);
+        refBetas.push_back(beta);
+    }
+
+    std::vector<typename R::RefillType> refills(numReads);
+    for (int n = 0; n < numReads; n++)
+    {
+        refills[n].Evaluator = &mutated[n];
+        refills[n].Alpha = &alphas[n];
+        refills[n].Beta = &betas[n];
+        refills[n].ChangeBegin = mutations[n].Start();
+        refills[n].ChangeEnd = mutations[n].End();
+        refills[n].LengthDiff = mutations[n].LengthDiff();
+        refills[n].Counters = NULL;
+        refills[n].FlipFlops = -2;
+    }
+    recursor.RefillAlphaBetas(refills);
+
+    for (int n = 0; n < numReads; n++)
+    {
+        const QvEvaluator& ee = mutated[n];
+        const Mutation& m = mutations[n];
+        int newLength = ee.TemplateLength();
+        int readLength = ee.ReadLength();
+
+        int flipFlops = reference.RefillAlphaBeta(ee, refAlphas[n], refBetas[n],
+                                                  m.Start(), m.End(), m.LengthDiff());
+        ASSERT_EQ(flipFlops, refills[n].FlipFlops) << m.ToString();
+        ASSERT_EQ(newLength + 1, alphas[n].Columns());
+        ASSERT_EQ(newLength + 1, betas[n].Columns());
+
+        ExpectSameCells(refAlphas[n], alphas[n], "alpha " + m.ToString());
+        ExpectSameCells(refBetas[n], betas[n], "beta " + m.ToString());
+        ASSERT_NEAR(alphas[n](readLength, newLength), betas[n](0, 0), 0.2) << m.ToString();
+    }
+}
+
+
+// ----------------------------------------------------------------------------
+// The wavefront recursor, checked against the simple recursor for the
+// sum-product recursion too (where the band is wide enough that they fill
+// the same cells), and with banding narrow enough to bite.
+// ----------------------------------------------------------------------------
+
+template <typename T>
+class WavefrontRecursorFuzzTest : public RecursorFuzzTest<T>
+{
+protected:
+    typedef SimpleRecursor<typename T::MatrixType,
+                           typename T::EvaluatorType,
+                           typename T::CombinerType> ReferenceRecursor;
+};
+
+typedef testing::Types<SparseWavefrontQvRecursor,
+                       SparseWavefrontQvSumProductRecursor> WavefrontImplementations;
+
+TYPED_TEST_CASE(WavefrontRecursorFuzzTest, WavefrontImplementations);
+
+
+TYPED_TEST(WavefrontRecursorFuzzTest, FillAlphaBetaVsSimple)
+{
+    R recursor(BASIC_MOVES | MERGE, this->banding_);
+    typename TestFixture::ReferenceRecursor reference(BASIC_MOVES | MERGE, this->banding_);
+
+    foreach (const QvEvaluator& e, this->fuzzEvaluators_)
+    {
+        int tplLength = e.TemplateLength();
+        int readLength = e.ReadLength();
+
+        M alpha(readLength + 1, tplLength + 1);
+        M beta(readLength + 1, tplLength + 1);
+        M refAlpha(readLength + 1, tplLength + 1);
+        M refBeta(readLength + 1, tplLength + 1);
+
+        recursor.FillAlpha(e, NULL_MATRIX, alpha);
+        recursor.FillBeta(e, alpha, beta);
+        reference.FillAlpha(e, NULL_MATRIX, refAlpha);
+        reference.FillBeta(e, refAlpha, refBeta);
+
+        ExpectSameCells(refAlpha, alpha, "alpha");
+        ExpectSameCells(refBeta, beta, "beta");
+        EXPECT_NEAR(refAlpha(readLength, tplLength), alpha(readLength, tplLength), 1e-3);
+        EXPECT_NEAR(refBeta(0, 0), beta(0, 0), 1e-3);
+    }
+}
+
+
+TYPED_TEST(WavefrontRecursorFuzzTest, NarrowBands)
+{
+    // With a narrow band the wavefront's bands differ from the simple
+    // recursor's, but must still hold the best paths of these reads,
+    // which are noisy copies of their templates.
+    BandingOptions narrow(4, 12);
+    R recursor(BASIC_MOVES | MERGE, narrow);
+    typename TestFixture::ReferenceRecursor reference(BASIC_MOVES | MERGE, narrow);
+
+    Rng rng(23);
+    for (int n = 0; n < 20; n++)
+    {
+        QvEvaluator e = RandomQvEvaluator(rng, 200);
+        std::string tpl = e.Template();
+        QvEvaluator copy(AnonymousRead(tpl.substr(0, 90) + tpl.substr(91, 60) + "A" + tpl.substr(151)),
+                         tpl, this->testingParams_);
+        int tplLength = copy.TemplateLength();
+        int readLength = copy.ReadLength();
+
+        M alpha(readLength + 1, tplLength + 1);
+        M beta(readLength + 1, tplLength + 1);
+        M refAlpha(readLength + 1, tplLength + 1);
+        M refBeta(readLength + 1, tplLength + 1);
+
+        recursor.FillAlphaBeta(copy, alpha, beta);
+        reference.FillAlphaBeta(copy, refAlpha, refBeta);
+
+        EXPECT_NEAR(refBeta(0, 0), beta(0, 0), 1e-2);
+        EXPECT_NEAR(alpha(readLength, tplLength), beta(0, 0), 1e-2);
+        EXPECT_GT(200 * (readLength + 1), (int)alpha.UsedEntries());
+        for (int j = 2; j < tplLength - 1; j += 17)
+        {
+            EXPECT_NEAR(beta(0, 0), recursor.LinkAlphaBeta(copy, alpha, j, beta, j, j), 1e-2);
+        }
+    }
+}
+
+
+// ----------------------------------------------------------------------------
+// The probability-space sum-product recursor, checked against the log-space
+// SSE one (held to its 4-wide kernels, whose bands end where the scaled
+// recursor's do).  To exercise the probability-space code rather than its
+// fallback to the SseRecursor, the band is narrower than the fuzz tests' and
+// the reads are noisy copies of their templates; cells far below their
+// column's best may still differ, so only those within SCALED_TEST_CUTOFF of
+// it are compared.
+// ----------------------------------------------------------------------------
+
+#define SCALED_TEST_CUTOFF  30.0f
+
+class ScaledRecursorFuzzTest : public RecursorFuzzTest<SparseScaledQvSumProductRecursor>
+{
+protected:
+    ScaledRecursorFuzzTest()
+        : scaledBanding_(4, 25),
+          recursor_(BASIC_MOVES | MERGE, scaledBanding_),
+          reference_(BASIC_MOVES | MERGE, scaledBanding_)
+    {}
+
+    void SetUp()
+    {
+        RecursorFuzzTest<SparseScaledQvSumProductRecursor>::SetUp();
+        detail::LimitSimdWidth(4);
+        recursor_ = SparseScaledQvSumProductRecursor(BASIC_MOVES | MERGE, scaledBanding_);
+        reference_ = SparseSseQvSumProductRecursor(BASIC_MOVES | MERGE, scaledBanding_);
+
+        // Each read is its template with a deletion and a substitution
+        for (int n = 0; n < static_cast<int>(fuzzEvaluators_.size()); n++)
+        {
+            std::string read = fuzzEvaluators_[n].Template();
+            int tplLength = read.length();
+            read.erase(n % tplLength, 1);
+            int s = (7 * n + 3) % (tplLength - 1);
+            read[s] = (read[s] == 'A') ? 'C' : 'A';
+            fuzzEvaluators_[n] = QvEvaluator(AnonymousRead(read),
+                                             fuzzEvaluators_[n].Template(),
+                                             testingParams_);
+        }
+    }
+
+    void TearDown()
+    {
+        detail::LimitSimdWidth(0);
+    }
+
+protected:
+    BandingOptions scaledBanding_;
+    SparseScaledQvSumProductRecursor recursor_;
+    SparseSseQvSumProductRecursor reference_;
+};
+
+
+static void
+ExpectSameLiveCells(const SparseMatrix& expected, const SparseMatrix& actual,
+                    int numColumns, const std::string& what)
+{
+    for (int j = 0; j < numColumns; j++)
+    {
+        float best = -FLT_MAX;
+        for (int i = 0; i < expected.Rows(); i++)
+        {
+            best = std::max(best, expected(i, j));
+        }
+        for (int i = 0; i < expected.Rows(); i++)
+        {
+            if (expected(i, j) > best - SCALED_TEST_CUTOFF)
+                ASSERT_NEAR(expected(i, j), actual(i, j), 1e-3) << what << " " << i << " " << j;
+        }
+    }
+}
+
+
+TEST_F(ScaledRecursorFuzzTest, FillAlphaBetaVsSse)
+{
+    foreach (const QvEvaluator& e, this->fuzzEvaluators_)
+    {
+        int tplLength = e.TemplateLength();
+        int readLength = e.ReadLength();
+
+        SparseMatrix alpha(readLength + 1, tplLength + 1);
+        SparseMatrix beta(readLength + 1, tplLength + 1);
+        SparseMatrix refAlpha(readLength + 1, tplLength + 1);
+        SparseMatrix refBeta(readLength + 1, tplLength + 1);
+
+        recursor_.FillAlpha(e, SparseMatrix::Null(), alpha);
+        recursor_.FillBeta(e, alpha, beta);
+        reference_.FillAlpha(e, SparseMatrix::Null(), refAlpha);
+        reference_.FillBeta(e, refAlpha, refBeta);
+
+        ExpectSameLiveCells(refAlpha, alpha, tplLength + 1, "alpha");
+        ExpectSameLiveCells(refBeta, beta, tplLength + 1, "beta");
+        EXPECT_NEAR(refAlpha(readLength, tplLength), alpha(readLength, tplLength), 1e-3);
+        EXPECT_NEAR(alpha(readLength, tplLength), beta(0, 0), 1e-3);
+    }
+}
+
+
+TEST_F(ScaledRecursorFuzzTest, LinkAndExtendVsSse)
+{
+    foreach (const QvEvaluator& e, this->fuzzEvaluators_)
+    {
+        int tplLength = e.TemplateLength();
+        int readLength = e.ReadLength();
+
+        SparseMatrix alpha(readLength + 1, tplLength + 1);
+        SparseMatrix beta(readLength + 1, tplLength + 1);
+        recursor_.FillAlphaBeta(e, alpha, beta);
+
+        for (int j = 2; j < tplLength - 2; j++)
+        {
+            ASSERT_NEAR(reference_.LinkAlphaBeta(e, alpha, j, beta, j, j),
+                        recursor_.LinkAlphaBeta(e, alpha, j, beta, j, j), 1e-3) << j;
+
+            // Extend through a substitution at j, two columns and three
+            QvEvaluator mutated = e;
+            mutated.ApplyMutation(Mutation(SUBSTITUTION, j, 'A'));
+            for (int numExtColumns = 2; numExtColumns <= 3; numExtColumns++)
+            {
+                SparseMatrix ext(readLength + 1, numExtColumns);
+                SparseMatrix refExt(readLength + 1, numExtColumns);
+
+                recursor_.ExtendAlpha(mutated, alpha, j, ext, numExtColumns);
+                reference_.ExtendAlpha(mutated, alpha, j, refExt, numExtColumns);
+                ExpectSameLiveCells(refExt, ext, numExtColumns, "ExtendAlpha");
+
+                if (j - numExtColumns + 1 < 0) continue;
+                recursor_.ExtendBeta(mutated, beta, j, ext, numExtColumns);
+                reference_.ExtendBeta(mutated, beta, j, refExt, numExtColumns);
+                ExpectSameLiveCells(refExt, ext, numExtColumns, "ExtendBeta");
+            }
+        }
+
+        // ExtendBeta through indels at the start, as MutationScorer does
+        for (int start = 0; start < 3; start++)
+        {
+            Mutation muts[] = { Mutation(INSERTION, start, 'C'), Mutation(DELETION, start, '-') };
+            foreach (const Mutation& m, muts)
+            {
+                QvEvaluator mutated = e;
+                mutated.ApplyMutation(m);
+                int extendLength = m.End() + m.LengthDiff() + 1;
+
+                SparseMatrix ext(readLength + 1, extendLength);
+                SparseMatrix refExt(readLength + 1, extendLength);
+                recursor_.ExtendBeta(mutated, beta, m.End(), ext, extendLength, m.LengthDiff());
+                reference_.ExtendBeta(mutated, beta, m.End(), refExt, extendLength, m.LengthDiff());
+                ExpectSameLiveCells(refExt, ext, extendLength, m.ToString());
+            }
+        }
+    }
+}
+
+
+TEST_F(ScaledRecursorFuzzTest, NarrowBands)
+{
+    // Noisy copies of longer templates, with banding narrow enough to bite
+    BandingOptions narrow(4, 12);
+    SparseScaledQvSumProductRecursor recursor(BASIC_MOVES | MERGE, narrow);
+    SparseSseQvSumProductRecursor reference(BASIC_MOVES | MERGE, narrow);
+
+    Rng rng(23);
+    for (int n = 0; n < 20; n++)
+    {
+        QvEvaluator e = RandomQvEvaluator(rng, 200);
+        std::string tpl = e.Template();
+        QvEvaluator copy(AnonymousRead(tpl.substr(0, 90) + tpl.substr(91, 60) + "A" + tpl.substr(151)),
+                         tpl, this->testingParams_);
+        int tplLength = copy.TemplateLength();
+        int readLength = copy.ReadLength();
+
+        SparseMatrix alpha(readLength + 1, tplLength + 1);
+        SparseMatrix beta(readLength + 1, tplLength + 1);
+        SparseMatrix refAlpha(readLength + 1, tplLength + 1);
+        SparseMatrix refBeta(readLength + 1, tplLength + 1);
+
+        recursor.FillAlphaBeta(copy, alpha, beta);
+        reference.FillAlphaBeta(copy, refAlpha, refBeta);
+
+        EXPECT_NEAR(refBeta(0, 0), beta(0, 0), 1e-2);
+        EXPECT_NEAR(alpha(readLength, tplLength), beta(0, 0), 1e-2);
+        for (int j = 2; j < tplLength - 1; j += 17)
+        {
+            EXPECT_NEAR(beta(0, 0), recursor.LinkAlphaBeta(copy, alpha, j, beta, j, j), 1e-2);
+        }
+    }
+}
+
+
+TEST_F(ScaledRecursorFuzzTest, FallsBackToLogSpace)
+{
+    // Random reads, unrelated to their templates, reach their pinned corners
+    // only through cells far below the float's range; as does any read
+    // whose band is too wide.  Either way the scores must still agree.
+    const float scoreDiffs[] = { 25, 200 };
+    foreach (float scoreDiff, scoreDiffs)
+    {
+        BandingOptions banding(4, scoreDiff);
+        SparseScaledQvSumProductRecursor recursor(BASIC_MOVES | MERGE, banding);
+        SparseSseQvSumProductRecursor reference(BASIC_MOVES | MERGE, banding);
+
+        Rng rng(42);
+        for (int n = 0; n < 50; n++)
+        {
+            QvEvaluator e = RandomQvEvaluator(rng, 20);
+            int tplLength = e.TemplateLength();
+            int readLength = e.ReadLength();
+
+            SparseMatrix alpha(readLength + 1, tplLength + 1);
+            SparseMatrix beta(readLength + 1, tplLength + 1);
+            SparseMatrix refAlpha(readLength + 1, tplLength + 1);
+            SparseMatrix refBeta(readLength + 1, tplLength + 1);
+
+            recursor.FillAlpha(e, SparseMatrix::Null(), alpha);
+            recursor.FillBeta(e, alpha, beta);
+            reference.FillAlpha(e, SparseMatrix::Null(), refAlpha);
+            reference.FillBeta(e, refAlpha, refBeta);
+
+            EXPECT_NEAR(refAlpha(readLength, tplLength), alpha(readLength, tplLength), 1e-3);
+            EXPECT_NEAR(refBeta(0, 0), beta(0, 0), 1e-3);
+            for (int j = 2; j < tplLength - 2; j += 5)
+            {
+                EXPECT_NEAR(reference.LinkAlphaBeta(e, refAlpha, j, refBeta, j, j),
+                            recursor.LinkAlphaBeta(e, alpha, j, beta, j, j), 1e-3) << j;
+            }
+        }
+    }
+}
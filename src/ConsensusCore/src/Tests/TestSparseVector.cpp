@@ -91,6 +91,25 @@ TEST(SparseVectorTest, BasicTest2)
 
 
 
+TEST(SparseVectorTest, CountsReallocs)
+{
+    // Setting within the allocated range reuses it; setting outside it
+    // reallocates, once
+    SparseVector sv(100, 10, 20);
+    int reallocs = sv.NumReallocs();
+    for (int i = 10; i < 20; i++)
+    {
+        sv.Set(i, i);
+    }
+    EXPECT_EQ(reallocs, sv.NumReallocs());
+
+    sv.Set(50, 50);
+    EXPECT_EQ(reallocs + 1, sv.NumReallocs());
+    sv.Set(45, 45);
+    EXPECT_EQ(reallocs + 1, sv.NumReallocs());
+}
+
+
 TEST(SparseVector, CopyTest)
 {
     SparseVector sv(10, 3, 7);
@@ -0,0 +1,100 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+
+#include "Quiver/detail/SseMath.hpp"
+
+using namespace ConsensusCore; // NOLINT
+using namespace ConsensusCore::detail; // NOLINT
+
+// The bound documented in SseMath.hpp, plus float rounding
+static double Log1pExpErrorBound()
+{
+    double h = 1.0 / (1 << LOGADD_TABLE_BITS);
+    return std::max(pow(h, 4) / 3072, exp(-static_cast<double>(LOGADD_CUTOFF))) + 2.5e-7;
+}
+
+TEST(SseMathTest, Log1pExpAccuracy)
+{
+    double bound = Log1pExpErrorBound();
+    for (int n = 0; n < 4 * 40000; n += 4)
+    {
+        float d[4], f[4];
+        for (int k = 0; k < 4; k++)
+        {
+            d[k] = (n + k) * 1e-4f;
+        }
+        _mm_storeu_ps(f, log1pExp4(_mm_loadu_ps(d)));
+        for (int k = 0; k < 4; k++)
+        {
+            double expected = log(1.0 + exp(-static_cast<double>(d[k])));
+            ASSERT_NEAR(expected, f[k], bound) << "d = " << d[k];
+        }
+    }
+}
+
+TEST(SseMathTest, LogAddAccuracy)
+{
+    const float as[] = { 0.0f, -1.0f, -3.5f, -20.0f, -100.25f, -1000.0f };
+    for (unsigned int i = 0; i < sizeof(as) / sizeof(float); i++)
+    {
+        for (float delta = -30.0f; delta <= 30.0f; delta += 0.01f)
+        {
+            float a = as[i], b = as[i] + delta;
+            double expected = std::max<double>(a, b) +
+                log(1.0 + exp(-fabs(static_cast<double>(a) - b)));
+            // Absolute error of log1pExp, plus rounding of the sum
+            double tolerance = Log1pExpErrorBound() +
+                fabs(expected) * FLT_EPSILON;
+            ASSERT_NEAR(expected, logAdd(a, b), tolerance) << a << " " << b;
+            ASSERT_EQ(logAdd(a, b), logAdd(b, a));
+        }
+    }
+}
+
+TEST(SseMathTest, LogAddExtremes)
+{
+    EXPECT_EQ(-FLT_MAX, logAdd(-FLT_MAX, -FLT_MAX));
+    EXPECT_FLOAT_EQ(-5.0f, logAdd(-5.0f, -FLT_MAX));
+    EXPECT_FLOAT_EQ(-5.0f, logAdd(-FLT_MAX, -5.0f));
+    EXPECT_FLOAT_EQ(static_cast<float>(log(2.0)), logAdd(0.0f, 0.0f));
+    EXPECT_FLOAT_EQ(-5.0f, logAdd(-5.0f, -std::numeric_limits<float>::infinity()));
+}
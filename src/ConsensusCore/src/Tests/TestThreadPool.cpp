@@ -0,0 +1,230 @@
+// Copyright (c) 2011-2013, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "Quiver/detail/ThreadPool.hpp"
+#include "Types.hpp"
+
+using ConsensusCore::detail::ParallelTask;
+using ConsensusCore::detail::ThreadPool;
+
+namespace {
+
+    // Records which items ran and the order they were committed in;
+    // cancels once the running sum of the items reaches a limit.
+    class RecordingTask : public ParallelTask
+    {
+    public:
+        RecordingTask(int numItems, int limit)
+            : ran(numItems, 0),
+              sum(0),
+              limit_(limit)
+        {}
+
+        void Run(int i)
+        {
+            // Uneven amounts of work, so items finish out of order
+            volatile int spin = 0;
+            for (int k = 0; k < (i % 7) * 10000; k++) spin++;
+            ran[i]++;
+        }
+
+        bool Commit(int i)
+        {
+            committed.push_back(i);
+            sum += i;
+            return sum < limit_;
+        }
+
+        std::vector<int> ran;
+        std::vector<int> committed;
+        int sum;
+
+    private:
+        int limit_;
+    };
+}
+
+
+TEST(ThreadPoolTest, NumThreads)
+{
+    EXPECT_EQ(1, ThreadPool(1).NumThreads());
+    EXPECT_EQ(3, ThreadPool(3).NumThreads());
+    EXPECT_EQ(1, ThreadPool(0).NumThreads());
+    EXPECT_EQ(ThreadPool::HardwareConcurrency(), ThreadPool(-1).NumThreads());
+}
+
+TEST(ThreadPoolTest, CommitsInOrder)
+{
+    for (int numThreads = 1; numThreads <= 4; numThreads++)
+    {
+        ThreadPool pool(numThreads);
+        for (int n = 0; n < 200; n += 17)
+        {
+            RecordingTask task(n, 1 << 30);
+            pool.ParallelFor(n, task);
+            ASSERT_EQ(n, (int)task.committed.size());
+            for (int i = 0; i < n; i++)
+            {
+                EXPECT_EQ(1, task.ran[i]);
+                EXPECT_EQ(i, task.committed[i]);
+            }
+        }
+    }
+}
+
+TEST(ThreadPoolTest, Cancellation)
+{
+    for (int numThreads = 1; numThreads <= 4; numThreads++)
+    {
+        ThreadPool pool(numThreads);
+        RecordingTask task(1000, 100);
+        pool.ParallelFor(1000, task);
+
+        // 0 + 1 + ... + 14 = 105 is the first sum past the limit
+        ASSERT_EQ(15, (int)task.committed.size());
+        for (int i = 0; i < 15; i++)
+        {
+            EXPECT_EQ(i, task.committed[i]);
+        }
+        // Items handed out ahead of the commit point may still run, but
+        // nothing is run twice and the rest are never started
+        int numRun = 0;
+        for (int i = 0; i < 1000; i++)
+        {
+            EXPECT_LE(task.ran[i], 1);
+            numRun += task.ran[i];
+        }
+        EXPECT_LE(15, numRun);
+        EXPECT_GT(1000, numRun);
+    }
+}
+
+namespace {
+
+    // Each item runs an inner task on the same pool, which is busy
+    class NestingTask : public ParallelTask
+    {
+    public:
+        NestingTask(ThreadPool* pool, int numItems)
+            : pool_(pool),
+              inner(numItems, RecordingTask(50, 1 << 30))
+        {}
+
+        void Run(int i)
+        {
+            pool_->ParallelFor(50, inner[i]);
+        }
+
+        std::vector<RecordingTask> inner;
+
+    private:
+        ThreadPool* pool_;
+    };
+}
+
+TEST(ThreadPoolTest, NestedCallsRunSerially)
+{
+    for (int numThreads = 1; numThreads <= 4; numThreads++)
+    {
+        ThreadPool pool(numThreads);
+        NestingTask task(&pool, 20);
+        pool.ParallelFor(20, task);
+        for (int n = 0; n < 20; n++)
+        {
+            ASSERT_EQ(50, (int)task.inner[n].committed.size());
+            for (int i = 0; i < 50; i++)
+            {
+                EXPECT_EQ(1, task.inner[n].ran[i]);
+                EXPECT_EQ(i, task.inner[n].committed[i]);
+            }
+        }
+    }
+}
+
+namespace {
+
+    // Throws from the items given, an InvalidInputError from the first
+    // and an InternalError from the second
+    class ThrowingTask : public ParallelTask
+    {
+    public:
+        ThrowingTask(int firstThrower, int secondThrower)
+            : firstThrower_(firstThrower),
+              secondThrower_(secondThrower)
+        {}
+
+        void Run(int i)
+        {
+            volatile int spin = 0;
+            for (int k = 0; k < (i % 5) * 10000; k++) spin++;
+            if (i == firstThrower_) throw ConsensusCore::InvalidInputError("first");
+            if (i == secondThrower_) throw ConsensusCore::InternalError("second");
+        }
+
+    private:
+        int firstThrower_;
+        int secondThrower_;
+    };
+}
+
+TEST(ThreadPoolTest, ExceptionsReachTheCaller)
+{
+    for (int numThreads = 1; numThreads <= 4; numThreads++)
+    {
+        ThreadPool pool(numThreads);
+        for (int trial = 0; trial < 20; trial++)
+        {
+            // The earlier item's exception wins, whichever threw first
+            ThrowingTask task(7, 9);
+            try
+            {
+                pool.ParallelFor(200, task);
+                FAIL() << "no exception";
+            }
+            catch (const ConsensusCore::InvalidInputError& e)
+            {
+                EXPECT_EQ("first", e.Message());
+            }
+        }
+
+        // And the pool carries on afterwards
+        RecordingTask task(100, 1 << 30);
+        pool.ParallelFor(100, task);
+        EXPECT_EQ(100, (int)task.committed.size());
+    }
+}
@@ -498,6 +498,38 @@ namespace PacBio.Consensus
             }
         }
 
+        /// <summary>
+        /// The work done filling matrices and scoring mutations, summed over the reads
+        /// </summary>
+        public ScorerCounters Counters
+        {
+            get { return scorer.Counters(); }
+        }
+
+        /// <summary>
+        /// The work done filling matrices and scoring mutations for each read; for
+        /// spotting the reads that take far longer than the rest
+        /// </summary>
+        public ScorerCounters[] ReadCounters
+        {
+            get
+            {
+                var r = new ScorerCounters[scorer.NumReads()];
+
+                for (int i = 0; i < scorer.NumReads(); i++)
+                {
+                    r[i] = scorer.Counters(i);
+                }
+
+                return r;
+            }
+        }
+
+        public void ResetCounters()
+        {
+            scorer.ResetCounters();
+        }
+
         /// <summary>
         /// Access the ConsensusCore MappedRead object for each read
         /// </summary>
@@ -569,6 +601,28 @@ namespace PacBio.Consensus
         {
             return scorer.Score(m.Type, m.TemplatePosition, m.Base);
         }
+
+        /// <summary>
+        /// Score a batch of mutations with a single call into ConsensusCore.  Entry k of the result
+        /// is ScoreMutation(mutations[k]).
+        /// </summary>
+        public float[] ScoreMutations(IList<Mutation> mutations)
+        {
+            var n = mutations.Count;
+            var types = new int[n];
+            var positions = new int[n];
+            var bases = new byte[n];
+            for (int k = 0; k < n; k++)
+            {
+                types[k] = (int) mutations[k].Type;
+                positions[k] = mutations[k].TemplatePosition;
+                bases[k] = (byte) mutations[k].Base;
+            }
+
+            var scores = new float[n];
+            scorer.ScoreMutations(n, types, positions, bases, scores);
+            return scores;
+        }
         
         public float ScoreMutationFast(Mutation m)
         {
@@ -420,8 +420,7 @@ namespace PacBio.Consensus
                                                                                         out int iterationsTaken)
         {
 
-            Func<Mutation, MutationScore> scoreMutation = 
-                m => new MutationScore { Score = scorer.ScoreMutation(m), Mutation = m, Exists = true };
+            var scoreMutations = BatchScorer(scorer);
 
 
             // This will be used to derive QVs
@@ -435,7 +434,7 @@ namespace PacBio.Consensus
             float minScore = 0.35f;
             int prevMutationWindow = 12;
 
-            Func<IEnumerable<Mutation>, List<Mutation>> screenMutations = mutationsToTry => FindMutations(mutationsToTry, scoreMutation, out score, mutationSpacing, minScore);
+            Func<IEnumerable<Mutation>, List<Mutation>> screenMutations = mutationsToTry => FindMutations(mutationsToTry, scoreMutations, out score, mutationSpacing, minScore);
 
             var tpl = scorer.Template;
 
@@ -492,7 +491,7 @@ namespace PacBio.Consensus
                         // In phase 3 we shouldn't get many new mutations. Compute the scores
                         // of all possible mutations in preparation for computing the QVs.
                         // If we do find real mutations, apply them and try again.
-                        allScores = UniqueMutationsScores(scoreMutation, tpl);
+                        allScores = UniqueMutationsScores(scoreMutations, tpl);
                         var possibleMutations =
                             allScores.Where(s => !s.Mutation.IsSynonymous(tpl) && s.Score > minScore).ToList();
                         var bestMutations = SpacedSelector.BestMutations(possibleMutations, mutationSpacing);
@@ -520,24 +519,24 @@ namespace PacBio.Consensus
 
         public static int ImproveConsensus(MultiReadMutationScorer scorer, int maxIterations, float[] mappingRatios = null, bool fast = false)
         {
-            Func<Mutation, MutationScore> scoreMutation;
+            Func<IList<Mutation>, List<MutationScore>> scoreMutations;
 
             if (mappingRatios == null)
             {
                 if (fast)
                 {
-                    scoreMutation = m => new MutationScore { Score = scorer.ScoreMutationFast(m), Mutation = m, Exists = true };
+                    scoreMutations = Batched(m => new MutationScore { Score = scorer.ScoreMutationFast(m), Mutation = m, Exists = true });
                 }
                 else
                 {
                     // Normal style -- only one template in play
-                    scoreMutation = m => new MutationScore { Score = scorer.ScoreMutation(m), Mutation = m, Exists = true };
+                    scoreMutations = BatchScorer(scorer);
                 }
             }
             else
             {
                 // Multi-template scoring -- the mapping ratio is P_this_read / sum_i (P_read_i)
-                scoreMutation = m => new MutationScore { Score = scorer.ScoreMutationWeighted(m, mappingRatios), Mutation = m, Exists = true };
+                scoreMutations = Batched(m => new MutationScore { Score = scorer.ScoreMutationWeighted(m, mappingRatios), Mutation = m, Exists = true });
             }
 
             double score;
@@ -549,7 +548,7 @@ namespace PacBio.Consensus
             const int prevMutationWindow = 22;
 
             Func<IEnumerable<Mutation>, List<Mutation>> screenMutations =
-                mutationsToTry => FindMutations(mutationsToTry, scoreMutation, out score, mutationSpacing, minScore);
+                mutationsToTry => FindMutations(mutationsToTry, scoreMutations, out score, mutationSpacing, minScore);
                     // FIXME -- consider the compound mutation search procedure
                     //FindMutationsAndSearch(mutationsToTry, scoreMutation, mutationSpacing, minScore, compoundScore);
 
@@ -593,21 +592,21 @@ namespace PacBio.Consensus
 
         public static List<MutationScore> ComputeAllQVs(MultiReadMutationScorer scorer, float[] mappingRatios = null)
         {
-            Func<Mutation, MutationScore> scoreMutation;
+            Func<IList<Mutation>, List<MutationScore>> scoreMutations;
 
             if (mappingRatios == null)
             {  
                 // Normal style -- only one template in play
-                scoreMutation = m => new MutationScore { Score = scorer.ScoreMutation(m), Mutation = m, Exists = true };
+                scoreMutations = BatchScorer(scorer);
             }
             else
             {
                 // Multi-template scoring -- the mapping ratio is P_this_read / sum_i (P_read_i)
-                scoreMutation = m => new MutationScore { Score = scorer.ScoreMutationWeighted(m, mappingRatios), Mutation = m, Exists = true };
+                scoreMutations = Batched(m => new MutationScore { Score = scorer.ScoreMutationWeighted(m, mappingRatios), Mutation = m, Exists = true });
             }
             
             var tpl = scorer.Template;
-            var allScores = UniqueMutationsScores(scoreMutation, tpl);
+            var allScores = UniqueMutationsScores(scoreMutations, tpl);
             return allScores;
         }
 
@@ -791,11 +790,11 @@ namespace PacBio.Consensus
         /// constraints on the density and score of the returned mutations
         /// </summary>
         public static List<Mutation> FindMutations(IEnumerable<Mutation> mutations, 
-            Func<Mutation, MutationScore> scoreMutation, out double score, int minSpacing, float minScore)
+            Func<IList<Mutation>, List<MutationScore>> scoreMutations, out double score, int minSpacing, float minScore)
         {
             // Generate all possible mutations of the template.  GenerateAllMutations will not generate mutations
             // in the adapter regions. Filter out mutations that don't meet the minimum score threshold.
-            var possibleMutations = mutations.Select(scoreMutation).Where(ms => ms.Score > minScore).ToList();
+            var possibleMutations = scoreMutations(mutations.ToList()).Where(ms => ms.Score > minScore).ToList();
 
             // Find the set of mutations with at minSpacing template bases between mutations with the highest total score
             var bestMutations = SpacedSelector.BestMutations(possibleMutations, minSpacing);
@@ -811,23 +810,50 @@ namespace PacBio.Consensus
         /// Generate a list of beneficial template mutations, given an initial trial template, a series of PulsePassModels, and some
         /// constraints on the density and score of the returned mutations
         /// </summary>
-        static List<MutationScore> UniqueMutationsScores(Func<Mutation, MutationScore> scoreMutation, TrialTemplate tpl)
+        static List<MutationScore> UniqueMutationsScores(Func<IList<Mutation>, List<MutationScore>> scoreMutations, TrialTemplate tpl)
         {
             // Generate all possible mutations of the template.  GenerateAllMutations will not generate mutations
             // in the adapter regions. Filter out mutations that don't meet the minimum score threshold.
-            return GenerateMutations.GenerateUniqueMutations(tpl).Select(
-                m =>
-                    {
-                        if (m.IsSynonymous(tpl))
-                            return new MutationScore
-                                {
-                                    Exists = true,
-                                    Mutation = m,
-                                    Score = 0
-                                };
-                        else
-                            return scoreMutation(m);
-                    }).ToList();
+            var mutations = GenerateMutations.GenerateUniqueMutations(tpl).ToList();
+
+            // Score the non-synonymous mutations in one batch
+            var scores = scoreMutations(mutations.Where(m => !m.IsSynonymous(tpl)).ToList());
+
+            var allScores = new List<MutationScore>(mutations.Count);
+            var k = 0;
+            foreach (var m in mutations)
+            {
+                if (m.IsSynonymous(tpl))
+                    allScores.Add(new MutationScore
+                        {
+                            Exists = true,
+                            Mutation = m,
+                            Score = 0
+                        });
+                else
+                    allScores.Add(scores[k++]);
+            }
+            return allScores;
+        }
+
+        /// <summary>
+        /// Score batches of mutations with a single call into ConsensusCore per batch
+        /// </summary>
+        static Func<IList<Mutation>, List<MutationScore>> BatchScorer(MultiReadMutationScorer scorer)
+        {
+            return mutations =>
+                {
+                    var scores = scorer.ScoreMutations(mutations);
+                    return mutations.Select((m, k) => new MutationScore { Score = scores[k], Mutation = m, Exists = true }).ToList();
+                };
+        }
+
+        /// <summary>
+        /// Score batches of mutations one mutation at a time
+        /// </summary>
+        static Func<IList<Mutation>, List<MutationScore>> Batched(Func<Mutation, MutationScore> scoreMutation)
+        {
+            return mutations => mutations.Select(scoreMutation).ToList();
         }
     }
 }
\ No newline at end of file